@@ -278,6 +278,9 @@ typedef enum VSCoreCreationFlags {
     ccfEnableGraphInspection = 1,
     ccfDisableAutoLoading = 2,
     ccfDisableLibraryUnloading = 4
+#ifdef VS_GRAPH_API
+    , ccfEnableTracing = 8 /* not part of the stable api, records what happens in the core for writeTrace */
+#endif
 } VSCoreCreationFlags;
 
 typedef enum VSPluginConfigFlags {
@@ -476,6 +479,13 @@ struct VSAPI {
     int64_t (VS_CC *getNodeFilterTime)(VSNode *node) VS_NOEXCEPT; /* time spent processing frames in nanoseconds */
     const VSFilterDependency *(VS_CC *getNodeDependencies)(VSNode *node) VS_NOEXCEPT;
     int (VS_CC *getNumNodeDependencies)(VSNode *node) VS_NOEXCEPT;
+    void (VS_CC *getNodeStatistics)(VSNode *node, VSMap *out) VS_NOEXCEPT; /* stores the number of getFrame calls and returned frames, the latency percentiles of the calls that returned a frame in nanoseconds, cache hits and misses and bytes allocated by the filter in out */
+    void (VS_CC *getCoreStatistics)(VSCore *core, VSMap *out) VS_NOEXCEPT; /* stores the time in nanoseconds worker threads spent idle and waiting for the task queue lock in out */
+    int (VS_CC *writeTrace)(VSCore *core, const char *filename) VS_NOEXCEPT; /* writes everything recorded so far by a core created with ccfEnableTracing as a Chrome trace event JSON file, returns non-zero on success, recording stops after about a million events and the number of dropped events is noted in the file */
+
+    /* Experimental graph snapshots, like the functions above this is not safe to use concurrently with frame requests */
+    void (VS_CC *saveGraphSnapshot)(const VSMap *nodes, const char *filename, VSMap *out) VS_NOEXCEPT; /* writes the plugin function calls that created every node in nodes and their arguments to filename, requires ccfEnableGraphInspection and sets an error in out if a node wasn't returned by a plugin function or an argument is a function or frame */
+    void (VS_CC *loadGraphSnapshot)(const char *filename, VSCore *core, VSMap *out) VS_NOEXCEPT; /* repeats the calls in a snapshot without evaluating the script again and stores the resulting nodes in out under the keys they were saved with, or sets an error */
 #endif
 };
 
@@ -24,8 +24,12 @@
 #define VAPOURSYNTHC_H
 
 #include <stdint.h>
+#include "VapourSynth4.h"
 
 #define VAPOURSYNTHC_API_VERSION 0x76732d63 // 'vs-c'
+#define VAPOURSYNTHC_API_VERSION2 0x76732d32 // 'vs-2', returns the same struct but NULL from cores that don't have the functions after setNodeName
+
+typedef void (VS_CC *VSExternalBufferFree)(void *userData);
 
 typedef struct VSCAPI {
     int (VS_CC *getPluginAPIVersion)(const VSPlugin *); // major version only
@@ -33,6 +37,20 @@ typedef struct VSCAPI {
     int (VS_CC *pluginRenameFunc)(VSPlugin *, const char *oldname, const char *newname);
     VSPlugin *(VS_CC *createPlugin)(const char *id, const char *ns, int version, VSCore *core);
     void (VS_CC *setNodeName)(VSNode *node, const char *name);
+
+    // Only call these when getVapourSynthAPI(VAPOURSYNTHC_API_VERSION2) returned the struct
+
+    // Requests all the frames at once with consecutive priorities, the callback is called exactly once per entry in frames and in the same order,
+    // the frames array can be freed as soon as the function returns, safe to call concurrently just like getFrameAsync
+    void (VS_CC *getFramesAsync)(const int *frames, int numFrames, VSNode *node, VSFrameDoneCallback callback, void *userData);
+    // Creates a frame that uses one externally allocated buffer per plane without copying, returns NULL if a pointer or stride isn't a multiple of the
+    // frame alignment or a stride is too small, freeBuffer is called once with userData when no plane is referenced anymore, the buffers are never
+    // written to and get copied on the first getWritePtr call
+    VSFrame *(VS_CC *newVideoFrameFromBuffers)(const VSVideoFormat *format, int width, int height, uint8_t * const *planeData, const ptrdiff_t *strides, VSExternalBufferFree freeBuffer, void *userData, const VSFrame *propSrc, VSCore *core);
+    // Stores the thread pool's thread, task queue and frame context counts, the framebuffer limit, usage and recycled buffer bytes in out, followed by
+    // the name, current and maximum size and history length and total hits and misses of every enabled cache as cache_* arrays with one entry per node,
+    // safe to call at any time even while frames are being processed
+    void (VS_CC *getLiveStatistics)(VSCore *core, VSMap *out);
 } VSCAPI;
 
 #endif /* VAPOURSYNTHC_H */
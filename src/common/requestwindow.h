@@ -0,0 +1,95 @@
+/*
+* Copyright (c) 2026 vapoursynth-classic contributors
+*
+* This file is part of VapourSynth.
+*
+* VapourSynth is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 2.1 of the License, or (at your option) any later version.
+*
+* VapourSynth is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with VapourSynth; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+// Adaptive number of concurrent frame requests, used by vspipe and RawNode.frames() in the Python module.
+// The window starts out at the number of threads and is adjusted once per measurement period by hill climbing
+// on the throughput. It keeps moving in the same direction as long as that makes things faster and turns around
+// when it gets slower, when nothing changes the smaller window is preferred since it uses less memory. Going over
+// the framebuffer cache limit always shrinks it. Plain C so it can be used from Cython.
+
+#ifndef REQUESTWINDOW_H
+#define REQUESTWINDOW_H
+
+typedef struct VSRequestWindow {
+    int window;
+    int minWindow;
+    int maxWindow;
+    int direction; /* 1 when the last adjustment grew the window, -1 when it shrunk it */
+    int completedFrames; /* in the current period */
+    double periodStart; /* seconds */
+    double lastThroughput; /* frames per second in the previous period, 0 if there wasn't one */
+} VSRequestWindow;
+
+static inline void vsRequestWindowInit(VSRequestWindow *w, int numThreads, double now) {
+    if (numThreads < 1)
+        numThreads = 1;
+    w->window = numThreads;
+    w->minWindow = 1;
+    w->maxWindow = numThreads * 4;
+    w->direction = 1;
+    w->completedFrames = 0;
+    w->periodStart = now;
+    w->lastThroughput = 0;
+}
+
+/* Call once for every completed frame, returns non-zero when the period is over and vsRequestWindowAdjust() should be called.
+ * A period lasts for at least twice the window in frames and 50ms so the throughput isn't dominated by noise. */
+static inline int vsRequestWindowFrameDone(VSRequestWindow *w, double now) {
+    w->completedFrames++;
+    return w->completedFrames >= 2 * w->window && now - w->periodStart >= 0.05;
+}
+
+/* overLimit should be non-zero when the core's framebuffer usage is above the cache size limit */
+static inline void vsRequestWindowAdjust(VSRequestWindow *w, double now, int overLimit) {
+    double throughput = w->completedFrames / (now - w->periodStart);
+    int step = w->window / 8;
+    if (step < 1)
+        step = 1;
+
+    if (overLimit) {
+        w->direction = -1;
+        step = w->window / 4;
+        if (step < 1)
+            step = 1;
+        /* the throughput measured while thrashing isn't a useful reference */
+        throughput = 0;
+    } else if (w->lastThroughput > 0 && throughput > w->lastThroughput * 1.02) {
+        /* the last move helped, keep going */
+    } else if (w->lastThroughput > 0 && throughput < w->lastThroughput * 0.98) {
+        w->direction = -w->direction;
+    } else if (w->lastThroughput > 0) {
+        w->direction = -1;
+    }
+
+    w->window += w->direction * step;
+    if (w->window < w->minWindow) {
+        w->window = w->minWindow;
+        w->direction = 1;
+    } else if (w->window > w->maxWindow) {
+        w->window = w->maxWindow;
+        w->direction = -1;
+    }
+
+    w->lastThroughput = throughput;
+    w->completedFrames = 0;
+    w->periodStart = now;
+}
+
+#endif
@@ -0,0 +1,234 @@
+/*
+* Copyright (c) 2026 vapoursynth-classic contributors
+*
+* This file is part of VapourSynth.
+*
+* VapourSynth is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 2.1 of the License, or (at your option) any later version.
+*
+* VapourSynth is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with VapourSynth; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "videopack.h"
+#include <cstring>
+
+// SSE2 and NEON are part of the baseline on the targets where these are defined so no runtime dispatch is needed
+#if defined(VS_TARGET_CPU_X86)
+#include <emmintrin.h>
+#elif defined(VS_TARGET_CPU_AARCH64)
+#include <arm_neon.h>
+#endif
+
+static inline void StoreLE16(uint8_t *Dst, unsigned Value) {
+    Dst[0] = static_cast<uint8_t>(Value);
+    Dst[1] = static_cast<uint8_t>(Value >> 8);
+}
+
+static inline void StoreLE32(uint8_t *Dst, uint32_t Value) {
+    Dst[0] = static_cast<uint8_t>(Value);
+    Dst[1] = static_cast<uint8_t>(Value >> 8);
+    Dst[2] = static_cast<uint8_t>(Value >> 16);
+    Dst[3] = static_cast<uint8_t>(Value >> 24);
+}
+
+#if defined(VS_TARGET_CPU_X86)
+// Turns four RGB0 pixels into 12 bytes of RGB at the start of the register, the last 4 bytes are zero
+static inline __m128i CompactRGB0(__m128i P) {
+    __m128i first = _mm_and_si128(P, _mm_set1_epi64x(0x0000000000FFFFFFLL));
+    __m128i second = _mm_and_si128(_mm_srli_epi64(P, 8), _mm_set1_epi64x(0x0000FFFFFF000000LL));
+    __m128i six = _mm_or_si128(first, second);
+    __m128i low = _mm_and_si128(six, _mm_set_epi64x(0, 0x0000FFFFFFFFFFFFLL));
+    __m128i high = _mm_srli_si128(_mm_and_si128(six, _mm_set_epi64x(0x0000FFFFFFFFFFFFLL, 0)), 2);
+    return _mm_or_si128(low, high);
+}
+#endif
+
+void PackRowRGB24(const uint8_t *R, const uint8_t *G, const uint8_t *B, uint8_t *Dst, size_t Width) {
+    size_t x = 0;
+#if defined(VS_TARGET_CPU_X86)
+    const __m128i zero = _mm_setzero_si128();
+    for (; x + 16 <= Width; x += 16) {
+        __m128i r = _mm_loadu_si128(reinterpret_cast<const __m128i *>(R + x));
+        __m128i g = _mm_loadu_si128(reinterpret_cast<const __m128i *>(G + x));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(B + x));
+        __m128i rgLo = _mm_unpacklo_epi8(r, g);
+        __m128i rgHi = _mm_unpackhi_epi8(r, g);
+        __m128i bLo = _mm_unpacklo_epi8(b, zero);
+        __m128i bHi = _mm_unpackhi_epi8(b, zero);
+
+        // Each store writes 4 bytes of zeroes past its pixels which the next store overwrites
+        uint8_t *d = Dst + x * 3;
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(d + 0), CompactRGB0(_mm_unpacklo_epi16(rgLo, bLo)));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(d + 12), CompactRGB0(_mm_unpackhi_epi16(rgLo, bLo)));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(d + 24), CompactRGB0(_mm_unpacklo_epi16(rgHi, bHi)));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(d + 36), CompactRGB0(_mm_unpackhi_epi16(rgHi, bHi)));
+    }
+#elif defined(VS_TARGET_CPU_AARCH64)
+    for (; x + 16 <= Width; x += 16) {
+        uint8x16x3_t v;
+        v.val[0] = vld1q_u8(R + x);
+        v.val[1] = vld1q_u8(G + x);
+        v.val[2] = vld1q_u8(B + x);
+        vst3q_u8(Dst + x * 3, v);
+    }
+#endif
+    for (; x < Width; x++) {
+        Dst[x * 3 + 0] = R[x];
+        Dst[x * 3 + 1] = G[x];
+        Dst[x * 3 + 2] = B[x];
+    }
+}
+
+void PackRowBGRA(const uint8_t *R, const uint8_t *G, const uint8_t *B, const uint8_t *A, uint8_t *Dst, size_t Width) {
+    size_t x = 0;
+#if defined(VS_TARGET_CPU_X86)
+    const __m128i opaque = _mm_set1_epi8(-1);
+    for (; x + 16 <= Width; x += 16) {
+        __m128i r = _mm_loadu_si128(reinterpret_cast<const __m128i *>(R + x));
+        __m128i g = _mm_loadu_si128(reinterpret_cast<const __m128i *>(G + x));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(B + x));
+        __m128i a = A ? _mm_loadu_si128(reinterpret_cast<const __m128i *>(A + x)) : opaque;
+        __m128i bgLo = _mm_unpacklo_epi8(b, g);
+        __m128i bgHi = _mm_unpackhi_epi8(b, g);
+        __m128i raLo = _mm_unpacklo_epi8(r, a);
+        __m128i raHi = _mm_unpackhi_epi8(r, a);
+
+        __m128i *d = reinterpret_cast<__m128i *>(Dst + x * 4);
+        _mm_storeu_si128(d + 0, _mm_unpacklo_epi16(bgLo, raLo));
+        _mm_storeu_si128(d + 1, _mm_unpackhi_epi16(bgLo, raLo));
+        _mm_storeu_si128(d + 2, _mm_unpacklo_epi16(bgHi, raHi));
+        _mm_storeu_si128(d + 3, _mm_unpackhi_epi16(bgHi, raHi));
+    }
+#elif defined(VS_TARGET_CPU_AARCH64)
+    const uint8x16_t opaque = vdupq_n_u8(255);
+    for (; x + 16 <= Width; x += 16) {
+        uint8x16x4_t v;
+        v.val[0] = vld1q_u8(B + x);
+        v.val[1] = vld1q_u8(G + x);
+        v.val[2] = vld1q_u8(R + x);
+        v.val[3] = A ? vld1q_u8(A + x) : opaque;
+        vst4q_u8(Dst + x * 4, v);
+    }
+#endif
+    for (; x < Width; x++) {
+        Dst[x * 4 + 0] = B[x];
+        Dst[x * 4 + 1] = G[x];
+        Dst[x * 4 + 2] = R[x];
+        Dst[x * 4 + 3] = A ? A[x] : 255;
+    }
+}
+
+void PackRowYUYV(const uint8_t *Y, const uint8_t *U, const uint8_t *V, uint8_t *Dst, size_t Width) {
+    size_t x = 0;
+#if defined(VS_TARGET_CPU_X86)
+    for (; x + 16 <= Width; x += 16) {
+        __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i *>(Y + x));
+        __m128i u = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(U + x / 2));
+        __m128i v = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(V + x / 2));
+        __m128i uv = _mm_unpacklo_epi8(u, v);
+
+        __m128i *d = reinterpret_cast<__m128i *>(Dst + x * 2);
+        _mm_storeu_si128(d + 0, _mm_unpacklo_epi8(y, uv));
+        _mm_storeu_si128(d + 1, _mm_unpackhi_epi8(y, uv));
+    }
+#elif defined(VS_TARGET_CPU_AARCH64)
+    for (; x + 16 <= Width; x += 16) {
+        uint8x16_t y = vld1q_u8(Y + x);
+        uint8x8x2_t evenOdd = vuzp_u8(vget_low_u8(y), vget_high_u8(y));
+        uint8x8x4_t v;
+        v.val[0] = evenOdd.val[0];
+        v.val[1] = vld1_u8(U + x / 2);
+        v.val[2] = evenOdd.val[1];
+        v.val[3] = vld1_u8(V + x / 2);
+        vst4_u8(Dst + x * 2, v);
+    }
+#endif
+    for (; x + 2 <= Width; x += 2) {
+        Dst[x * 2 + 0] = Y[x];
+        Dst[x * 2 + 1] = U[x / 2];
+        Dst[x * 2 + 2] = Y[x + 1];
+        Dst[x * 2 + 3] = V[x / 2];
+    }
+}
+
+void PackRowV210(const uint16_t *Y, const uint16_t *U, const uint16_t *V, uint8_t *Dst, size_t Width) {
+    size_t x = 0;
+    uint8_t *d = Dst;
+
+    for (; x + 6 <= Width; x += 6) {
+        const uint16_t *y = Y + x;
+        const uint16_t *u = U + x / 2;
+        const uint16_t *v = V + x / 2;
+        StoreLE32(d + 0, (u[0] & 0x3FF) | ((y[0] & 0x3FF) << 10) | (static_cast<uint32_t>(v[0] & 0x3FF) << 20));
+        StoreLE32(d + 4, (y[1] & 0x3FF) | ((u[1] & 0x3FF) << 10) | (static_cast<uint32_t>(y[2] & 0x3FF) << 20));
+        StoreLE32(d + 8, (v[1] & 0x3FF) | ((y[3] & 0x3FF) << 10) | (static_cast<uint32_t>(u[2] & 0x3FF) << 20));
+        StoreLE32(d + 12, (y[4] & 0x3FF) | ((v[2] & 0x3FF) << 10) | (static_cast<uint32_t>(y[5] & 0x3FF) << 20));
+        d += 16;
+    }
+
+    if (x < Width) {
+        uint16_t y[6] = {};
+        uint16_t u[3] = {};
+        uint16_t v[3] = {};
+        for (size_t i = 0; x + i < Width; i++) {
+            y[i] = Y[x + i];
+            if (!(i & 1)) {
+                u[i / 2] = U[(x + i) / 2];
+                v[i / 2] = V[(x + i) / 2];
+            }
+        }
+        StoreLE32(d + 0, (u[0] & 0x3FF) | ((y[0] & 0x3FF) << 10) | (static_cast<uint32_t>(v[0] & 0x3FF) << 20));
+        StoreLE32(d + 4, (y[1] & 0x3FF) | ((u[1] & 0x3FF) << 10) | (static_cast<uint32_t>(y[2] & 0x3FF) << 20));
+        StoreLE32(d + 8, (v[1] & 0x3FF) | ((y[3] & 0x3FF) << 10) | (static_cast<uint32_t>(u[2] & 0x3FF) << 20));
+        StoreLE32(d + 12, (y[4] & 0x3FF) | ((v[2] & 0x3FF) << 10) | (static_cast<uint32_t>(y[5] & 0x3FF) << 20));
+        d += 16;
+    }
+
+    memset(d, 0, Dst + V210RowSize(Width) - d);
+}
+
+void PackRowP010Luma(const uint16_t *Y, uint8_t *Dst, size_t Width) {
+    size_t x = 0;
+#if defined(VS_TARGET_CPU_X86)
+    for (; x + 8 <= Width; x += 8)
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(Dst + x * 2), _mm_slli_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(Y + x)), 6));
+#elif defined(VS_TARGET_CPU_AARCH64)
+    for (; x + 8 <= Width; x += 8)
+        vst1q_u8(Dst + x * 2, vreinterpretq_u8_u16(vshlq_n_u16(vld1q_u16(Y + x), 6)));
+#endif
+    for (; x < Width; x++)
+        StoreLE16(Dst + x * 2, Y[x] << 6);
+}
+
+void PackRowP010Chroma(const uint16_t *U, const uint16_t *V, uint8_t *Dst, size_t Width) {
+    size_t x = 0;
+#if defined(VS_TARGET_CPU_X86)
+    for (; x + 8 <= Width; x += 8) {
+        __m128i u = _mm_slli_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(U + x)), 6);
+        __m128i v = _mm_slli_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(V + x)), 6);
+        __m128i *d = reinterpret_cast<__m128i *>(Dst + x * 4);
+        _mm_storeu_si128(d + 0, _mm_unpacklo_epi16(u, v));
+        _mm_storeu_si128(d + 1, _mm_unpackhi_epi16(u, v));
+    }
+#elif defined(VS_TARGET_CPU_AARCH64)
+    for (; x + 8 <= Width; x += 8) {
+        uint16x8x2_t v;
+        v.val[0] = vshlq_n_u16(vld1q_u16(U + x), 6);
+        v.val[1] = vshlq_n_u16(vld1q_u16(V + x), 6);
+        vst2q_u16(reinterpret_cast<uint16_t *>(Dst + x * 4), v);
+    }
+#endif
+    for (; x < Width; x++) {
+        StoreLE16(Dst + x * 4 + 0, U[x] << 6);
+        StoreLE16(Dst + x * 4 + 2, V[x] << 6);
+    }
+}
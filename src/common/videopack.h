@@ -0,0 +1,49 @@
+/*
+* Copyright (c) 2026 vapoursynth-classic contributors
+*
+* This file is part of VapourSynth.
+*
+* VapourSynth is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 2.1 of the License, or (at your option) any later version.
+*
+* VapourSynth is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with VapourSynth; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef VIDEOPACK_H
+#define VIDEOPACK_H
+
+#include <cstdint>
+#include <cstddef>
+
+// Row functions that interleave planar video into the packed layouts other programs expect as raw input.
+// All of them may write up to VideoPackOverwrite bytes past the end of the row so the destination needs that much slack.
+
+static const size_t VideoPackOverwrite = 16;
+
+// R, G and B bytes
+void PackRowRGB24(const uint8_t *R, const uint8_t *G, const uint8_t *B, uint8_t *Dst, size_t Width);
+// B, G, R and A bytes, A is set to 255 when there is no alpha plane
+void PackRowBGRA(const uint8_t *R, const uint8_t *G, const uint8_t *B, const uint8_t *A, uint8_t *Dst, size_t Width);
+// Y0, U, Y1 and V bytes for every pair of pixels
+void PackRowYUYV(const uint8_t *Y, const uint8_t *U, const uint8_t *V, uint8_t *Dst, size_t Width);
+// 10 bit 4:2:2 with 6 pixels in every 16 bytes, the last group is padded with zeroes
+void PackRowV210(const uint16_t *Y, const uint16_t *U, const uint16_t *V, uint8_t *Dst, size_t Width);
+// 10 bit samples shifted into the top of 16 bit little endian words, the chroma row has U and V interleaved
+void PackRowP010Luma(const uint16_t *Y, uint8_t *Dst, size_t Width);
+void PackRowP010Chroma(const uint16_t *U, const uint16_t *V, uint8_t *Dst, size_t Width);
+
+// The byte size of a v210 row, it's always padded to a multiple of 128
+static inline size_t V210RowSize(size_t Width) {
+    return (Width + 47) / 48 * 128;
+}
+
+#endif
@@ -36,6 +36,7 @@
 
 #ifdef VS_TARGET_CPU_X86
 #include <emmintrin.h>
+#include "cpufeatures.h"
 #endif
 
 namespace {
@@ -163,7 +164,15 @@ static const VSFrame *VS_CC averageFramesGetFrame(int n, int activationReason, v
             bool chroma = (plane == 1 || plane == 2) && fi->colorFamily == cfYUV;
 
 #ifdef VS_TARGET_CPU_X86
-            if (vs_get_cpulevel(core) >= VS_CPU_LEVEL_SSE2) {
+            if (getCPUFeatures()->avx512_f && getCPUFeatures()->avx512_bw && vs_get_cpulevel(core) >= VS_CPU_LEVEL_AVX512) {
+                if (fi->bytesPerSample == 1)
+                    func = chroma ? vs_average_plane_byte_chroma_avx512 : vs_average_plane_byte_luma_avx512;
+                else if (fi->bytesPerSample == 2)
+                    func = chroma ? vs_average_plane_word_chroma_avx512 : vs_average_plane_word_luma_avx512;
+                else
+                    func = vs_average_plane_float_avx512;
+            }
+            if (!func && vs_get_cpulevel(core) >= VS_CPU_LEVEL_SSE2) {
                 if (fi->bytesPerSample == 1)
                     func = chroma ? vs_average_plane_byte_chroma_sse2 : vs_average_plane_byte_luma_sse2;
                 else if (fi->bytesPerSample == 2)
@@ -171,6 +180,15 @@ static const VSFrame *VS_CC averageFramesGetFrame(int n, int activationReason, v
                 else
                     func = vs_average_plane_float_sse2;
             }
+#elif defined(VS_TARGET_CPU_AARCH64)
+            if (vs_get_cpulevel(core) >= VS_CPU_LEVEL_NEON) {
+                if (fi->bytesPerSample == 1)
+                    func = chroma ? vs_average_plane_byte_chroma_neon : vs_average_plane_byte_luma_neon;
+                else if (fi->bytesPerSample == 2)
+                    func = chroma ? vs_average_plane_word_chroma_neon : vs_average_plane_word_luma_neon;
+                else
+                    func = vs_average_plane_float_neon;
+            }
 #endif
             if (!func) {
                 if (fi->bytesPerSample == 1)
@@ -27,6 +27,7 @@
 #include <cstdlib>
 #include <limits>
 #include <memory>
+#include <numeric>
 #include <string>
 #include <vector>
 #include "VapourSynth4.h"
@@ -97,6 +98,7 @@ enum GenericOperations {
     GenericMaximum,
 
     GenericMedian,
+    GenericPercentile,
 
     GenericDeflate,
     GenericInflate,
@@ -126,15 +128,32 @@ struct GenericDataExtra {
     // Minimum, Maximum
     uint8_t enable;
 
+    // Median, Percentile
+    int radius;
+    unsigned rank;
+
     // Convolution
     ConvolutionTypes convolution_type;
-    int matrix[25];
-    float matrixf[25];
+    int matrix[VS_GENERIC_MAX_CONV_SIZE * VS_GENERIC_MAX_CONV_SIZE];
+    float matrixf[VS_GENERIC_MAX_CONV_SIZE * VS_GENERIC_MAX_CONV_SIZE];
     int matrix_sum;
     int matrix_elements;
     float rdiv;
     float bias;
     bool saturate;
+    // 5x5 and 1D matrices of up to 25 elements keep the edge handling they had before larger sizes were added
+    bool legacy_edges;
+
+    // Convolution as a vertical pass followed by a horizontal pass
+    bool separable;
+    bool separable_int32;
+    bool square_int32;
+    int matrix_h[VS_GENERIC_MAX_CONV_SIZE];
+    int matrix_v[VS_GENERIC_MAX_CONV_SIZE];
+    float matrixf_h[VS_GENERIC_MAX_CONV_SIZE];
+    float matrixf_v[VS_GENERIC_MAX_CONV_SIZE];
+    int matrix_h_elements;
+    int matrix_v_elements;
 
     int cpulevel;
 };
@@ -208,6 +227,22 @@ static void templateInit(T& d, const char *name, bool allowVariableFormat, const
     getPlanesArg(in, d->process, vsapi);
 }
 
+static void checkConvolutionRadius(const GenericData *d, int width, int height) {
+    int size = d->matrix_elements;
+    if (d->convolution_type == ConvolutionSquare)
+        size = static_cast<int>(std::lround(std::sqrt(size)));
+
+    if (d->convolution_type != ConvolutionVertical && size / 2 >= width)
+        throw std::runtime_error("Width must be bigger than convolution radius.");
+    if (d->convolution_type != ConvolutionHorizontal && size / 2 >= height)
+        throw std::runtime_error("Height must be bigger than convolution radius.");
+}
+
+static void checkRankRadius(const GenericData *d, int width, int height) {
+    if (d->radius >= width || d->radius >= height)
+        throw std::runtime_error("radius must be smaller than the width and height of all planes.");
+}
+
 vs_generic_params make_generic_params(const GenericData *d, const VSVideoFormat *fi, int plane)
 {
     vs_generic_params params{};
@@ -217,6 +252,8 @@ vs_generic_params make_generic_params(const GenericData *d, const VSVideoFormat
     params.threshold = d->th;
     params.thresholdf = d->thf;
     params.stencil = d->enable;
+    params.radius = d->radius;
+    params.rank = d->rank;
 
     for (int i = 0; i < d->matrix_elements; ++i) {
         params.matrix[i] = d->matrix[i];
@@ -228,10 +265,93 @@ vs_generic_params make_generic_params(const GenericData *d, const VSVideoFormat
     params.bias = d->bias;
     params.saturate = d->saturate;
 
+    for (int i = 0; i < d->matrix_h_elements; ++i) {
+        params.matrix_h[i] = d->matrix_h[i];
+        params.matrixf_h[i] = d->matrixf_h[i];
+    }
+    for (int i = 0; i < d->matrix_v_elements; ++i) {
+        params.matrix_v[i] = d->matrix_v[i];
+        params.matrixf_v[i] = d->matrixf_v[i];
+    }
+    params.matrixsize_h = d->matrix_h_elements;
+    params.matrixsize_v = d->matrix_v_elements;
+
     return params;
 }
 
 #ifdef VS_TARGET_CPU_X86
+template <GenericOperations op>
+static decltype(&vs_generic_3x3_conv_byte_c) genericSelectAVX512(const VSVideoFormat *fi, GenericData *d) {
+    if (fi->sampleType == stInteger && fi->bytesPerSample == 1) {
+        switch (op) {
+        case GenericPrewitt: return vs_generic_3x3_prewitt_byte_avx512;
+        case GenericSobel: return vs_generic_3x3_sobel_byte_avx512;
+        case GenericMinimum: return vs_generic_3x3_min_byte_avx512;
+        case GenericMaximum: return vs_generic_3x3_max_byte_avx512;
+        case GenericMedian:
+            if (d->radius == 1)
+                return vs_generic_3x3_median_byte_avx512;
+            return vs_generic_rank_byte_avx512;
+        case GenericPercentile: return vs_generic_rank_byte_avx512;
+        case GenericDeflate: return vs_generic_3x3_deflate_byte_avx512;
+        case GenericInflate: return vs_generic_3x3_inflate_byte_avx512;
+        case GenericConvolution:
+            if (d->convolution_type == ConvolutionSquare && d->matrix_elements == 9)
+                return vs_generic_3x3_conv_byte_avx512;
+            else if (d->separable && d->separable_int32)
+                return vs_generic_separable_conv_byte_avx512;
+            else if (d->convolution_type == ConvolutionSquare && d->square_int32 && !d->legacy_edges)
+                return vs_generic_nxn_conv_byte_avx512;
+            break;
+        }
+    } else if (fi->sampleType == stInteger && fi->bytesPerSample == 2) {
+        switch (op) {
+        case GenericPrewitt: return vs_generic_3x3_prewitt_word_avx512;
+        case GenericSobel: return vs_generic_3x3_sobel_word_avx512;
+        case GenericMinimum: return vs_generic_3x3_min_word_avx512;
+        case GenericMaximum: return vs_generic_3x3_max_word_avx512;
+        case GenericMedian:
+            if (d->radius == 1)
+                return vs_generic_3x3_median_word_avx512;
+            return vs_generic_rank_word_avx512;
+        case GenericPercentile: return vs_generic_rank_word_avx512;
+        case GenericDeflate: return vs_generic_3x3_deflate_word_avx512;
+        case GenericInflate: return vs_generic_3x3_inflate_word_avx512;
+        case GenericConvolution:
+            if (d->convolution_type == ConvolutionSquare && d->matrix_elements == 9)
+                return vs_generic_3x3_conv_word_avx512;
+            else if (d->separable && d->separable_int32)
+                return vs_generic_separable_conv_word_avx512;
+            else if (d->convolution_type == ConvolutionSquare && d->square_int32 && !d->legacy_edges)
+                return vs_generic_nxn_conv_word_avx512;
+            break;
+        }
+    } else if (fi->sampleType == stFloat && fi->bytesPerSample == 4) {
+        switch (op) {
+        case GenericPrewitt: return vs_generic_3x3_prewitt_float_avx512;
+        case GenericSobel: return vs_generic_3x3_sobel_float_avx512;
+        case GenericMinimum: return vs_generic_3x3_min_float_avx512;
+        case GenericMaximum: return vs_generic_3x3_max_float_avx512;
+        case GenericMedian:
+            if (d->radius == 1)
+                return vs_generic_3x3_median_float_avx512;
+            break;
+        case GenericPercentile: break;
+        case GenericDeflate: return vs_generic_3x3_deflate_float_avx512;
+        case GenericInflate: return vs_generic_3x3_inflate_float_avx512;
+        case GenericConvolution:
+            if (d->convolution_type == ConvolutionSquare && d->matrix_elements == 9)
+                return vs_generic_3x3_conv_float_avx512;
+            else if (d->separable && d->separable_int32)
+                return vs_generic_separable_conv_float_avx512;
+            else if (d->convolution_type == ConvolutionSquare && d->square_int32 && !d->legacy_edges)
+                return vs_generic_nxn_conv_float_avx512;
+            break;
+        }
+    }
+    return nullptr;
+}
+
 template <GenericOperations op>
 static decltype(&vs_generic_3x3_conv_byte_c) genericSelectAVX2(const VSVideoFormat *fi, GenericData *d) {
     if (fi->sampleType == stInteger && fi->bytesPerSample == 1) {
@@ -240,12 +360,18 @@ static decltype(&vs_generic_3x3_conv_byte_c) genericSelectAVX2(const VSVideoForm
         case GenericSobel: return vs_generic_3x3_sobel_byte_avx2;
         case GenericMinimum: return vs_generic_3x3_min_byte_avx2;
         case GenericMaximum: return vs_generic_3x3_max_byte_avx2;
-        case GenericMedian: return vs_generic_3x3_median_byte_avx2;
+        case GenericMedian:
+            if (d->radius == 1)
+                return vs_generic_3x3_median_byte_avx2;
+            return vs_generic_rank_byte_avx2;
+        case GenericPercentile: return vs_generic_rank_byte_avx2;
         case GenericDeflate: return vs_generic_3x3_deflate_byte_avx2;
         case GenericInflate: return vs_generic_3x3_inflate_byte_avx2;
         case GenericConvolution:
             if (d->convolution_type == ConvolutionSquare && d->matrix_elements == 9)
                 return vs_generic_3x3_conv_byte_avx2;
+            else if (d->separable && d->separable_int32)
+                return vs_generic_separable_conv_byte_avx2;
             break;
         }
     } else if (fi->sampleType == stInteger && fi->bytesPerSample == 2) {
@@ -254,12 +380,18 @@ static decltype(&vs_generic_3x3_conv_byte_c) genericSelectAVX2(const VSVideoForm
         case GenericSobel: return vs_generic_3x3_sobel_word_avx2;
         case GenericMinimum: return vs_generic_3x3_min_word_avx2;
         case GenericMaximum: return vs_generic_3x3_max_word_avx2;
-        case GenericMedian: return vs_generic_3x3_median_word_avx2;
+        case GenericMedian:
+            if (d->radius == 1)
+                return vs_generic_3x3_median_word_avx2;
+            return vs_generic_rank_word_avx2;
+        case GenericPercentile: return vs_generic_rank_word_avx2;
         case GenericDeflate: return vs_generic_3x3_deflate_word_avx2;
         case GenericInflate: return vs_generic_3x3_inflate_word_avx2;
         case GenericConvolution:
             if (d->convolution_type == ConvolutionSquare && d->matrix_elements == 9)
                 return vs_generic_3x3_conv_word_avx2;
+            else if (d->separable && d->separable_int32)
+                return vs_generic_separable_conv_word_avx2;
             break;
         }
     } else if (fi->sampleType == stFloat && fi->bytesPerSample == 4) {
@@ -268,12 +400,18 @@ static decltype(&vs_generic_3x3_conv_byte_c) genericSelectAVX2(const VSVideoForm
         case GenericSobel: return vs_generic_3x3_sobel_float_avx2;
         case GenericMinimum: return vs_generic_3x3_min_float_avx2;
         case GenericMaximum: return vs_generic_3x3_max_float_avx2;
-        case GenericMedian: return vs_generic_3x3_median_float_avx2;
+        case GenericMedian:
+            if (d->radius == 1)
+                return vs_generic_3x3_median_float_avx2;
+            break;
+        case GenericPercentile: break;
         case GenericDeflate: return vs_generic_3x3_deflate_float_avx2;
         case GenericInflate: return vs_generic_3x3_inflate_float_avx2;
         case GenericConvolution:
             if (d->convolution_type == ConvolutionSquare && d->matrix_elements == 9)
                 return vs_generic_3x3_conv_float_avx2;
+            else if (d->separable && d->separable_int32)
+                return vs_generic_separable_conv_float_avx2;
             break;
         }
     }
@@ -288,7 +426,11 @@ static decltype(&vs_generic_3x3_conv_byte_c) genericSelectSSE2(const VSVideoForm
         case GenericSobel: return vs_generic_3x3_sobel_byte_sse2;
         case GenericMinimum: return vs_generic_3x3_min_byte_sse2;
         case GenericMaximum: return vs_generic_3x3_max_byte_sse2;
-        case GenericMedian: return vs_generic_3x3_median_byte_sse2;
+        case GenericMedian:
+            if (d->radius == 1)
+                return vs_generic_3x3_median_byte_sse2;
+            break;
+        case GenericPercentile: break;
         case GenericDeflate: return vs_generic_3x3_deflate_byte_sse2;
         case GenericInflate: return vs_generic_3x3_inflate_byte_sse2;
         case GenericConvolution:
@@ -302,7 +444,11 @@ static decltype(&vs_generic_3x3_conv_byte_c) genericSelectSSE2(const VSVideoForm
         case GenericSobel: return vs_generic_3x3_sobel_word_sse2;
         case GenericMinimum: return vs_generic_3x3_min_word_sse2;
         case GenericMaximum: return vs_generic_3x3_max_word_sse2;
-        case GenericMedian: return vs_generic_3x3_median_word_sse2;
+        case GenericMedian:
+            if (d->radius == 1)
+                return vs_generic_3x3_median_word_sse2;
+            break;
+        case GenericPercentile: break;
         case GenericDeflate: return vs_generic_3x3_deflate_word_sse2;
         case GenericInflate: return vs_generic_3x3_inflate_word_sse2;
         case GenericConvolution:
@@ -316,7 +462,11 @@ static decltype(&vs_generic_3x3_conv_byte_c) genericSelectSSE2(const VSVideoForm
         case GenericSobel: return vs_generic_3x3_sobel_float_sse2;
         case GenericMinimum: return vs_generic_3x3_min_float_sse2;
         case GenericMaximum: return vs_generic_3x3_max_float_sse2;
-        case GenericMedian: return vs_generic_3x3_median_float_sse2;
+        case GenericMedian:
+            if (d->radius == 1)
+                return vs_generic_3x3_median_float_sse2;
+            break;
+        case GenericPercentile: break;
         case GenericDeflate: return vs_generic_3x3_deflate_float_sse2;
         case GenericInflate: return vs_generic_3x3_inflate_float_sse2;
         case GenericConvolution:
@@ -327,6 +477,72 @@ static decltype(&vs_generic_3x3_conv_byte_c) genericSelectSSE2(const VSVideoForm
     }
     return nullptr;
 }
+#elif defined(VS_TARGET_CPU_AARCH64)
+template <GenericOperations op>
+static decltype(&vs_generic_3x3_conv_byte_c) genericSelectNEON(const VSVideoFormat *fi, GenericData *d) {
+    if (fi->sampleType == stInteger && fi->bytesPerSample == 1) {
+        switch (op) {
+        case GenericPrewitt: return vs_generic_3x3_prewitt_byte_neon;
+        case GenericSobel: return vs_generic_3x3_sobel_byte_neon;
+        case GenericMinimum: return vs_generic_3x3_min_byte_neon;
+        case GenericMaximum: return vs_generic_3x3_max_byte_neon;
+        case GenericMedian:
+            if (d->radius == 1)
+                return vs_generic_3x3_median_byte_neon;
+            return vs_generic_rank_byte_neon;
+        case GenericPercentile: return vs_generic_rank_byte_neon;
+        case GenericDeflate: return vs_generic_3x3_deflate_byte_neon;
+        case GenericInflate: return vs_generic_3x3_inflate_byte_neon;
+        case GenericConvolution:
+            if (d->convolution_type == ConvolutionSquare && d->matrix_elements == 9)
+                return vs_generic_3x3_conv_byte_neon;
+            else if (d->separable && d->separable_int32)
+                return vs_generic_separable_conv_byte_neon;
+            break;
+        }
+    } else if (fi->sampleType == stInteger && fi->bytesPerSample == 2) {
+        switch (op) {
+        case GenericPrewitt: return vs_generic_3x3_prewitt_word_neon;
+        case GenericSobel: return vs_generic_3x3_sobel_word_neon;
+        case GenericMinimum: return vs_generic_3x3_min_word_neon;
+        case GenericMaximum: return vs_generic_3x3_max_word_neon;
+        case GenericMedian:
+            if (d->radius == 1)
+                return vs_generic_3x3_median_word_neon;
+            return vs_generic_rank_word_neon;
+        case GenericPercentile: return vs_generic_rank_word_neon;
+        case GenericDeflate: return vs_generic_3x3_deflate_word_neon;
+        case GenericInflate: return vs_generic_3x3_inflate_word_neon;
+        case GenericConvolution:
+            if (d->convolution_type == ConvolutionSquare && d->matrix_elements == 9)
+                return vs_generic_3x3_conv_word_neon;
+            else if (d->separable && d->separable_int32)
+                return vs_generic_separable_conv_word_neon;
+            break;
+        }
+    } else if (fi->sampleType == stFloat && fi->bytesPerSample == 4) {
+        switch (op) {
+        case GenericPrewitt: return vs_generic_3x3_prewitt_float_neon;
+        case GenericSobel: return vs_generic_3x3_sobel_float_neon;
+        case GenericMinimum: return vs_generic_3x3_min_float_neon;
+        case GenericMaximum: return vs_generic_3x3_max_float_neon;
+        case GenericMedian:
+            if (d->radius == 1)
+                return vs_generic_3x3_median_float_neon;
+            break;
+        case GenericPercentile: break;
+        case GenericDeflate: return vs_generic_3x3_deflate_float_neon;
+        case GenericInflate: return vs_generic_3x3_inflate_float_neon;
+        case GenericConvolution:
+            if (d->convolution_type == ConvolutionSquare && d->matrix_elements == 9)
+                return vs_generic_3x3_conv_float_neon;
+            else if (d->separable && d->separable_int32)
+                return vs_generic_separable_conv_float_neon;
+            break;
+        }
+    }
+    return nullptr;
+}
 #endif
 
 template <GenericOperations op>
@@ -337,14 +553,22 @@ static decltype(&vs_generic_3x3_conv_byte_c) genericSelectC(const VSVideoFormat
         case GenericSobel: return vs_generic_3x3_sobel_byte_c;
         case GenericMinimum: return vs_generic_3x3_min_byte_c;
         case GenericMaximum: return vs_generic_3x3_max_byte_c;
-        case GenericMedian: return vs_generic_3x3_median_byte_c;
+        case GenericMedian:
+            if (d->radius == 1)
+                return vs_generic_3x3_median_byte_c;
+            return vs_generic_rank_byte_c;
+        case GenericPercentile: return vs_generic_rank_byte_c;
         case GenericDeflate: return vs_generic_3x3_deflate_byte_c;
         case GenericInflate: return vs_generic_3x3_inflate_byte_c;
         case GenericConvolution:
             if (d->convolution_type == ConvolutionSquare && d->matrix_elements == 9)
                 return vs_generic_3x3_conv_byte_c;
+            else if (d->separable)
+                return vs_generic_separable_conv_byte_c;
             else if (d->convolution_type == ConvolutionSquare && d->matrix_elements == 25)
                 return vs_generic_5x5_conv_byte_c;
+            else if (d->convolution_type == ConvolutionSquare)
+                return vs_generic_nxn_conv_byte_c;
             else if (d->convolution_type == ConvolutionHorizontal)
                 return vs_generic_1d_conv_h_byte_c;
             else if (d->convolution_type == ConvolutionVertical)
@@ -357,14 +581,22 @@ static decltype(&vs_generic_3x3_conv_byte_c) genericSelectC(const VSVideoFormat
         case GenericSobel: return vs_generic_3x3_sobel_word_c;
         case GenericMinimum: return vs_generic_3x3_min_word_c;
         case GenericMaximum: return vs_generic_3x3_max_word_c;
-        case GenericMedian: return vs_generic_3x3_median_word_c;
+        case GenericMedian:
+            if (d->radius == 1)
+                return vs_generic_3x3_median_word_c;
+            return vs_generic_rank_word_c;
+        case GenericPercentile: return vs_generic_rank_word_c;
         case GenericDeflate: return vs_generic_3x3_deflate_word_c;
         case GenericInflate: return vs_generic_3x3_inflate_word_c;
         case GenericConvolution:
             if (d->convolution_type == ConvolutionSquare && d->matrix_elements == 9)
                 return vs_generic_3x3_conv_word_c;
+            else if (d->separable)
+                return vs_generic_separable_conv_word_c;
             else if (d->convolution_type == ConvolutionSquare && d->matrix_elements == 25)
                 return vs_generic_5x5_conv_word_c;
+            else if (d->convolution_type == ConvolutionSquare)
+                return vs_generic_nxn_conv_word_c;
             else if (d->convolution_type == ConvolutionHorizontal)
                 return vs_generic_1d_conv_h_word_c;
             else if (d->convolution_type == ConvolutionVertical)
@@ -377,14 +609,22 @@ static decltype(&vs_generic_3x3_conv_byte_c) genericSelectC(const VSVideoFormat
         case GenericSobel: return vs_generic_3x3_sobel_float_c;
         case GenericMinimum: return vs_generic_3x3_min_float_c;
         case GenericMaximum: return vs_generic_3x3_max_float_c;
-        case GenericMedian: return vs_generic_3x3_median_float_c;
+        case GenericMedian:
+            if (d->radius == 1)
+                return vs_generic_3x3_median_float_c;
+            return vs_generic_rank_float_c;
+        case GenericPercentile: return vs_generic_rank_float_c;
         case GenericDeflate: return vs_generic_3x3_deflate_float_c;
         case GenericInflate: return vs_generic_3x3_inflate_float_c;
         case GenericConvolution:
             if (d->convolution_type == ConvolutionSquare && d->matrix_elements == 9)
                 return vs_generic_3x3_conv_float_c;
+            else if (d->separable)
+                return vs_generic_separable_conv_float_c;
             else if (d->convolution_type == ConvolutionSquare && d->matrix_elements == 25)
                 return vs_generic_5x5_conv_float_c;
+            else if (d->convolution_type == ConvolutionSquare)
+                return vs_generic_nxn_conv_float_c;
             else if (d->convolution_type == ConvolutionHorizontal)
                 return vs_generic_1d_conv_h_float_c;
             else if (d->convolution_type == ConvolutionVertical)
@@ -410,7 +650,10 @@ static const VSFrame *VS_CC genericGetframe(int n, int activationReason, void *i
                 throw std::runtime_error("Frame must be constant format and of integer 8-16 bit type or 32 bit float, passed " + videoFormatToName(*fi, vsapi) + ".");
             if (vsapi->getFrameWidth(src, fi->numPlanes - 1) < 4 || vsapi->getFrameHeight(src, fi->numPlanes - 1) < 4)
                 throw std::runtime_error("Cannot process frames with subsampled planes smaller than 4x4.");
-
+            if (op == GenericConvolution)
+                checkConvolutionRadius(d, vsapi->getFrameWidth(src, fi->numPlanes - 1), vsapi->getFrameHeight(src, fi->numPlanes - 1));
+            if (op == GenericMedian || op == GenericPercentile)
+                checkRankRadius(d, vsapi->getFrameWidth(src, fi->numPlanes - 1), vsapi->getFrameHeight(src, fi->numPlanes - 1));
         } catch (const std::runtime_error &error) {
             vsapi->setFilterError((d->filter_name + ": "_s + error.what()).c_str(), frameCtx);
             vsapi->freeFrame(src);
@@ -429,10 +672,15 @@ static const VSFrame *VS_CC genericGetframe(int n, int activationReason, void *i
         void (*func)(const void *, ptrdiff_t, void *, ptrdiff_t, const vs_generic_params *, unsigned, unsigned) = nullptr;
 
 #ifdef VS_TARGET_CPU_X86
-        if (getCPUFeatures()->avx2 && d->cpulevel >= VS_CPU_LEVEL_AVX2)
+        if (getCPUFeatures()->avx512_f && getCPUFeatures()->avx512_bw && d->cpulevel >= VS_CPU_LEVEL_AVX512)
+            func = genericSelectAVX512<op>(fi, d);
+        if (!func && getCPUFeatures()->avx2 && d->cpulevel >= VS_CPU_LEVEL_AVX2)
             func = genericSelectAVX2<op>(fi, d);
         if (!func && d->cpulevel >= VS_CPU_LEVEL_SSE2)
             func = genericSelectSSE2<op>(fi, d);
+#elif defined(VS_TARGET_CPU_AARCH64)
+        if (d->cpulevel >= VS_CPU_LEVEL_NEON)
+            func = genericSelectNEON<op>(fi, d);
 #endif
         if (!func)
             func = genericSelectC<op>(fi, d);
@@ -467,6 +715,72 @@ static inline int64_t floatToInt64S(float f) {
         return static_cast<int64_t>(llround(f));
 }
 
+// Splits a square matrix into a vertical and a horizontal vector whose outer product is the matrix. Integer
+// factors are exact, so the separable result is identical to the full 2D convolution.
+static bool factorizeConvolution(GenericData *d, bool integer) {
+    int size = static_cast<int>(std::lround(std::sqrt(d->matrix_elements)));
+
+    if (integer) {
+        int pivot = -1;
+        for (int i = 0; i < d->matrix_elements && pivot < 0; i++)
+            if (d->matrix[i])
+                pivot = i / size;
+        if (pivot < 0)
+            return false;
+
+        int gcd = 0;
+        for (int j = 0; j < size; j++)
+            gcd = std::gcd(gcd, d->matrix[pivot * size + j]);
+
+        int col = -1;
+        for (int j = 0; j < size; j++) {
+            d->matrix_h[j] = d->matrix[pivot * size + j] / gcd;
+            if (col < 0 && d->matrix_h[j])
+                col = j;
+        }
+
+        for (int i = 0; i < size; i++) {
+            if (d->matrix[i * size + col] % d->matrix_h[col])
+                return false;
+            d->matrix_v[i] = d->matrix[i * size + col] / d->matrix_h[col];
+            for (int j = 0; j < size; j++)
+                if (d->matrix[i * size + j] != d->matrix_v[i] * d->matrix_h[j])
+                    return false;
+        }
+
+        for (int i = 0; i < size; i++) {
+            d->matrixf_h[i] = static_cast<float>(d->matrix_h[i]);
+            d->matrixf_v[i] = static_cast<float>(d->matrix_v[i]);
+        }
+    } else {
+        int pivot = 0;
+        for (int i = 1; i < d->matrix_elements; i++)
+            if (std::fabs(d->matrixf[i]) > std::fabs(d->matrixf[pivot]))
+                pivot = i;
+        double maxabs = std::fabs(d->matrixf[pivot]);
+        if (maxabs == 0)
+            return false;
+
+        int row = pivot / size;
+        int col = pivot % size;
+        for (int i = 0; i < size; i++) {
+            double h = d->matrixf[row * size + i];
+            double v = d->matrixf[i * size + col] / static_cast<double>(d->matrixf[pivot]);
+            for (int j = 0; j < size; j++)
+                if (std::fabs(d->matrixf[i * size + j] - v * d->matrixf[row * size + j]) > maxabs * 1e-6)
+                    return false;
+            d->matrixf_h[i] = static_cast<float>(h);
+            d->matrixf_v[i] = static_cast<float>(v);
+            d->matrix_h[i] = 0;
+            d->matrix_v[i] = 0;
+        }
+    }
+
+    d->matrix_h_elements = size;
+    d->matrix_v_elements = size;
+    return true;
+}
+
 template <GenericOperations op>
 static void VS_CC genericCreate(const VSMap *in, VSMap *out, void *userData, VSCore *core, const VSAPI *vsapi) {
     std::unique_ptr<GenericData> d(new GenericData(vsapi));
@@ -521,6 +835,34 @@ static void VS_CC genericCreate(const VSMap *in, VSMap *out, void *userData, VSC
         }
 
 
+        if (op == GenericMedian || op == GenericPercentile) {
+            d->radius = vsh::int64ToIntS(vsapi->mapGetInt(in, "radius", 0, &err));
+            if (err)
+                d->radius = 1;
+
+            // 16-bit histogram counts limit the window to 255x255
+            if (d->radius < 1 || d->radius > 127)
+                throw std::runtime_error("radius must be between 1 and 127.");
+
+            unsigned size = (2 * d->radius + 1) * (2 * d->radius + 1);
+
+            if (op == GenericPercentile) {
+                double percentile = vsapi->mapGetFloat(in, "percentile", 0, &err);
+                if (err)
+                    percentile = 50;
+
+                if (percentile < 0 || percentile > 100)
+                    throw std::runtime_error("percentile must be between 0 and 100.");
+
+                d->rank = static_cast<unsigned>(std::lround(percentile / 100 * (size - 1)));
+            } else {
+                d->rank = size / 2;
+            }
+
+            if (d->vi->height && d->vi->width)
+                checkRankRadius(d.get(), planeWidth(d->vi, d->vi->format.numPlanes - 1), planeHeight(d->vi, d->vi->format.numPlanes - 1));
+        }
+
         if (op == GenericPrewitt || op == GenericSobel) {
             d->scale = static_cast<float>(vsapi->mapGetFloat(in, "scale", 0, &err));
             if (err)
@@ -543,16 +885,17 @@ static void VS_CC genericCreate(const VSMap *in, VSMap *out, void *userData, VSC
             if (err || mode[0] == 's') {
                 d->convolution_type = ConvolutionSquare;
 
-                if (d->matrix_elements != 9 && d->matrix_elements != 25)
-                    throw std::runtime_error("When mode starts with 's', matrix must contain exactly 9 or exactly 25 numbers.");
+                int size = static_cast<int>(std::lround(std::sqrt(d->matrix_elements)));
+                if (size * size != d->matrix_elements || size % 2 == 0 || size < 3 || size > VS_GENERIC_MAX_CONV_SIZE)
+                    throw std::runtime_error("When mode starts with 's', matrix must contain N*N numbers, where N is odd and between 3 and 31.");
             } else if (mode[0] == 'h' || mode[0] == 'v') {
                 if (mode[0] == 'h')
                     d->convolution_type = ConvolutionHorizontal;
                 else
                     d->convolution_type = ConvolutionVertical;
 
-                if (d->matrix_elements < 3 || d->matrix_elements > 25)
-                    throw std::runtime_error("When mode starts with 'h' or 'v', matrix must contain between 3 and 25 numbers.");
+                if (d->matrix_elements < 3 || d->matrix_elements > VS_GENERIC_MAX_CONV_SIZE)
+                    throw std::runtime_error("When mode starts with 'h' or 'v', matrix must contain between 3 and 31 numbers.");
 
                 if (d->matrix_elements % 2 == 0)
                     throw std::runtime_error("matrix must contain an odd number of numbers.");
@@ -632,12 +975,46 @@ static void VS_CC genericCreate(const VSMap *in, VSMap *out, void *userData, VSC
                 d->matrixf[6] = 0.f;
                 d->matrixf[8] = 0.f;
             }
-        }
 
-        if (op == GenericConvolution && d->convolution_type == ConvolutionHorizontal && d->matrix_elements / 2 >= planeWidth(d->vi, d->vi->format.numPlanes - 1))
-            throw std::runtime_error("Width must be bigger than convolution radius.");
-        if (op == GenericConvolution && d->convolution_type == ConvolutionVertical && d->matrix_elements / 2 >= planeHeight(d->vi, d->vi->format.numPlanes - 1))
-            throw std::runtime_error("Height must be bigger than convolution radius.");
+            // only the C kernels reproduce the old edges so these never get the separable paths
+            d->legacy_edges = d->convolution_type == ConvolutionSquare ? d->matrix_elements == 25 : d->matrix_elements <= 25;
+
+            if (d->convolution_type == ConvolutionSquare && d->matrix_elements > 9 && !d->legacy_edges) {
+                d->separable = factorizeConvolution(d.get(), d->vi->format.sampleType == stInteger);
+            } else if (d->convolution_type != ConvolutionSquare && !d->legacy_edges) {
+                // A 1D convolution is a separable one with a single tap in the other direction
+                bool horizontal = d->convolution_type == ConvolutionHorizontal;
+                d->separable = true;
+                d->matrix_h_elements = horizontal ? d->matrix_elements : 1;
+                d->matrix_v_elements = horizontal ? 1 : d->matrix_elements;
+                for (int i = 0; i < d->matrix_elements; i++) {
+                    (horizontal ? d->matrix_h : d->matrix_v)[i] = d->matrix[i];
+                    (horizontal ? d->matrixf_h : d->matrixf_v)[i] = d->matrixf[i];
+                }
+                (horizontal ? d->matrix_v : d->matrix_h)[0] = 1;
+                (horizontal ? d->matrixf_v : d->matrixf_h)[0] = 1.f;
+            }
+
+            if (d->separable) {
+                int64_t sum_h = 0;
+                int64_t sum_v = 0;
+                for (int i = 0; i < d->matrix_h_elements; i++)
+                    sum_h += std::abs(d->matrix_h[i]);
+                for (int i = 0; i < d->matrix_v_elements; i++)
+                    sum_v += std::abs(d->matrix_v[i]);
+                d->separable_int32 = d->vi->format.sampleType == stFloat || ((1 << d->vi->format.bitsPerSample) - 1) * sum_h * sum_v <= std::numeric_limits<int32_t>::max();
+            }
+
+            if (d->convolution_type == ConvolutionSquare) {
+                int64_t sum = 0;
+                for (int i = 0; i < d->matrix_elements; i++)
+                    sum += std::abs(d->matrix[i]);
+                d->square_int32 = d->vi->format.sampleType == stFloat || ((1 << d->vi->format.bitsPerSample) - 1) * sum <= std::numeric_limits<int32_t>::max();
+            }
+
+            if (d->convolution_type != ConvolutionSquare || (d->vi->width && d->vi->height))
+                checkConvolutionRadius(d.get(), planeWidth(d->vi, d->vi->format.numPlanes - 1), planeHeight(d->vi, d->vi->format.numPlanes - 1));
+        }
 
         d->cpulevel = vs_get_cpulevel(core);
     } catch (const std::runtime_error &error) {
@@ -1016,10 +1393,19 @@ void genericInitialize(VSPlugin *plugin, const VSPLUGINAPI *vspapi) {
 
     vspapi->registerFunction("Median",
             "clip:vnode;"
-            "planes:int[]:opt;",
+            "planes:int[]:opt;"
+            "radius:int:opt;",
             "clip:vnode;",
             genericCreate<GenericMedian>, const_cast<char *>("Median"), plugin);
 
+    vspapi->registerFunction("Percentile",
+            "clip:vnode;"
+            "percentile:float:opt;"
+            "radius:int:opt;"
+            "planes:int[]:opt;",
+            "clip:vnode;",
+            genericCreate<GenericPercentile>, const_cast<char *>("Percentile"), plugin);
+
     vspapi->registerFunction("Deflate",
             "clip:vnode;"
             "planes:int[]:opt;"
@@ -0,0 +1,207 @@
+#include <assert.h>
+#include <stdint.h>
+#include <arm_neon.h>
+#include "VSHelper4.h"
+#include "../average.h"
+
+static int32x4_t scale_int(int32x4_t x, float32x4_t scale)
+{
+	return vcvtnq_s32_f32(vmulq_f32(vcvtq_f32_s32(x), scale));
+}
+
+void vs_average_plane_byte_luma_neon(const void *weights_, const void * const *srcs_, unsigned num_srcs, void *dst_, const void *scale_, unsigned depth, unsigned w, unsigned h, ptrdiff_t stride)
+{
+	const uint8_t * const *srcs = (const uint8_t * const *)srcs_;
+	const int *weights = weights_;
+	float32x4_t scale = vdupq_n_f32(1.0f / *(const int *)scale_);
+	ptrdiff_t offset = 0;
+	unsigned i, j, k;
+
+	assert(num_srcs <= 32);
+
+	for (i = 0; i < h; ++i) {
+		uint8_t *dst = (uint8_t *)dst_ + offset;
+
+		for (j = 0; j < w; j += 16) {
+			int32x4_t lolo = vdupq_n_s32(0);
+			int32x4_t lohi = vdupq_n_s32(0);
+			int32x4_t hilo = vdupq_n_s32(0);
+			int32x4_t hihi = vdupq_n_s32(0);
+			int16x8_t lo, hi;
+
+			for (k = 0; k < num_srcs; ++k) {
+				int16_t coeff = weights[k];
+				uint8x16_t v = vld1q_u8(srcs[k] + offset + j);
+				int16x8_t v_lo = vreinterpretq_s16_u16(vmovl_u8(vget_low_u8(v)));
+				int16x8_t v_hi = vreinterpretq_s16_u16(vmovl_high_u8(v));
+
+				lolo = vmlal_n_s16(lolo, vget_low_s16(v_lo), coeff);
+				lohi = vmlal_high_n_s16(lohi, v_lo, coeff);
+				hilo = vmlal_n_s16(hilo, vget_low_s16(v_hi), coeff);
+				hihi = vmlal_high_n_s16(hihi, v_hi, coeff);
+			}
+
+			lo = vcombine_s16(vqmovn_s32(scale_int(lolo, scale)), vqmovn_s32(scale_int(lohi, scale)));
+			hi = vcombine_s16(vqmovn_s32(scale_int(hilo, scale)), vqmovn_s32(scale_int(hihi, scale)));
+
+			vst1q_u8(dst + j, vcombine_u8(vqmovun_s16(lo), vqmovun_s16(hi)));
+		}
+
+		offset += stride;
+	}
+}
+
+void vs_average_plane_byte_chroma_neon(const void *weights_, const void * const *srcs_, unsigned num_srcs, void *dst_, const void *scale_, unsigned depth, unsigned w, unsigned h, ptrdiff_t stride)
+{
+	const uint8_t * const *srcs = (const uint8_t * const *)srcs_;
+	const int *weights = weights_;
+	float32x4_t scale = vdupq_n_f32(1.0f / *(const int *)scale_);
+	int16x8_t bias_i16 = vdupq_n_s16(128);
+	uint8x16_t bias_i8 = vdupq_n_u8(128);
+	ptrdiff_t offset = 0;
+	unsigned i, j, k;
+
+	assert(num_srcs <= 32);
+
+	for (i = 0; i < h; ++i) {
+		uint8_t *dst = (uint8_t *)dst_ + offset;
+
+		for (j = 0; j < w; j += 16) {
+			int32x4_t lolo = vdupq_n_s32(0);
+			int32x4_t lohi = vdupq_n_s32(0);
+			int32x4_t hilo = vdupq_n_s32(0);
+			int32x4_t hihi = vdupq_n_s32(0);
+			int16x8_t lo, hi;
+			int8x16_t result;
+
+			for (k = 0; k < num_srcs; ++k) {
+				int16_t coeff = weights[k];
+				uint8x16_t v = vld1q_u8(srcs[k] + offset + j);
+				int16x8_t v_lo = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vget_low_u8(v))), bias_i16);
+				int16x8_t v_hi = vsubq_s16(vreinterpretq_s16_u16(vmovl_high_u8(v)), bias_i16);
+
+				lolo = vmlal_n_s16(lolo, vget_low_s16(v_lo), coeff);
+				lohi = vmlal_high_n_s16(lohi, v_lo, coeff);
+				hilo = vmlal_n_s16(hilo, vget_low_s16(v_hi), coeff);
+				hihi = vmlal_high_n_s16(hihi, v_hi, coeff);
+			}
+
+			lo = vcombine_s16(vqmovn_s32(scale_int(lolo, scale)), vqmovn_s32(scale_int(lohi, scale)));
+			hi = vcombine_s16(vqmovn_s32(scale_int(hilo, scale)), vqmovn_s32(scale_int(hihi, scale)));
+			result = vcombine_s8(vqmovn_s16(lo), vqmovn_s16(hi));
+
+			vst1q_u8(dst + j, vaddq_u8(vreinterpretq_u8_s8(result), bias_i8));
+		}
+
+		offset += stride;
+	}
+}
+
+void vs_average_plane_word_luma_neon(const void *weights_, const void * const *srcs_, unsigned num_srcs, void *dst_, const void *scale_, unsigned depth, unsigned w, unsigned h, ptrdiff_t stride)
+{
+	const uint8_t * const *srcs = (const uint8_t * const *)srcs_;
+	const int *weights = weights_;
+	float32x4_t scale = vdupq_n_f32(1.0f / *(const int *)scale_);
+	uint16x8_t maxval = vdupq_n_u16((1U << depth) - 1);
+	ptrdiff_t offset = 0;
+	unsigned i, j, k;
+
+	assert(num_srcs <= 32);
+
+	for (i = 0; i < h; ++i) {
+		uint16_t *dst = (uint16_t *)((uint8_t *)dst_ + offset);
+
+		for (j = 0; j < w; j += 8) {
+			int32x4_t lo = vdupq_n_s32(0);
+			int32x4_t hi = vdupq_n_s32(0);
+			uint16x8_t result;
+
+			for (k = 0; k < num_srcs; ++k) {
+				const uint16_t *ptr = (const uint16_t *)(srcs[k] + offset);
+				uint16x8_t v = vld1q_u16(ptr + j);
+
+				lo = vmlaq_n_s32(lo, vreinterpretq_s32_u32(vmovl_u16(vget_low_u16(v))), weights[k]);
+				hi = vmlaq_n_s32(hi, vreinterpretq_s32_u32(vmovl_high_u16(v)), weights[k]);
+			}
+
+			result = vcombine_u16(vqmovun_s32(scale_int(lo, scale)), vqmovun_s32(scale_int(hi, scale)));
+			vst1q_u16(dst + j, vminq_u16(result, maxval));
+		}
+
+		offset += stride;
+	}
+}
+
+void vs_average_plane_word_chroma_neon(const void *weights_, const void * const *srcs_, unsigned num_srcs, void *dst_, const void *scale_, unsigned depth, unsigned w, unsigned h, ptrdiff_t stride)
+{
+	const uint8_t * const *srcs = (const uint8_t * const *)srcs_;
+	const int *weights = weights_;
+	float32x4_t scale = vdupq_n_f32(1.0f / *(const int *)scale_);
+	int16x8_t bias = vdupq_n_s16(1U << (depth - 1));
+	int16x8_t minval = vnegq_s16(bias);
+	int16x8_t maxval = vsubq_s16(vdupq_n_s16((1U << depth) - 1), bias);
+	int32x4_t accum_bias = vdupq_n_s32(0);
+	ptrdiff_t offset = 0;
+	unsigned i, j, k;
+
+	assert(num_srcs <= 32);
+
+	/* sum(weights * bias) */
+	for (k = 0; k < num_srcs; ++k) {
+		accum_bias = vaddq_s32(accum_bias, vdupq_n_s32(weights[k] * (1 << (depth - 1))));
+	}
+
+	for (i = 0; i < h; ++i) {
+		uint16_t *dst = (uint16_t *)((uint8_t *)dst_ + offset);
+
+		for (j = 0; j < w; j += 8) {
+			int32x4_t lo = vdupq_n_s32(0);
+			int32x4_t hi = vdupq_n_s32(0);
+			int16x8_t result;
+
+			for (k = 0; k < num_srcs; ++k) {
+				const uint16_t *ptr = (const uint16_t *)(srcs[k] + offset);
+				uint16x8_t v = vld1q_u16(ptr + j);
+
+				lo = vmlaq_n_s32(lo, vreinterpretq_s32_u32(vmovl_u16(vget_low_u16(v))), weights[k]);
+				hi = vmlaq_n_s32(hi, vreinterpretq_s32_u32(vmovl_high_u16(v)), weights[k]);
+			}
+			lo = vsubq_s32(lo, accum_bias);
+			hi = vsubq_s32(hi, accum_bias);
+
+			result = vcombine_s16(vqmovn_s32(scale_int(lo, scale)), vqmovn_s32(scale_int(hi, scale)));
+			result = vminq_s16(vmaxq_s16(result, minval), maxval);
+
+			vst1q_u16(dst + j, vreinterpretq_u16_s16(vaddq_s16(result, bias)));
+		}
+
+		offset += stride;
+	}
+}
+
+void vs_average_plane_float_neon(const void *weights_, const void * const *srcs, unsigned num_srcs, void *dst_, const void *scale_, unsigned depth, unsigned w, unsigned h, ptrdiff_t stride)
+{
+	const float *weights = weights_;
+	float32x4_t scale = vdupq_n_f32(1.0f / *(const float *)scale_);
+	ptrdiff_t offset = 0;
+	unsigned i, j, k;
+
+	assert(num_srcs <= 32);
+
+	for (i = 0; i < h; ++i) {
+		float *dst = (float *)((uint8_t *)dst_ + offset);
+
+		for (j = 0; j < w; j += 4) {
+			float32x4_t accum = vdupq_n_f32(0.0f);
+
+			for (k = 0; k < num_srcs; ++k) {
+				const float *ptr = (const float *)((const uint8_t *)srcs[k] + offset);
+				accum = vaddq_f32(accum, vmulq_n_f32(vld1q_f32(ptr + j), weights[k]));
+			}
+
+			vst1q_f32(dst + j, vmulq_f32(accum, scale));
+		}
+
+		offset += stride;
+	}
+}
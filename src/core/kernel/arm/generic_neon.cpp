@@ -0,0 +1,1291 @@
+/*
+* Copyright (c) 2012-2019 Fredrik Mellbin
+*
+* This file is part of VapourSynth.
+*
+* VapourSynth is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 2.1 of the License, or (at your option) any later version.
+*
+* VapourSynth is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with VapourSynth; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+#include <arm_neon.h>
+#include "../generic.h"
+#include "../rank.h"
+
+#ifdef _MSC_VER
+#define FORCE_INLINE inline __forceinline
+#else
+#define FORCE_INLINE inline __attribute__((always_inline))
+#endif
+
+namespace {
+
+template <class T>
+T *line_ptr(T *ptr, unsigned i, ptrdiff_t stride)
+{
+    return (T *)(((unsigned char *)ptr) + static_cast<ptrdiff_t>(i) * stride);
+}
+
+const uint8_t ascend8[16] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 };
+const uint16_t ascend16[8] = { 0, 1, 2, 3, 4, 5, 6, 7 };
+const uint32_t ascend32[4] = { 0, 1, 2, 3 };
+
+
+struct ByteTraits {
+    typedef uint8_t T;
+    typedef uint8x16_t vec_type;
+    static constexpr unsigned vec_len = 16;
+
+    static uint8x16_t load(const uint8_t *ptr) { return vld1q_u8(ptr); }
+    static uint8x16_t loadu(const uint8_t *ptr) { return vld1q_u8(ptr); }
+    static void store(uint8_t *ptr, uint8x16_t x) { vst1q_u8(ptr, x); }
+
+    static uint8x16_t shl_insert_lo(uint8x16_t x, uint8_t y)
+    {
+        return vextq_u8(vdupq_n_u8(y), x, 15);
+    }
+
+    static uint8x16_t shr_insert(uint8x16_t x, uint8_t y, unsigned idx)
+    {
+        uint8x16_t mask = vceqq_u8(vld1q_u8(ascend8), vdupq_n_u8(idx));
+        return vbslq_u8(mask, vdupq_n_u8(y), vextq_u8(x, vdupq_n_u8(0), 1));
+    }
+};
+
+struct WordTraits {
+    typedef uint16_t T;
+    typedef uint16x8_t vec_type;
+    static constexpr unsigned vec_len = 8;
+
+    static uint16x8_t load(const uint16_t *ptr) { return vld1q_u16(ptr); }
+    static uint16x8_t loadu(const uint16_t *ptr) { return vld1q_u16(ptr); }
+    static void store(uint16_t *ptr, uint16x8_t x) { vst1q_u16(ptr, x); }
+
+    static uint16x8_t shl_insert_lo(uint16x8_t x, uint16_t y)
+    {
+        return vextq_u16(vdupq_n_u16(y), x, 7);
+    }
+
+    static uint16x8_t shr_insert(uint16x8_t x, uint16_t y, unsigned idx)
+    {
+        uint16x8_t mask = vceqq_u16(vld1q_u16(ascend16), vdupq_n_u16(idx));
+        return vbslq_u16(mask, vdupq_n_u16(y), vextq_u16(x, vdupq_n_u16(0), 1));
+    }
+};
+
+struct FloatTraits {
+    typedef float T;
+    typedef float32x4_t vec_type;
+    static constexpr unsigned vec_len = 4;
+
+    static float32x4_t load(const float *ptr) { return vld1q_f32(ptr); }
+    static float32x4_t loadu(const float *ptr) { return vld1q_f32(ptr); }
+    static void store(float *ptr, float32x4_t x) { vst1q_f32(ptr, x); }
+
+    static float32x4_t shl_insert_lo(float32x4_t x, float y)
+    {
+        return vextq_f32(vdupq_n_f32(y), x, 3);
+    }
+
+    static float32x4_t shr_insert(float32x4_t x, float y, unsigned idx)
+    {
+        uint32x4_t mask = vceqq_u32(vld1q_u32(ascend32), vdupq_n_u32(idx));
+        return vbslq_f32(mask, vdupq_n_f32(y), vextq_f32(x, vdupq_n_f32(0.0f), 1));
+    }
+};
+
+// Widen the low or high half of a byte vector to signed 16-bit.
+FORCE_INLINE int16x8_t widen_lo(uint8x16_t x) { return vreinterpretq_s16_u16(vmovl_u8(vget_low_u8(x))); }
+FORCE_INLINE int16x8_t widen_hi(uint8x16_t x) { return vreinterpretq_s16_u16(vmovl_high_u8(x)); }
+
+// Widen the low or high half of a word vector to signed 32-bit.
+FORCE_INLINE int32x4_t widen_lo(uint16x8_t x) { return vreinterpretq_s32_u32(vmovl_u16(vget_low_u16(x))); }
+FORCE_INLINE int32x4_t widen_hi(uint16x8_t x) { return vreinterpretq_s32_u32(vmovl_high_u16(x)); }
+
+// Round to nearest even, as the C reference does, and saturate.
+FORCE_INLINE uint8x16_t pack_byte(float32x4_t lolo, float32x4_t lohi, float32x4_t hilo, float32x4_t hihi)
+{
+    int16x8_t lo = vcombine_s16(vqmovn_s32(vcvtnq_s32_f32(lolo)), vqmovn_s32(vcvtnq_s32_f32(lohi)));
+    int16x8_t hi = vcombine_s16(vqmovn_s32(vcvtnq_s32_f32(hilo)), vqmovn_s32(vcvtnq_s32_f32(hihi)));
+    return vcombine_u8(vqmovun_s16(lo), vqmovun_s16(hi));
+}
+
+FORCE_INLINE uint16x8_t pack_word(float32x4_t lo, float32x4_t hi, uint16x8_t maxval)
+{
+    uint16x8_t tmp = vcombine_u16(vqmovun_s32(vcvtnq_s32_f32(lo)), vqmovun_s32(vcvtnq_s32_f32(hi)));
+    return vminq_u16(tmp, maxval);
+}
+
+
+#define OP_ARGS const vec_type &a00_, const vec_type &a01_, const vec_type &a02_, const vec_type &a10_, const vec_type &a11_, const vec_type &a12_, const vec_type &a20_, const vec_type &a21_, const vec_type &a22_
+#define PROLOGUE() \
+  auto a00 = a00_; auto a01 = a01_; auto a02 = a02_; \
+  auto a10 = a10_; auto a11 = a11_; auto a12 = a12_; \
+  auto a20 = a20_; auto a21 = a21_; auto a22 = a22_;
+
+struct PrewittSobelTraits {
+    float scale;
+
+    explicit PrewittSobelTraits(const vs_generic_params &params) : scale{ params.scale } {}
+};
+
+template <bool Sobel>
+struct PrewittSobelByte : PrewittSobelTraits, ByteTraits {
+    using PrewittSobelTraits::PrewittSobelTraits;
+
+    template <class Widen>
+    FORCE_INLINE static void gradient(int16x8_t &gx, int16x8_t &gy, Widen w, OP_ARGS)
+    {
+        PROLOGUE();
+        (void)a11;
+
+        gx = vsubq_s16(w(a22), w(a00));
+        gy = gx;
+
+        gx = vaddq_s16(gx, w(a20));
+        gx = vaddq_s16(gx, Sobel ? vshlq_n_s16(w(a21), 1) : w(a21));
+        gx = vsubq_s16(gx, Sobel ? vshlq_n_s16(w(a01), 1) : w(a01));
+        gx = vsubq_s16(gx, w(a02));
+
+        gy = vaddq_s16(gy, w(a02));
+        gy = vaddq_s16(gy, Sobel ? vshlq_n_s16(w(a12), 1) : w(a12));
+        gy = vsubq_s16(gy, Sobel ? vshlq_n_s16(w(a10), 1) : w(a10));
+        gy = vsubq_s16(gy, w(a20));
+    }
+
+    FORCE_INLINE float32x4_t magnitude(int16x4_t gx, int16x4_t gy)
+    {
+        int32x4_t gxy = vmlal_s16(vmull_s16(gx, gx), gy, gy);
+        return vmulq_n_f32(vsqrtq_f32(vcvtq_f32_s32(gxy)), scale);
+    }
+
+    FORCE_INLINE vec_type op(OP_ARGS)
+    {
+        int16x8_t gx_lo, gy_lo, gx_hi, gy_hi;
+        gradient(gx_lo, gy_lo, [](uint8x16_t x) { return widen_lo(x); }, a00_, a01_, a02_, a10_, a11_, a12_, a20_, a21_, a22_);
+        gradient(gx_hi, gy_hi, [](uint8x16_t x) { return widen_hi(x); }, a00_, a01_, a02_, a10_, a11_, a12_, a20_, a21_, a22_);
+
+        return pack_byte(magnitude(vget_low_s16(gx_lo), vget_low_s16(gy_lo)), magnitude(vget_high_s16(gx_lo), vget_high_s16(gy_lo)),
+                         magnitude(vget_low_s16(gx_hi), vget_low_s16(gy_hi)), magnitude(vget_high_s16(gx_hi), vget_high_s16(gy_hi)));
+    }
+};
+
+template <bool Sobel>
+struct PrewittSobelWord : PrewittSobelTraits, WordTraits {
+    uint16x8_t maxval;
+
+    explicit PrewittSobelWord(const vs_generic_params &params) :
+        PrewittSobelTraits(params),
+        maxval(vdupq_n_u16(params.maxval))
+    {}
+
+    template <class Widen>
+    FORCE_INLINE float32x4_t magnitude(Widen w, OP_ARGS)
+    {
+        PROLOGUE();
+        (void)a11;
+
+        int32x4_t gx = vsubq_s32(w(a22), w(a00));
+        int32x4_t gy = gx;
+
+        gx = vaddq_s32(gx, w(a20));
+        gx = vaddq_s32(gx, Sobel ? vshlq_n_s32(w(a21), 1) : w(a21));
+        gx = vsubq_s32(gx, Sobel ? vshlq_n_s32(w(a01), 1) : w(a01));
+        gx = vsubq_s32(gx, w(a02));
+
+        gy = vaddq_s32(gy, w(a02));
+        gy = vaddq_s32(gy, Sobel ? vshlq_n_s32(w(a12), 1) : w(a12));
+        gy = vsubq_s32(gy, Sobel ? vshlq_n_s32(w(a10), 1) : w(a10));
+        gy = vsubq_s32(gy, w(a20));
+
+        float32x4_t gxsq = vcvtq_f32_s32(gx);
+        float32x4_t gysq = vcvtq_f32_s32(gy);
+        gxsq = vmulq_f32(gxsq, gxsq);
+        gysq = vmulq_f32(gysq, gysq);
+
+        return vmulq_n_f32(vsqrtq_f32(vaddq_f32(gxsq, gysq)), scale);
+    }
+
+    FORCE_INLINE vec_type op(OP_ARGS)
+    {
+        float32x4_t lo = magnitude([](uint16x8_t x) { return widen_lo(x); }, a00_, a01_, a02_, a10_, a11_, a12_, a20_, a21_, a22_);
+        float32x4_t hi = magnitude([](uint16x8_t x) { return widen_hi(x); }, a00_, a01_, a02_, a10_, a11_, a12_, a20_, a21_, a22_);
+        return pack_word(lo, hi, maxval);
+    }
+};
+
+template <bool Sobel>
+struct PrewittSobelFloat : PrewittSobelTraits, FloatTraits {
+    using PrewittSobelTraits::PrewittSobelTraits;
+
+    FORCE_INLINE vec_type op(OP_ARGS)
+    {
+        PROLOGUE();
+        (void)a11;
+
+        float32x4_t gx = vsubq_f32(a22, a00);
+        float32x4_t gy = gx;
+
+        gx = vaddq_f32(gx, a20);
+        gx = vaddq_f32(gx, Sobel ? vmulq_n_f32(a21, 2.0f) : a21);
+        gx = vsubq_f32(gx, Sobel ? vmulq_n_f32(a01, 2.0f) : a01);
+        gx = vsubq_f32(gx, a02);
+
+        gy = vaddq_f32(gy, a02);
+        gy = vaddq_f32(gy, Sobel ? vmulq_n_f32(a12, 2.0f) : a12);
+        gy = vsubq_f32(gy, Sobel ? vmulq_n_f32(a10, 2.0f) : a10);
+        gy = vsubq_f32(gy, a20);
+
+        gx = vmulq_f32(gx, gx);
+        gy = vmulq_f32(gy, gy);
+
+        float32x4_t tmp = vaddq_f32(gx, gy);
+        tmp = vsqrtq_f32(tmp);
+        tmp = vmulq_n_f32(tmp, scale);
+        return tmp;
+    }
+};
+
+template <class Derived, class vec_type>
+struct MinMaxTraits {
+    vec_type mask00;
+    vec_type mask01;
+    vec_type mask02;
+    vec_type mask10;
+    vec_type mask12;
+    vec_type mask20;
+    vec_type mask21;
+    vec_type mask22;
+
+    explicit MinMaxTraits(const vs_generic_params &params) :
+        mask00((params.stencil & 0x01) ? Derived::enabled_mask() : Derived::disabled_mask()),
+        mask01((params.stencil & 0x02) ? Derived::enabled_mask() : Derived::disabled_mask()),
+        mask02((params.stencil & 0x04) ? Derived::enabled_mask() : Derived::disabled_mask()),
+        mask10((params.stencil & 0x08) ? Derived::enabled_mask() : Derived::disabled_mask()),
+        mask12((params.stencil & 0x10) ? Derived::enabled_mask() : Derived::disabled_mask()),
+        mask20((params.stencil & 0x20) ? Derived::enabled_mask() : Derived::disabled_mask()),
+        mask21((params.stencil & 0x40) ? Derived::enabled_mask() : Derived::disabled_mask()),
+        mask22((params.stencil & 0x80) ? Derived::enabled_mask() : Derived::disabled_mask())
+    {}
+
+    FORCE_INLINE vec_type apply_stencil(OP_ARGS)
+    {
+        PROLOGUE();
+
+        vec_type val = a11;
+        val = Derived::reduce(val, a00, mask00);
+        val = Derived::reduce(val, a01, mask01);
+        val = Derived::reduce(val, a02, mask02);
+        val = Derived::reduce(val, a10, mask10);
+        val = Derived::reduce(val, a12, mask12);
+        val = Derived::reduce(val, a20, mask20);
+        val = Derived::reduce(val, a21, mask21);
+        val = Derived::reduce(val, a22, mask22);
+        return val;
+    }
+};
+
+template <bool Max>
+uint8x16_t limit_diff(uint8x16_t val, uint8x16_t orig, uint8x16_t threshold)
+{
+    uint8x16_t limit = Max ? vqaddq_u8(orig, threshold) : vqsubq_u8(orig, threshold);
+    return Max ? vminq_u8(val, limit) : vmaxq_u8(val, limit);
+}
+
+template <bool Max>
+uint16x8_t limit_diff(uint16x8_t val, uint16x8_t orig, uint16x8_t threshold)
+{
+    uint16x8_t limit = Max ? vqaddq_u16(orig, threshold) : vqsubq_u16(orig, threshold);
+    return Max ? vminq_u16(val, limit) : vmaxq_u16(val, limit);
+}
+
+template <bool Max>
+float32x4_t limit_diff(float32x4_t val, float32x4_t orig, float32x4_t threshold)
+{
+    float32x4_t limit = Max ? vaddq_f32(orig, threshold) : vsubq_f32(orig, threshold);
+    return Max ? vminq_f32(val, limit) : vmaxq_f32(val, limit);
+}
+
+template <bool Max>
+struct MinMaxByte : MinMaxTraits<MinMaxByte<Max>, uint8x16_t>, ByteTraits {
+    typedef MinMaxTraits<MinMaxByte<Max>, uint8x16_t> MinMaxTraitsT;
+    uint8x16_t threshold;
+
+    static uint8x16_t enabled_mask() { return Max ? vdupq_n_u8(UINT8_MAX) : vdupq_n_u8(0); }
+    static uint8x16_t disabled_mask() { return Max ? vdupq_n_u8(0) : vdupq_n_u8(UINT8_MAX); }
+
+    static uint8x16_t reduce(uint8x16_t lhs, uint8x16_t rhs, uint8x16_t mask)
+    {
+        return Max ? vmaxq_u8(lhs, vandq_u8(mask, rhs)) : vminq_u8(lhs, vorrq_u8(mask, rhs));
+    }
+
+    explicit MinMaxByte(const vs_generic_params &params) :
+        MinMaxTraitsT(params),
+        threshold(vdupq_n_u8(static_cast<uint8_t>(std::min(params.threshold, static_cast<uint16_t>(UINT8_MAX)))))
+    {}
+
+    FORCE_INLINE vec_type op(OP_ARGS)
+    {
+        PROLOGUE();
+
+        uint8x16_t val = MinMaxTraitsT::apply_stencil(a00, a01, a02, a10, a11, a12, a20, a21, a22);
+        return limit_diff<Max>(val, a11, threshold);
+    }
+};
+
+template <bool Max>
+struct MinMaxWord : MinMaxTraits<MinMaxWord<Max>, uint16x8_t>, WordTraits {
+    typedef MinMaxTraits<MinMaxWord<Max>, uint16x8_t> MinMaxTraitsT;
+    uint16x8_t threshold;
+
+    static uint16x8_t enabled_mask() { return Max ? vdupq_n_u16(UINT16_MAX) : vdupq_n_u16(0); }
+    static uint16x8_t disabled_mask() { return Max ? vdupq_n_u16(0) : vdupq_n_u16(UINT16_MAX); }
+
+    static uint16x8_t reduce(uint16x8_t lhs, uint16x8_t rhs, uint16x8_t mask)
+    {
+        return Max ? vmaxq_u16(lhs, vandq_u16(mask, rhs)) : vminq_u16(lhs, vorrq_u16(mask, rhs));
+    }
+
+    explicit MinMaxWord(const vs_generic_params &params) :
+        MinMaxTraitsT(params),
+        threshold(vdupq_n_u16(params.threshold))
+    {}
+
+    FORCE_INLINE vec_type op(OP_ARGS)
+    {
+        PROLOGUE();
+
+        uint16x8_t val = MinMaxTraitsT::apply_stencil(a00, a01, a02, a10, a11, a12, a20, a21, a22);
+        return limit_diff<Max>(val, a11, threshold);
+    }
+};
+
+template <bool Max>
+struct MinMaxFloat : MinMaxTraits<MinMaxFloat<Max>, float32x4_t>, FloatTraits {
+    typedef MinMaxTraits<MinMaxFloat<Max>, float32x4_t> MinMaxTraitsT;
+    float32x4_t threshold;
+
+    static float32x4_t enabled_mask() { return Max ? vdupq_n_f32(INFINITY) : vdupq_n_f32(-INFINITY); }
+    static float32x4_t disabled_mask() { return Max ? vdupq_n_f32(-INFINITY) : vdupq_n_f32(INFINITY); }
+
+    FORCE_INLINE static float32x4_t reduce(float32x4_t lhs, float32x4_t rhs, float32x4_t mask)
+    {
+        // INFINITY is not a bit mask, so need to use min/max on rhs instead of and/or.
+        return Max ? vmaxq_f32(lhs, vminq_f32(rhs, mask)) : vminq_f32(lhs, vmaxq_f32(rhs, mask));
+    }
+
+    explicit MinMaxFloat(const vs_generic_params &params) :
+        MinMaxTraitsT(params),
+        threshold(vdupq_n_f32(params.thresholdf))
+    {}
+
+    FORCE_INLINE vec_type op(OP_ARGS)
+    {
+        PROLOGUE();
+
+        float32x4_t val = MinMaxTraitsT::apply_stencil(a00, a01, a02, a10, a11, a12, a20, a21, a22);
+        return limit_diff<Max>(val, a11, threshold);
+    }
+};
+
+constexpr uint8_t STENCIL_ALL = 0xFF;
+constexpr uint8_t STENCIL_H = 0x18;
+constexpr uint8_t STENCIL_V = 0x42;
+constexpr uint8_t STENCIL_PLUS = STENCIL_H | STENCIL_V;
+
+template <uint8_t Stencil, class Derived, class vec_type>
+struct MinMaxFixedTraits {
+    static FORCE_INLINE vec_type apply_stencil(OP_ARGS)
+    {
+        PROLOGUE();
+
+        vec_type val = a11;
+        val = (Stencil & 0x01) ? Derived::reduce(val, a00) : val;
+        val = (Stencil & 0x02) ? Derived::reduce(val, a01) : val;
+        val = (Stencil & 0x04) ? Derived::reduce(val, a02) : val;
+        val = (Stencil & 0x08) ? Derived::reduce(val, a10) : val;
+        val = (Stencil & 0x10) ? Derived::reduce(val, a12) : val;
+        val = (Stencil & 0x20) ? Derived::reduce(val, a20) : val;
+        val = (Stencil & 0x40) ? Derived::reduce(val, a21) : val;
+        val = (Stencil & 0x80) ? Derived::reduce(val, a22) : val;
+        return val;
+    }
+};
+
+template <uint8_t Stencil, bool Max>
+struct MinMaxFixedByte : MinMaxFixedTraits<Stencil, MinMaxFixedByte<Stencil, Max>, uint8x16_t>, ByteTraits {
+    typedef MinMaxFixedTraits<Stencil, MinMaxFixedByte, uint8x16_t> MinMaxFixedTraitsT;
+    uint8x16_t threshold;
+
+    static uint8x16_t reduce(uint8x16_t lhs, uint8x16_t rhs)
+    {
+        return Max ? vmaxq_u8(lhs, rhs) : vminq_u8(lhs, rhs);
+    }
+
+    explicit MinMaxFixedByte(const vs_generic_params &params) :
+        threshold(vdupq_n_u8(static_cast<uint8_t>(std::min(params.threshold, static_cast<uint16_t>(UINT8_MAX)))))
+    {}
+
+    FORCE_INLINE vec_type op(OP_ARGS)
+    {
+        PROLOGUE();
+
+        uint8x16_t val = MinMaxFixedTraitsT::apply_stencil(a00, a01, a02, a10, a11, a12, a20, a21, a22);
+        return limit_diff<Max>(val, a11, threshold);
+    }
+};
+
+template <uint8_t Stencil, bool Max>
+struct MinMaxFixedWord : MinMaxFixedTraits<Stencil, MinMaxFixedWord<Stencil, Max>, uint16x8_t>, WordTraits {
+    typedef MinMaxFixedTraits<Stencil, MinMaxFixedWord, uint16x8_t> MinMaxFixedTraitsT;
+    uint16x8_t threshold;
+
+    static uint16x8_t reduce(uint16x8_t lhs, uint16x8_t rhs)
+    {
+        return Max ? vmaxq_u16(lhs, rhs) : vminq_u16(lhs, rhs);
+    }
+
+    explicit MinMaxFixedWord(const vs_generic_params &params) :
+        threshold(vdupq_n_u16(params.threshold))
+    {}
+
+    FORCE_INLINE vec_type op(OP_ARGS)
+    {
+        PROLOGUE();
+
+        uint16x8_t val = MinMaxFixedTraitsT::apply_stencil(a00, a01, a02, a10, a11, a12, a20, a21, a22);
+        return limit_diff<Max>(val, a11, threshold);
+    }
+};
+
+template <uint8_t Stencil, bool Max>
+struct MinMaxFixedFloat : MinMaxFixedTraits<Stencil, MinMaxFixedFloat<Stencil, Max>, float32x4_t>, FloatTraits {
+    typedef MinMaxFixedTraits<Stencil, MinMaxFixedFloat<Stencil, Max>, float32x4_t> MinMaxFixedTraitsT;
+    float32x4_t threshold;
+
+    FORCE_INLINE static float32x4_t reduce(float32x4_t lhs, float32x4_t rhs)
+    {
+        return Max ? vmaxq_f32(lhs, rhs) : vminq_f32(lhs, rhs);
+    }
+
+    explicit MinMaxFixedFloat(const vs_generic_params &params) : threshold(vdupq_n_f32(params.thresholdf)) {}
+
+    FORCE_INLINE vec_type op(OP_ARGS)
+    {
+        PROLOGUE();
+
+        float32x4_t val = MinMaxFixedTraitsT::apply_stencil(a00, a01, a02, a10, a11, a12, a20, a21, a22);
+        return limit_diff<Max>(val, a11, threshold);
+    }
+};
+
+template <class Derived, class vec_type>
+struct MedianTraits {
+    FORCE_INLINE vec_type op(OP_ARGS)
+    {
+        PROLOGUE();
+
+        Derived::compare_exchange(a00, a01);
+        Derived::compare_exchange(a02, a10);
+        Derived::compare_exchange(a12, a20);
+        Derived::compare_exchange(a21, a22);
+
+        Derived::compare_exchange(a00, a02);
+        Derived::compare_exchange(a01, a10);
+        Derived::compare_exchange(a12, a21);
+        Derived::compare_exchange(a20, a22);
+
+        Derived::compare_exchange(a01, a02);
+        Derived::compare_exchange(a20, a21);
+
+        a12 = Derived::max(a00, a12);
+        a20 = Derived::max(a01, a20);
+        a02 = Derived::min(a02, a21);
+        a10 = Derived::min(a10, a22);
+
+        a12 = Derived::max(a02, a12);
+        a10 = Derived::min(a10, a20);
+
+        Derived::compare_exchange(a10, a12);
+
+        a11 = Derived::max(a10, a11);
+        a11 = Derived::min(a11, a12);
+        return a11;
+    }
+};
+
+struct MedianByte : MedianTraits<MedianByte, uint8x16_t>, ByteTraits {
+    static uint8x16_t min(uint8x16_t lhs, uint8x16_t rhs) { return vminq_u8(lhs, rhs); }
+    static uint8x16_t max(uint8x16_t lhs, uint8x16_t rhs) { return vmaxq_u8(lhs, rhs); }
+
+    static FORCE_INLINE void compare_exchange(uint8x16_t &lhs, uint8x16_t &rhs)
+    {
+        uint8x16_t a = lhs;
+        uint8x16_t b = rhs;
+        lhs = vminq_u8(a, b);
+        rhs = vmaxq_u8(a, b);
+    }
+
+    explicit MedianByte(const vs_generic_params &) {}
+};
+
+struct MedianWord : MedianTraits<MedianWord, uint16x8_t>, WordTraits {
+    static uint16x8_t min(uint16x8_t lhs, uint16x8_t rhs) { return vminq_u16(lhs, rhs); }
+    static uint16x8_t max(uint16x8_t lhs, uint16x8_t rhs) { return vmaxq_u16(lhs, rhs); }
+
+    static FORCE_INLINE void compare_exchange(uint16x8_t &lhs, uint16x8_t &rhs)
+    {
+        uint16x8_t a = lhs;
+        uint16x8_t b = rhs;
+        lhs = vminq_u16(a, b);
+        rhs = vmaxq_u16(a, b);
+    }
+
+    explicit MedianWord(const vs_generic_params &) {}
+};
+
+struct MedianFloat : MedianTraits<MedianFloat, float32x4_t>, FloatTraits {
+    static float32x4_t min(float32x4_t lhs, float32x4_t rhs) { return vminq_f32(lhs, rhs); }
+    static float32x4_t max(float32x4_t lhs, float32x4_t rhs) { return vmaxq_f32(lhs, rhs); }
+
+    static FORCE_INLINE void compare_exchange(float32x4_t &lhs, float32x4_t &rhs)
+    {
+        float32x4_t a = lhs;
+        float32x4_t b = rhs;
+        lhs = vminq_f32(a, b);
+        rhs = vmaxq_f32(a, b);
+    }
+
+    explicit MedianFloat(const vs_generic_params &) {}
+};
+
+template <bool Inflate>
+struct DeflateInflateByte : ByteTraits {
+    uint8x16_t threshold;
+
+    explicit DeflateInflateByte(const vs_generic_params &params) :
+        threshold(vdupq_n_u8(static_cast<uint8_t>(std::min(params.threshold, static_cast<uint16_t>(UINT8_MAX)))))
+    {}
+
+    FORCE_INLINE vec_type op(OP_ARGS)
+    {
+        PROLOGUE();
+
+        uint16x8_t accum_lo = vaddl_u8(vget_low_u8(a00), vget_low_u8(a01));
+        uint16x8_t accum_hi = vaddl_high_u8(a00, a01);
+        accum_lo = vaddw_u8(accum_lo, vget_low_u8(a02));
+        accum_hi = vaddw_high_u8(accum_hi, a02);
+        accum_lo = vaddw_u8(accum_lo, vget_low_u8(a10));
+        accum_hi = vaddw_high_u8(accum_hi, a10);
+        accum_lo = vaddw_u8(accum_lo, vget_low_u8(a12));
+        accum_hi = vaddw_high_u8(accum_hi, a12);
+        accum_lo = vaddw_u8(accum_lo, vget_low_u8(a20));
+        accum_hi = vaddw_high_u8(accum_hi, a20);
+        accum_lo = vaddw_u8(accum_lo, vget_low_u8(a21));
+        accum_hi = vaddw_high_u8(accum_hi, a21);
+        accum_lo = vaddw_u8(accum_lo, vget_low_u8(a22));
+        accum_hi = vaddw_high_u8(accum_hi, a22);
+
+        // (accum + 4) >> 3
+        uint8x16_t tmp = vcombine_u8(vrshrn_n_u16(accum_lo, 3), vrshrn_n_u16(accum_hi, 3));
+        tmp = Inflate ? vmaxq_u8(tmp, a11) : vminq_u8(tmp, a11);
+
+        uint8x16_t limit = Inflate ? vqaddq_u8(a11, threshold) : vqsubq_u8(a11, threshold);
+        tmp = Inflate ? vminq_u8(tmp, limit) : vmaxq_u8(tmp, limit);
+
+        return tmp;
+    }
+};
+
+template <bool Inflate>
+struct DeflateInflateWord : WordTraits {
+    uint16x8_t threshold;
+
+    explicit DeflateInflateWord(const vs_generic_params &params) : threshold(vdupq_n_u16(params.threshold)) {}
+
+    FORCE_INLINE vec_type op(OP_ARGS)
+    {
+        PROLOGUE();
+
+        uint32x4_t accum_lo = vaddl_u16(vget_low_u16(a00), vget_low_u16(a01));
+        uint32x4_t accum_hi = vaddl_high_u16(a00, a01);
+        accum_lo = vaddw_u16(accum_lo, vget_low_u16(a02));
+        accum_hi = vaddw_high_u16(accum_hi, a02);
+        accum_lo = vaddw_u16(accum_lo, vget_low_u16(a10));
+        accum_hi = vaddw_high_u16(accum_hi, a10);
+        accum_lo = vaddw_u16(accum_lo, vget_low_u16(a12));
+        accum_hi = vaddw_high_u16(accum_hi, a12);
+        accum_lo = vaddw_u16(accum_lo, vget_low_u16(a20));
+        accum_hi = vaddw_high_u16(accum_hi, a20);
+        accum_lo = vaddw_u16(accum_lo, vget_low_u16(a21));
+        accum_hi = vaddw_high_u16(accum_hi, a21);
+        accum_lo = vaddw_u16(accum_lo, vget_low_u16(a22));
+        accum_hi = vaddw_high_u16(accum_hi, a22);
+
+        // (accum + 4) >> 3
+        uint16x8_t tmp = vcombine_u16(vrshrn_n_u32(accum_lo, 3), vrshrn_n_u32(accum_hi, 3));
+        tmp = Inflate ? vmaxq_u16(tmp, a11) : vminq_u16(tmp, a11);
+
+        uint16x8_t limit = Inflate ? vqaddq_u16(a11, threshold) : vqsubq_u16(a11, threshold);
+        tmp = Inflate ? vminq_u16(tmp, limit) : vmaxq_u16(tmp, limit);
+
+        return tmp;
+    }
+};
+
+template <bool Inflate>
+struct DeflateInflateFloat : FloatTraits {
+    float32x4_t threshold;
+
+    explicit DeflateInflateFloat(const vs_generic_params &params) : threshold(vdupq_n_f32(params.thresholdf)) {}
+
+    FORCE_INLINE vec_type op(OP_ARGS)
+    {
+        PROLOGUE();
+
+        float32x4_t accum0 = vaddq_f32(a00, a01);
+        float32x4_t accum1 = vaddq_f32(a02, a10);
+        accum0 = vaddq_f32(accum0, a12);
+        accum1 = vaddq_f32(accum1, a20);
+        accum0 = vaddq_f32(accum0, a21);
+        accum1 = vaddq_f32(accum1, a22);
+
+        float32x4_t tmp = vaddq_f32(accum0, accum1);
+        tmp = vmulq_n_f32(tmp, 1.0f / 8.0f);
+        tmp = Inflate ? vmaxq_f32(tmp, a11) : vminq_f32(tmp, a11);
+
+        float32x4_t limit = Inflate ? vaddq_f32(a11, threshold) : vsubq_f32(a11, threshold);
+        tmp = Inflate ? vminq_f32(tmp, limit) : vmaxq_f32(tmp, limit);
+
+        return tmp;
+    }
+};
+
+struct ConvolutionTraits {
+    float32x4_t div;
+    float32x4_t bias;
+    uint32x4_t saturate_mask;
+
+    explicit ConvolutionTraits(const vs_generic_params &params) :
+        div(vdupq_n_f32(params.div)),
+        bias(vdupq_n_f32(params.bias)),
+        saturate_mask(vdupq_n_u32(params.saturate ? 0xFFFFFFFF : 0x7FFFFFFF))
+    {}
+
+    FORCE_INLINE float32x4_t finish(int32x4_t accum)
+    {
+        float32x4_t tmp = vaddq_f32(vmulq_f32(vcvtq_f32_s32(accum), div), bias);
+        return vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(tmp), saturate_mask));
+    }
+};
+
+struct ConvolutionIntTraits : ConvolutionTraits {
+    int16_t c00, c01, c02, c10, c11, c12, c20, c21, c22;
+
+    explicit ConvolutionIntTraits(const vs_generic_params &params) :
+        ConvolutionTraits(params),
+        c00(params.matrix[0]), c01(params.matrix[1]), c02(params.matrix[2]),
+        c10(params.matrix[3]), c11(params.matrix[4]), c12(params.matrix[5]),
+        c20(params.matrix[6]), c21(params.matrix[7]), c22(params.matrix[8])
+    {}
+};
+
+struct ConvolutionByte : ConvolutionIntTraits, ByteTraits {
+    using ConvolutionIntTraits::ConvolutionIntTraits;
+
+    FORCE_INLINE void accumulate(int32x4_t &lo, int32x4_t &hi, int16x8_t x, int16_t c)
+    {
+        lo = vmlal_n_s16(lo, vget_low_s16(x), c);
+        hi = vmlal_high_n_s16(hi, x, c);
+    }
+
+    FORCE_INLINE vec_type op(OP_ARGS)
+    {
+        PROLOGUE();
+
+        int32x4_t accum_lolo = vdupq_n_s32(0);
+        int32x4_t accum_lohi = vdupq_n_s32(0);
+        int32x4_t accum_hilo = vdupq_n_s32(0);
+        int32x4_t accum_hihi = vdupq_n_s32(0);
+
+        accumulate(accum_lolo, accum_lohi, widen_lo(a00), c00);
+        accumulate(accum_hilo, accum_hihi, widen_hi(a00), c00);
+        accumulate(accum_lolo, accum_lohi, widen_lo(a01), c01);
+        accumulate(accum_hilo, accum_hihi, widen_hi(a01), c01);
+        accumulate(accum_lolo, accum_lohi, widen_lo(a02), c02);
+        accumulate(accum_hilo, accum_hihi, widen_hi(a02), c02);
+        accumulate(accum_lolo, accum_lohi, widen_lo(a10), c10);
+        accumulate(accum_hilo, accum_hihi, widen_hi(a10), c10);
+        accumulate(accum_lolo, accum_lohi, widen_lo(a11), c11);
+        accumulate(accum_hilo, accum_hihi, widen_hi(a11), c11);
+        accumulate(accum_lolo, accum_lohi, widen_lo(a12), c12);
+        accumulate(accum_hilo, accum_hihi, widen_hi(a12), c12);
+        accumulate(accum_lolo, accum_lohi, widen_lo(a20), c20);
+        accumulate(accum_hilo, accum_hihi, widen_hi(a20), c20);
+        accumulate(accum_lolo, accum_lohi, widen_lo(a21), c21);
+        accumulate(accum_hilo, accum_hihi, widen_hi(a21), c21);
+        accumulate(accum_lolo, accum_lohi, widen_lo(a22), c22);
+        accumulate(accum_hilo, accum_hihi, widen_hi(a22), c22);
+
+        return pack_byte(finish(accum_lolo), finish(accum_lohi), finish(accum_hilo), finish(accum_hihi));
+    }
+};
+
+struct ConvolutionWord : ConvolutionIntTraits, WordTraits {
+    uint16x8_t maxval;
+
+    explicit ConvolutionWord(const vs_generic_params &params) :
+        ConvolutionIntTraits(params),
+        maxval(vdupq_n_u16(params.maxval))
+    {}
+
+    FORCE_INLINE void accumulate(int32x4_t &lo, int32x4_t &hi, uint16x8_t x, int16_t c)
+    {
+        lo = vmlaq_n_s32(lo, widen_lo(x), c);
+        hi = vmlaq_n_s32(hi, widen_hi(x), c);
+    }
+
+    FORCE_INLINE vec_type op(OP_ARGS)
+    {
+        PROLOGUE();
+
+        int32x4_t accum_lo = vdupq_n_s32(0);
+        int32x4_t accum_hi = vdupq_n_s32(0);
+
+        accumulate(accum_lo, accum_hi, a00, c00);
+        accumulate(accum_lo, accum_hi, a01, c01);
+        accumulate(accum_lo, accum_hi, a02, c02);
+        accumulate(accum_lo, accum_hi, a10, c10);
+        accumulate(accum_lo, accum_hi, a11, c11);
+        accumulate(accum_lo, accum_hi, a12, c12);
+        accumulate(accum_lo, accum_hi, a20, c20);
+        accumulate(accum_lo, accum_hi, a21, c21);
+        accumulate(accum_lo, accum_hi, a22, c22);
+
+        return pack_word(finish(accum_lo), finish(accum_hi), maxval);
+    }
+};
+
+struct ConvolutionFloat : ConvolutionTraits, FloatTraits {
+    float c00, c01, c02, c10, c11, c12, c20, c21, c22;
+
+    explicit ConvolutionFloat(const vs_generic_params &params) :
+        ConvolutionTraits(params),
+        c00(params.matrixf[0] * params.div),
+        c01(params.matrixf[1] * params.div),
+        c02(params.matrixf[2] * params.div),
+        c10(params.matrixf[3] * params.div),
+        c11(params.matrixf[4] * params.div),
+        c12(params.matrixf[5] * params.div),
+        c20(params.matrixf[6] * params.div),
+        c21(params.matrixf[7] * params.div),
+        c22(params.matrixf[8] * params.div)
+    {}
+
+    FORCE_INLINE vec_type op(OP_ARGS)
+    {
+        PROLOGUE();
+
+        float32x4_t accum0 = vmulq_n_f32(a00, c00);
+        float32x4_t accum1 = vmulq_n_f32(a01, c01);
+        accum0 = vaddq_f32(accum0, vmulq_n_f32(a02, c02));
+        accum1 = vaddq_f32(accum1, vmulq_n_f32(a10, c10));
+        accum0 = vaddq_f32(accum0, vmulq_n_f32(a11, c11));
+        accum1 = vaddq_f32(accum1, vmulq_n_f32(a12, c12));
+        accum0 = vaddq_f32(accum0, vmulq_n_f32(a20, c20));
+        accum1 = vaddq_f32(accum1, vmulq_n_f32(a21, c21));
+        accum0 = vaddq_f32(accum0, vmulq_n_f32(a22, c22));
+        accum1 = vaddq_f32(accum1, bias);
+
+        float32x4_t tmp = vaddq_f32(accum0, accum1);
+        return vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(tmp), saturate_mask));
+    }
+};
+
+#undef PROLOGUE
+#undef OP_ARGS
+
+
+template <class Traits>
+void filter_plane_3x3(const void *src, ptrdiff_t src_stride, void *dst, ptrdiff_t dst_stride, const vs_generic_params &params, unsigned width, unsigned height)
+{
+    typedef typename Traits::T T;
+    typedef typename Traits::vec_type vec_type;
+
+    Traits traits{ params };
+
+    unsigned vec_end = (width - 1) & ~(Traits::vec_len - 1);
+
+#define INVOKE(p0, p1, p2) (traits.op(Traits::loadu(p0 - 1), Traits::load(p0), Traits::loadu(p0 + 1), Traits::loadu(p1 - 1), Traits::load(p1), Traits::loadu(p1 + 1), Traits::loadu(p2 - 1), Traits::load(p2), Traits::loadu(p2 + 1)))
+    for (unsigned i = 0; i < height; ++i) {
+        unsigned above_idx = i == 0 ? std::min(1U, height - 1) : i - 1;
+        unsigned below_idx = i == height - 1 ? height - std::min(2U, height) : i + 1;
+
+        const T *srcp0 = static_cast<const T *>(line_ptr(src, above_idx, src_stride));
+        const T *srcp1 = static_cast<const T *>(line_ptr(src, i, src_stride));
+        const T *srcp2 = static_cast<const T *>(line_ptr(src, below_idx, src_stride));
+        T *dstp = static_cast<T *>(line_ptr(dst, i, dst_stride));
+
+        {
+            vec_type a01 = Traits::load(srcp0);
+            vec_type a11 = Traits::load(srcp1);
+            vec_type a21 = Traits::load(srcp2);
+
+            vec_type a00 = Traits::shl_insert_lo(a01, srcp0[std::min(1U, width - 1)]);
+            vec_type a10 = Traits::shl_insert_lo(a11, srcp1[std::min(1U, width - 1)]);
+            vec_type a20 = Traits::shl_insert_lo(a21, srcp2[std::min(1U, width - 1)]);
+
+            vec_type a02, a12, a22;
+            if (width > Traits::vec_len) {
+                a02 = Traits::loadu(srcp0 + 1);
+                a12 = Traits::loadu(srcp1 + 1);
+                a22 = Traits::loadu(srcp2 + 1);
+            } else {
+                a02 = Traits::shr_insert(a01, srcp0[width - std::min(2U, width)], width - 1);
+                a12 = Traits::shr_insert(a11, srcp1[width - std::min(2U, width)], width - 1);
+                a22 = Traits::shr_insert(a21, srcp2[width - std::min(2U, width)], width - 1);
+            }
+
+            vec_type val = traits.op(a00, a01, a02, a10, a11, a12, a20, a21, a22);
+            Traits::store(dstp + 0, val);
+        }
+
+        for (unsigned j = Traits::vec_len; j < vec_end; j += Traits::vec_len) {
+            vec_type val = INVOKE(srcp0 + j, srcp1 + j, srcp2 + j);
+            Traits::store(dstp + j, val);
+        }
+
+        if (vec_end >= Traits::vec_len) {
+            vec_type a00 = Traits::loadu(srcp0 + vec_end - 1);
+            vec_type a10 = Traits::loadu(srcp1 + vec_end - 1);
+            vec_type a20 = Traits::loadu(srcp2 + vec_end - 1);
+
+            vec_type a01 = Traits::load(srcp0 + vec_end);
+            vec_type a11 = Traits::load(srcp1 + vec_end);
+            vec_type a21 = Traits::load(srcp2 + vec_end);
+
+            vec_type a02 = Traits::shr_insert(a01, srcp0[width - 2], width - vec_end - 1);
+            vec_type a12 = Traits::shr_insert(a11, srcp1[width - 2], width - vec_end - 1);
+            vec_type a22 = Traits::shr_insert(a21, srcp2[width - 2], width - vec_end - 1);
+
+            vec_type val = traits.op(a00, a01, a02, a10, a11, a12, a20, a21, a22);
+            Traits::store(dstp + vec_end, val);
+        }
+    }
+#undef INVOKE
+}
+
+struct SeparableByte {
+    typedef uint8_t T;
+    typedef int16_t weight_type;
+    typedef int32x4_t vec_type;
+
+    static const weight_type *coeffs_h(const vs_generic_params &params) { return params.matrix_h; }
+    static const weight_type *coeffs_v(const vs_generic_params &params) { return params.matrix_v; }
+
+    static FORCE_INLINE vec_type load(const T *ptr)
+    {
+        uint32_t tmp;
+        memcpy(&tmp, ptr, sizeof(tmp));
+        return vreinterpretq_s32_u32(vmovl_u16(vget_low_u16(vmovl_u8(vreinterpret_u8_u32(vdup_n_u32(tmp))))));
+    }
+
+    static FORCE_INLINE vec_type loadu(const int32_t *ptr) { return vld1q_s32(ptr); }
+    static FORCE_INLINE void storeu(int32_t *ptr, vec_type x) { vst1q_s32(ptr, x); }
+    static FORCE_INLINE vec_type zero() { return vdupq_n_s32(0); }
+    static FORCE_INLINE vec_type madd(weight_type c, vec_type x, vec_type accum) { return vmlaq_n_s32(accum, x, c); }
+    static FORCE_INLINE float32x4_t to_float(vec_type x) { return vcvtq_f32_s32(x); }
+
+    static FORCE_INLINE void store(T *ptr, float32x4_t x)
+    {
+        uint16x4_t tmp = vqmovun_s32(vcvtnq_s32_f32(x));
+        uint32_t packed = vget_lane_u32(vreinterpret_u32_u8(vqmovn_u16(vcombine_u16(tmp, tmp))), 0);
+        memcpy(ptr, &packed, sizeof(packed));
+    }
+};
+
+struct SeparableWord : SeparableByte {
+    typedef uint16_t T;
+
+    static FORCE_INLINE vec_type load(const T *ptr) { return vreinterpretq_s32_u32(vmovl_u16(vld1_u16(ptr))); }
+    static FORCE_INLINE void store(T *ptr, float32x4_t x) { vst1_u16(ptr, vqmovun_s32(vcvtnq_s32_f32(x))); }
+};
+
+struct SeparableFloat {
+    typedef float T;
+    typedef float weight_type;
+    typedef float32x4_t vec_type;
+
+    static const weight_type *coeffs_h(const vs_generic_params &params) { return params.matrixf_h; }
+    static const weight_type *coeffs_v(const vs_generic_params &params) { return params.matrixf_v; }
+
+    static FORCE_INLINE vec_type load(const T *ptr) { return vld1q_f32(ptr); }
+    static FORCE_INLINE vec_type loadu(const float *ptr) { return vld1q_f32(ptr); }
+    static FORCE_INLINE void storeu(float *ptr, vec_type x) { vst1q_f32(ptr, x); }
+    static FORCE_INLINE vec_type zero() { return vdupq_n_f32(0.0f); }
+    static FORCE_INLINE vec_type madd(weight_type c, vec_type x, vec_type accum) { return vaddq_f32(accum, vmulq_n_f32(x, c)); }
+    static FORCE_INLINE float32x4_t to_float(vec_type x) { return x; }
+    static FORCE_INLINE void store(T *ptr, float32x4_t x) { vst1q_f32(ptr, x); }
+};
+
+// Vertical pass into a 32-bit row buffer followed by a horizontal pass over it. Integer sums are exact, so
+// this requires maxval * sum(|h|) * sum(|v|) to fit in int32_t. The caller checks this.
+template <class Traits>
+void conv_plane_separable(const void *src, ptrdiff_t src_stride, void *dst, ptrdiff_t dst_stride, const vs_generic_params &params, unsigned width, unsigned height)
+{
+    typedef typename Traits::T T;
+    typedef typename Traits::vec_type vec_type;
+    typedef typename std::conditional<std::is_integral<T>::value, int32_t, float>::type Intermediate;
+
+    const typename Traits::weight_type *coeffs_h = Traits::coeffs_h(params);
+    const typename Traits::weight_type *coeffs_v = Traits::coeffs_v(params);
+    unsigned fwidth = params.matrixsize_h;
+    unsigned fheight = params.matrixsize_v;
+    unsigned support_h = fwidth / 2;
+    unsigned support_v = fheight / 2;
+
+    const float32x4_t div = vdupq_n_f32(params.div);
+    const float32x4_t bias = vdupq_n_f32(params.bias);
+    const uint32x4_t saturate_mask = vdupq_n_u32(params.saturate ? 0xFFFFFFFF : 0x7FFFFFFF);
+    const float32x4_t maxval = vdupq_n_f32(params.maxval);
+
+    thread_local std::vector<Intermediate> row_buffer;
+    row_buffer.resize(width + 2 * support_h + 4);
+    Intermediate *row = row_buffer.data() + support_h;
+    const Intermediate *row_h = row_buffer.data();
+
+    const T *srcp[VS_GENERIC_MAX_CONV_SIZE];
+
+    // The last horizontal vector may read past the mirrored padding, hence the spare vector in the row buffer.
+    unsigned vec_end = width & ~3U;
+
+    for (unsigned i = 0; i < height; ++i) {
+        T *dstp = static_cast<T *>(line_ptr(dst, i, dst_stride));
+
+        for (unsigned k = 0; k < fheight; ++k) {
+            int idx = static_cast<int>(i + k) - static_cast<int>(support_v);
+            idx = idx < 0 ? -idx : idx >= static_cast<int>(height) ? 2 * (height - 1) - idx : idx;
+            srcp[k] = static_cast<const T *>(line_ptr(src, idx, src_stride));
+        }
+
+        for (unsigned j = 0; j < vec_end; j += 4) {
+            vec_type accum = Traits::zero();
+
+            for (unsigned k = 0; k < fheight; ++k) {
+                accum = Traits::madd(coeffs_v[k], Traits::load(srcp[k] + j), accum);
+            }
+            Traits::storeu(row + j, accum);
+        }
+        for (unsigned j = vec_end; j < width; ++j) {
+            Intermediate accum = 0;
+
+            for (unsigned k = 0; k < fheight; ++k) {
+                accum += coeffs_v[k] * static_cast<Intermediate>(srcp[k][j]);
+            }
+            row[j] = accum;
+        }
+
+        for (unsigned k = 1; k <= support_h; ++k) {
+            row[-static_cast<int>(k)] = row[k];
+            row[width - 1 + k] = row[width - 1 - k];
+        }
+
+        for (unsigned j = 0; j < width; j += 4) {
+            vec_type accum = Traits::zero();
+
+            for (unsigned k = 0; k < fwidth; ++k) {
+                accum = Traits::madd(coeffs_h[k], Traits::loadu(row_h + j + k), accum);
+            }
+
+            float32x4_t tmp = vaddq_f32(vmulq_f32(Traits::to_float(accum), div), bias);
+            tmp = vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(tmp), saturate_mask));
+
+            if (std::is_integral<T>::value)
+                tmp = vminq_f32(vmaxq_f32(tmp, vdupq_n_f32(0.0f)), maxval);
+
+            if (j + 4 <= width) {
+                Traits::store(dstp + j, tmp);
+            } else {
+                alignas(16) T tail[4];
+                Traits::store(tail, tmp);
+                std::copy_n(tail, width - j, dstp + j);
+            }
+        }
+    }
+}
+
+struct RankOps {
+    static void add(uint16_t *dst, const uint16_t *src, unsigned n)
+    {
+        for (unsigned i = 0; i < n; i += 8) {
+            vst1q_u16(dst + i, vaddq_u16(vld1q_u16(dst + i), vld1q_u16(src + i)));
+        }
+    }
+
+    static void add_sub(uint16_t *dst, const uint16_t *add, const uint16_t *sub, unsigned n)
+    {
+        for (unsigned i = 0; i < n; i += 8) {
+            uint16x8_t x = vaddq_u16(vld1q_u16(dst + i), vld1q_u16(add + i));
+            vst1q_u16(dst + i, vsubq_u16(x, vld1q_u16(sub + i)));
+        }
+    }
+};
+
+} // namespace
+
+void vs_generic_3x3_prewitt_byte_neon(const void *src, ptrdiff_t src_stride, void *dst, ptrdiff_t dst_stride, const struct vs_generic_params *params, unsigned width, unsigned height)
+{
+    filter_plane_3x3<PrewittSobelByte<false>>(src, src_stride, dst, dst_stride, *params, width, height);
+}
+
+void vs_generic_3x3_prewitt_word_neon(const void *src, ptrdiff_t src_stride, void *dst, ptrdiff_t dst_stride, const struct vs_generic_params *params, unsigned width, unsigned height)
+{
+    filter_plane_3x3<PrewittSobelWord<false>>(src, src_stride, dst, dst_stride, *params, width, height);
+}
+
+void vs_generic_3x3_prewitt_float_neon(const void *src, ptrdiff_t src_stride, void *dst, ptrdiff_t dst_stride, const struct vs_generic_params *params, unsigned width, unsigned height)
+{
+    filter_plane_3x3<PrewittSobelFloat<false>>(src, src_stride, dst, dst_stride, *params, width, height);
+}
+
+void vs_generic_3x3_sobel_byte_neon(const void *src, ptrdiff_t src_stride, void *dst, ptrdiff_t dst_stride, const struct vs_generic_params *params, unsigned width, unsigned height)
+{
+    filter_plane_3x3<PrewittSobelByte<true>>(src, src_stride, dst, dst_stride, *params, width, height);
+}
+
+void vs_generic_3x3_sobel_word_neon(const void *src, ptrdiff_t src_stride, void *dst, ptrdiff_t dst_stride, const struct vs_generic_params *params, unsigned width, unsigned height)
+{
+    filter_plane_3x3<PrewittSobelWord<true>>(src, src_stride, dst, dst_stride, *params, width, height);
+}
+
+void vs_generic_3x3_sobel_float_neon(const void *src, ptrdiff_t src_stride, void *dst, ptrdiff_t dst_stride, const struct vs_generic_params *params, unsigned width, unsigned height)
+{
+    filter_plane_3x3<PrewittSobelFloat<true>>(src, src_stride, dst, dst_stride, *params, width, height);
+}
+
+void vs_generic_3x3_min_byte_neon(const void *src, ptrdiff_t src_stride, void *dst, ptrdiff_t dst_stride, const struct vs_generic_params *params, unsigned width, unsigned height)
+{
+    switch (params->stencil) {
+    case STENCIL_H:
+        filter_plane_3x3<MinMaxFixedByte<STENCIL_H, false>>(src, src_stride, dst, dst_stride, *params, width, height);
+        break;
+    case STENCIL_V:
+        filter_plane_3x3<MinMaxFixedByte<STENCIL_V, false>>(src, src_stride, dst, dst_stride, *params, width, height);
+        break;
+    case STENCIL_PLUS:
+        filter_plane_3x3<MinMaxFixedByte<STENCIL_PLUS, false>>(src, src_stride, dst, dst_stride, *params, width, height);
+        break;
+    case STENCIL_ALL:
+        filter_plane_3x3<MinMaxFixedByte<STENCIL_ALL, false>>(src, src_stride, dst, dst_stride, *params, width, height);
+        break;
+    default:
+        filter_plane_3x3<MinMaxByte<false>>(src, src_stride, dst, dst_stride, *params, width, height);
+        break;
+    }
+}
+
+void vs_generic_3x3_min_word_neon(const void *src, ptrdiff_t src_stride, void *dst, ptrdiff_t dst_stride, const struct vs_generic_params *params, unsigned width, unsigned height)
+{
+    switch (params->stencil) {
+    case STENCIL_H:
+        filter_plane_3x3<MinMaxFixedWord<STENCIL_H, false>>(src, src_stride, dst, dst_stride, *params, width, height);
+        break;
+    case STENCIL_V:
+        filter_plane_3x3<MinMaxFixedWord<STENCIL_V, false>>(src, src_stride, dst, dst_stride, *params, width, height);
+        break;
+    case STENCIL_PLUS:
+        filter_plane_3x3<MinMaxFixedWord<STENCIL_PLUS, false>>(src, src_stride, dst, dst_stride, *params, width, height);
+        break;
+    case STENCIL_ALL:
+        filter_plane_3x3<MinMaxFixedWord<STENCIL_ALL, false>>(src, src_stride, dst, dst_stride, *params, width, height);
+        break;
+    default:
+        filter_plane_3x3<MinMaxWord<false>>(src, src_stride, dst, dst_stride, *params, width, height);
+        break;
+    }
+}
+
+void vs_generic_3x3_min_float_neon(const void *src, ptrdiff_t src_stride, void *dst, ptrdiff_t dst_stride, const struct vs_generic_params *params, unsigned width, unsigned height)
+{
+    switch (params->stencil) {
+    case STENCIL_H:
+        filter_plane_3x3<MinMaxFixedFloat<STENCIL_H, false>>(src, src_stride, dst, dst_stride, *params, width, height);
+        break;
+    case STENCIL_V:
+        filter_plane_3x3<MinMaxFixedFloat<STENCIL_V, false>>(src, src_stride, dst, dst_stride, *params, width, height);
+        break;
+    case STENCIL_PLUS:
+        filter_plane_3x3<MinMaxFixedFloat<STENCIL_PLUS, false>>(src, src_stride, dst, dst_stride, *params, width, height);
+        break;
+    case STENCIL_ALL:
+        filter_plane_3x3<MinMaxFixedFloat<STENCIL_ALL, false>>(src, src_stride, dst, dst_stride, *params, width, height);
+        break;
+    default:
+        filter_plane_3x3<MinMaxFloat<false>>(src, src_stride, dst, dst_stride, *params, width, height);
+        break;
+    }
+}
+
+void vs_generic_3x3_max_byte_neon(const void *src, ptrdiff_t src_stride, void *dst, ptrdiff_t dst_stride, const struct vs_generic_params *params, unsigned width, unsigned height)
+{
+    switch (params->stencil) {
+    case STENCIL_H:
+        filter_plane_3x3<MinMaxFixedByte<STENCIL_H, true>>(src, src_stride, dst, dst_stride, *params, width, height);
+        break;
+    case STENCIL_V:
+        filter_plane_3x3<MinMaxFixedByte<STENCIL_V, true>>(src, src_stride, dst, dst_stride, *params, width, height);
+        break;
+    case STENCIL_PLUS:
+        filter_plane_3x3<MinMaxFixedByte<STENCIL_PLUS, true>>(src, src_stride, dst, dst_stride, *params, width, height);
+        break;
+    case STENCIL_ALL:
+        filter_plane_3x3<MinMaxFixedByte<STENCIL_ALL, true>>(src, src_stride, dst, dst_stride, *params, width, height);
+        break;
+    default:
+        filter_plane_3x3<MinMaxByte<true>>(src, src_stride, dst, dst_stride, *params, width, height);
+        break;
+    }
+}
+
+void vs_generic_3x3_max_word_neon(const void *src, ptrdiff_t src_stride, void *dst, ptrdiff_t dst_stride, const struct vs_generic_params *params, unsigned width, unsigned height)
+{
+    switch (params->stencil) {
+    case STENCIL_H:
+        filter_plane_3x3<MinMaxFixedWord<STENCIL_H, true>>(src, src_stride, dst, dst_stride, *params, width, height);
+        break;
+    case STENCIL_V:
+        filter_plane_3x3<MinMaxFixedWord<STENCIL_V, true>>(src, src_stride, dst, dst_stride, *params, width, height);
+        break;
+    case STENCIL_PLUS:
+        filter_plane_3x3<MinMaxFixedWord<STENCIL_PLUS, true>>(src, src_stride, dst, dst_stride, *params, width, height);
+        break;
+    case STENCIL_ALL:
+        filter_plane_3x3<MinMaxFixedWord<STENCIL_ALL, true>>(src, src_stride, dst, dst_stride, *params, width, height);
+        break;
+    default:
+        filter_plane_3x3<MinMaxWord<true>>(src, src_stride, dst, dst_stride, *params, width, height);
+        break;
+    }
+}
+
+void vs_generic_3x3_max_float_neon(const void *src, ptrdiff_t src_stride, void *dst, ptrdiff_t dst_stride, const struct vs_generic_params *params, unsigned width, unsigned height)
+{
+    switch (params->stencil) {
+    case STENCIL_H:
+        filter_plane_3x3<MinMaxFixedFloat<STENCIL_H, true>>(src, src_stride, dst, dst_stride, *params, width, height);
+        break;
+    case STENCIL_V:
+        filter_plane_3x3<MinMaxFixedFloat<STENCIL_V, true>>(src, src_stride, dst, dst_stride, *params, width, height);
+        break;
+    case STENCIL_PLUS:
+        filter_plane_3x3<MinMaxFixedFloat<STENCIL_PLUS, true>>(src, src_stride, dst, dst_stride, *params, width, height);
+        break;
+    case STENCIL_ALL:
+        filter_plane_3x3<MinMaxFixedFloat<STENCIL_ALL, true>>(src, src_stride, dst, dst_stride, *params, width, height);
+        break;
+    default:
+        filter_plane_3x3<MinMaxFloat<true>>(src, src_stride, dst, dst_stride, *params, width, height);
+        break;
+    }
+}
+
+void vs_generic_3x3_median_byte_neon(const void *src, ptrdiff_t src_stride, void *dst, ptrdiff_t dst_stride, const struct vs_generic_params *params, unsigned width, unsigned height)
+{
+    filter_plane_3x3<MedianByte>(src, src_stride, dst, dst_stride, *params, width, height);
+}
+
+void vs_generic_3x3_median_word_neon(const void *src, ptrdiff_t src_stride, void *dst, ptrdiff_t dst_stride, const struct vs_generic_params *params, unsigned width, unsigned height)
+{
+    filter_plane_3x3<MedianWord>(src, src_stride, dst, dst_stride, *params, width, height);
+}
+
+void vs_generic_3x3_median_float_neon(const void *src, ptrdiff_t src_stride, void *dst, ptrdiff_t dst_stride, const struct vs_generic_params *params, unsigned width, unsigned height)
+{
+    filter_plane_3x3<MedianFloat>(src, src_stride, dst, dst_stride, *params, width, height);
+}
+
+void vs_generic_3x3_deflate_byte_neon(const void *src, ptrdiff_t src_stride, void *dst, ptrdiff_t dst_stride, const struct vs_generic_params *params, unsigned width, unsigned height)
+{
+    filter_plane_3x3<DeflateInflateByte<false>>(src, src_stride, dst, dst_stride, *params, width, height);
+}
+
+void vs_generic_3x3_deflate_word_neon(const void *src, ptrdiff_t src_stride, void *dst, ptrdiff_t dst_stride, const struct vs_generic_params *params, unsigned width, unsigned height)
+{
+    filter_plane_3x3<DeflateInflateWord<false>>(src, src_stride, dst, dst_stride, *params, width, height);
+}
+
+void vs_generic_3x3_deflate_float_neon(const void *src, ptrdiff_t src_stride, void *dst, ptrdiff_t dst_stride, const struct vs_generic_params *params, unsigned width, unsigned height)
+{
+    filter_plane_3x3<DeflateInflateFloat<false>>(src, src_stride, dst, dst_stride, *params, width, height);
+}
+
+void vs_generic_3x3_inflate_byte_neon(const void *src, ptrdiff_t src_stride, void *dst, ptrdiff_t dst_stride, const struct vs_generic_params *params, unsigned width, unsigned height)
+{
+    filter_plane_3x3<DeflateInflateByte<true>>(src, src_stride, dst, dst_stride, *params, width, height);
+}
+
+void vs_generic_3x3_inflate_word_neon(const void *src, ptrdiff_t src_stride, void *dst, ptrdiff_t dst_stride, const struct vs_generic_params *params, unsigned width, unsigned height)
+{
+    filter_plane_3x3<DeflateInflateWord<true>>(src, src_stride, dst, dst_stride, *params, width, height);
+}
+
+void vs_generic_3x3_inflate_float_neon(const void *src, ptrdiff_t src_stride, void *dst, ptrdiff_t dst_stride, const struct vs_generic_params *params, unsigned width, unsigned height)
+{
+    filter_plane_3x3<DeflateInflateFloat<true>>(src, src_stride, dst, dst_stride, *params, width, height);
+}
+
+void vs_generic_3x3_conv_byte_neon(const void *src, ptrdiff_t src_stride, void *dst, ptrdiff_t dst_stride, const struct vs_generic_params *params, unsigned width, unsigned height)
+{
+    filter_plane_3x3<ConvolutionByte>(src, src_stride, dst, dst_stride, *params, width, height);
+}
+
+void vs_generic_3x3_conv_word_neon(const void *src, ptrdiff_t src_stride, void *dst, ptrdiff_t dst_stride, const struct vs_generic_params *params, unsigned width, unsigned height)
+{
+    filter_plane_3x3<ConvolutionWord>(src, src_stride, dst, dst_stride, *params, width, height);
+}
+
+void vs_generic_3x3_conv_float_neon(const void *src, ptrdiff_t src_stride, void *dst, ptrdiff_t dst_stride, const struct vs_generic_params *params, unsigned width, unsigned height)
+{
+    filter_plane_3x3<ConvolutionFloat>(src, src_stride, dst, dst_stride, *params, width, height);
+}
+
+void vs_generic_separable_conv_byte_neon(const void *src, ptrdiff_t src_stride, void *dst, ptrdiff_t dst_stride, const struct vs_generic_params *params, unsigned width, unsigned height)
+{
+    conv_plane_separable<SeparableByte>(src, src_stride, dst, dst_stride, *params, width, height);
+}
+
+void vs_generic_separable_conv_word_neon(const void *src, ptrdiff_t src_stride, void *dst, ptrdiff_t dst_stride, const struct vs_generic_params *params, unsigned width, unsigned height)
+{
+    conv_plane_separable<SeparableWord>(src, src_stride, dst, dst_stride, *params, width, height);
+}
+
+void vs_generic_separable_conv_float_neon(const void *src, ptrdiff_t src_stride, void *dst, ptrdiff_t dst_stride, const struct vs_generic_params *params, unsigned width, unsigned height)
+{
+    conv_plane_separable<SeparableFloat>(src, src_stride, dst, dst_stride, *params, width, height);
+}
+
+void vs_generic_rank_byte_neon(const void *src, ptrdiff_t src_stride, void *dst, ptrdiff_t dst_stride, const struct vs_generic_params *params, unsigned width, unsigned height)
+{
+    vs_rank::rank_plane<uint8_t, RankOps>(src, src_stride, dst, dst_stride, *params, width, height);
+}
+
+void vs_generic_rank_word_neon(const void *src, ptrdiff_t src_stride, void *dst, ptrdiff_t dst_stride, const struct vs_generic_params *params, unsigned width, unsigned height)
+{
+    vs_rank::rank_plane<uint16_t, RankOps>(src, src_stride, dst, dst_stride, *params, width, height);
+}
@@ -0,0 +1,432 @@
+/*
+* Copyright (c) 2012-2019 Fredrik Mellbin
+*
+* This file is part of VapourSynth.
+*
+* VapourSynth is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 2.1 of the License, or (at your option) any later version.
+*
+* VapourSynth is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with VapourSynth; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include <arm_neon.h>
+#define VS_MERGE_IMPL
+#include "../merge.h"
+#include "VSHelper4.h"
+
+#define MERGESHIFT 15
+
+/* round(x / 255) for x <= 255 * 255. */
+static uint16x8_t div255_round_u16(uint16x8_t x)
+{
+    return vrshrq_n_u16(vrsraq_n_u16(x, x, 8), 8);
+}
+
+/* (x * div) >> (32 + shift) using the magic numbers from merge.h. */
+static uint32x4_t div_magic_u32(uint32x4_t x, uint32_t div, int32x4_t neg_shift)
+{
+    uint64x2_t lo = vmull_u32(vget_low_u32(x), vdup_n_u32(div));
+    uint64x2_t hi = vmull_high_u32(x, vdupq_n_u32(div));
+    uint32x4_t result = vcombine_u32(vshrn_n_u64(lo, 32), vshrn_n_u64(hi, 32));
+    return vshlq_u32(result, neg_shift);
+}
+
+static int16x8_t premul_u8(uint8x8_t x, uint8x8_t a, uint8x8_t offset)
+{
+    int16x8_t tmp = vreinterpretq_s16_u16(vsubl_u8(x, offset));
+    uint16x8_t absval = vreinterpretq_u16_s16(vabsq_s16(tmp));
+    int16x8_t result = vreinterpretq_s16_u16(div255_round_u16(vmulq_u16(absval, vmovl_u8(a))));
+    return vbslq_s16(vcltzq_s16(tmp), vnegq_s16(result), result);
+}
+
+static int32x4_t premul_u16(uint32x4_t x, uint32x4_t a, uint32x4_t offset, uint32x4_t round, uint32_t div, int32x4_t neg_shift)
+{
+    int32x4_t tmp = vreinterpretq_s32_u32(vsubq_u32(x, offset));
+    uint32x4_t absval = vreinterpretq_u32_s32(vabsq_s32(tmp));
+    int32x4_t result = vreinterpretq_s32_u32(div_magic_u32(vmlaq_u32(round, absval, a), div, neg_shift));
+    return vbslq_s32(vcltzq_s32(tmp), vnegq_s32(result), result);
+}
+
+void vs_premultiply_byte_neon(const void *src1, const void *src2, void *dst, unsigned depth, unsigned offset, unsigned n)
+{
+    const uint8_t *srcp1 = src1;
+    const uint8_t *srcp2 = src2;
+    uint8_t *dstp = dst;
+    unsigned i;
+
+    uint8x8_t off8 = vdup_n_u8(offset);
+    int16x8_t off16 = vdupq_n_s16(offset);
+
+    (void)depth;
+
+    for (i = 0; i < n; i += 16) {
+        uint8x16_t v1 = vld1q_u8(srcp1 + i);
+        uint8x16_t v2 = vld1q_u8(srcp2 + i);
+
+        int16x8_t lo = vaddq_s16(premul_u8(vget_low_u8(v1), vget_low_u8(v2), off8), off16);
+        int16x8_t hi = vaddq_s16(premul_u8(vget_high_u8(v1), vget_high_u8(v2), off8), off16);
+
+        vst1q_u8(dstp + i, vcombine_u8(vmovn_u16(vreinterpretq_u16_s16(lo)), vmovn_u16(vreinterpretq_u16_s16(hi))));
+    }
+}
+
+void vs_premultiply_word_neon(const void *src1, const void *src2, void *dst, unsigned depth, unsigned offset, unsigned n)
+{
+    const uint16_t *srcp1 = src1;
+    const uint16_t *srcp2 = src2;
+    uint16_t *dstp = dst;
+    unsigned i;
+
+    uint32x4_t off = vdupq_n_u32(offset);
+    uint32x4_t round = vdupq_n_u32(((1U << depth) - 1) / 2);
+    uint32_t div = div_table[depth - 9];
+    int32x4_t neg_shift = vdupq_n_s32(-(int)shift_table[depth - 9]);
+
+    for (i = 0; i < n; i += 8) {
+        uint16x8_t v1 = vld1q_u16(srcp1 + i);
+        uint16x8_t v2 = vld1q_u16(srcp2 + i);
+
+        int32x4_t lo = premul_u16(vmovl_u16(vget_low_u16(v1)), vmovl_u16(vget_low_u16(v2)), off, round, div, neg_shift);
+        int32x4_t hi = premul_u16(vmovl_high_u16(v1), vmovl_high_u16(v2), off, round, div, neg_shift);
+        lo = vaddq_s32(lo, vreinterpretq_s32_u32(off));
+        hi = vaddq_s32(hi, vreinterpretq_s32_u32(off));
+
+        vst1q_u16(dstp + i, vcombine_u16(vmovn_u32(vreinterpretq_u32_s32(lo)), vmovn_u32(vreinterpretq_u32_s32(hi))));
+    }
+}
+
+void vs_premultiply_float_neon(const void *src1, const void *src2, void *dst, unsigned depth, unsigned offset, unsigned n)
+{
+    const float *srcp1 = src1;
+    const float *srcp2 = src2;
+    float *dstp = dst;
+    unsigned i;
+
+    (void)depth;
+    (void)offset;
+
+    for (i = 0; i < n; i += 4) {
+        vst1q_f32(dstp + i, vmulq_f32(vld1q_f32(srcp1 + i), vld1q_f32(srcp2 + i)));
+    }
+}
+
+void vs_merge_byte_neon(const void *src1, const void *src2, void *dst, union vs_merge_weight weight, unsigned n)
+{
+    const uint8_t *srcp1 = src1;
+    const uint8_t *srcp2 = src2;
+    uint8_t *dstp = dst;
+    unsigned i;
+
+    int16x8_t w = vdupq_n_s16(weight.u);
+
+    for (i = 0; i < n; i += 16) {
+        uint8x16_t v1 = vld1q_u8(srcp1 + i);
+        uint8x16_t v2 = vld1q_u8(srcp2 + i);
+
+        int16x8_t difflo = vreinterpretq_s16_u16(vsubl_u8(vget_low_u8(v2), vget_low_u8(v1)));
+        int16x8_t diffhi = vreinterpretq_s16_u16(vsubl_high_u8(v2, v1));
+
+        // ((v2 - v1) * w + ROUND) >> MERGESHIFT
+        int16x8_t tmplo = vcombine_s16(vrshrn_n_s32(vmull_s16(vget_low_s16(difflo), vget_low_s16(w)), MERGESHIFT), vrshrn_n_s32(vmull_high_s16(difflo, w), MERGESHIFT));
+        int16x8_t tmphi = vcombine_s16(vrshrn_n_s32(vmull_s16(vget_low_s16(diffhi), vget_low_s16(w)), MERGESHIFT), vrshrn_n_s32(vmull_high_s16(diffhi, w), MERGESHIFT));
+
+        int8x16_t tmp = vcombine_s8(vmovn_s16(tmplo), vmovn_s16(tmphi));
+        vst1q_u8(dstp + i, vaddq_u8(v1, vreinterpretq_u8_s8(tmp)));
+    }
+}
+
+void vs_merge_word_neon(const void *src1, const void *src2, void *dst, union vs_merge_weight weight, unsigned n)
+{
+    const uint16_t *srcp1 = src1;
+    const uint16_t *srcp2 = src2;
+    uint16_t *dstp = dst;
+    unsigned i;
+
+    int32_t w = weight.u;
+
+    for (i = 0; i < n; i += 8) {
+        uint16x8_t v1 = vld1q_u16(srcp1 + i);
+        uint16x8_t v2 = vld1q_u16(srcp2 + i);
+
+        int32x4_t difflo = vreinterpretq_s32_u32(vsubl_u16(vget_low_u16(v2), vget_low_u16(v1)));
+        int32x4_t diffhi = vreinterpretq_s32_u32(vsubl_high_u16(v2, v1));
+
+        int16x8_t tmp = vcombine_s16(vrshrn_n_s32(vmulq_n_s32(difflo, w), MERGESHIFT), vrshrn_n_s32(vmulq_n_s32(diffhi, w), MERGESHIFT));
+        vst1q_u16(dstp + i, vaddq_u16(v1, vreinterpretq_u16_s16(tmp)));
+    }
+}
+
+void vs_merge_float_neon(const void *src1, const void *src2, void *dst, union vs_merge_weight weight, unsigned n)
+{
+    const float *srcp1 = src1;
+    const float *srcp2 = src2;
+    float *dstp = dst;
+    unsigned i;
+
+    float32x4_t w = vdupq_n_f32(weight.f);
+
+    for (i = 0; i < n; i += 4) {
+        float32x4_t v1 = vld1q_f32(srcp1 + i);
+        float32x4_t v2 = vld1q_f32(srcp2 + i);
+        vst1q_f32(dstp + i, vaddq_f32(v1, vmulq_f32(vsubq_f32(v2, v1), w)));
+    }
+}
+
+void vs_mask_merge_byte_neon(const void *src1, const void *src2, const void *mask, void *dst, unsigned depth, unsigned offset, unsigned n)
+{
+    const uint8_t *srcp1 = src1;
+    const uint8_t *srcp2 = src2;
+    const uint8_t *maskp = mask;
+    uint8_t *dstp = dst;
+    unsigned i;
+
+    (void)depth;
+    (void)offset;
+
+    for (i = 0; i < n; i += 16) {
+        uint8x16_t v1 = vld1q_u8(srcp1 + i);
+        uint8x16_t v2 = vld1q_u8(srcp2 + i);
+        uint8x16_t m = vld1q_u8(maskp + i);
+        uint8x16_t invmask = vmvnq_u8(m);
+
+        uint16x8_t tmplo = vmlal_u8(vmull_u8(vget_low_u8(invmask), vget_low_u8(v1)), vget_low_u8(m), vget_low_u8(v2));
+        uint16x8_t tmphi = vmlal_high_u8(vmull_high_u8(invmask, v1), m, v2);
+
+        vst1q_u8(dstp + i, vcombine_u8(vmovn_u16(div255_round_u16(tmplo)), vmovn_u16(div255_round_u16(tmphi))));
+    }
+}
+
+void vs_mask_merge_word_neon(const void *src1, const void *src2, const void *mask, void *dst, unsigned depth, unsigned offset, unsigned n)
+{
+    const uint16_t *srcp1 = src1;
+    const uint16_t *srcp2 = src2;
+    const uint16_t *maskp = mask;
+    uint16_t *dstp = dst;
+    unsigned i;
+
+    uint16x8_t maxval = vdupq_n_u16((1U << depth) - 1);
+    uint32x4_t round = vdupq_n_u32(((1U << depth) - 1) / 2);
+    uint32_t div = div_table[depth - 9];
+    int32x4_t neg_shift = vdupq_n_s32(-(int)shift_table[depth - 9]);
+
+    (void)offset;
+
+    for (i = 0; i < n; i += 8) {
+        uint16x8_t v1 = vld1q_u16(srcp1 + i);
+        uint16x8_t v2 = vld1q_u16(srcp2 + i);
+        uint16x8_t m = vld1q_u16(maskp + i);
+        uint16x8_t invmask = vsubq_u16(maxval, m);
+
+        uint32x4_t tmplo = vmlal_u16(vmlal_u16(round, vget_low_u16(invmask), vget_low_u16(v1)), vget_low_u16(m), vget_low_u16(v2));
+        uint32x4_t tmphi = vmlal_high_u16(vmlal_high_u16(round, invmask, v1), m, v2);
+
+        vst1q_u16(dstp + i, vcombine_u16(vmovn_u32(div_magic_u32(tmplo, div, neg_shift)), vmovn_u32(div_magic_u32(tmphi, div, neg_shift))));
+    }
+}
+
+void vs_mask_merge_float_neon(const void *src1, const void *src2, const void *mask, void *dst, unsigned depth, unsigned offset, unsigned n)
+{
+    const float *srcp1 = src1;
+    const float *srcp2 = src2;
+    const float *maskp = mask;
+    float *dstp = dst;
+    unsigned i;
+
+    (void)depth;
+    (void)offset;
+
+    for (i = 0; i < n; i += 4) {
+        float32x4_t v1 = vld1q_f32(srcp1 + i);
+        float32x4_t v2 = vld1q_f32(srcp2 + i);
+        float32x4_t m = vld1q_f32(maskp + i);
+        vst1q_f32(dstp + i, vaddq_f32(v1, vmulq_f32(vsubq_f32(v2, v1), m)));
+    }
+}
+
+void vs_mask_merge_premul_byte_neon(const void *src1, const void *src2, const void *mask, void *dst, unsigned depth, unsigned offset, unsigned n)
+{
+    const uint8_t *srcp1 = src1;
+    const uint8_t *srcp2 = src2;
+    const uint8_t *maskp = mask;
+    uint8_t *dstp = dst;
+    unsigned i;
+
+    uint8x8_t off8 = vdup_n_u8(offset);
+
+    (void)depth;
+
+    for (i = 0; i < n; i += 16) {
+        uint8x16_t v1 = vld1q_u8(srcp1 + i);
+        uint8x16_t v2 = vld1q_u8(srcp2 + i);
+        uint8x16_t invmask = vmvnq_u8(vld1q_u8(maskp + i));
+
+        int16x8_t lo = premul_u8(vget_low_u8(v1), vget_low_u8(invmask), off8);
+        int16x8_t hi = premul_u8(vget_high_u8(v1), vget_high_u8(invmask), off8);
+        lo = vaddq_s16(lo, vreinterpretq_s16_u16(vmovl_u8(vget_low_u8(v2))));
+        hi = vaddq_s16(hi, vreinterpretq_s16_u16(vmovl_high_u8(v2)));
+
+        vst1q_u8(dstp + i, vcombine_u8(vqmovun_s16(lo), vqmovun_s16(hi)));
+    }
+}
+
+void vs_mask_merge_premul_word_neon(const void *src1, const void *src2, const void *mask, void *dst, unsigned depth, unsigned offset, unsigned n)
+{
+    const uint16_t *srcp1 = src1;
+    const uint16_t *srcp2 = src2;
+    const uint16_t *maskp = mask;
+    uint16_t *dstp = dst;
+    unsigned i;
+
+    uint16x8_t maxval = vdupq_n_u16((1U << depth) - 1);
+    uint32x4_t off = vdupq_n_u32(offset);
+    uint32x4_t round = vdupq_n_u32(((1U << depth) - 1) / 2);
+    uint32_t div = div_table[depth - 9];
+    int32x4_t neg_shift = vdupq_n_s32(-(int)shift_table[depth - 9]);
+
+    for (i = 0; i < n; i += 8) {
+        uint16x8_t v1 = vld1q_u16(srcp1 + i);
+        uint16x8_t v2 = vld1q_u16(srcp2 + i);
+        uint16x8_t invmask = vsubq_u16(maxval, vld1q_u16(maskp + i));
+
+        int32x4_t lo = premul_u16(vmovl_u16(vget_low_u16(v1)), vmovl_u16(vget_low_u16(invmask)), off, round, div, neg_shift);
+        int32x4_t hi = premul_u16(vmovl_high_u16(v1), vmovl_high_u16(invmask), off, round, div, neg_shift);
+        lo = vaddq_s32(lo, vreinterpretq_s32_u32(vmovl_u16(vget_low_u16(v2))));
+        hi = vaddq_s32(hi, vreinterpretq_s32_u32(vmovl_high_u16(v2)));
+
+        vst1q_u16(dstp + i, vminq_u16(vcombine_u16(vqmovun_s32(lo), vqmovun_s32(hi)), maxval));
+    }
+}
+
+void vs_mask_merge_premul_float_neon(const void *src1, const void *src2, const void *mask, void *dst, unsigned depth, unsigned offset, unsigned n)
+{
+    const float *srcp1 = src1;
+    const float *srcp2 = src2;
+    const float *maskp = mask;
+    float *dstp = dst;
+    unsigned i;
+
+    (void)depth;
+    (void)offset;
+
+    for (i = 0; i < n; i += 4) {
+        float32x4_t v1 = vld1q_f32(srcp1 + i);
+        float32x4_t v2 = vld1q_f32(srcp2 + i);
+        float32x4_t invmask = vsubq_f32(vdupq_n_f32(1.0f), vld1q_f32(maskp + i));
+        vst1q_f32(dstp + i, vaddq_f32(vmulq_f32(invmask, v1), v2));
+    }
+}
+
+void vs_makediff_byte_neon(const void *src1, const void *src2, void *dst, unsigned depth, unsigned n)
+{
+    const uint8_t *srcp1 = src1;
+    const uint8_t *srcp2 = src2;
+    uint8_t *dstp = dst;
+    unsigned i;
+
+    int8x16_t sign = vdupq_n_s8(INT8_MIN);
+
+    (void)depth;
+
+    for (i = 0; i < n; i += 16) {
+        int8x16_t v1 = veorq_s8(vreinterpretq_s8_u8(vld1q_u8(srcp1 + i)), sign);
+        int8x16_t v2 = veorq_s8(vreinterpretq_s8_u8(vld1q_u8(srcp2 + i)), sign);
+        vst1q_u8(dstp + i, vreinterpretq_u8_s8(veorq_s8(vqsubq_s8(v1, v2), sign)));
+    }
+}
+
+void vs_makediff_word_neon(const void *src1, const void *src2, void *dst, unsigned depth, unsigned n)
+{
+    const uint16_t *srcp1 = src1;
+    const uint16_t *srcp2 = src2;
+    uint16_t *dstp = dst;
+    unsigned i;
+
+    int32x4_t half = vdupq_n_s32(1U << (depth - 1));
+    uint16x8_t maxval = vdupq_n_u16((1U << depth) - 1);
+
+    for (i = 0; i < n; i += 8) {
+        uint16x8_t v1 = vld1q_u16(srcp1 + i);
+        uint16x8_t v2 = vld1q_u16(srcp2 + i);
+
+        int32x4_t lo = vaddq_s32(vreinterpretq_s32_u32(vsubl_u16(vget_low_u16(v1), vget_low_u16(v2))), half);
+        int32x4_t hi = vaddq_s32(vreinterpretq_s32_u32(vsubl_high_u16(v1, v2)), half);
+
+        vst1q_u16(dstp + i, vminq_u16(vcombine_u16(vqmovun_s32(lo), vqmovun_s32(hi)), maxval));
+    }
+}
+
+void vs_makediff_float_neon(const void *src1, const void *src2, void *dst, unsigned depth, unsigned n)
+{
+    const float *srcp1 = src1;
+    const float *srcp2 = src2;
+    float *dstp = dst;
+    unsigned i;
+
+    (void)depth;
+
+    for (i = 0; i < n; i += 4) {
+        vst1q_f32(dstp + i, vsubq_f32(vld1q_f32(srcp1 + i), vld1q_f32(srcp2 + i)));
+    }
+}
+
+void vs_mergediff_byte_neon(const void *src1, const void *src2, void *dst, unsigned depth, unsigned n)
+{
+    const uint8_t *srcp1 = src1;
+    const uint8_t *srcp2 = src2;
+    uint8_t *dstp = dst;
+    unsigned i;
+
+    int8x16_t sign = vdupq_n_s8(INT8_MIN);
+
+    (void)depth;
+
+    for (i = 0; i < n; i += 16) {
+        int8x16_t v1 = veorq_s8(vreinterpretq_s8_u8(vld1q_u8(srcp1 + i)), sign);
+        int8x16_t v2 = veorq_s8(vreinterpretq_s8_u8(vld1q_u8(srcp2 + i)), sign);
+        vst1q_u8(dstp + i, vreinterpretq_u8_s8(veorq_s8(vqaddq_s8(v1, v2), sign)));
+    }
+}
+
+void vs_mergediff_word_neon(const void *src1, const void *src2, void *dst, unsigned depth, unsigned n)
+{
+    const uint16_t *srcp1 = src1;
+    const uint16_t *srcp2 = src2;
+    uint16_t *dstp = dst;
+    unsigned i;
+
+    int32x4_t half = vdupq_n_s32(1U << (depth - 1));
+    uint16x8_t maxval = vdupq_n_u16((1U << depth) - 1);
+
+    for (i = 0; i < n; i += 8) {
+        uint16x8_t v1 = vld1q_u16(srcp1 + i);
+        uint16x8_t v2 = vld1q_u16(srcp2 + i);
+
+        int32x4_t lo = vsubq_s32(vreinterpretq_s32_u32(vaddl_u16(vget_low_u16(v1), vget_low_u16(v2))), half);
+        int32x4_t hi = vsubq_s32(vreinterpretq_s32_u32(vaddl_high_u16(v1, v2)), half);
+
+        vst1q_u16(dstp + i, vminq_u16(vcombine_u16(vqmovun_s32(lo), vqmovun_s32(hi)), maxval));
+    }
+}
+
+void vs_mergediff_float_neon(const void *src1, const void *src2, void *dst, unsigned depth, unsigned n)
+{
+    const float *srcp1 = src1;
+    const float *srcp2 = src2;
+    float *dstp = dst;
+    unsigned i;
+
+    (void)depth;
+
+    for (i = 0; i < n; i += 4) {
+        vst1q_f32(dstp + i, vaddq_f32(vld1q_f32(srcp1 + i), vld1q_f32(srcp2 + i)));
+    }
+}
@@ -0,0 +1,259 @@
+/*
+* Copyright (c) 2012-2019 Fredrik Mellbin
+*
+* This file is part of VapourSynth.
+*
+* VapourSynth is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 2.1 of the License, or (at your option) any later version.
+*
+* VapourSynth is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with VapourSynth; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include <math.h>
+#include <arm_neon.h>
+#include "../planestats.h"
+
+static const uint8_t ascend8[16] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 };
+static const uint16_t ascend16[8] = { 0, 1, 2, 3, 4, 5, 6, 7 };
+static const uint32_t ascend32[4] = { 0, 1, 2, 3 };
+
+static void accumulate_f32(float64x2_t *acc, float32x4_t v)
+{
+    *acc = vaddq_f64(*acc, vcvt_f64_f32(vget_low_f32(v)));
+    *acc = vaddq_f64(*acc, vcvt_high_f64_f32(v));
+}
+
+
+void vs_plane_stats_1_byte_neon(union vs_plane_stats *stats, const void *src, ptrdiff_t stride, unsigned width, unsigned height)
+{
+    const uint8_t *srcp = src;
+    unsigned tail = width & ~15;
+    unsigned x, y;
+
+    uint8x16_t mmin = vdupq_n_u8(UINT8_MAX);
+    uint8x16_t mmax = vdupq_n_u8(0);
+    uint64x2_t macc = vdupq_n_u64(0);
+    uint8x16_t mask = vcltq_u8(vld1q_u8(ascend8), vdupq_n_u8(width % 16));
+
+    for (y = 0; y < height; y++) {
+        /* Row sums are gathered in 32 bits and widened once per row. */
+        uint32x4_t rowacc = vdupq_n_u32(0);
+
+        for (x = 0; x < tail; x += 16) {
+            uint8x16_t v = vld1q_u8(srcp + x);
+            mmin = vminq_u8(mmin, v);
+            mmax = vmaxq_u8(mmax, v);
+            rowacc = vpadalq_u16(rowacc, vpaddlq_u8(v));
+        }
+        if (width != tail) {
+            uint8x16_t v = vandq_u8(vld1q_u8(srcp + tail), mask);
+            mmin = vminq_u8(mmin, vornq_u8(v, mask));
+            mmax = vmaxq_u8(mmax, v);
+            rowacc = vpadalq_u16(rowacc, vpaddlq_u8(v));
+        }
+        macc = vpadalq_u32(macc, rowacc);
+        srcp += stride;
+    }
+
+    stats->i.min = vminvq_u8(mmin);
+    stats->i.max = vmaxvq_u8(mmax);
+    stats->i.acc = vaddvq_u64(macc);
+}
+
+void vs_plane_stats_1_word_neon(union vs_plane_stats *stats, const void *src, ptrdiff_t stride, unsigned width, unsigned height)
+{
+    const uint8_t *srcp = src;
+    unsigned tail = width & ~7;
+    unsigned x, y;
+
+    uint16x8_t mmin = vdupq_n_u16(UINT16_MAX);
+    uint16x8_t mmax = vdupq_n_u16(0);
+    uint64x2_t macc = vdupq_n_u64(0);
+    uint16x8_t mask = vcltq_u16(vld1q_u16(ascend16), vdupq_n_u16(width % 8));
+
+    for (y = 0; y < height; y++) {
+        for (x = 0; x < tail; x += 8) {
+            uint16x8_t v = vld1q_u16((const uint16_t *)srcp + x);
+            mmin = vminq_u16(mmin, v);
+            mmax = vmaxq_u16(mmax, v);
+            macc = vpadalq_u32(macc, vpaddlq_u16(v));
+        }
+        if (width != tail) {
+            uint16x8_t v = vandq_u16(vld1q_u16((const uint16_t *)srcp + tail), mask);
+            mmin = vminq_u16(mmin, vornq_u16(v, mask));
+            mmax = vmaxq_u16(mmax, v);
+            macc = vpadalq_u32(macc, vpaddlq_u16(v));
+        }
+        srcp += stride;
+    }
+
+    stats->i.min = vminvq_u16(mmin);
+    stats->i.max = vmaxvq_u16(mmax);
+    stats->i.acc = vaddvq_u64(macc);
+}
+
+void vs_plane_stats_1_float_neon(union vs_plane_stats *stats, const void *src, ptrdiff_t stride, unsigned width, unsigned height)
+{
+    const uint8_t *srcp = src;
+    unsigned tail = width & ~3;
+    unsigned x, y;
+
+    float32x4_t fmmin = vdupq_n_f32(INFINITY);
+    float32x4_t fmmax = vdupq_n_f32(-INFINITY);
+    float64x2_t fmacc = vdupq_n_f64(0.0);
+    uint32x4_t mask = vcltq_u32(vld1q_u32(ascend32), vdupq_n_u32(width % 4));
+
+    for (y = 0; y < height; y++) {
+        for (x = 0; x < tail; x += 4) {
+            float32x4_t v = vld1q_f32((const float *)srcp + x);
+            fmmin = vminq_f32(fmmin, v);
+            fmmax = vmaxq_f32(fmmax, v);
+            accumulate_f32(&fmacc, v);
+        }
+        if (width != tail) {
+            float32x4_t v = vld1q_f32((const float *)srcp + tail);
+            fmmin = vminq_f32(fmmin, vbslq_f32(mask, v, vdupq_n_f32(INFINITY)));
+            fmmax = vmaxq_f32(fmmax, vbslq_f32(mask, v, vdupq_n_f32(-INFINITY)));
+            accumulate_f32(&fmacc, vbslq_f32(mask, v, vdupq_n_f32(0.0f)));
+        }
+        srcp += stride;
+    }
+
+    stats->f.min = vminvq_f32(fmmin);
+    stats->f.max = vmaxvq_f32(fmmax);
+    stats->f.acc = vaddvq_f64(fmacc);
+}
+
+void vs_plane_stats_2_byte_neon(union vs_plane_stats *stats, const void *src1, ptrdiff_t src1_stride, const void *src2, ptrdiff_t src2_stride, unsigned width, unsigned height)
+{
+    const uint8_t *srcp1 = src1;
+    const uint8_t *srcp2 = src2;
+    unsigned tail = width & ~15;
+    unsigned x, y;
+
+    uint8x16_t mmin = vdupq_n_u8(UINT8_MAX);
+    uint8x16_t mmax = vdupq_n_u8(0);
+    uint64x2_t macc = vdupq_n_u64(0);
+    uint64x2_t mdiffacc = vdupq_n_u64(0);
+    uint8x16_t mask = vcltq_u8(vld1q_u8(ascend8), vdupq_n_u8(width % 16));
+
+    for (y = 0; y < height; y++) {
+        uint32x4_t rowacc = vdupq_n_u32(0);
+        uint32x4_t rowdiffacc = vdupq_n_u32(0);
+
+        for (x = 0; x < tail; x += 16) {
+            uint8x16_t v1 = vld1q_u8(srcp1 + x);
+            uint8x16_t v2 = vld1q_u8(srcp2 + x);
+            mmin = vminq_u8(mmin, v1);
+            mmax = vmaxq_u8(mmax, v1);
+            rowacc = vpadalq_u16(rowacc, vpaddlq_u8(v1));
+            rowdiffacc = vpadalq_u16(rowdiffacc, vpaddlq_u8(vabdq_u8(v1, v2)));
+        }
+        if (width != tail) {
+            uint8x16_t v1 = vandq_u8(vld1q_u8(srcp1 + tail), mask);
+            uint8x16_t v2 = vandq_u8(vld1q_u8(srcp2 + tail), mask);
+            mmin = vminq_u8(mmin, vornq_u8(v1, mask));
+            mmax = vmaxq_u8(mmax, v1);
+            rowacc = vpadalq_u16(rowacc, vpaddlq_u8(v1));
+            rowdiffacc = vpadalq_u16(rowdiffacc, vpaddlq_u8(vabdq_u8(v1, v2)));
+        }
+        macc = vpadalq_u32(macc, rowacc);
+        mdiffacc = vpadalq_u32(mdiffacc, rowdiffacc);
+        srcp1 += src1_stride;
+        srcp2 += src2_stride;
+    }
+
+    stats->i.min = vminvq_u8(mmin);
+    stats->i.max = vmaxvq_u8(mmax);
+    stats->i.acc = vaddvq_u64(macc);
+    stats->i.diffacc = vaddvq_u64(mdiffacc);
+}
+
+void vs_plane_stats_2_word_neon(union vs_plane_stats *stats, const void *src1, ptrdiff_t src1_stride, const void *src2, ptrdiff_t src2_stride, unsigned width, unsigned height)
+{
+    const uint8_t *srcp1 = src1;
+    const uint8_t *srcp2 = src2;
+    unsigned tail = width & ~7;
+    unsigned x, y;
+
+    uint16x8_t mmin = vdupq_n_u16(UINT16_MAX);
+    uint16x8_t mmax = vdupq_n_u16(0);
+    uint64x2_t macc = vdupq_n_u64(0);
+    uint64x2_t mdiffacc = vdupq_n_u64(0);
+    uint16x8_t mask = vcltq_u16(vld1q_u16(ascend16), vdupq_n_u16(width % 8));
+
+    for (y = 0; y < height; y++) {
+        for (x = 0; x < tail; x += 8) {
+            uint16x8_t v1 = vld1q_u16((const uint16_t *)srcp1 + x);
+            uint16x8_t v2 = vld1q_u16((const uint16_t *)srcp2 + x);
+            mmin = vminq_u16(mmin, v1);
+            mmax = vmaxq_u16(mmax, v1);
+            macc = vpadalq_u32(macc, vpaddlq_u16(v1));
+            mdiffacc = vpadalq_u32(mdiffacc, vpaddlq_u16(vabdq_u16(v1, v2)));
+        }
+        if (width != tail) {
+            uint16x8_t v1 = vandq_u16(vld1q_u16((const uint16_t *)srcp1 + tail), mask);
+            uint16x8_t v2 = vandq_u16(vld1q_u16((const uint16_t *)srcp2 + tail), mask);
+            mmin = vminq_u16(mmin, vornq_u16(v1, mask));
+            mmax = vmaxq_u16(mmax, v1);
+            macc = vpadalq_u32(macc, vpaddlq_u16(v1));
+            mdiffacc = vpadalq_u32(mdiffacc, vpaddlq_u16(vabdq_u16(v1, v2)));
+        }
+        srcp1 += src1_stride;
+        srcp2 += src2_stride;
+    }
+
+    stats->i.min = vminvq_u16(mmin);
+    stats->i.max = vmaxvq_u16(mmax);
+    stats->i.acc = vaddvq_u64(macc);
+    stats->i.diffacc = vaddvq_u64(mdiffacc);
+}
+
+void vs_plane_stats_2_float_neon(union vs_plane_stats *stats, const void *src1, ptrdiff_t src1_stride, const void *src2, ptrdiff_t src2_stride, unsigned width, unsigned height)
+{
+    const uint8_t *srcp1 = src1;
+    const uint8_t *srcp2 = src2;
+    unsigned tail = width & ~3;
+    unsigned x, y;
+
+    float32x4_t fmmin = vdupq_n_f32(INFINITY);
+    float32x4_t fmmax = vdupq_n_f32(-INFINITY);
+    float64x2_t fmacc = vdupq_n_f64(0.0);
+    float64x2_t fmdiffacc = vdupq_n_f64(0.0);
+    uint32x4_t mask = vcltq_u32(vld1q_u32(ascend32), vdupq_n_u32(width % 4));
+
+    for (y = 0; y < height; y++) {
+        for (x = 0; x < tail; x += 4) {
+            float32x4_t v1 = vld1q_f32((const float *)srcp1 + x);
+            float32x4_t v2 = vld1q_f32((const float *)srcp2 + x);
+            fmmin = vminq_f32(fmmin, v1);
+            fmmax = vmaxq_f32(fmmax, v1);
+            accumulate_f32(&fmacc, v1);
+            accumulate_f32(&fmdiffacc, vabdq_f32(v1, v2));
+        }
+        if (width != tail) {
+            float32x4_t v1 = vld1q_f32((const float *)srcp1 + tail);
+            float32x4_t v2 = vld1q_f32((const float *)srcp2 + tail);
+            fmmin = vminq_f32(fmmin, vbslq_f32(mask, v1, vdupq_n_f32(INFINITY)));
+            fmmax = vmaxq_f32(fmmax, vbslq_f32(mask, v1, vdupq_n_f32(-INFINITY)));
+            accumulate_f32(&fmacc, vbslq_f32(mask, v1, vdupq_n_f32(0.0f)));
+            accumulate_f32(&fmdiffacc, vbslq_f32(mask, vabdq_f32(v1, v2), vdupq_n_f32(0.0f)));
+        }
+        srcp1 += src1_stride;
+        srcp2 += src2_stride;
+    }
+
+    stats->f.min = vminvq_f32(fmmin);
+    stats->f.max = vmaxvq_f32(fmmax);
+    stats->f.acc = vaddvq_f64(fmacc);
+    stats->f.diffacc = vaddvq_f64(fmdiffacc);
+}
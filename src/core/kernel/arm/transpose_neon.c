@@ -0,0 +1,166 @@
+/*
+* Copyright (c) 2012-2019 Fredrik Mellbin
+*
+* This file is part of VapourSynth.
+*
+* VapourSynth is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 2.1 of the License, or (at your option) any later version.
+*
+* VapourSynth is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with VapourSynth; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+#include <arm_neon.h>
+
+#define VS_TRANSPOSE_IMPL
+#define BLOCK_WIDTH_BYTE 16
+#define BLOCK_HEIGHT_BYTE 8
+#define BLOCK_WIDTH_WORD 8
+#define BLOCK_HEIGHT_WORD 8
+#define BLOCK_WIDTH_DWORD 4
+#define BLOCK_HEIGHT_DWORD 4
+#define TRANSPOSE_PREFETCH(p) __builtin_prefetch((const void *)(p))
+#include "../transpose.h"
+
+/* Two independent 8x8 transposes, one in each half of the registers. */
+static void transpose_block_byte(const uint8_t * VS_RESTRICT src, ptrdiff_t src_stride, uint8_t * VS_RESTRICT dst, ptrdiff_t dst_stride)
+{
+    uint8x16_t row0 = vld1q_u8(ADD_OFFSET(src, 0 * src_stride));
+    uint8x16_t row1 = vld1q_u8(ADD_OFFSET(src, 1 * src_stride));
+    uint8x16_t row2 = vld1q_u8(ADD_OFFSET(src, 2 * src_stride));
+    uint8x16_t row3 = vld1q_u8(ADD_OFFSET(src, 3 * src_stride));
+    uint8x16_t row4 = vld1q_u8(ADD_OFFSET(src, 4 * src_stride));
+    uint8x16_t row5 = vld1q_u8(ADD_OFFSET(src, 5 * src_stride));
+    uint8x16_t row6 = vld1q_u8(ADD_OFFSET(src, 6 * src_stride));
+    uint8x16_t row7 = vld1q_u8(ADD_OFFSET(src, 7 * src_stride));
+
+    uint8x16x2_t t0, t1, t2, t3;
+    uint16x8x2_t tt0, tt1, tt2, tt3;
+    uint32x4x2_t ttt0, ttt1, ttt2, ttt3;
+
+    t0 = vtrnq_u8(row0, row1);
+    t1 = vtrnq_u8(row2, row3);
+    t2 = vtrnq_u8(row4, row5);
+    t3 = vtrnq_u8(row6, row7);
+
+    tt0 = vtrnq_u16(vreinterpretq_u16_u8(t0.val[0]), vreinterpretq_u16_u8(t1.val[0]));
+    tt1 = vtrnq_u16(vreinterpretq_u16_u8(t0.val[1]), vreinterpretq_u16_u8(t1.val[1]));
+    tt2 = vtrnq_u16(vreinterpretq_u16_u8(t2.val[0]), vreinterpretq_u16_u8(t3.val[0]));
+    tt3 = vtrnq_u16(vreinterpretq_u16_u8(t2.val[1]), vreinterpretq_u16_u8(t3.val[1]));
+
+    ttt0 = vtrnq_u32(vreinterpretq_u32_u16(tt0.val[0]), vreinterpretq_u32_u16(tt2.val[0]));
+    ttt1 = vtrnq_u32(vreinterpretq_u32_u16(tt1.val[0]), vreinterpretq_u32_u16(tt3.val[0]));
+    ttt2 = vtrnq_u32(vreinterpretq_u32_u16(tt0.val[1]), vreinterpretq_u32_u16(tt2.val[1]));
+    ttt3 = vtrnq_u32(vreinterpretq_u32_u16(tt1.val[1]), vreinterpretq_u32_u16(tt3.val[1]));
+
+    row0 = vreinterpretq_u8_u32(ttt0.val[0]);
+    row1 = vreinterpretq_u8_u32(ttt1.val[0]);
+    row2 = vreinterpretq_u8_u32(ttt2.val[0]);
+    row3 = vreinterpretq_u8_u32(ttt3.val[0]);
+    row4 = vreinterpretq_u8_u32(ttt0.val[1]);
+    row5 = vreinterpretq_u8_u32(ttt1.val[1]);
+    row6 = vreinterpretq_u8_u32(ttt2.val[1]);
+    row7 = vreinterpretq_u8_u32(ttt3.val[1]);
+
+    vst1_u8(ADD_OFFSET(dst, 0 * dst_stride), vget_low_u8(row0));
+    vst1_u8(ADD_OFFSET(dst, 1 * dst_stride), vget_low_u8(row1));
+    vst1_u8(ADD_OFFSET(dst, 2 * dst_stride), vget_low_u8(row2));
+    vst1_u8(ADD_OFFSET(dst, 3 * dst_stride), vget_low_u8(row3));
+    vst1_u8(ADD_OFFSET(dst, 4 * dst_stride), vget_low_u8(row4));
+    vst1_u8(ADD_OFFSET(dst, 5 * dst_stride), vget_low_u8(row5));
+    vst1_u8(ADD_OFFSET(dst, 6 * dst_stride), vget_low_u8(row6));
+    vst1_u8(ADD_OFFSET(dst, 7 * dst_stride), vget_low_u8(row7));
+
+    vst1_u8(ADD_OFFSET(dst, 8 * dst_stride), vget_high_u8(row0));
+    vst1_u8(ADD_OFFSET(dst, 9 * dst_stride), vget_high_u8(row1));
+    vst1_u8(ADD_OFFSET(dst, 10 * dst_stride), vget_high_u8(row2));
+    vst1_u8(ADD_OFFSET(dst, 11 * dst_stride), vget_high_u8(row3));
+    vst1_u8(ADD_OFFSET(dst, 12 * dst_stride), vget_high_u8(row4));
+    vst1_u8(ADD_OFFSET(dst, 13 * dst_stride), vget_high_u8(row5));
+    vst1_u8(ADD_OFFSET(dst, 14 * dst_stride), vget_high_u8(row6));
+    vst1_u8(ADD_OFFSET(dst, 15 * dst_stride), vget_high_u8(row7));
+}
+
+static void transpose_block_word(const uint16_t * VS_RESTRICT src, ptrdiff_t src_stride, uint16_t * VS_RESTRICT dst, ptrdiff_t dst_stride)
+{
+    uint16x8_t row0 = vld1q_u16(ADD_OFFSET(src, 0 * src_stride));
+    uint16x8_t row1 = vld1q_u16(ADD_OFFSET(src, 1 * src_stride));
+    uint16x8_t row2 = vld1q_u16(ADD_OFFSET(src, 2 * src_stride));
+    uint16x8_t row3 = vld1q_u16(ADD_OFFSET(src, 3 * src_stride));
+    uint16x8_t row4 = vld1q_u16(ADD_OFFSET(src, 4 * src_stride));
+    uint16x8_t row5 = vld1q_u16(ADD_OFFSET(src, 5 * src_stride));
+    uint16x8_t row6 = vld1q_u16(ADD_OFFSET(src, 6 * src_stride));
+    uint16x8_t row7 = vld1q_u16(ADD_OFFSET(src, 7 * src_stride));
+
+    uint16x8x2_t t0, t1, t2, t3;
+    uint32x4x2_t tt0, tt1, tt2, tt3;
+
+    t0 = vtrnq_u16(row0, row1);
+    t1 = vtrnq_u16(row2, row3);
+    t2 = vtrnq_u16(row4, row5);
+    t3 = vtrnq_u16(row6, row7);
+
+    tt0 = vtrnq_u32(vreinterpretq_u32_u16(t0.val[0]), vreinterpretq_u32_u16(t1.val[0]));
+    tt1 = vtrnq_u32(vreinterpretq_u32_u16(t0.val[1]), vreinterpretq_u32_u16(t1.val[1]));
+    tt2 = vtrnq_u32(vreinterpretq_u32_u16(t2.val[0]), vreinterpretq_u32_u16(t3.val[0]));
+    tt3 = vtrnq_u32(vreinterpretq_u32_u16(t2.val[1]), vreinterpretq_u32_u16(t3.val[1]));
+
+    row0 = vreinterpretq_u16_u32(vcombine_u32(vget_low_u32(tt0.val[0]), vget_low_u32(tt2.val[0])));
+    row1 = vreinterpretq_u16_u32(vcombine_u32(vget_low_u32(tt1.val[0]), vget_low_u32(tt3.val[0])));
+    row2 = vreinterpretq_u16_u32(vcombine_u32(vget_low_u32(tt0.val[1]), vget_low_u32(tt2.val[1])));
+    row3 = vreinterpretq_u16_u32(vcombine_u32(vget_low_u32(tt1.val[1]), vget_low_u32(tt3.val[1])));
+    row4 = vreinterpretq_u16_u32(vcombine_u32(vget_high_u32(tt0.val[0]), vget_high_u32(tt2.val[0])));
+    row5 = vreinterpretq_u16_u32(vcombine_u32(vget_high_u32(tt1.val[0]), vget_high_u32(tt3.val[0])));
+    row6 = vreinterpretq_u16_u32(vcombine_u32(vget_high_u32(tt0.val[1]), vget_high_u32(tt2.val[1])));
+    row7 = vreinterpretq_u16_u32(vcombine_u32(vget_high_u32(tt1.val[1]), vget_high_u32(tt3.val[1])));
+
+    vst1q_u16(ADD_OFFSET(dst, 0 * dst_stride), row0);
+    vst1q_u16(ADD_OFFSET(dst, 1 * dst_stride), row1);
+    vst1q_u16(ADD_OFFSET(dst, 2 * dst_stride), row2);
+    vst1q_u16(ADD_OFFSET(dst, 3 * dst_stride), row3);
+    vst1q_u16(ADD_OFFSET(dst, 4 * dst_stride), row4);
+    vst1q_u16(ADD_OFFSET(dst, 5 * dst_stride), row5);
+    vst1q_u16(ADD_OFFSET(dst, 6 * dst_stride), row6);
+    vst1q_u16(ADD_OFFSET(dst, 7 * dst_stride), row7);
+}
+
+static void transpose_block_dword(const uint32_t * VS_RESTRICT src, ptrdiff_t src_stride, uint32_t * VS_RESTRICT dst, ptrdiff_t dst_stride)
+{
+    uint32x4_t row0 = vld1q_u32(ADD_OFFSET(src, 0 * src_stride));
+    uint32x4_t row1 = vld1q_u32(ADD_OFFSET(src, 1 * src_stride));
+    uint32x4_t row2 = vld1q_u32(ADD_OFFSET(src, 2 * src_stride));
+    uint32x4_t row3 = vld1q_u32(ADD_OFFSET(src, 3 * src_stride));
+
+    uint32x4x2_t t0 = vtrnq_u32(row0, row1);
+    uint32x4x2_t t1 = vtrnq_u32(row2, row3);
+
+    vst1q_u32(ADD_OFFSET(dst, 0 * dst_stride), vcombine_u32(vget_low_u32(t0.val[0]), vget_low_u32(t1.val[0])));
+    vst1q_u32(ADD_OFFSET(dst, 1 * dst_stride), vcombine_u32(vget_low_u32(t0.val[1]), vget_low_u32(t1.val[1])));
+    vst1q_u32(ADD_OFFSET(dst, 2 * dst_stride), vcombine_u32(vget_high_u32(t0.val[0]), vget_high_u32(t1.val[0])));
+    vst1q_u32(ADD_OFFSET(dst, 3 * dst_stride), vcombine_u32(vget_high_u32(t0.val[1]), vget_high_u32(t1.val[1])));
+}
+
+void vs_transpose_plane_byte_neon(const void * VS_RESTRICT src, ptrdiff_t src_stride, void * VS_RESTRICT dst, ptrdiff_t dst_stride, unsigned width, unsigned height)
+{
+    transpose_plane_byte(src, src_stride, dst, dst_stride, width, height);
+}
+
+void vs_transpose_plane_word_neon(const void * VS_RESTRICT src, ptrdiff_t src_stride, void * VS_RESTRICT dst, ptrdiff_t dst_stride, unsigned width, unsigned height)
+{
+    transpose_plane_word(src, src_stride, dst, dst_stride, width, height);
+}
+
+void vs_transpose_plane_dword_neon(const void * VS_RESTRICT src, ptrdiff_t src_stride, void * VS_RESTRICT dst, ptrdiff_t dst_stride, unsigned width, unsigned height)
+{
+    transpose_plane_dword(src, src_stride, dst, dst_stride, width, height);
+}
@@ -24,7 +24,9 @@
 #include <cstdint>
 #include <limits>
 #include <type_traits>
+#include <vector>
 #include "generic.h"
+#include "rank.h"
 
 namespace {
 
@@ -310,7 +312,7 @@ void conv_plane_5x5(const void *src, ptrdiff_t src_stride, void *dst, ptrdiff_t
         T *dst_p = static_cast<T *>(line_ptr(dst, i, dst_stride));
 
         for (unsigned j = 0; j < std::min(width, 2U); ++j) {
-            unsigned dist_from_right = width - 1 - i;
+            unsigned dist_from_right = width - 1 - j;
             unsigned idx[5];
 
             idx[0] = j < 2 ? std::min(2 - j, width - 1) : j - 2;
@@ -351,7 +353,7 @@ void conv_plane_5x5(const void *src, ptrdiff_t src_stride, void *dst, ptrdiff_t
         }
 
         for (unsigned j = std::max(2U, width - std::min(width, 2U)); j < width; ++j) {
-            unsigned dist_from_right = width - 1 - i;
+            unsigned dist_from_right = width - 1 - j;
             unsigned idx[5];
 
             idx[0] = j < 2 ? std::min(2 - j, width - 1) : j - 2;
@@ -397,7 +399,7 @@ void conv_plane_h(const void *src, ptrdiff_t src_stride, void *dst, ptrdiff_t ds
         T *dstp = static_cast<T *>(line_ptr(dst, i, dst_stride));
 
         for (unsigned j = 0; j < std::min(width, support); ++j) {
-            unsigned dist_from_right = width - 1 - i;
+            unsigned dist_from_right = width - 1 - j;
 
             Accum accum = 0;
 
@@ -429,7 +431,7 @@ void conv_plane_h(const void *src, ptrdiff_t src_stride, void *dst, ptrdiff_t ds
         }
 
         for (unsigned j = std::max(support, width - std::min(width, support)); j < width; ++j) {
-            unsigned dist_from_right = width - 1 - i;
+            unsigned dist_from_right = width - 1 - j;
 
             Accum accum = 0;
 
@@ -468,7 +470,7 @@ void conv_plane_v(const void *src, ptrdiff_t src_stride, void *dst, ptrdiff_t ds
         T *dstp = static_cast<T *>(line_ptr(dst, i, dst_stride));
 
         unsigned dist_from_bottom = height - 1 - i;
-        unsigned idx[25];
+        unsigned idx[VS_GENERIC_MAX_CONV_SIZE];
 
         for (unsigned k = 0; k < support; ++k) {
             idx[k] = i < support - k ? std::min(support - k - i, height - 1) : i - support + k;
@@ -508,7 +510,7 @@ void conv_plane_v(const void *src, ptrdiff_t src_stride, void *dst, ptrdiff_t ds
         T *dstp = static_cast<T *>(line_ptr(dst, i, dst_stride));
 
         unsigned dist_from_bottom = height - 1 - i;
-        unsigned idx[25];
+        unsigned idx[VS_GENERIC_MAX_CONV_SIZE];
 
         for (unsigned k = 0; k < support; ++k) {
             idx[k] = i < support - k ? std::min(support - k - i, height - 1) : i - support + k;
@@ -531,6 +533,173 @@ void conv_plane_v(const void *src, ptrdiff_t src_stride, void *dst, ptrdiff_t ds
     }
 }
 
+unsigned mirror_idx(int idx, unsigned size)
+{
+    if (idx < 0)
+        return -idx;
+    else if (static_cast<unsigned>(idx) >= size)
+        return 2 * (size - 1) - idx;
+    else
+        return idx;
+}
+
+template <class T>
+void conv_plane_nxn(const void *src, ptrdiff_t src_stride, void *dst, ptrdiff_t dst_stride, const vs_generic_params &params, unsigned width, unsigned height)
+{
+    // Up to 961 taps, so the integer sum no longer fits in 32 bits.
+    typedef typename std::conditional<std::is_integral<T>::value, int64_t, float>::type Accum;
+    typedef typename std::conditional<std::is_integral<T>::value, int16_t, float>::type Weight;
+
+    const Weight *coeffs = std::is_integral<T>::value ? (const Weight *)params.matrix : (const Weight *)params.matrixf;
+    unsigned fsize = static_cast<unsigned>(std::lrint(std::sqrt(static_cast<double>(params.matrixsize))));
+    int support = fsize / 2;
+
+    uint16_t maxval = params.maxval;
+    float div = params.div;
+    float bias = params.bias;
+    bool saturate = params.saturate;
+
+    const T *srcp[VS_GENERIC_MAX_CONV_SIZE];
+    unsigned idx[VS_GENERIC_MAX_CONV_SIZE];
+
+    for (unsigned i = 0; i < height; ++i) {
+        T *dstp = static_cast<T *>(line_ptr(dst, i, dst_stride));
+
+        for (unsigned k = 0; k < fsize; ++k) {
+            srcp[k] = static_cast<const T *>(line_ptr(src, mirror_idx(static_cast<int>(i + k) - support, height), src_stride));
+        }
+
+        for (unsigned j = 0; j < width; ++j) {
+            for (unsigned k = 0; k < fsize; ++k) {
+                idx[k] = mirror_idx(static_cast<int>(j + k) - support, width);
+            }
+
+            Accum accum = 0;
+
+            for (unsigned m = 0; m < fsize; ++m) {
+                for (unsigned k = 0; k < fsize; ++k) {
+                    accum += coeffs[fsize * m + k] * static_cast<Accum>(srcp[m][idx[k]]);
+                }
+            }
+
+            float tmp = static_cast<float>(accum) * div + bias;
+            tmp = saturate ? tmp : std::fabs(tmp);
+            dstp[j] = limit(xrint<T>(tmp), maxval);
+        }
+    }
+}
+
+template <class T, class Accum>
+void conv_plane_separable_impl(const void *src, ptrdiff_t src_stride, void *dst, ptrdiff_t dst_stride, const vs_generic_params &params, unsigned width, unsigned height)
+{
+    typedef typename std::conditional<std::is_integral<T>::value, int32_t, float>::type Intermediate;
+    typedef typename std::conditional<std::is_integral<T>::value, int16_t, float>::type Weight;
+
+    const Weight *coeffs_h = std::is_integral<T>::value ? (const Weight *)params.matrix_h : (const Weight *)params.matrixf_h;
+    const Weight *coeffs_v = std::is_integral<T>::value ? (const Weight *)params.matrix_v : (const Weight *)params.matrixf_v;
+    unsigned fwidth = params.matrixsize_h;
+    unsigned fheight = params.matrixsize_v;
+    unsigned support_h = fwidth / 2;
+    int support_v = fheight / 2;
+
+    uint16_t maxval = params.maxval;
+    float div = params.div;
+    float bias = params.bias;
+    bool saturate = params.saturate;
+
+    // Vertically filtered row, padded by mirroring so the horizontal pass needs no edge handling.
+    thread_local std::vector<Intermediate> row_buffer;
+    row_buffer.resize(width + 2 * support_h);
+    Intermediate *row = row_buffer.data() + support_h;
+
+    const T *srcp[VS_GENERIC_MAX_CONV_SIZE];
+
+    for (unsigned i = 0; i < height; ++i) {
+        T *dstp = static_cast<T *>(line_ptr(dst, i, dst_stride));
+
+        for (unsigned k = 0; k < fheight; ++k) {
+            srcp[k] = static_cast<const T *>(line_ptr(src, mirror_idx(static_cast<int>(i + k) - support_v, height), src_stride));
+        }
+
+        for (unsigned j = 0; j < width; ++j) {
+            Intermediate accum = 0;
+
+            for (unsigned k = 0; k < fheight; ++k) {
+                accum += coeffs_v[k] * static_cast<Intermediate>(srcp[k][j]);
+            }
+            row[j] = accum;
+        }
+
+        for (unsigned k = 1; k <= support_h; ++k) {
+            row[-static_cast<int>(k)] = row[k];
+            row[width - 1 + k] = row[width - 1 - k];
+        }
+
+        for (unsigned j = 0; j < width; ++j) {
+            Accum accum = 0;
+
+            for (unsigned k = 0; k < fwidth; ++k) {
+                accum += coeffs_h[k] * static_cast<Accum>(row[static_cast<int>(j + k) - static_cast<int>(support_h)]);
+            }
+
+            float tmp = static_cast<float>(accum) * div + bias;
+            tmp = saturate ? tmp : std::fabs(tmp);
+            dstp[j] = limit(xrint<T>(tmp), maxval);
+        }
+    }
+}
+
+template <class T>
+void conv_plane_separable(const void *src, ptrdiff_t src_stride, void *dst, ptrdiff_t dst_stride, const vs_generic_params &params, unsigned width, unsigned height)
+{
+    // The vertical sums always fit in 32 bits. The full sum may not for 16-bit input and large kernels.
+    int64_t sum_h = 0;
+    int64_t sum_v = 0;
+
+    for (unsigned k = 0; k < params.matrixsize_h; ++k) {
+        sum_h += std::abs(params.matrix_h[k]);
+    }
+    for (unsigned k = 0; k < params.matrixsize_v; ++k) {
+        sum_v += std::abs(params.matrix_v[k]);
+    }
+
+    if (std::is_integral<T>::value && params.maxval * sum_h * sum_v > std::numeric_limits<int32_t>::max())
+        conv_plane_separable_impl<T, int64_t>(src, src_stride, dst, dst_stride, params, width, height);
+    else
+        conv_plane_separable_impl<T, typename std::conditional<std::is_integral<T>::value, int32_t, float>::type>(src, src_stride, dst, dst_stride, params, width, height);
+}
+
+template <class T>
+void rank_plane_sort(const void *src, ptrdiff_t src_stride, void *dst, ptrdiff_t dst_stride, const vs_generic_params &params, unsigned width, unsigned height)
+{
+    int radius = params.radius;
+    unsigned rank = params.rank;
+
+    std::vector<const T *> srcp(2 * radius + 1);
+    std::vector<T> window((2 * radius + 1) * (2 * radius + 1));
+
+    for (unsigned i = 0; i < height; ++i) {
+        T *dstp = static_cast<T *>(line_ptr(dst, i, dst_stride));
+
+        for (int k = -radius; k <= radius; ++k) {
+            srcp[k + radius] = static_cast<const T *>(line_ptr(src, mirror_idx(static_cast<int>(i) + k, height), src_stride));
+        }
+
+        for (unsigned j = 0; j < width; ++j) {
+            auto it = window.begin();
+
+            for (int m = 0; m <= 2 * radius; ++m) {
+                for (int k = -radius; k <= radius; ++k) {
+                    *it++ = srcp[m][mirror_idx(static_cast<int>(j) + k, width)];
+                }
+            }
+
+            std::nth_element(window.begin(), window.begin() + rank, window.end());
+            dstp[j] = window[rank];
+        }
+    }
+}
+
 } // namespace
 
 
@@ -698,3 +867,49 @@ void vs_generic_1d_conv_v_float_c(const void *src, ptrdiff_t src_stride, void *d
 {
     conv_plane_v<float>(src, src_stride, dst, dst_stride, *params, width, height);
 }
+
+void vs_generic_nxn_conv_byte_c(const void *src, ptrdiff_t src_stride, void *dst, ptrdiff_t dst_stride, const struct vs_generic_params *params, unsigned width, unsigned height)
+{
+    conv_plane_nxn<uint8_t>(src, src_stride, dst, dst_stride, *params, width, height);
+}
+
+void vs_generic_nxn_conv_word_c(const void *src, ptrdiff_t src_stride, void *dst, ptrdiff_t dst_stride, const struct vs_generic_params *params, unsigned width, unsigned height)
+{
+    conv_plane_nxn<uint16_t>(src, src_stride, dst, dst_stride, *params, width, height);
+}
+
+void vs_generic_nxn_conv_float_c(const void *src, ptrdiff_t src_stride, void *dst, ptrdiff_t dst_stride, const struct vs_generic_params *params, unsigned width, unsigned height)
+{
+    conv_plane_nxn<float>(src, src_stride, dst, dst_stride, *params, width, height);
+}
+
+void vs_generic_separable_conv_byte_c(const void *src, ptrdiff_t src_stride, void *dst, ptrdiff_t dst_stride, const struct vs_generic_params *params, unsigned width, unsigned height)
+{
+    conv_plane_separable<uint8_t>(src, src_stride, dst, dst_stride, *params, width, height);
+}
+
+void vs_generic_separable_conv_word_c(const void *src, ptrdiff_t src_stride, void *dst, ptrdiff_t dst_stride, const struct vs_generic_params *params, unsigned width, unsigned height)
+{
+    conv_plane_separable<uint16_t>(src, src_stride, dst, dst_stride, *params, width, height);
+}
+
+void vs_generic_separable_conv_float_c(const void *src, ptrdiff_t src_stride, void *dst, ptrdiff_t dst_stride, const struct vs_generic_params *params, unsigned width, unsigned height)
+{
+    conv_plane_separable<float>(src, src_stride, dst, dst_stride, *params, width, height);
+}
+
+void vs_generic_rank_byte_c(const void *src, ptrdiff_t src_stride, void *dst, ptrdiff_t dst_stride, const struct vs_generic_params *params, unsigned width, unsigned height)
+{
+    vs_rank::rank_plane<uint8_t, vs_rank::ScalarOps>(src, src_stride, dst, dst_stride, *params, width, height);
+}
+
+void vs_generic_rank_word_c(const void *src, ptrdiff_t src_stride, void *dst, ptrdiff_t dst_stride, const struct vs_generic_params *params, unsigned width, unsigned height)
+{
+    vs_rank::rank_plane<uint16_t, vs_rank::ScalarOps>(src, src_stride, dst, dst_stride, *params, width, height);
+}
+
+void vs_generic_rank_float_c(const void *src, ptrdiff_t src_stride, void *dst, ptrdiff_t dst_stride, const struct vs_generic_params *params, unsigned width, unsigned height)
+{
+    // No histogram for float samples, so select from each window instead.
+    rank_plane_sort<float>(src, src_stride, dst, dst_stride, *params, width, height);
+}
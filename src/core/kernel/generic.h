@@ -28,6 +28,9 @@
 extern "C" {
 #endif
 
+/* Largest odd convolution width/height accepted by std.Convolution. */
+#define VS_GENERIC_MAX_CONV_SIZE 31
+
 struct vs_generic_params {
 	uint16_t maxval;
 
@@ -41,13 +44,25 @@ struct vs_generic_params {
 	/* Minimum, Maximum. */
 	uint8_t stencil;
 
+	/* Median, Percentile with a radius above 1. Rank is zero-based in the sorted window. */
+	unsigned radius;
+	unsigned rank;
+
 	/* Convolution. */
 	unsigned matrixsize;
-	int16_t matrix[25];
-	float matrixf[25];
+	int16_t matrix[VS_GENERIC_MAX_CONV_SIZE * VS_GENERIC_MAX_CONV_SIZE];
+	float matrixf[VS_GENERIC_MAX_CONV_SIZE * VS_GENERIC_MAX_CONV_SIZE];
 	float div;
 	float bias;
 	uint8_t saturate;
+
+	/* Separable convolution. The vertical pass is applied first. */
+	unsigned matrixsize_h;
+	unsigned matrixsize_v;
+	int16_t matrix_h[VS_GENERIC_MAX_CONV_SIZE];
+	int16_t matrix_v[VS_GENERIC_MAX_CONV_SIZE];
+	float matrixf_h[VS_GENERIC_MAX_CONV_SIZE];
+	float matrixf_v[VS_GENERIC_MAX_CONV_SIZE];
 };
 
 #define DECL(kernel, pixel, isa) void vs_generic_##kernel##_##pixel##_##isa(const void *src, ptrdiff_t src_stride, void *dst, ptrdiff_t dst_stride, const struct vs_generic_params *params, unsigned width, unsigned height);
@@ -97,6 +112,18 @@ DECL(1d_conv_v, byte, c)
 DECL(1d_conv_v, word, c)
 DECL(1d_conv_v, float, c)
 
+DECL(nxn_conv, byte, c)
+DECL(nxn_conv, word, c)
+DECL(nxn_conv, float, c)
+
+DECL(separable_conv, byte, c)
+DECL(separable_conv, word, c)
+DECL(separable_conv, float, c)
+
+DECL(rank, byte, c)
+DECL(rank, word, c)
+DECL(rank, float, c)
+
 #ifdef VS_TARGET_CPU_X86
 DECL_3x3(prewitt, byte, sse2)
 DECL_3x3(prewitt, word, sse2)
@@ -161,8 +188,99 @@ DECL_3x3(inflate, float, avx2)
 DECL_3x3(conv, byte, avx2)
 DECL_3x3(conv, word, avx2)
 DECL_3x3(conv, float, avx2)
+
+DECL(separable_conv, byte, avx2)
+DECL(separable_conv, word, avx2)
+DECL(separable_conv, float, avx2)
+
+DECL(rank, byte, avx2)
+DECL(rank, word, avx2)
+
+DECL_3x3(prewitt, byte, avx512)
+DECL_3x3(prewitt, word, avx512)
+DECL_3x3(prewitt, float, avx512)
+
+DECL_3x3(sobel, byte, avx512)
+DECL_3x3(sobel, word, avx512)
+DECL_3x3(sobel, float, avx512)
+
+DECL_3x3(min, byte, avx512)
+DECL_3x3(min, word, avx512)
+DECL_3x3(min, float, avx512)
+
+DECL_3x3(max, byte, avx512)
+DECL_3x3(max, word, avx512)
+DECL_3x3(max, float, avx512)
+
+DECL_3x3(median, byte, avx512)
+DECL_3x3(median, word, avx512)
+DECL_3x3(median, float, avx512)
+
+DECL_3x3(deflate, byte, avx512)
+DECL_3x3(deflate, word, avx512)
+DECL_3x3(deflate, float, avx512)
+
+DECL_3x3(inflate, byte, avx512)
+DECL_3x3(inflate, word, avx512)
+DECL_3x3(inflate, float, avx512)
+
+DECL_3x3(conv, byte, avx512)
+DECL_3x3(conv, word, avx512)
+DECL_3x3(conv, float, avx512)
+
+DECL(separable_conv, byte, avx512)
+DECL(separable_conv, word, avx512)
+DECL(separable_conv, float, avx512)
+
+DECL(nxn_conv, byte, avx512)
+DECL(nxn_conv, word, avx512)
+DECL(nxn_conv, float, avx512)
+
+DECL(rank, byte, avx512)
+DECL(rank, word, avx512)
 #endif /* VS_TARGET_CPU_X86 */
 
+#ifdef VS_TARGET_CPU_AARCH64
+DECL_3x3(prewitt, byte, neon)
+DECL_3x3(prewitt, word, neon)
+DECL_3x3(prewitt, float, neon)
+
+DECL_3x3(sobel, byte, neon)
+DECL_3x3(sobel, word, neon)
+DECL_3x3(sobel, float, neon)
+
+DECL_3x3(min, byte, neon)
+DECL_3x3(min, word, neon)
+DECL_3x3(min, float, neon)
+
+DECL_3x3(max, byte, neon)
+DECL_3x3(max, word, neon)
+DECL_3x3(max, float, neon)
+
+DECL_3x3(median, byte, neon)
+DECL_3x3(median, word, neon)
+DECL_3x3(median, float, neon)
+
+DECL_3x3(deflate, byte, neon)
+DECL_3x3(deflate, word, neon)
+DECL_3x3(deflate, float, neon)
+
+DECL_3x3(inflate, byte, neon)
+DECL_3x3(inflate, word, neon)
+DECL_3x3(inflate, float, neon)
+
+DECL_3x3(conv, byte, neon)
+DECL_3x3(conv, word, neon)
+DECL_3x3(conv, float, neon)
+
+DECL(separable_conv, byte, neon)
+DECL(separable_conv, word, neon)
+DECL(separable_conv, float, neon)
+
+DECL(rank, byte, neon)
+DECL(rank, word, neon)
+#endif /* VS_TARGET_CPU_AARCH64 */
+
 #undef DECL_3x3
 #undef DECL
 
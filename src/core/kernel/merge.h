@@ -104,8 +104,58 @@ DECL_MAKEDIFF(float, avx2)
 DECL_MERGEDIFF(byte, avx2)
 DECL_MERGEDIFF(word, avx2)
 DECL_MERGEDIFF(float, avx2)
+
+DECL_PREMUL(byte, avx512)
+DECL_PREMUL(word, avx512)
+DECL_PREMUL(float, avx512)
+
+DECL_MERGE(byte, avx512)
+DECL_MERGE(word, avx512)
+DECL_MERGE(float, avx512)
+
+DECL_MASK_MERGE(byte, avx512)
+DECL_MASK_MERGE(word, avx512)
+DECL_MASK_MERGE(float, avx512)
+
+DECL_MASK_MERGE_PREMUL(byte, avx512)
+DECL_MASK_MERGE_PREMUL(word, avx512)
+DECL_MASK_MERGE_PREMUL(float, avx512)
+
+DECL_MAKEDIFF(byte, avx512)
+DECL_MAKEDIFF(word, avx512)
+DECL_MAKEDIFF(float, avx512)
+
+DECL_MERGEDIFF(byte, avx512)
+DECL_MERGEDIFF(word, avx512)
+DECL_MERGEDIFF(float, avx512)
 #endif /* VS_TARGET_CPU_X86 */
 
+#ifdef VS_TARGET_CPU_AARCH64
+DECL_PREMUL(byte, neon)
+DECL_PREMUL(word, neon)
+DECL_PREMUL(float, neon)
+
+DECL_MERGE(byte, neon)
+DECL_MERGE(word, neon)
+DECL_MERGE(float, neon)
+
+DECL_MASK_MERGE(byte, neon)
+DECL_MASK_MERGE(word, neon)
+DECL_MASK_MERGE(float, neon)
+
+DECL_MASK_MERGE_PREMUL(byte, neon)
+DECL_MASK_MERGE_PREMUL(word, neon)
+DECL_MASK_MERGE_PREMUL(float, neon)
+
+DECL_MAKEDIFF(byte, neon)
+DECL_MAKEDIFF(word, neon)
+DECL_MAKEDIFF(float, neon)
+
+DECL_MERGEDIFF(byte, neon)
+DECL_MERGEDIFF(word, neon)
+DECL_MERGEDIFF(float, neon)
+#endif /* VS_TARGET_CPU_AARCH64 */
+
 #undef DECL_MERGEDIFF
 #undef DECL_MAKEDIFF
 #undef DECL_MASK_MERGE_PREMUL
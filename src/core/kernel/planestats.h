@@ -71,8 +71,26 @@ DECL_1(float, avx2)
 DECL_2(byte, avx2)
 DECL_2(word, avx2)
 DECL_2(float, avx2)
+
+DECL_1(byte, avx512)
+DECL_1(word, avx512)
+DECL_1(float, avx512)
+
+DECL_2(byte, avx512)
+DECL_2(word, avx512)
+DECL_2(float, avx512)
 #endif /* VS_TARGET_CPU_X86 */
 
+#ifdef VS_TARGET_CPU_AARCH64
+DECL_1(byte, neon)
+DECL_1(word, neon)
+DECL_1(float, neon)
+
+DECL_2(byte, neon)
+DECL_2(word, neon)
+DECL_2(float, neon)
+#endif /* VS_TARGET_CPU_AARCH64 */
+
 #undef DECL_2
 #undef DECL_1
 
@@ -0,0 +1,209 @@
+/*
+* Copyright (c) 2012-2019 Fredrik Mellbin
+*
+* This file is part of VapourSynth.
+*
+* VapourSynth is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 2.1 of the License, or (at your option) any later version.
+*
+* VapourSynth is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with VapourSynth; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef RANK_H
+#define RANK_H
+
+/*
+ * Constant time rank filter for integer samples, after Perreault and Hebert,
+ * "Median Filtering in Constant Time". Shared by the C and SIMD kernels, which
+ * only differ in the Ops policy doing the histogram arithmetic.
+ *
+ * Every column keeps a histogram of the 2*radius+1 rows around the current
+ * row. The window histogram is the sum of 2*radius+1 column histograms and is
+ * updated with one add and one subtract per pixel. Histograms have a coarse
+ * level indexed by the high half of the sample bits and a fine level indexed
+ * by the whole sample. Only the coarse level of the window histogram is kept
+ * current. A fine segment is brought up to date only when the rank falls in
+ * its coarse bin.
+ *
+ * Counts are 16 bits, which limits the radius to 127. Deep samples have big
+ * column histograms, so the plane is processed in vertical stripes to bound
+ * memory use. Edges are mirrored the same way as the convolution kernels.
+ */
+
+#include <algorithm>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include "generic.h"
+
+namespace vs_rank {
+
+// Bins are padded to this many counts so SIMD policies never need a tail loop.
+constexpr unsigned bin_align = 16;
+
+inline unsigned mirror(int idx, unsigned size)
+{
+    if (idx < 0)
+        return -idx;
+    else if (static_cast<unsigned>(idx) >= size)
+        return 2 * (size - 1) - idx;
+    else
+        return idx;
+}
+
+struct ScalarOps {
+    static void add(uint16_t *dst, const uint16_t *src, unsigned n)
+    {
+        for (unsigned i = 0; i < n; ++i) {
+            dst[i] += src[i];
+        }
+    }
+
+    static void add_sub(uint16_t *dst, const uint16_t *add, const uint16_t *sub, unsigned n)
+    {
+        for (unsigned i = 0; i < n; ++i) {
+            dst[i] += add[i] - sub[i];
+        }
+    }
+};
+
+template <class T, class Ops>
+void rank_plane(const void *src, ptrdiff_t src_stride, void *dst, ptrdiff_t dst_stride, const vs_generic_params &params, unsigned width, unsigned height)
+{
+    unsigned bits = 0;
+    while ((1U << bits) <= params.maxval)
+        ++bits;
+
+    const unsigned fine_bits = bits / 2;
+    const unsigned coarse_bins = 1U << (bits - fine_bits);
+    const unsigned fine_bins = 1U << fine_bits;
+    const unsigned coarse_size = std::max(coarse_bins, bin_align);
+    const unsigned fine_size = std::max(fine_bins, bin_align);
+    const size_t column_size = coarse_size + static_cast<size_t>(coarse_bins) * fine_size;
+
+    const int radius = params.radius;
+    const unsigned rank = params.rank;
+
+    // Size the stripe so its column histograms, including the 2*radius extra
+    // columns at the sides, fit in 4 MB. A 16 bit column histogram is 128 kB so
+    // that's not possible with a radius above 7, those stripes are 16 columns
+    // wide and the buffer is released again at the end.
+    const size_t histogram_budget = size_t{ 4 } << 20;
+    const size_t budget_columns = histogram_budget / (column_size * sizeof(uint16_t));
+    const unsigned stripe = budget_columns >= 2U * radius + 16 ? static_cast<unsigned>(budget_columns) - 2 * radius : 16;
+
+    // Column histograms are left zeroed after each call, so they are only cleared when first allocated.
+    thread_local std::vector<uint16_t> column_buffer;
+    thread_local std::vector<uint16_t> window_buffer;
+    thread_local std::vector<int> synced;
+
+    column_buffer.resize(std::max(column_buffer.size(), std::min(width, stripe + 2 * radius) * column_size));
+    window_buffer.resize(column_size);
+    synced.resize(coarse_bins);
+
+    uint16_t *window_coarse = window_buffer.data();
+    uint16_t *window_fine = window_buffer.data() + coarse_size;
+
+    auto row_ptr = [&](int i) { return reinterpret_cast<const T *>(static_cast<const uint8_t *>(src) + static_cast<ptrdiff_t>(mirror(i, height)) * src_stride); };
+
+    for (unsigned x0 = 0; x0 < width; x0 += stripe) {
+        unsigned x1 = std::min(width, x0 + stripe);
+        unsigned c0 = x0 > static_cast<unsigned>(radius) ? x0 - radius : 0;
+        unsigned c1 = std::min(width, x1 + radius);
+
+        auto column = [&](int x) { return column_buffer.data() + (mirror(x, width) - c0) * column_size; };
+
+        auto update_columns = [&](int i, int delta) {
+            const T *srcp = row_ptr(i);
+
+            for (unsigned c = c0; c < c1; ++c) {
+                uint16_t *hist = column_buffer.data() + (c - c0) * column_size;
+                // Out of range samples would index past the histograms, so they count as maxval.
+                unsigned v = std::min<unsigned>(srcp[c], params.maxval);
+                hist[v >> fine_bits] += delta;
+                hist[coarse_size + (v >> fine_bits) * fine_size + (v & (fine_bins - 1))] += delta;
+            }
+        };
+
+        for (int k = -radius; k <= radius; ++k) {
+            update_columns(k, 1);
+        }
+
+        for (unsigned i = 0; i < height; ++i) {
+            T *dstp = reinterpret_cast<T *>(static_cast<uint8_t *>(dst) + static_cast<ptrdiff_t>(i) * dst_stride);
+
+            if (i > 0) {
+                update_columns(static_cast<int>(i) - radius - 1, -1);
+                update_columns(static_cast<int>(i) + radius, 1);
+            }
+
+            std::memset(window_coarse, 0, coarse_size * sizeof(uint16_t));
+            for (int k = -radius; k <= radius; ++k) {
+                Ops::add(window_coarse, column(static_cast<int>(x0) + k), coarse_size);
+            }
+            std::fill(synced.begin(), synced.end(), INT_MIN);
+
+            for (unsigned x = x0; x < x1; ++x) {
+                int xi = static_cast<int>(x);
+
+                if (x > x0)
+                    Ops::add_sub(window_coarse, column(xi + radius), column(xi - radius - 1), coarse_size);
+
+                unsigned sum = 0;
+                unsigned b = 0;
+                while (sum + window_coarse[b] <= rank) {
+                    sum += window_coarse[b];
+                    ++b;
+                }
+
+                uint16_t *fine = window_fine + b * fine_size;
+                size_t fine_offset = coarse_size + b * fine_size;
+
+                if (synced[b] == INT_MIN || xi - synced[b] > radius) {
+                    std::memset(fine, 0, fine_size * sizeof(uint16_t));
+                    for (int k = -radius; k <= radius; ++k) {
+                        Ops::add(fine, column(xi + k) + fine_offset, fine_size);
+                    }
+                } else {
+                    for (int p = synced[b] + 1; p <= xi; ++p) {
+                        Ops::add_sub(fine, column(p + radius) + fine_offset, column(p - radius - 1) + fine_offset, fine_size);
+                    }
+                }
+                synced[b] = xi;
+
+                unsigned f = 0;
+                while (sum + fine[f] <= rank) {
+                    sum += fine[f];
+                    ++f;
+                }
+
+                dstp[x] = static_cast<T>((b << fine_bits) | f);
+            }
+        }
+
+        for (int k = -radius; k <= radius; ++k) {
+            update_columns(static_cast<int>(height) - 1 + k, -1);
+        }
+    }
+
+    // Only buffers within the budget stay around for the next call on this thread.
+    if (column_buffer.size() * sizeof(uint16_t) > histogram_budget) {
+        std::vector<uint16_t>().swap(column_buffer);
+        std::vector<uint16_t>().swap(window_buffer);
+    }
+}
+
+} // namespace vs_rank
+
+#endif // RANK_H
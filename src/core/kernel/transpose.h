@@ -37,18 +37,47 @@ void vs_transpose_plane_dword_c(const void * VS_RESTRICT src, ptrdiff_t src_stri
 void vs_transpose_plane_byte_sse2(const void * VS_RESTRICT src, ptrdiff_t src_stride, void * VS_RESTRICT dst, ptrdiff_t dst_stride, unsigned width, unsigned height);
 void vs_transpose_plane_word_sse2(const void * VS_RESTRICT src, ptrdiff_t src_stride, void * VS_RESTRICT dst, ptrdiff_t dst_stride, unsigned width, unsigned height);
 void vs_transpose_plane_dword_sse2(const void * VS_RESTRICT src, ptrdiff_t src_stride, void * VS_RESTRICT dst, ptrdiff_t dst_stride, unsigned width, unsigned height);
+
+void vs_transpose_plane_byte_avx2(const void * VS_RESTRICT src, ptrdiff_t src_stride, void * VS_RESTRICT dst, ptrdiff_t dst_stride, unsigned width, unsigned height);
+void vs_transpose_plane_word_avx2(const void * VS_RESTRICT src, ptrdiff_t src_stride, void * VS_RESTRICT dst, ptrdiff_t dst_stride, unsigned width, unsigned height);
+void vs_transpose_plane_dword_avx2(const void * VS_RESTRICT src, ptrdiff_t src_stride, void * VS_RESTRICT dst, ptrdiff_t dst_stride, unsigned width, unsigned height);
+
+void vs_transpose_plane_byte_avx512(const void * VS_RESTRICT src, ptrdiff_t src_stride, void * VS_RESTRICT dst, ptrdiff_t dst_stride, unsigned width, unsigned height);
+void vs_transpose_plane_word_avx512(const void * VS_RESTRICT src, ptrdiff_t src_stride, void * VS_RESTRICT dst, ptrdiff_t dst_stride, unsigned width, unsigned height);
+void vs_transpose_plane_dword_avx512(const void * VS_RESTRICT src, ptrdiff_t src_stride, void * VS_RESTRICT dst, ptrdiff_t dst_stride, unsigned width, unsigned height);
+#endif
+
+#ifdef VS_TARGET_CPU_AARCH64
+void vs_transpose_plane_byte_neon(const void * VS_RESTRICT src, ptrdiff_t src_stride, void * VS_RESTRICT dst, ptrdiff_t dst_stride, unsigned width, unsigned height);
+void vs_transpose_plane_word_neon(const void * VS_RESTRICT src, ptrdiff_t src_stride, void * VS_RESTRICT dst, ptrdiff_t dst_stride, unsigned width, unsigned height);
+void vs_transpose_plane_dword_neon(const void * VS_RESTRICT src, ptrdiff_t src_stride, void * VS_RESTRICT dst, ptrdiff_t dst_stride, unsigned width, unsigned height);
 #endif
 
+/*
+ * Strides may be negative. Passing a pointer to the last row together with a
+ * negated stride for either the source or the destination turns the transpose
+ * into a 90 degree rotation without a second pass over the frame.
+ */
+
 /* Implementation details. */
 #ifdef VS_TRANSPOSE_IMPL
 
-#define ADD_OFFSET(p, stride) ((p) + (stride) / (sizeof(*(p))))
+#define ADD_OFFSET(p, stride) ((p) + (ptrdiff_t)(stride) / (ptrdiff_t)(sizeof(*(p))))
 
 #define CACHELINE_SIZE 64
 #define CACHELINE_SIZE_BYTE (CACHELINE_SIZE / sizeof(uint8_t))
 #define CACHELINE_SIZE_WORD (CACHELINE_SIZE / sizeof(uint16_t))
 #define CACHELINE_SIZE_DWORD (CACHELINE_SIZE / sizeof(uint32_t))
 
+/*
+ * Each cacheline-high strip of the source is walked column by column, so every
+ * source row is its own stream. There are more of them than the hardware
+ * prefetcher tracks, so implementations can prefetch the next line of each row.
+ */
+#ifndef TRANSPOSE_PREFETCH
+#define TRANSPOSE_PREFETCH(p) ((void)(p))
+#endif
+
 static void transpose_block_byte(const uint8_t * VS_RESTRICT src, ptrdiff_t src_stride, uint8_t * VS_RESTRICT dst, ptrdiff_t dst_stride);
 static void transpose_block_word(const uint16_t * VS_RESTRICT src, ptrdiff_t src_stride, uint16_t * VS_RESTRICT dst, ptrdiff_t dst_stride);
 static void transpose_block_dword(const uint32_t * VS_RESTRICT src, ptrdiff_t src_stride, uint32_t * VS_RESTRICT dst, ptrdiff_t dst_stride);
@@ -65,6 +94,11 @@ static void transpose_plane_byte(const void * VS_RESTRICT src, ptrdiff_t src_str
 
     for (i = 0; i < height_floor; i += CACHELINE_SIZE_BYTE) {
         for (j = 0; j < width_floor; j += BLOCK_WIDTH_BYTE) {
+            if (j % CACHELINE_SIZE_BYTE == 0) {
+                for (ii = i; ii < i + CACHELINE_SIZE_BYTE; ++ii) {
+                    TRANSPOSE_PREFETCH(ADD_OFFSET(src_p, ii * src_stride) + j + CACHELINE_SIZE_BYTE);
+                }
+            }
             /* Prioritize contiguous stores over contiguous loads. */
             for (ii = i; ii < i + CACHELINE_SIZE_BYTE; ii += BLOCK_HEIGHT_BYTE) {
                 transpose_block_byte(ADD_OFFSET(src_p, ii * src_stride) + j, src_stride, ADD_OFFSET(dst_p, j * dst_stride) + ii, dst_stride);
@@ -105,6 +139,11 @@ static void transpose_plane_word(const void * VS_RESTRICT src, ptrdiff_t src_str
 
     for (i = 0; i < height_floor; i += CACHELINE_SIZE_WORD) {
         for (j = 0; j < width_floor; j += BLOCK_WIDTH_WORD) {
+            if (j % CACHELINE_SIZE_WORD == 0) {
+                for (ii = i; ii < i + CACHELINE_SIZE_WORD; ++ii) {
+                    TRANSPOSE_PREFETCH(ADD_OFFSET(src_p, ii * src_stride) + j + CACHELINE_SIZE_WORD);
+                }
+            }
             /* Prioritize contiguous stores over contiguous loads. */
             for (ii = i; ii < i + CACHELINE_SIZE_WORD; ii += BLOCK_HEIGHT_WORD) {
                 transpose_block_word(ADD_OFFSET(src_p, ii * src_stride) + j, src_stride, ADD_OFFSET(dst_p, j * dst_stride) + ii, dst_stride);
@@ -138,13 +177,18 @@ static void transpose_plane_dword(const void * VS_RESTRICT src, ptrdiff_t src_st
     const uint32_t *src_p = src;
     uint32_t *dst_p = dst;
 
-    unsigned width_floor = width - width % BLOCK_WIDTH_BYTE;
-    unsigned height_floor = height - height % CACHELINE_SIZE_BYTE;
-    unsigned height_floor2 = height - height % BLOCK_HEIGHT_BYTE;
+    unsigned width_floor = width - width % BLOCK_WIDTH_DWORD;
+    unsigned height_floor = height - height % CACHELINE_SIZE_DWORD;
+    unsigned height_floor2 = height - height % BLOCK_HEIGHT_DWORD;
     unsigned i, j, ii;
 
     for (i = 0; i < height_floor; i += CACHELINE_SIZE_DWORD) {
         for (j = 0; j < width_floor; j += BLOCK_WIDTH_DWORD) {
+            if (j % CACHELINE_SIZE_DWORD == 0) {
+                for (ii = i; ii < i + CACHELINE_SIZE_DWORD; ++ii) {
+                    TRANSPOSE_PREFETCH(ADD_OFFSET(src_p, ii * src_stride) + j + CACHELINE_SIZE_DWORD);
+                }
+            }
             /* Prioritize contiguous stores over contiguous loads. */
             for (ii = i; ii < i + CACHELINE_SIZE_DWORD; ii += BLOCK_HEIGHT_DWORD) {
                 transpose_block_dword(ADD_OFFSET(src_p, ii * src_stride) + j, src_stride, ADD_OFFSET(dst_p, j * dst_stride) + ii, dst_stride);
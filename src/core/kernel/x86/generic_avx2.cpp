@@ -20,8 +20,12 @@
 
 #include <algorithm>
 #include <cmath>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
 #include <immintrin.h>
 #include "../generic.h"
+#include "../rank.h"
 
 #ifdef _MSC_VER
 #define FORCE_INLINE inline __forceinline
@@ -1019,6 +1023,168 @@ void filter_plane_3x3(const void *src, ptrdiff_t src_stride, void *dst, ptrdiff_
 #undef INVOKE
 }
 
+struct SeparableByte {
+    typedef uint8_t T;
+    typedef int16_t weight_type;
+    typedef __m256i vec_type;
+
+    static const weight_type *coeffs_h(const vs_generic_params &params) { return params.matrix_h; }
+    static const weight_type *coeffs_v(const vs_generic_params &params) { return params.matrix_v; }
+
+    static FORCE_INLINE vec_type load(const T *ptr) { return _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)ptr)); }
+    static FORCE_INLINE vec_type loadu(const int32_t *ptr) { return _mm256_loadu_si256((const __m256i *)ptr); }
+    static FORCE_INLINE void storeu(int32_t *ptr, vec_type x) { _mm256_storeu_si256((__m256i *)ptr, x); }
+    static FORCE_INLINE vec_type set1(weight_type x) { return _mm256_set1_epi32(x); }
+    static FORCE_INLINE vec_type zero() { return _mm256_setzero_si256(); }
+    static FORCE_INLINE vec_type madd(vec_type c, vec_type x, vec_type accum) { return _mm256_add_epi32(accum, _mm256_mullo_epi32(c, x)); }
+
+    static FORCE_INLINE __m256 to_float(vec_type x) { return _mm256_cvtepi32_ps(x); }
+
+    static FORCE_INLINE void store(T *ptr, __m256 x)
+    {
+        __m256i tmp = _mm256_cvtps_epi32(x);
+        __m128i packed = _mm_packs_epi32(_mm256_castsi256_si128(tmp), _mm256_extracti128_si256(tmp, 1));
+        _mm_storel_epi64((__m128i *)ptr, _mm_packus_epi16(packed, packed));
+    }
+};
+
+struct SeparableWord : SeparableByte {
+    typedef uint16_t T;
+
+    static FORCE_INLINE vec_type load(const T *ptr) { return _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *)ptr)); }
+
+    static FORCE_INLINE void store(T *ptr, __m256 x)
+    {
+        __m256i tmp = _mm256_cvtps_epi32(x);
+        _mm_storeu_si128((__m128i *)ptr, _mm_packus_epi32(_mm256_castsi256_si128(tmp), _mm256_extracti128_si256(tmp, 1)));
+    }
+};
+
+struct SeparableFloat {
+    typedef float T;
+    typedef float weight_type;
+    typedef __m256 vec_type;
+
+    static const weight_type *coeffs_h(const vs_generic_params &params) { return params.matrixf_h; }
+    static const weight_type *coeffs_v(const vs_generic_params &params) { return params.matrixf_v; }
+
+    static FORCE_INLINE vec_type load(const T *ptr) { return _mm256_loadu_ps(ptr); }
+    static FORCE_INLINE vec_type loadu(const float *ptr) { return _mm256_loadu_ps(ptr); }
+    static FORCE_INLINE void storeu(float *ptr, vec_type x) { _mm256_storeu_ps(ptr, x); }
+    static FORCE_INLINE vec_type set1(weight_type x) { return _mm256_set1_ps(x); }
+    static FORCE_INLINE vec_type zero() { return _mm256_setzero_ps(); }
+    static FORCE_INLINE vec_type madd(vec_type c, vec_type x, vec_type accum) { return _mm256_fmadd_ps(c, x, accum); }
+    static FORCE_INLINE __m256 to_float(vec_type x) { return x; }
+    static FORCE_INLINE void store(T *ptr, __m256 x) { _mm256_storeu_ps(ptr, x); }
+};
+
+// Vertical pass into a 32-bit row buffer followed by a horizontal pass over it. Integer sums are exact, so
+// this requires maxval * sum(|h|) * sum(|v|) to fit in int32_t. The caller checks this.
+template <class Traits>
+void conv_plane_separable(const void *src, ptrdiff_t src_stride, void *dst, ptrdiff_t dst_stride, const vs_generic_params &params, unsigned width, unsigned height)
+{
+    typedef typename Traits::T T;
+    typedef typename Traits::vec_type vec_type;
+    typedef typename std::conditional<std::is_integral<T>::value, int32_t, float>::type Intermediate;
+
+    const typename Traits::weight_type *coeffs_h = Traits::coeffs_h(params);
+    const typename Traits::weight_type *coeffs_v = Traits::coeffs_v(params);
+    unsigned fwidth = params.matrixsize_h;
+    unsigned fheight = params.matrixsize_v;
+    unsigned support_h = fwidth / 2;
+    unsigned support_v = fheight / 2;
+
+    const __m256 div = _mm256_set1_ps(params.div);
+    const __m256 bias = _mm256_set1_ps(params.bias);
+    const __m256 saturate_mask = _mm256_castsi256_ps(_mm256_set1_epi32(params.saturate ? 0xFFFFFFFF : 0x7FFFFFFF));
+    const __m256 maxval = _mm256_set1_ps(params.maxval);
+
+    thread_local std::vector<Intermediate> row_buffer;
+    row_buffer.resize(width + 2 * support_h + 8);
+    Intermediate *row = row_buffer.data() + support_h;
+    const Intermediate *row_h = row_buffer.data();
+
+    const T *srcp[VS_GENERIC_MAX_CONV_SIZE];
+
+    // The last horizontal vector may read past the mirrored padding, hence the spare vector in the row buffer.
+    unsigned vec_end = width & ~7U;
+
+    for (unsigned i = 0; i < height; ++i) {
+        T *dstp = static_cast<T *>(line_ptr(dst, i, dst_stride));
+
+        for (unsigned k = 0; k < fheight; ++k) {
+            int idx = static_cast<int>(i + k) - static_cast<int>(support_v);
+            idx = idx < 0 ? -idx : idx >= static_cast<int>(height) ? 2 * (height - 1) - idx : idx;
+            srcp[k] = static_cast<const T *>(line_ptr(src, idx, src_stride));
+        }
+
+        for (unsigned j = 0; j < vec_end; j += 8) {
+            vec_type accum = Traits::zero();
+
+            for (unsigned k = 0; k < fheight; ++k) {
+                accum = Traits::madd(Traits::set1(coeffs_v[k]), Traits::load(srcp[k] + j), accum);
+            }
+            Traits::storeu(row + j, accum);
+        }
+        for (unsigned j = vec_end; j < width; ++j) {
+            Intermediate accum = 0;
+
+            for (unsigned k = 0; k < fheight; ++k) {
+                accum += coeffs_v[k] * static_cast<Intermediate>(srcp[k][j]);
+            }
+            row[j] = accum;
+        }
+
+        for (unsigned k = 1; k <= support_h; ++k) {
+            row[-static_cast<int>(k)] = row[k];
+            row[width - 1 + k] = row[width - 1 - k];
+        }
+
+        for (unsigned j = 0; j < width; j += 8) {
+            vec_type accum = Traits::zero();
+
+            for (unsigned k = 0; k < fwidth; ++k) {
+                accum = Traits::madd(Traits::set1(coeffs_h[k]), Traits::loadu(row_h + j + k), accum);
+            }
+
+            __m256 tmp = _mm256_add_ps(_mm256_mul_ps(Traits::to_float(accum), div), bias);
+            tmp = _mm256_and_ps(tmp, saturate_mask);
+
+            if (std::is_integral<T>::value)
+                tmp = _mm256_min_ps(_mm256_max_ps(tmp, _mm256_setzero_ps()), maxval);
+
+            if (j + 8 <= width) {
+                Traits::store(dstp + j, tmp);
+            } else {
+                alignas(32) T tail[8];
+                Traits::store(tail, tmp);
+                std::copy_n(tail, width - j, dstp + j);
+            }
+        }
+    }
+}
+
+struct RankOps {
+    static void add(uint16_t *dst, const uint16_t *src, unsigned n)
+    {
+        for (unsigned i = 0; i < n; i += 16) {
+            __m256i x = _mm256_loadu_si256((const __m256i *)(dst + i));
+            x = _mm256_add_epi16(x, _mm256_loadu_si256((const __m256i *)(src + i)));
+            _mm256_storeu_si256((__m256i *)(dst + i), x);
+        }
+    }
+
+    static void add_sub(uint16_t *dst, const uint16_t *add, const uint16_t *sub, unsigned n)
+    {
+        for (unsigned i = 0; i < n; i += 16) {
+            __m256i x = _mm256_loadu_si256((const __m256i *)(dst + i));
+            x = _mm256_add_epi16(x, _mm256_loadu_si256((const __m256i *)(add + i)));
+            x = _mm256_sub_epi16(x, _mm256_loadu_si256((const __m256i *)(sub + i)));
+            _mm256_storeu_si256((__m256i *)(dst + i), x);
+        }
+    }
+};
+
 } // namespace
 
 
@@ -1237,3 +1403,28 @@ void vs_generic_3x3_conv_float_avx2(const void *src, ptrdiff_t src_stride, void
 {
     filter_plane_3x3<ConvolutionFloat>(src, src_stride, dst, dst_stride, *params, width, height);
 }
+
+void vs_generic_separable_conv_byte_avx2(const void *src, ptrdiff_t src_stride, void *dst, ptrdiff_t dst_stride, const struct vs_generic_params *params, unsigned width, unsigned height)
+{
+    conv_plane_separable<SeparableByte>(src, src_stride, dst, dst_stride, *params, width, height);
+}
+
+void vs_generic_separable_conv_word_avx2(const void *src, ptrdiff_t src_stride, void *dst, ptrdiff_t dst_stride, const struct vs_generic_params *params, unsigned width, unsigned height)
+{
+    conv_plane_separable<SeparableWord>(src, src_stride, dst, dst_stride, *params, width, height);
+}
+
+void vs_generic_separable_conv_float_avx2(const void *src, ptrdiff_t src_stride, void *dst, ptrdiff_t dst_stride, const struct vs_generic_params *params, unsigned width, unsigned height)
+{
+    conv_plane_separable<SeparableFloat>(src, src_stride, dst, dst_stride, *params, width, height);
+}
+
+void vs_generic_rank_byte_avx2(const void *src, ptrdiff_t src_stride, void *dst, ptrdiff_t dst_stride, const struct vs_generic_params *params, unsigned width, unsigned height)
+{
+    vs_rank::rank_plane<uint8_t, RankOps>(src, src_stride, dst, dst_stride, *params, width, height);
+}
+
+void vs_generic_rank_word_avx2(const void *src, ptrdiff_t src_stride, void *dst, ptrdiff_t dst_stride, const struct vs_generic_params *params, unsigned width, unsigned height)
+{
+    vs_rank::rank_plane<uint16_t, RankOps>(src, src_stride, dst, dst_stride, *params, width, height);
+}
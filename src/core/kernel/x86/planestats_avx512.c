@@ -0,0 +1,317 @@
+/*
+* Copyright (c) 2012-2019 Fredrik Mellbin
+*
+* This file is part of VapourSynth.
+*
+* VapourSynth is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 2.1 of the License, or (at your option) any later version.
+*
+* VapourSynth is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with VapourSynth; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include <math.h>
+#include <immintrin.h>
+#include "../planestats.h"
+
+static unsigned hmax_epu8(__m512i x)
+{
+    __m256i tmp256 = _mm256_max_epu8(_mm512_castsi512_si256(x), _mm512_extracti64x4_epi64(x, 1));
+    __m128i tmp = _mm_max_epu8(_mm256_castsi256_si128(tmp256), _mm256_extracti128_si256(tmp256, 1));
+    tmp = _mm_max_epu8(tmp, _mm_srli_si128(tmp, 8));
+    tmp = _mm_max_epu8(tmp, _mm_srli_si128(tmp, 4));
+    tmp = _mm_max_epu8(tmp, _mm_srli_si128(tmp, 2));
+    tmp = _mm_max_epu8(tmp, _mm_srli_si128(tmp, 1));
+    return _mm_cvtsi128_si32(tmp) & 0xFF;
+}
+
+static unsigned hmin_epu8(__m512i x)
+{
+    __m256i tmp256 = _mm256_min_epu8(_mm512_castsi512_si256(x), _mm512_extracti64x4_epi64(x, 1));
+    __m128i tmp = _mm_min_epu8(_mm256_castsi256_si128(tmp256), _mm256_extracti128_si256(tmp256, 1));
+    tmp = _mm_min_epu8(tmp, _mm_srli_si128(tmp, 8));
+    tmp = _mm_min_epu8(tmp, _mm_srli_si128(tmp, 4));
+    tmp = _mm_min_epu8(tmp, _mm_srli_si128(tmp, 2));
+    tmp = _mm_min_epu8(tmp, _mm_srli_si128(tmp, 1));
+    return _mm_cvtsi128_si32(tmp) & 0xFF;
+}
+
+static unsigned hmax_epu16(__m512i x)
+{
+    /* Zero extended words compare the same as dwords. */
+    __m512i lo = _mm512_and_si512(x, _mm512_set1_epi32(0xFFFF));
+    __m512i hi = _mm512_srli_epi32(x, 16);
+    return _mm512_reduce_max_epu32(_mm512_max_epu32(lo, hi));
+}
+
+static unsigned hmin_epu16(__m512i x)
+{
+    __m512i lo = _mm512_and_si512(x, _mm512_set1_epi32(0xFFFF));
+    __m512i hi = _mm512_srli_epi32(x, 16);
+    return _mm512_reduce_min_epu32(_mm512_min_epu32(lo, hi));
+}
+
+/* Sum of words, with each half accumulated by sad_epu8 and the high half weighted by 256. */
+static uint64_t hadd_epu16_sad(__m512i acc_lo, __m512i acc_hi)
+{
+    return (uint64_t)_mm512_reduce_add_epi64(acc_lo) + ((uint64_t)_mm512_reduce_add_epi64(acc_hi) << 8);
+}
+
+static __m512d cvtps_pd_lo(__m512 x) { return _mm512_cvtps_pd(_mm512_castps512_ps256(x)); }
+static __m512d cvtps_pd_hi(__m512 x) { return _mm512_cvtps_pd(_mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(x), 1))); }
+
+
+void vs_plane_stats_1_byte_avx512(union vs_plane_stats *stats, const void *src, ptrdiff_t stride, unsigned width, unsigned height)
+{
+    const uint8_t *srcp = src;
+    unsigned tail = width & ~63;
+    __mmask64 mask = ((__mmask64)1 << (width % 64)) - 1;
+    unsigned x, y;
+
+    __m512i mmin = _mm512_set1_epi8(UINT8_MAX);
+    __m512i mmax = _mm512_setzero_si512();
+    __m512i macc = _mm512_setzero_si512();
+
+    for (y = 0; y < height; y++) {
+        for (x = 0; x < tail; x += 64) {
+            __m512i v = _mm512_load_si512(srcp + x);
+            mmin = _mm512_min_epu8(mmin, v);
+            mmax = _mm512_max_epu8(mmax, v);
+            macc = _mm512_add_epi64(macc, _mm512_sad_epu8(v, _mm512_setzero_si512()));
+        }
+        if (width != tail) {
+            __m512i v = _mm512_maskz_loadu_epi8(mask, srcp + tail);
+            mmin = _mm512_mask_min_epu8(mmin, mask, mmin, v);
+            mmax = _mm512_max_epu8(mmax, v);
+            macc = _mm512_add_epi64(macc, _mm512_sad_epu8(v, _mm512_setzero_si512()));
+        }
+        srcp += stride;
+    }
+
+    stats->i.min = hmin_epu8(mmin);
+    stats->i.max = hmax_epu8(mmax);
+    stats->i.acc = _mm512_reduce_add_epi64(macc);
+}
+
+void vs_plane_stats_1_word_avx512(union vs_plane_stats *stats, const void *src, ptrdiff_t stride, unsigned width, unsigned height)
+{
+    const uint8_t *srcp = src;
+    unsigned tail = width & ~31;
+    __mmask32 mask = (__mmask32)(((uint64_t)1 << (width % 32)) - 1);
+    unsigned x, y;
+
+    __m512i mmin = _mm512_set1_epi16(UINT16_MAX);
+    __m512i mmax = _mm512_setzero_si512();
+    __m512i macc_lo = _mm512_setzero_si512();
+    __m512i macc_hi = _mm512_setzero_si512();
+    __m512i low8mask = _mm512_set1_epi16(0xFF);
+
+    for (y = 0; y < height; y++) {
+        for (x = 0; x < tail; x += 32) {
+            __m512i v = _mm512_load_si512((const uint16_t *)srcp + x);
+            mmin = _mm512_min_epu16(mmin, v);
+            mmax = _mm512_max_epu16(mmax, v);
+
+            macc_lo = _mm512_add_epi64(macc_lo, _mm512_sad_epu8(_mm512_and_si512(low8mask, v), _mm512_setzero_si512()));
+            macc_hi = _mm512_add_epi64(macc_hi, _mm512_sad_epu8(_mm512_srli_epi16(v, 8), _mm512_setzero_si512()));
+        }
+        if (width != tail) {
+            __m512i v = _mm512_maskz_loadu_epi16(mask, (const uint16_t *)srcp + tail);
+            mmin = _mm512_mask_min_epu16(mmin, mask, mmin, v);
+            mmax = _mm512_max_epu16(mmax, v);
+
+            macc_lo = _mm512_add_epi64(macc_lo, _mm512_sad_epu8(_mm512_and_si512(low8mask, v), _mm512_setzero_si512()));
+            macc_hi = _mm512_add_epi64(macc_hi, _mm512_sad_epu8(_mm512_srli_epi16(v, 8), _mm512_setzero_si512()));
+        }
+        srcp += stride;
+    }
+
+    stats->i.min = hmin_epu16(mmin);
+    stats->i.max = hmax_epu16(mmax);
+    stats->i.acc = hadd_epu16_sad(macc_lo, macc_hi);
+}
+
+void vs_plane_stats_1_float_avx512(union vs_plane_stats *stats, const void *src, ptrdiff_t stride, unsigned width, unsigned height)
+{
+    const uint8_t *srcp = src;
+    unsigned tail = width & ~15;
+    __mmask16 mask = (__mmask16)((1U << (width % 16)) - 1);
+    unsigned x, y;
+
+    __m512 fmmin = _mm512_set1_ps(INFINITY);
+    __m512 fmmax = _mm512_set1_ps(-INFINITY);
+    __m512d fmacc = _mm512_setzero_pd();
+
+    for (y = 0; y < height; y++) {
+        for (x = 0; x < tail; x += 16) {
+            __m512 v = _mm512_load_ps((const float *)srcp + x);
+            fmmin = _mm512_min_ps(fmmin, v);
+            fmmax = _mm512_max_ps(fmmax, v);
+            fmacc = _mm512_add_pd(fmacc, cvtps_pd_lo(v));
+            fmacc = _mm512_add_pd(fmacc, cvtps_pd_hi(v));
+        }
+        if (width != tail) {
+            __m512 v = _mm512_maskz_loadu_ps(mask, (const float *)srcp + tail);
+            fmmin = _mm512_mask_min_ps(fmmin, mask, fmmin, v);
+            fmmax = _mm512_mask_max_ps(fmmax, mask, fmmax, v);
+            fmacc = _mm512_add_pd(fmacc, cvtps_pd_lo(v));
+            fmacc = _mm512_add_pd(fmacc, cvtps_pd_hi(v));
+        }
+        srcp += stride;
+    }
+
+    stats->f.min = _mm512_reduce_min_ps(fmmin);
+    stats->f.max = _mm512_reduce_max_ps(fmmax);
+    stats->f.acc = _mm512_reduce_add_pd(fmacc);
+}
+
+void vs_plane_stats_2_byte_avx512(union vs_plane_stats *stats, const void *src1, ptrdiff_t src1_stride, const void *src2, ptrdiff_t src2_stride, unsigned width, unsigned height)
+{
+    const uint8_t *srcp1 = src1;
+    const uint8_t *srcp2 = src2;
+    unsigned tail = width & ~63;
+    __mmask64 mask = ((__mmask64)1 << (width % 64)) - 1;
+    unsigned x, y;
+
+    __m512i mmin = _mm512_set1_epi8(UINT8_MAX);
+    __m512i mmax = _mm512_setzero_si512();
+    __m512i macc = _mm512_setzero_si512();
+    __m512i mdiffacc = _mm512_setzero_si512();
+
+    for (y = 0; y < height; y++) {
+        for (x = 0; x < tail; x += 64) {
+            __m512i v1 = _mm512_load_si512(srcp1 + x);
+            __m512i v2 = _mm512_load_si512(srcp2 + x);
+            mmin = _mm512_min_epu8(mmin, v1);
+            mmax = _mm512_max_epu8(mmax, v1);
+            macc = _mm512_add_epi64(macc, _mm512_sad_epu8(v1, _mm512_setzero_si512()));
+            mdiffacc = _mm512_add_epi64(mdiffacc, _mm512_sad_epu8(v1, v2));
+        }
+        if (width != tail) {
+            __m512i v1 = _mm512_maskz_loadu_epi8(mask, srcp1 + tail);
+            __m512i v2 = _mm512_maskz_loadu_epi8(mask, srcp2 + tail);
+            mmin = _mm512_mask_min_epu8(mmin, mask, mmin, v1);
+            mmax = _mm512_max_epu8(mmax, v1);
+            macc = _mm512_add_epi64(macc, _mm512_sad_epu8(v1, _mm512_setzero_si512()));
+            mdiffacc = _mm512_add_epi64(mdiffacc, _mm512_sad_epu8(v1, v2));
+        }
+        srcp1 += src1_stride;
+        srcp2 += src2_stride;
+    }
+
+    stats->i.min = hmin_epu8(mmin);
+    stats->i.max = hmax_epu8(mmax);
+    stats->i.acc = _mm512_reduce_add_epi64(macc);
+    stats->i.diffacc = _mm512_reduce_add_epi64(mdiffacc);
+}
+
+void vs_plane_stats_2_word_avx512(union vs_plane_stats *stats, const void *src1, ptrdiff_t src1_stride, const void *src2, ptrdiff_t src2_stride, unsigned width, unsigned height)
+{
+    const uint8_t *srcp1 = src1;
+    const uint8_t *srcp2 = src2;
+    unsigned tail = width & ~31;
+    __mmask32 mask = (__mmask32)(((uint64_t)1 << (width % 32)) - 1);
+    unsigned x, y;
+
+    __m512i mmin = _mm512_set1_epi16(UINT16_MAX);
+    __m512i mmax = _mm512_setzero_si512();
+    __m512i macc_lo = _mm512_setzero_si512();
+    __m512i macc_hi = _mm512_setzero_si512();
+    __m512i mdiffacc_lo = _mm512_setzero_si512();
+    __m512i mdiffacc_hi = _mm512_setzero_si512();
+    __m512i low8mask = _mm512_set1_epi16(0xFF);
+
+    for (y = 0; y < height; y++) {
+        for (x = 0; x < tail; x += 32) {
+            __m512i v1 = _mm512_load_si512((const uint16_t *)srcp1 + x);
+            __m512i v2 = _mm512_load_si512((const uint16_t *)srcp2 + x);
+            __m512i udiff = _mm512_or_si512(_mm512_subs_epu16(v1, v2), _mm512_subs_epu16(v2, v1));
+
+            mmin = _mm512_min_epu16(mmin, v1);
+            mmax = _mm512_max_epu16(mmax, v1);
+
+            macc_lo = _mm512_add_epi64(macc_lo, _mm512_sad_epu8(_mm512_and_si512(low8mask, v1), _mm512_setzero_si512()));
+            macc_hi = _mm512_add_epi64(macc_hi, _mm512_sad_epu8(_mm512_srli_epi16(v1, 8), _mm512_setzero_si512()));
+
+            mdiffacc_lo = _mm512_add_epi64(mdiffacc_lo, _mm512_sad_epu8(_mm512_and_si512(low8mask, udiff), _mm512_setzero_si512()));
+            mdiffacc_hi = _mm512_add_epi64(mdiffacc_hi, _mm512_sad_epu8(_mm512_srli_epi16(udiff, 8), _mm512_setzero_si512()));
+        }
+        if (width != tail) {
+            __m512i v1 = _mm512_maskz_loadu_epi16(mask, (const uint16_t *)srcp1 + tail);
+            __m512i v2 = _mm512_maskz_loadu_epi16(mask, (const uint16_t *)srcp2 + tail);
+            __m512i udiff = _mm512_or_si512(_mm512_subs_epu16(v1, v2), _mm512_subs_epu16(v2, v1));
+
+            mmin = _mm512_mask_min_epu16(mmin, mask, mmin, v1);
+            mmax = _mm512_max_epu16(mmax, v1);
+
+            macc_lo = _mm512_add_epi64(macc_lo, _mm512_sad_epu8(_mm512_and_si512(low8mask, v1), _mm512_setzero_si512()));
+            macc_hi = _mm512_add_epi64(macc_hi, _mm512_sad_epu8(_mm512_srli_epi16(v1, 8), _mm512_setzero_si512()));
+
+            mdiffacc_lo = _mm512_add_epi64(mdiffacc_lo, _mm512_sad_epu8(_mm512_and_si512(low8mask, udiff), _mm512_setzero_si512()));
+            mdiffacc_hi = _mm512_add_epi64(mdiffacc_hi, _mm512_sad_epu8(_mm512_srli_epi16(udiff, 8), _mm512_setzero_si512()));
+        }
+        srcp1 += src1_stride;
+        srcp2 += src2_stride;
+    }
+
+    stats->i.min = hmin_epu16(mmin);
+    stats->i.max = hmax_epu16(mmax);
+    stats->i.acc = hadd_epu16_sad(macc_lo, macc_hi);
+    stats->i.diffacc = hadd_epu16_sad(mdiffacc_lo, mdiffacc_hi);
+}
+
+void vs_plane_stats_2_float_avx512(union vs_plane_stats *stats, const void *src1, ptrdiff_t src1_stride, const void *src2, ptrdiff_t src2_stride, unsigned width, unsigned height)
+{
+    const uint8_t *srcp1 = src1;
+    const uint8_t *srcp2 = src2;
+    unsigned tail = width & ~15;
+    __mmask16 mask = (__mmask16)((1U << (width % 16)) - 1);
+    unsigned x, y;
+
+    __m512 fmmin = _mm512_set1_ps(INFINITY);
+    __m512 fmmax = _mm512_set1_ps(-INFINITY);
+    __m512d fmacc = _mm512_setzero_pd();
+    __m512d fmdiffacc = _mm512_setzero_pd();
+
+    for (y = 0; y < height; y++) {
+        for (x = 0; x < tail; x += 16) {
+            __m512 v1 = _mm512_load_ps((const float *)srcp1 + x);
+            __m512 v2 = _mm512_load_ps((const float *)srcp2 + x);
+            __m512 tmp;
+            fmmin = _mm512_min_ps(fmmin, v1);
+            fmmax = _mm512_max_ps(fmmax, v1);
+            fmacc = _mm512_add_pd(fmacc, cvtps_pd_lo(v1));
+            fmacc = _mm512_add_pd(fmacc, cvtps_pd_hi(v1));
+            tmp = _mm512_abs_ps(_mm512_sub_ps(v1, v2));
+            fmdiffacc = _mm512_add_pd(fmdiffacc, cvtps_pd_lo(tmp));
+            fmdiffacc = _mm512_add_pd(fmdiffacc, cvtps_pd_hi(tmp));
+        }
+        if (width != tail) {
+            __m512 v1 = _mm512_maskz_loadu_ps(mask, (const float *)srcp1 + tail);
+            __m512 v2 = _mm512_maskz_loadu_ps(mask, (const float *)srcp2 + tail);
+            __m512 tmp;
+            fmmin = _mm512_mask_min_ps(fmmin, mask, fmmin, v1);
+            fmmax = _mm512_mask_max_ps(fmmax, mask, fmmax, v1);
+            fmacc = _mm512_add_pd(fmacc, cvtps_pd_lo(v1));
+            fmacc = _mm512_add_pd(fmacc, cvtps_pd_hi(v1));
+            tmp = _mm512_abs_ps(_mm512_sub_ps(v1, v2));
+            fmdiffacc = _mm512_add_pd(fmdiffacc, cvtps_pd_lo(tmp));
+            fmdiffacc = _mm512_add_pd(fmdiffacc, cvtps_pd_hi(tmp));
+        }
+        srcp1 += src1_stride;
+        srcp2 += src2_stride;
+    }
+
+    stats->f.min = _mm512_reduce_min_ps(fmmin);
+    stats->f.max = _mm512_reduce_max_ps(fmmax);
+    stats->f.acc = _mm512_reduce_add_pd(fmacc);
+    stats->f.diffacc = _mm512_reduce_add_pd(fmdiffacc);
+}
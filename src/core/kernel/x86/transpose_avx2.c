@@ -0,0 +1,210 @@
+/*
+* Copyright (c) 2012-2019 Fredrik Mellbin
+*
+* This file is part of VapourSynth.
+*
+* VapourSynth is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 2.1 of the License, or (at your option) any later version.
+*
+* VapourSynth is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with VapourSynth; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+#include <immintrin.h>
+
+#define VS_TRANSPOSE_IMPL
+#define BLOCK_WIDTH_BYTE 32
+#define BLOCK_HEIGHT_BYTE 16
+#define BLOCK_WIDTH_WORD 16
+#define BLOCK_HEIGHT_WORD 16
+#define BLOCK_WIDTH_DWORD 8
+#define BLOCK_HEIGHT_DWORD 8
+#define TRANSPOSE_PREFETCH(p) _mm_prefetch((const char *)(p), _MM_HINT_T0)
+#include "../transpose.h"
+
+/* 8x8 byte transpose within each 128-bit lane, see the SSE2 version. */
+static inline void transpose_8x16_byte_lanes(__m256i row[8])
+{
+    __m256i t0, t1, t2, t3, t4, t5, t6, t7;
+    __m256i tt0, tt1, tt2, tt3, tt4, tt5, tt6, tt7;
+    int k;
+
+    for (k = 0; k < 8; ++k) {
+        row[k] = _mm256_shuffle_epi32(row[k], _MM_SHUFFLE(3, 1, 2, 0));
+    }
+
+    t0 = _mm256_unpacklo_epi8(row[0], row[1]);
+    t1 = _mm256_unpacklo_epi8(row[2], row[3]);
+    t2 = _mm256_unpacklo_epi8(row[4], row[5]);
+    t3 = _mm256_unpacklo_epi8(row[6], row[7]);
+    t4 = _mm256_unpackhi_epi8(row[0], row[1]);
+    t5 = _mm256_unpackhi_epi8(row[2], row[3]);
+    t6 = _mm256_unpackhi_epi8(row[4], row[5]);
+    t7 = _mm256_unpackhi_epi8(row[6], row[7]);
+
+    tt0 = _mm256_unpacklo_epi16(t0, t1);
+    tt1 = _mm256_unpackhi_epi16(t0, t1);
+    tt2 = _mm256_unpacklo_epi16(t2, t3);
+    tt3 = _mm256_unpackhi_epi16(t2, t3);
+    tt4 = _mm256_unpacklo_epi16(t4, t5);
+    tt5 = _mm256_unpackhi_epi16(t4, t5);
+    tt6 = _mm256_unpacklo_epi16(t6, t7);
+    tt7 = _mm256_unpackhi_epi16(t6, t7);
+
+    /* Reorder so that row[k] holds output rows 2k and 2k+1 of each lane. */
+    row[0] = _mm256_unpacklo_epi32(tt0, tt2);
+    row[1] = _mm256_unpackhi_epi32(tt0, tt2);
+    row[4] = _mm256_unpacklo_epi32(tt1, tt3);
+    row[5] = _mm256_unpackhi_epi32(tt1, tt3);
+    row[2] = _mm256_unpacklo_epi32(tt4, tt6);
+    row[3] = _mm256_unpackhi_epi32(tt4, tt6);
+    row[6] = _mm256_unpacklo_epi32(tt5, tt7);
+    row[7] = _mm256_unpackhi_epi32(tt5, tt7);
+}
+
+/* 8x8 word transpose within each 128-bit lane. */
+static inline void transpose_8x8_word_lanes(__m256i row[8])
+{
+    __m256i t0, t1, t2, t3, t4, t5, t6, t7;
+    __m256i tt0, tt1, tt2, tt3, tt4, tt5, tt6, tt7;
+
+    t0 = _mm256_unpacklo_epi16(row[0], row[1]);
+    t1 = _mm256_unpacklo_epi16(row[2], row[3]);
+    t2 = _mm256_unpacklo_epi16(row[4], row[5]);
+    t3 = _mm256_unpacklo_epi16(row[6], row[7]);
+    t4 = _mm256_unpackhi_epi16(row[0], row[1]);
+    t5 = _mm256_unpackhi_epi16(row[2], row[3]);
+    t6 = _mm256_unpackhi_epi16(row[4], row[5]);
+    t7 = _mm256_unpackhi_epi16(row[6], row[7]);
+
+    tt0 = _mm256_unpacklo_epi32(t0, t1);
+    tt1 = _mm256_unpackhi_epi32(t0, t1);
+    tt2 = _mm256_unpacklo_epi32(t2, t3);
+    tt3 = _mm256_unpackhi_epi32(t2, t3);
+    tt4 = _mm256_unpacklo_epi32(t4, t5);
+    tt5 = _mm256_unpackhi_epi32(t4, t5);
+    tt6 = _mm256_unpacklo_epi32(t6, t7);
+    tt7 = _mm256_unpackhi_epi32(t6, t7);
+
+    row[0] = _mm256_unpacklo_epi64(tt0, tt2);
+    row[1] = _mm256_unpackhi_epi64(tt0, tt2);
+    row[2] = _mm256_unpacklo_epi64(tt1, tt3);
+    row[3] = _mm256_unpackhi_epi64(tt1, tt3);
+    row[4] = _mm256_unpacklo_epi64(tt4, tt6);
+    row[5] = _mm256_unpackhi_epi64(tt4, tt6);
+    row[6] = _mm256_unpacklo_epi64(tt5, tt7);
+    row[7] = _mm256_unpackhi_epi64(tt5, tt7);
+}
+
+static void transpose_block_byte(const uint8_t * VS_RESTRICT src, ptrdiff_t src_stride, uint8_t * VS_RESTRICT dst, ptrdiff_t dst_stride)
+{
+    __m256i a[8];
+    __m256i b[8];
+    int k;
+
+    for (k = 0; k < 8; ++k) {
+        a[k] = _mm256_load_si256((const __m256i *)ADD_OFFSET(src, k * src_stride));
+        b[k] = _mm256_load_si256((const __m256i *)ADD_OFFSET(src, (k + 8) * src_stride));
+    }
+
+    transpose_8x16_byte_lanes(a);
+    transpose_8x16_byte_lanes(b);
+
+    /* Join the halves from the upper and lower 8 source rows into full 16 byte output rows. */
+    for (k = 0; k < 8; ++k) {
+        __m256i lo = _mm256_unpacklo_epi64(a[k], b[k]);
+        __m256i hi = _mm256_unpackhi_epi64(a[k], b[k]);
+
+        _mm_store_si128((__m128i *)ADD_OFFSET(dst, (2 * k + 0) * dst_stride), _mm256_castsi256_si128(lo));
+        _mm_store_si128((__m128i *)ADD_OFFSET(dst, (2 * k + 1) * dst_stride), _mm256_castsi256_si128(hi));
+        _mm_store_si128((__m128i *)ADD_OFFSET(dst, (2 * k + 16) * dst_stride), _mm256_extracti128_si256(lo, 1));
+        _mm_store_si128((__m128i *)ADD_OFFSET(dst, (2 * k + 17) * dst_stride), _mm256_extracti128_si256(hi, 1));
+    }
+}
+
+static void transpose_block_word(const uint16_t * VS_RESTRICT src, ptrdiff_t src_stride, uint16_t * VS_RESTRICT dst, ptrdiff_t dst_stride)
+{
+    __m256i a[8];
+    __m256i b[8];
+    int k;
+
+    for (k = 0; k < 8; ++k) {
+        a[k] = _mm256_load_si256((const __m256i *)ADD_OFFSET(src, k * src_stride));
+        b[k] = _mm256_load_si256((const __m256i *)ADD_OFFSET(src, (k + 8) * src_stride));
+    }
+
+    transpose_8x8_word_lanes(a);
+    transpose_8x8_word_lanes(b);
+
+    for (k = 0; k < 8; ++k) {
+        _mm256_store_si256((__m256i *)ADD_OFFSET(dst, k * dst_stride), _mm256_permute2x128_si256(a[k], b[k], 0x20));
+        _mm256_store_si256((__m256i *)ADD_OFFSET(dst, (k + 8) * dst_stride), _mm256_permute2x128_si256(a[k], b[k], 0x31));
+    }
+}
+
+static void transpose_block_dword(const uint32_t * VS_RESTRICT src, ptrdiff_t src_stride, uint32_t * VS_RESTRICT dst, ptrdiff_t dst_stride)
+{
+    __m256 row0 = _mm256_load_ps((const float *)ADD_OFFSET(src, 0 * src_stride));
+    __m256 row1 = _mm256_load_ps((const float *)ADD_OFFSET(src, 1 * src_stride));
+    __m256 row2 = _mm256_load_ps((const float *)ADD_OFFSET(src, 2 * src_stride));
+    __m256 row3 = _mm256_load_ps((const float *)ADD_OFFSET(src, 3 * src_stride));
+    __m256 row4 = _mm256_load_ps((const float *)ADD_OFFSET(src, 4 * src_stride));
+    __m256 row5 = _mm256_load_ps((const float *)ADD_OFFSET(src, 5 * src_stride));
+    __m256 row6 = _mm256_load_ps((const float *)ADD_OFFSET(src, 6 * src_stride));
+    __m256 row7 = _mm256_load_ps((const float *)ADD_OFFSET(src, 7 * src_stride));
+
+    __m256 t0, t1, t2, t3, t4, t5, t6, t7;
+    __m256 tt0, tt1, tt2, tt3, tt4, tt5, tt6, tt7;
+
+    t0 = _mm256_unpacklo_ps(row0, row1);
+    t1 = _mm256_unpackhi_ps(row0, row1);
+    t2 = _mm256_unpacklo_ps(row2, row3);
+    t3 = _mm256_unpackhi_ps(row2, row3);
+    t4 = _mm256_unpacklo_ps(row4, row5);
+    t5 = _mm256_unpackhi_ps(row4, row5);
+    t6 = _mm256_unpacklo_ps(row6, row7);
+    t7 = _mm256_unpackhi_ps(row6, row7);
+
+    tt0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+    tt1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+    tt2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+    tt3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+    tt4 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(1, 0, 1, 0));
+    tt5 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(3, 2, 3, 2));
+    tt6 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(1, 0, 1, 0));
+    tt7 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(3, 2, 3, 2));
+
+    _mm256_store_ps((float *)ADD_OFFSET(dst, 0 * dst_stride), _mm256_permute2f128_ps(tt0, tt4, 0x20));
+    _mm256_store_ps((float *)ADD_OFFSET(dst, 1 * dst_stride), _mm256_permute2f128_ps(tt1, tt5, 0x20));
+    _mm256_store_ps((float *)ADD_OFFSET(dst, 2 * dst_stride), _mm256_permute2f128_ps(tt2, tt6, 0x20));
+    _mm256_store_ps((float *)ADD_OFFSET(dst, 3 * dst_stride), _mm256_permute2f128_ps(tt3, tt7, 0x20));
+    _mm256_store_ps((float *)ADD_OFFSET(dst, 4 * dst_stride), _mm256_permute2f128_ps(tt0, tt4, 0x31));
+    _mm256_store_ps((float *)ADD_OFFSET(dst, 5 * dst_stride), _mm256_permute2f128_ps(tt1, tt5, 0x31));
+    _mm256_store_ps((float *)ADD_OFFSET(dst, 6 * dst_stride), _mm256_permute2f128_ps(tt2, tt6, 0x31));
+    _mm256_store_ps((float *)ADD_OFFSET(dst, 7 * dst_stride), _mm256_permute2f128_ps(tt3, tt7, 0x31));
+}
+
+void vs_transpose_plane_byte_avx2(const void * VS_RESTRICT src, ptrdiff_t src_stride, void * VS_RESTRICT dst, ptrdiff_t dst_stride, unsigned width, unsigned height)
+{
+    transpose_plane_byte(src, src_stride, dst, dst_stride, width, height);
+}
+
+void vs_transpose_plane_word_avx2(const void * VS_RESTRICT src, ptrdiff_t src_stride, void * VS_RESTRICT dst, ptrdiff_t dst_stride, unsigned width, unsigned height)
+{
+    transpose_plane_word(src, src_stride, dst, dst_stride, width, height);
+}
+
+void vs_transpose_plane_dword_avx2(const void * VS_RESTRICT src, ptrdiff_t src_stride, void * VS_RESTRICT dst, ptrdiff_t dst_stride, unsigned width, unsigned height)
+{
+    transpose_plane_dword(src, src_stride, dst, dst_stride, width, height);
+}
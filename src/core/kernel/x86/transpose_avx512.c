@@ -0,0 +1,217 @@
+/*
+* Copyright (c) 2012-2019 Fredrik Mellbin
+*
+* This file is part of VapourSynth.
+*
+* VapourSynth is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 2.1 of the License, or (at your option) any later version.
+*
+* VapourSynth is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with VapourSynth; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+#include <immintrin.h>
+
+#define VS_TRANSPOSE_IMPL
+#define BLOCK_WIDTH_BYTE 64
+#define BLOCK_HEIGHT_BYTE 16
+#define BLOCK_WIDTH_WORD 32
+#define BLOCK_HEIGHT_WORD 16
+#define BLOCK_WIDTH_DWORD 16
+#define BLOCK_HEIGHT_DWORD 16
+#define TRANSPOSE_PREFETCH(p) _mm_prefetch((const char *)(p), _MM_HINT_T0)
+#include "../transpose.h"
+
+/* 8x8 byte transpose within each 128-bit lane, see the SSE2 version. */
+static inline void transpose_8x16_byte_lanes(__m512i row[8])
+{
+    __m512i t0, t1, t2, t3, t4, t5, t6, t7;
+    __m512i tt0, tt1, tt2, tt3, tt4, tt5, tt6, tt7;
+    int k;
+
+    for (k = 0; k < 8; ++k) {
+        row[k] = _mm512_shuffle_epi32(row[k], _MM_PERM_DBCA);
+    }
+
+    t0 = _mm512_unpacklo_epi8(row[0], row[1]);
+    t1 = _mm512_unpacklo_epi8(row[2], row[3]);
+    t2 = _mm512_unpacklo_epi8(row[4], row[5]);
+    t3 = _mm512_unpacklo_epi8(row[6], row[7]);
+    t4 = _mm512_unpackhi_epi8(row[0], row[1]);
+    t5 = _mm512_unpackhi_epi8(row[2], row[3]);
+    t6 = _mm512_unpackhi_epi8(row[4], row[5]);
+    t7 = _mm512_unpackhi_epi8(row[6], row[7]);
+
+    tt0 = _mm512_unpacklo_epi16(t0, t1);
+    tt1 = _mm512_unpackhi_epi16(t0, t1);
+    tt2 = _mm512_unpacklo_epi16(t2, t3);
+    tt3 = _mm512_unpackhi_epi16(t2, t3);
+    tt4 = _mm512_unpacklo_epi16(t4, t5);
+    tt5 = _mm512_unpackhi_epi16(t4, t5);
+    tt6 = _mm512_unpacklo_epi16(t6, t7);
+    tt7 = _mm512_unpackhi_epi16(t6, t7);
+
+    /* Reorder so that row[k] holds output rows 2k and 2k+1 of each lane. */
+    row[0] = _mm512_unpacklo_epi32(tt0, tt2);
+    row[1] = _mm512_unpackhi_epi32(tt0, tt2);
+    row[4] = _mm512_unpacklo_epi32(tt1, tt3);
+    row[5] = _mm512_unpackhi_epi32(tt1, tt3);
+    row[2] = _mm512_unpacklo_epi32(tt4, tt6);
+    row[3] = _mm512_unpackhi_epi32(tt4, tt6);
+    row[6] = _mm512_unpacklo_epi32(tt5, tt7);
+    row[7] = _mm512_unpackhi_epi32(tt5, tt7);
+}
+
+/* 8x8 word transpose within each 128-bit lane. */
+static inline void transpose_8x8_word_lanes(__m512i row[8])
+{
+    __m512i t0, t1, t2, t3, t4, t5, t6, t7;
+    __m512i tt0, tt1, tt2, tt3, tt4, tt5, tt6, tt7;
+
+    t0 = _mm512_unpacklo_epi16(row[0], row[1]);
+    t1 = _mm512_unpacklo_epi16(row[2], row[3]);
+    t2 = _mm512_unpacklo_epi16(row[4], row[5]);
+    t3 = _mm512_unpacklo_epi16(row[6], row[7]);
+    t4 = _mm512_unpackhi_epi16(row[0], row[1]);
+    t5 = _mm512_unpackhi_epi16(row[2], row[3]);
+    t6 = _mm512_unpackhi_epi16(row[4], row[5]);
+    t7 = _mm512_unpackhi_epi16(row[6], row[7]);
+
+    tt0 = _mm512_unpacklo_epi32(t0, t1);
+    tt1 = _mm512_unpackhi_epi32(t0, t1);
+    tt2 = _mm512_unpacklo_epi32(t2, t3);
+    tt3 = _mm512_unpackhi_epi32(t2, t3);
+    tt4 = _mm512_unpacklo_epi32(t4, t5);
+    tt5 = _mm512_unpackhi_epi32(t4, t5);
+    tt6 = _mm512_unpacklo_epi32(t6, t7);
+    tt7 = _mm512_unpackhi_epi32(t6, t7);
+
+    row[0] = _mm512_unpacklo_epi64(tt0, tt2);
+    row[1] = _mm512_unpackhi_epi64(tt0, tt2);
+    row[2] = _mm512_unpacklo_epi64(tt1, tt3);
+    row[3] = _mm512_unpackhi_epi64(tt1, tt3);
+    row[4] = _mm512_unpacklo_epi64(tt4, tt6);
+    row[5] = _mm512_unpackhi_epi64(tt4, tt6);
+    row[6] = _mm512_unpacklo_epi64(tt5, tt7);
+    row[7] = _mm512_unpackhi_epi64(tt5, tt7);
+}
+
+static void transpose_block_byte(const uint8_t * VS_RESTRICT src, ptrdiff_t src_stride, uint8_t * VS_RESTRICT dst, ptrdiff_t dst_stride)
+{
+    __m512i a[8];
+    __m512i b[8];
+    int k;
+
+    for (k = 0; k < 8; ++k) {
+        a[k] = _mm512_load_si512((const void *)ADD_OFFSET(src, k * src_stride));
+        b[k] = _mm512_load_si512((const void *)ADD_OFFSET(src, (k + 8) * src_stride));
+    }
+
+    transpose_8x16_byte_lanes(a);
+    transpose_8x16_byte_lanes(b);
+
+    /* Join the halves from the upper and lower 8 source rows into full 16 byte output rows. */
+    for (k = 0; k < 8; ++k) {
+        __m512i lo = _mm512_unpacklo_epi64(a[k], b[k]);
+        __m512i hi = _mm512_unpackhi_epi64(a[k], b[k]);
+
+        _mm_store_si128((__m128i *)ADD_OFFSET(dst, (2 * k + 0) * dst_stride), _mm512_castsi512_si128(lo));
+        _mm_store_si128((__m128i *)ADD_OFFSET(dst, (2 * k + 1) * dst_stride), _mm512_castsi512_si128(hi));
+        _mm_store_si128((__m128i *)ADD_OFFSET(dst, (2 * k + 16) * dst_stride), _mm512_extracti32x4_epi32(lo, 1));
+        _mm_store_si128((__m128i *)ADD_OFFSET(dst, (2 * k + 17) * dst_stride), _mm512_extracti32x4_epi32(hi, 1));
+        _mm_store_si128((__m128i *)ADD_OFFSET(dst, (2 * k + 32) * dst_stride), _mm512_extracti32x4_epi32(lo, 2));
+        _mm_store_si128((__m128i *)ADD_OFFSET(dst, (2 * k + 33) * dst_stride), _mm512_extracti32x4_epi32(hi, 2));
+        _mm_store_si128((__m128i *)ADD_OFFSET(dst, (2 * k + 48) * dst_stride), _mm512_extracti32x4_epi32(lo, 3));
+        _mm_store_si128((__m128i *)ADD_OFFSET(dst, (2 * k + 49) * dst_stride), _mm512_extracti32x4_epi32(hi, 3));
+    }
+}
+
+static void transpose_block_word(const uint16_t * VS_RESTRICT src, ptrdiff_t src_stride, uint16_t * VS_RESTRICT dst, ptrdiff_t dst_stride)
+{
+    __m512i a[8];
+    __m512i b[8];
+    int k;
+
+    for (k = 0; k < 8; ++k) {
+        a[k] = _mm512_load_si512((const void *)ADD_OFFSET(src, k * src_stride));
+        b[k] = _mm512_load_si512((const void *)ADD_OFFSET(src, (k + 8) * src_stride));
+    }
+
+    transpose_8x8_word_lanes(a);
+    transpose_8x8_word_lanes(b);
+
+    /* Pair lane n of the upper and lower halves to form output rows 8n+k. */
+    for (k = 0; k < 8; ++k) {
+        __m512i lo = _mm512_shuffle_i64x2(a[k], b[k], _MM_SHUFFLE(1, 0, 1, 0));
+        __m512i hi = _mm512_shuffle_i64x2(a[k], b[k], _MM_SHUFFLE(3, 2, 3, 2));
+
+        lo = _mm512_shuffle_i64x2(lo, lo, _MM_SHUFFLE(3, 1, 2, 0));
+        hi = _mm512_shuffle_i64x2(hi, hi, _MM_SHUFFLE(3, 1, 2, 0));
+
+        _mm256_store_si256((__m256i *)ADD_OFFSET(dst, (k + 0) * dst_stride), _mm512_castsi512_si256(lo));
+        _mm256_store_si256((__m256i *)ADD_OFFSET(dst, (k + 8) * dst_stride), _mm512_extracti64x4_epi64(lo, 1));
+        _mm256_store_si256((__m256i *)ADD_OFFSET(dst, (k + 16) * dst_stride), _mm512_castsi512_si256(hi));
+        _mm256_store_si256((__m256i *)ADD_OFFSET(dst, (k + 24) * dst_stride), _mm512_extracti64x4_epi64(hi, 1));
+    }
+}
+
+static void transpose_block_dword(const uint32_t * VS_RESTRICT src, ptrdiff_t src_stride, uint32_t * VS_RESTRICT dst, ptrdiff_t dst_stride)
+{
+    __m512i row[16];
+    __m512i t[16];
+    int k;
+
+    for (k = 0; k < 16; ++k) {
+        row[k] = _mm512_load_si512((const void *)ADD_OFFSET(src, k * src_stride));
+    }
+
+    for (k = 0; k < 8; ++k) {
+        t[2 * k + 0] = _mm512_unpacklo_epi32(row[2 * k], row[2 * k + 1]);
+        t[2 * k + 1] = _mm512_unpackhi_epi32(row[2 * k], row[2 * k + 1]);
+    }
+
+    /* row[4j+m] lane n now holds column 4n+m of source rows 4j to 4j+3. */
+    for (k = 0; k < 4; ++k) {
+        row[4 * k + 0] = _mm512_unpacklo_epi64(t[4 * k + 0], t[4 * k + 2]);
+        row[4 * k + 1] = _mm512_unpackhi_epi64(t[4 * k + 0], t[4 * k + 2]);
+        row[4 * k + 2] = _mm512_unpacklo_epi64(t[4 * k + 1], t[4 * k + 3]);
+        row[4 * k + 3] = _mm512_unpackhi_epi64(t[4 * k + 1], t[4 * k + 3]);
+    }
+
+    for (k = 0; k < 4; ++k) {
+        __m512i a = _mm512_shuffle_i32x4(row[k], row[k + 4], _MM_SHUFFLE(2, 0, 2, 0));
+        __m512i b = _mm512_shuffle_i32x4(row[k], row[k + 4], _MM_SHUFFLE(3, 1, 3, 1));
+        __m512i c = _mm512_shuffle_i32x4(row[k + 8], row[k + 12], _MM_SHUFFLE(2, 0, 2, 0));
+        __m512i d = _mm512_shuffle_i32x4(row[k + 8], row[k + 12], _MM_SHUFFLE(3, 1, 3, 1));
+
+        _mm512_store_si512((void *)ADD_OFFSET(dst, (k + 0) * dst_stride), _mm512_shuffle_i32x4(a, c, _MM_SHUFFLE(2, 0, 2, 0)));
+        _mm512_store_si512((void *)ADD_OFFSET(dst, (k + 4) * dst_stride), _mm512_shuffle_i32x4(b, d, _MM_SHUFFLE(2, 0, 2, 0)));
+        _mm512_store_si512((void *)ADD_OFFSET(dst, (k + 8) * dst_stride), _mm512_shuffle_i32x4(a, c, _MM_SHUFFLE(3, 1, 3, 1)));
+        _mm512_store_si512((void *)ADD_OFFSET(dst, (k + 12) * dst_stride), _mm512_shuffle_i32x4(b, d, _MM_SHUFFLE(3, 1, 3, 1)));
+    }
+}
+
+void vs_transpose_plane_byte_avx512(const void * VS_RESTRICT src, ptrdiff_t src_stride, void * VS_RESTRICT dst, ptrdiff_t dst_stride, unsigned width, unsigned height)
+{
+    transpose_plane_byte(src, src_stride, dst, dst_stride, width, height);
+}
+
+void vs_transpose_plane_word_avx512(const void * VS_RESTRICT src, ptrdiff_t src_stride, void * VS_RESTRICT dst, ptrdiff_t dst_stride, unsigned width, unsigned height)
+{
+    transpose_plane_word(src, src_stride, dst, dst_stride, width, height);
+}
+
+void vs_transpose_plane_dword_avx512(const void * VS_RESTRICT src, ptrdiff_t src_stride, void * VS_RESTRICT dst, ptrdiff_t dst_stride, unsigned width, unsigned height)
+{
+    transpose_plane_dword(src, src_stride, dst, dst_stride, width, height);
+}
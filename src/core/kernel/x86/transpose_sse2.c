@@ -29,6 +29,7 @@
 #define BLOCK_HEIGHT_WORD 8
 #define BLOCK_WIDTH_DWORD 4
 #define BLOCK_HEIGHT_DWORD 4
+#define TRANSPOSE_PREFETCH(p) _mm_prefetch((const char *)(p), _MM_HINT_T0)
 #include "../transpose.h"
 
 static void transpose_block_byte(const uint8_t * VS_RESTRICT src, ptrdiff_t src_stride, uint8_t * VS_RESTRICT dst, ptrdiff_t dst_stride)
@@ -35,7 +35,12 @@ using namespace vsh;
 // PreMultiply
 
 
-typedef VariableNodeData<VIPointerData> PreMultiplyData;
+typedef struct {
+    const VSVideoInfo *vi;
+    int cpulevel;
+} PreMultiplyDataExtra;
+
+typedef VariableNodeData<PreMultiplyDataExtra> PreMultiplyData;
 
 static unsigned getLimitedRangeOffset(const VSFrame *f, const VSVideoInfo *vi, const VSAPI *vsapi) {
     int err;
@@ -73,12 +78,33 @@ static const VSFrame *VS_CC preMultiplyGetFrame(int n, int activationReason, voi
 
             void (*func)(const void *, const void *, void *, unsigned, unsigned, unsigned) = nullptr;
 
-            if (d->vi->format.sampleType == stInteger && d->vi->format.bytesPerSample == 1)
-                func = vs_premultiply_byte_c;
-            else if (d->vi->format.sampleType == stInteger && d->vi->format.bytesPerSample == 2)
-                func = vs_premultiply_word_c;
-            else if (d->vi->format.sampleType == stFloat && d->vi->format.bytesPerSample == 4)
-                func = vs_premultiply_float_c;
+#ifdef VS_TARGET_CPU_X86
+            if (getCPUFeatures()->avx512_f && getCPUFeatures()->avx512_bw && d->cpulevel >= VS_CPU_LEVEL_AVX512) {
+                if (d->vi->format.sampleType == stInteger && d->vi->format.bytesPerSample == 1)
+                    func = vs_premultiply_byte_avx512;
+                else if (d->vi->format.sampleType == stInteger && d->vi->format.bytesPerSample == 2)
+                    func = vs_premultiply_word_avx512;
+                else if (d->vi->format.sampleType == stFloat && d->vi->format.bytesPerSample == 4)
+                    func = vs_premultiply_float_avx512;
+            }
+#elif defined(VS_TARGET_CPU_AARCH64)
+            if (d->cpulevel >= VS_CPU_LEVEL_NEON) {
+                if (d->vi->format.sampleType == stInteger && d->vi->format.bytesPerSample == 1)
+                    func = vs_premultiply_byte_neon;
+                else if (d->vi->format.sampleType == stInteger && d->vi->format.bytesPerSample == 2)
+                    func = vs_premultiply_word_neon;
+                else if (d->vi->format.sampleType == stFloat && d->vi->format.bytesPerSample == 4)
+                    func = vs_premultiply_float_neon;
+            }
+#endif
+            if (!func) {
+                if (d->vi->format.sampleType == stInteger && d->vi->format.bytesPerSample == 1)
+                    func = vs_premultiply_byte_c;
+                else if (d->vi->format.sampleType == stInteger && d->vi->format.bytesPerSample == 2)
+                    func = vs_premultiply_word_c;
+                else if (d->vi->format.sampleType == stFloat && d->vi->format.bytesPerSample == 4)
+                    func = vs_premultiply_float_c;
+            }
 
             if (!func)
                 continue;
@@ -135,6 +161,8 @@ static void VS_CC preMultiplyCreate(const VSMap *in, VSMap *out, void *userData,
         d->nodes[2] = vsapi->addNodeRef(d->nodes[1]);
     }
 
+    d->cpulevel = vs_get_cpulevel(core);
+
     VSFilterDependency deps[] = {{ d->nodes[0], rpStrictSpatial }, { d->nodes[1], (d->vi->numFrames <= vsapi->getVideoInfo(d->nodes[1])->numFrames) ? rpStrictSpatial : rpGeneral }, { d->nodes[2], (d->vi->numFrames <= vsapi->getVideoInfo(d->nodes[1])->numFrames) ? rpStrictSpatial : rpGeneral }};
     vsapi->createVideoFilter(out, "PreMultiply", d->vi, preMultiplyGetFrame, filterFree<PreMultiplyData>, fmParallel, deps, d->nodes[2] ? 3 : 2, d.get(), core);
     d.release();
@@ -181,7 +209,15 @@ static const VSFrame *VS_CC mergeGetFrame(int n, int activationReason, void *ins
                 union vs_merge_weight weight;
 
 #ifdef VS_TARGET_CPU_X86
-                if (getCPUFeatures()->avx2 && d->cpulevel >= VS_CPU_LEVEL_AVX2) {
+                if (getCPUFeatures()->avx512_f && getCPUFeatures()->avx512_bw && d->cpulevel >= VS_CPU_LEVEL_AVX512) {
+                    if (d->vi->format.sampleType == stInteger && d->vi->format.bytesPerSample == 1)
+                        func = vs_merge_byte_avx512;
+                    else if (d->vi->format.sampleType == stInteger && d->vi->format.bytesPerSample == 2)
+                        func = vs_merge_word_avx512;
+                    else if (d->vi->format.sampleType == stFloat && d->vi->format.bytesPerSample == 4)
+                        func = vs_merge_float_avx512;
+                }
+                if (!func && getCPUFeatures()->avx2 && d->cpulevel >= VS_CPU_LEVEL_AVX2) {
                     if (d->vi->format.sampleType == stInteger && d->vi->format.bytesPerSample == 1)
                         func = vs_merge_byte_avx2;
                     else if (d->vi->format.sampleType == stInteger && d->vi->format.bytesPerSample == 2)
@@ -197,6 +233,15 @@ static const VSFrame *VS_CC mergeGetFrame(int n, int activationReason, void *ins
                     else if (d->vi->format.sampleType == stFloat && d->vi->format.bytesPerSample == 4)
                         func = vs_merge_float_sse2;
                 }
+#elif defined(VS_TARGET_CPU_AARCH64)
+                if (d->cpulevel >= VS_CPU_LEVEL_NEON) {
+                    if (d->vi->format.sampleType == stInteger && d->vi->format.bytesPerSample == 1)
+                        func = vs_merge_byte_neon;
+                    else if (d->vi->format.sampleType == stInteger && d->vi->format.bytesPerSample == 2)
+                        func = vs_merge_word_neon;
+                    else if (d->vi->format.sampleType == stFloat && d->vi->format.bytesPerSample == 4)
+                        func = vs_merge_float_neon;
+                }
 #endif
                 if (!func) {
                     if (d->vi->format.sampleType == stInteger && d->vi->format.bytesPerSample == 1)
@@ -348,7 +393,15 @@ static const VSFrame *VS_CC maskedMergeGetFrame(int n, int activationReason, voi
                 }
 
 #ifdef VS_TARGET_CPU_X86
-                if (getCPUFeatures()->avx2 && d->cpulevel >= VS_CPU_LEVEL_AVX2) {
+                if (getCPUFeatures()->avx512_f && getCPUFeatures()->avx512_bw && d->cpulevel >= VS_CPU_LEVEL_AVX512) {
+                    if (d->vi->format.sampleType == stInteger && d->vi->format.bytesPerSample == 1)
+                        func = d->premultiplied ? vs_mask_merge_premul_byte_avx512 : vs_mask_merge_byte_avx512;
+                    else if (d->vi->format.sampleType == stInteger && d->vi->format.bytesPerSample == 2)
+                        func = d->premultiplied ? vs_mask_merge_premul_word_avx512 : vs_mask_merge_word_avx512;
+                    else if (d->vi->format.sampleType == stFloat && d->vi->format.bytesPerSample == 4)
+                        func = d->premultiplied ? vs_mask_merge_premul_float_avx512 : vs_mask_merge_float_avx512;
+                }
+                if (!func && getCPUFeatures()->avx2 && d->cpulevel >= VS_CPU_LEVEL_AVX2) {
                     if (d->vi->format.sampleType == stInteger && d->vi->format.bytesPerSample == 1)
                         func = d->premultiplied ? vs_mask_merge_premul_byte_avx2 : vs_mask_merge_byte_avx2;
                     else if (d->vi->format.sampleType == stInteger && d->vi->format.bytesPerSample == 2)
@@ -364,6 +417,15 @@ static const VSFrame *VS_CC maskedMergeGetFrame(int n, int activationReason, voi
                     else if (d->vi->format.sampleType == stFloat && d->vi->format.bytesPerSample == 4)
                         func = d->premultiplied ? vs_mask_merge_premul_float_sse2 : vs_mask_merge_float_sse2;
                 }
+#elif defined(VS_TARGET_CPU_AARCH64)
+                if (d->cpulevel >= VS_CPU_LEVEL_NEON) {
+                    if (d->vi->format.sampleType == stInteger && d->vi->format.bytesPerSample == 1)
+                        func = d->premultiplied ? vs_mask_merge_premul_byte_neon : vs_mask_merge_byte_neon;
+                    else if (d->vi->format.sampleType == stInteger && d->vi->format.bytesPerSample == 2)
+                        func = d->premultiplied ? vs_mask_merge_premul_word_neon : vs_mask_merge_word_neon;
+                    else if (d->vi->format.sampleType == stFloat && d->vi->format.bytesPerSample == 4)
+                        func = d->premultiplied ? vs_mask_merge_premul_float_neon : vs_mask_merge_float_neon;
+                }
 #endif
                 if (!func) {
                     if (d->vi->format.sampleType == stInteger && d->vi->format.bytesPerSample == 1)
@@ -496,7 +558,15 @@ static const VSFrame *VS_CC makeDiffGetFrame(int n, int activationReason, void *
                 void (*func)(const void *, const void *, void *, unsigned, unsigned) = 0;
 
 #ifdef VS_TARGET_CPU_X86
-                if (getCPUFeatures()->avx2 && d->cpulevel >= VS_CPU_LEVEL_AVX2) {
+                if (getCPUFeatures()->avx512_f && getCPUFeatures()->avx512_bw && d->cpulevel >= VS_CPU_LEVEL_AVX512) {
+                    if (d->vi->format.sampleType == stInteger && d->vi->format.bytesPerSample == 1)
+                        func = vs_makediff_byte_avx512;
+                    else if (d->vi->format.sampleType == stInteger && d->vi->format.bytesPerSample == 2)
+                        func = vs_makediff_word_avx512;
+                    else if (d->vi->format.sampleType == stFloat && d->vi->format.bytesPerSample == 4)
+                        func = vs_makediff_float_avx512;
+                }
+                if (!func && getCPUFeatures()->avx2 && d->cpulevel >= VS_CPU_LEVEL_AVX2) {
                     if (d->vi->format.sampleType == stInteger && d->vi->format.bytesPerSample == 1)
                         func = vs_makediff_byte_avx2;
                     else if (d->vi->format.sampleType == stInteger && d->vi->format.bytesPerSample == 2)
@@ -512,6 +582,15 @@ static const VSFrame *VS_CC makeDiffGetFrame(int n, int activationReason, void *
                     else if (d->vi->format.sampleType == stFloat && d->vi->format.bytesPerSample == 4)
                         func = vs_makediff_float_sse2;
                 }
+#elif defined(VS_TARGET_CPU_AARCH64)
+                if (d->cpulevel >= VS_CPU_LEVEL_NEON) {
+                    if (d->vi->format.sampleType == stInteger && d->vi->format.bytesPerSample == 1)
+                        func = vs_makediff_byte_neon;
+                    else if (d->vi->format.sampleType == stInteger && d->vi->format.bytesPerSample == 2)
+                        func = vs_makediff_word_neon;
+                    else if (d->vi->format.sampleType == stFloat && d->vi->format.bytesPerSample == 4)
+                        func = vs_makediff_float_neon;
+                }
 #endif
                 if (!func) {
                     if (d->vi->format.sampleType == stInteger && d->vi->format.bytesPerSample == 1)
@@ -602,7 +681,15 @@ static const VSFrame *VS_CC mergeDiffGetFrame(int n, int activationReason, void
                 void (*func)(const void *, const void *, void *, unsigned, unsigned) = 0;
 
 #ifdef VS_TARGET_CPU_X86
-                if (getCPUFeatures()->avx2 && d->cpulevel >= VS_CPU_LEVEL_AVX2) {
+                if (getCPUFeatures()->avx512_f && getCPUFeatures()->avx512_bw && d->cpulevel >= VS_CPU_LEVEL_AVX512) {
+                    if (d->vi->format.sampleType == stInteger && d->vi->format.bytesPerSample == 1)
+                        func = vs_mergediff_byte_avx512;
+                    else if (d->vi->format.sampleType == stInteger && d->vi->format.bytesPerSample == 2)
+                        func = vs_mergediff_word_avx512;
+                    else if (d->vi->format.sampleType == stFloat && d->vi->format.bytesPerSample == 4)
+                        func = vs_mergediff_float_avx512;
+                }
+                if (!func && getCPUFeatures()->avx2 && d->cpulevel >= VS_CPU_LEVEL_AVX2) {
                     if (d->vi->format.sampleType == stInteger && d->vi->format.bytesPerSample == 1)
                         func = vs_mergediff_byte_avx2;
                     else if (d->vi->format.sampleType == stInteger && d->vi->format.bytesPerSample == 2)
@@ -618,6 +705,15 @@ static const VSFrame *VS_CC mergeDiffGetFrame(int n, int activationReason, void
                     else if (d->vi->format.sampleType == stFloat && d->vi->format.bytesPerSample == 4)
                         func = vs_mergediff_float_sse2;
                 }
+#elif defined(VS_TARGET_CPU_AARCH64)
+                if (d->cpulevel >= VS_CPU_LEVEL_NEON) {
+                    if (d->vi->format.sampleType == stInteger && d->vi->format.bytesPerSample == 1)
+                        func = vs_mergediff_byte_neon;
+                    else if (d->vi->format.sampleType == stInteger && d->vi->format.bytesPerSample == 2)
+                        func = vs_mergediff_word_neon;
+                    else if (d->vi->format.sampleType == stFloat && d->vi->format.bytesPerSample == 4)
+                        func = vs_mergediff_float_neon;
+                }
 #endif
                 if (!func) {
                     if (d->vi->format.sampleType == stInteger && d->vi->format.bytesPerSample == 1)
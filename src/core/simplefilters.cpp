@@ -1665,8 +1665,15 @@ static void VS_CC modifyFrameCreate(const VSMap *in, VSMap *out, void *userData,
 //////////////////////////////////////////
 // Transpose
 
+enum TransposeTurn {
+    ttNone = 0,
+    ttLeft = 1,
+    ttRight = 2
+};
+
 typedef struct {
     VSVideoInfo vi;
+    int turn;
     int cpulevel;
 } TransposeDataExtra;
 
@@ -1690,13 +1697,35 @@ static const VSFrame *VS_CC transposeGetFrame(int n, int activationReason, void
         void (*func)(const void *, ptrdiff_t, void *, ptrdiff_t, unsigned, unsigned) = nullptr;
 
 #ifdef VS_TARGET_CPU_X86
-        if (d->cpulevel >= VS_CPU_LEVEL_SSE2) {
+        if (getCPUFeatures()->avx512_f && getCPUFeatures()->avx512_bw && d->cpulevel >= VS_CPU_LEVEL_AVX512) {
+            switch (d->vi.format.bytesPerSample) {
+            case 1: func = vs_transpose_plane_byte_avx512; break;
+            case 2: func = vs_transpose_plane_word_avx512; break;
+            case 4: func = vs_transpose_plane_dword_avx512; break;
+            }
+        }
+        if (!func && getCPUFeatures()->avx2 && d->cpulevel >= VS_CPU_LEVEL_AVX2) {
+            switch (d->vi.format.bytesPerSample) {
+            case 1: func = vs_transpose_plane_byte_avx2; break;
+            case 2: func = vs_transpose_plane_word_avx2; break;
+            case 4: func = vs_transpose_plane_dword_avx2; break;
+            }
+        }
+        if (!func && d->cpulevel >= VS_CPU_LEVEL_SSE2) {
             switch (d->vi.format.bytesPerSample) {
             case 1: func = vs_transpose_plane_byte_sse2; break;
             case 2: func = vs_transpose_plane_word_sse2; break;
             case 4: func = vs_transpose_plane_dword_sse2; break;
             }
         }
+#elif defined(VS_TARGET_CPU_AARCH64)
+        if (d->cpulevel >= VS_CPU_LEVEL_NEON) {
+            switch (d->vi.format.bytesPerSample) {
+            case 1: func = vs_transpose_plane_byte_neon; break;
+            case 2: func = vs_transpose_plane_word_neon; break;
+            case 4: func = vs_transpose_plane_dword_neon; break;
+            }
+        }
 #endif
         if (!func) {
             switch (d->vi.format.bytesPerSample) {
@@ -1714,6 +1743,15 @@ static const VSFrame *VS_CC transposeGetFrame(int n, int activationReason, void
             dstp = vsapi->getWritePtr(dst, plane);
             dst_stride = vsapi->getStride(dst, plane);
 
+            // Rotations are a transpose with the source or destination rows walked bottom-up
+            if (d->turn == ttLeft) {
+                dstp += dst_stride * (width - 1);
+                dst_stride = -dst_stride;
+            } else if (d->turn == ttRight) {
+                srcp += src_stride * (height - 1);
+                src_stride = -src_stride;
+            }
+
             if (func)
                 func(srcp, src_stride, dstp, dst_stride, width, height);
         }
@@ -1730,6 +1768,9 @@ static void VS_CC transposeCreate(const VSMap *in, VSMap *out, void *userData, V
     std::unique_ptr<TransposeData> d(new TransposeData(vsapi));
     int temp;
 
+    d->turn = static_cast<int>(reinterpret_cast<intptr_t>(userData));
+    const char *funcName = (d->turn == ttLeft) ? "TurnLeft" : (d->turn == ttRight) ? "TurnRight" : "Transpose";
+
     d->node = vsapi->mapGetNode(in, "clip", 0, 0);
     d->vi = *vsapi->getVideoInfo(d->node);
     temp = d->vi.width;
@@ -1737,13 +1778,13 @@ static void VS_CC transposeCreate(const VSMap *in, VSMap *out, void *userData, V
     d->vi.height = temp;
 
     if (!isConstantVideoFormat(&d->vi))
-        RETERROR("Transpose: clip must have constant format and dimensions and must not be CompatYUY2");
+        RETERROR((std::string(funcName) + ": clip must have constant format and dimensions and must not be CompatYUY2").c_str());
 
     vsapi->queryVideoFormat(&d->vi.format, d->vi.format.colorFamily, d->vi.format.sampleType, d->vi.format.bitsPerSample, d->vi.format.subSamplingH, d->vi.format.subSamplingW, core);
     d->cpulevel = vs_get_cpulevel(core);
 
     VSFilterDependency deps[] = {{d->node, rpStrictSpatial}};
-    vsapi->createVideoFilter(out, "Transpose", &d->vi, transposeGetFrame, filterFree<TransposeData>, fmParallel, deps, 1, d.get(), core);
+    vsapi->createVideoFilter(out, funcName, &d->vi, transposeGetFrame, filterFree<TransposeData>, fmParallel, deps, 1, d.get(), core);
     d.release();
 }
 
@@ -1913,7 +1954,14 @@ static const VSFrame *VS_CC planeStatsGetFrame(int n, int activationReason, void
             void (*func)(union vs_plane_stats *, const void *, ptrdiff_t, const void *, ptrdiff_t, unsigned, unsigned) = nullptr;
 
 #ifdef VS_TARGET_CPU_X86
-            if (getCPUFeatures()->avx2 && d->cpulevel >= VS_CPU_LEVEL_AVX2) {
+            if (getCPUFeatures()->avx512_f && getCPUFeatures()->avx512_bw && d->cpulevel >= VS_CPU_LEVEL_AVX512) {
+                switch (fi->bytesPerSample) {
+                case 1: func = vs_plane_stats_2_byte_avx512; break;
+                case 2: func = vs_plane_stats_2_word_avx512; break;
+                case 4: func = vs_plane_stats_2_float_avx512; break;
+                }
+            }
+            if (!func && getCPUFeatures()->avx2 && d->cpulevel >= VS_CPU_LEVEL_AVX2) {
                 switch (fi->bytesPerSample) {
                 case 1: func = vs_plane_stats_2_byte_avx2; break;
                 case 2: func = vs_plane_stats_2_word_avx2; break;
@@ -1927,6 +1975,14 @@ static const VSFrame *VS_CC planeStatsGetFrame(int n, int activationReason, void
                 case 4: func = vs_plane_stats_2_float_sse2; break;
                 }
             }
+#elif defined(VS_TARGET_CPU_AARCH64)
+            if (d->cpulevel >= VS_CPU_LEVEL_NEON) {
+                switch (fi->bytesPerSample) {
+                case 1: func = vs_plane_stats_2_byte_neon; break;
+                case 2: func = vs_plane_stats_2_word_neon; break;
+                case 4: func = vs_plane_stats_2_float_neon; break;
+                }
+            }
 #endif
             if (!func) {
                 switch (fi->bytesPerSample) {
@@ -1942,7 +1998,14 @@ static const VSFrame *VS_CC planeStatsGetFrame(int n, int activationReason, void
             void (*func)(union vs_plane_stats *, const void *, ptrdiff_t, unsigned, unsigned) = nullptr;
 
 #ifdef VS_TARGET_CPU_X86
-            if (getCPUFeatures()->avx2 && d->cpulevel >= VS_CPU_LEVEL_AVX2) {
+            if (getCPUFeatures()->avx512_f && getCPUFeatures()->avx512_bw && d->cpulevel >= VS_CPU_LEVEL_AVX512) {
+                switch (fi->bytesPerSample) {
+                case 1: func = vs_plane_stats_1_byte_avx512; break;
+                case 2: func = vs_plane_stats_1_word_avx512; break;
+                case 4: func = vs_plane_stats_1_float_avx512; break;
+                }
+            }
+            if (!func && getCPUFeatures()->avx2 && d->cpulevel >= VS_CPU_LEVEL_AVX2) {
                 switch (fi->bytesPerSample) {
                 case 1: func = vs_plane_stats_1_byte_avx2; break;
                 case 2: func = vs_plane_stats_1_word_avx2; break;
@@ -1956,6 +2019,14 @@ static const VSFrame *VS_CC planeStatsGetFrame(int n, int activationReason, void
                 case 4: func = vs_plane_stats_1_float_sse2; break;
                 }
             }
+#elif defined(VS_TARGET_CPU_AARCH64)
+            if (d->cpulevel >= VS_CPU_LEVEL_NEON) {
+                switch (fi->bytesPerSample) {
+                case 1: func = vs_plane_stats_1_byte_neon; break;
+                case 2: func = vs_plane_stats_1_word_neon; break;
+                case 4: func = vs_plane_stats_1_float_neon; break;
+                }
+            }
 #endif
             if (!func) {
                 switch (fi->bytesPerSample) {
@@ -2573,6 +2644,8 @@ void stdlibInitialize(VSPlugin *plugin, const VSPLUGINAPI *vspapi) {
     vspapi->registerFunction("FrameEval", "clip:vnode;eval:func;prop_src:vnode[]:opt;clip_src:vnode[]:opt;", "clip:vnode;", frameEvalCreate, 0, plugin);
     vspapi->registerFunction("ModifyFrame", "clip:vnode;clips:vnode[];selector:func;", "clip:vnode;", modifyFrameCreate, 0, plugin);
     vspapi->registerFunction("Transpose", "clip:vnode;", "clip:vnode;", transposeCreate, 0, plugin);
+    vspapi->registerFunction("TurnLeft", "clip:vnode;", "clip:vnode;", transposeCreate, (void *)ttLeft, plugin);
+    vspapi->registerFunction("TurnRight", "clip:vnode;", "clip:vnode;", transposeCreate, (void *)ttRight, plugin);
     vspapi->registerFunction("PEMVerifier", "clip:vnode;upper:float[]:opt;lower:float[]:opt;", "clip:vnode;", pemVerifierCreate, 0, plugin);
     vspapi->registerFunction("PlaneStats", "clipa:vnode;clipb:vnode:opt;plane:int:opt;prop:data:opt;", "clip:vnode;", planeStatsCreate, 0, plugin);
     vspapi->registerFunction("ClipToProp", "clip:vnode;mclip:vnode;prop:data:opt;", "clip:vnode;", clipToPropCreate, 0, plugin);
@@ -21,6 +21,7 @@
 #include "vscore.h"
 #include "cpufeatures.h"
 #include "vslog.h"
+#include "vsgraphsnapshot.h"
 #include "VSHelper4.h"
 #include "VapourSynthC.h"
 #include <cassert>
@@ -514,8 +515,7 @@ static int VS_CC mapSetEmpty(VSMap *map, const char *key, int type) VS_NOEXCEPT
     if (!isValidVSMapKey(key))
         return 1;
 
-    std::string skey = key;
-    if (map->find(skey))
+    if (map->find(key))
         return 1;
 
     switch (type) {
@@ -557,7 +557,6 @@ bool propSetShared(VSMap *map, const char *key, const T &val, int append) {
 
     if (!isValidVSMapKey(key))
         return false;
-    std::string skey = key;
 
     if (append == maReplace) {
         VSArray<T, propType> *v = new VSArray<T, propType>();
@@ -565,9 +564,9 @@ bool propSetShared(VSMap *map, const char *key, const T &val, int append) {
         map->insert(key, v);
         return true;
     } else if (append == maAppend) {
-        VSArrayBase *arr = map->find(skey);
+        VSArrayBase *arr = map->find(key);
         if (arr && arr->type() == propType) {
-            arr = map->detach(skey);
+            arr = map->detach(key);
             reinterpret_cast<VSArray<T, propType> *>(arr)->push_back(val);
             return true;
         } else if (arr) {
@@ -1056,6 +1055,142 @@ static int VS_CC getNumNodeDependencies(VSNode *node) VS_NOEXCEPT {
     return static_cast<int>(node->getNumDependencies());
 }
 
+static void VS_CC getNodeStatistics(VSNode *node, VSMap *out) VS_NOEXCEPT {
+    assert(node && out);
+    node->getStatistics(out);
+}
+
+static void VS_CC getCoreStatistics(VSCore *core, VSMap *out) VS_NOEXCEPT {
+    assert(core && out);
+    core->getStatistics(out);
+}
+
+static void VS_CC getLiveStatistics(VSCore *core, VSMap *out) VS_NOEXCEPT {
+    assert(core && out);
+    core->getLiveStatistics(out);
+}
+
+static int VS_CC writeTrace(VSCore *core, const char *filename) VS_NOEXCEPT {
+    assert(core && filename);
+    return core->tracer ? core->tracer->writeChromeTrace(filename) : 0;
+}
+
+// Holds the frames of a getFramesAsync() batch that completed out of order until everything before them has been passed on
+struct VSFrameBatch {
+    struct Entry {
+        VSFrameBatch *batch;
+        size_t index;
+        int n;
+        bool done;
+        const VSFrame *frame;
+        std::string errorMessage;
+    };
+
+    std::mutex lock;
+    std::vector<Entry> entries;
+    size_t nextEntry = 0;
+    bool delivering = false;
+    std::atomic<size_t> pendingCallbacks;
+    VSFrameDoneCallback callback;
+    void *userData;
+    VSNode *node;
+
+    VSFrameBatch(size_t numEntries, VSNode *node, VSFrameDoneCallback callback, void *userData) : entries(numEntries), pendingCallbacks(numEntries), callback(callback), userData(userData), node(node) {}
+};
+
+static void VS_CC frameBatchCallback(void *userData, const VSFrame *f, int n, VSNode *node, const char *errorMsg) VS_NOEXCEPT {
+    VSFrameBatch::Entry *entry = static_cast<VSFrameBatch::Entry *>(userData);
+    VSFrameBatch *batch = entry->batch;
+
+    {
+        std::unique_lock<std::mutex> l(batch->lock);
+        entry->done = true;
+        entry->frame = f;
+        if (errorMsg)
+            entry->errorMessage = errorMsg;
+
+        // Only one thread at a time passes on the frames that are ready, external callbacks are serialized
+        // by the thread pool anyway so there's no point in letting several threads do it
+        if (!batch->delivering) {
+            batch->delivering = true;
+            while (batch->nextEntry < batch->entries.size() && batch->entries[batch->nextEntry].done) {
+                VSFrameBatch::Entry &next = batch->entries[batch->nextEntry++];
+                l.unlock();
+                batch->callback(batch->userData, next.frame, next.n, batch->node, next.frame ? nullptr : next.errorMessage.c_str());
+                l.lock();
+            }
+            batch->delivering = false;
+        }
+    }
+
+    if (--batch->pendingCallbacks == 0)
+        delete batch;
+}
+
+static void VS_CC getFramesAsync(const int *frames, int numFrames, VSNode *clip, VSFrameDoneCallback fdc, void *userData) VS_NOEXCEPT {
+    assert(clip && fdc);
+    if (numFrames <= 0)
+        return;
+    assert(frames);
+
+    int clipFrames = (clip->getNodeType() == mtVideo) ? clip->getVideoInfo().numFrames : clip->getAudioInfo().numFrames;
+    VSFrameBatch *batch = new VSFrameBatch(numFrames, clip, fdc, userData);
+    std::vector<PVSFrameContext> contexts;
+    contexts.reserve(numFrames);
+
+    for (int i = 0; i < numFrames; i++) {
+        int n = frames[i];
+        batch->entries[i] = { batch, static_cast<size_t>(i), n, false, nullptr, {} };
+        PVSFrameContext ctx = new VSFrameContext(n, clip, frameBatchCallback, &batch->entries[i], true);
+        if (n < 0 || n >= clipFrames)
+            ctx->setError("Invalid frame number " + std::to_string(n) + " requested, clip only has " + std::to_string(clipFrames) + " frames");
+        contexts.push_back(std::move(ctx));
+    }
+
+    clip->getFrames(contexts);
+}
+
+static VSFrame *VS_CC newVideoFrameFromBuffers(const VSVideoFormat *format, int width, int height, uint8_t * const *planeData, const ptrdiff_t *strides, VSExternalBufferFree freeBuffer, void *userData, const VSFrame *propSrc, VSCore *core) VS_NOEXCEPT {
+    assert(format && planeData && strides && core);
+
+    // Filters are allowed to assume aligned planes and strides so anything else has to be copied by the caller
+    for (int plane = 0; plane < format->numPlanes; plane++) {
+        int planeWidth = width >> (plane ? format->subSamplingW : 0);
+        if (reinterpret_cast<uintptr_t>(planeData[plane]) % VSFrame::alignment || strides[plane] % VSFrame::alignment || strides[plane] < static_cast<ptrdiff_t>(planeWidth) * format->bytesPerSample)
+            return nullptr;
+    }
+
+#ifdef VS_FRAME_GUARD
+    // Planes with guard space can't wrap external memory
+    VSFrame *f = new VSFrame(*format, width, height, propSrc, core);
+    for (int plane = 0; plane < format->numPlanes; plane++)
+        vsh::bitblt(f->getWritePtr(plane), f->getStride(plane), planeData[plane], strides[plane], static_cast<size_t>(f->getWidth(plane)) * format->bytesPerSample, f->getHeight(plane));
+    if (freeBuffer)
+        freeBuffer(userData);
+    return f;
+#else
+    return new VSFrame(*format, width, height, planeData, strides, new VSExternalBuffer(format->numPlanes, freeBuffer, userData), propSrc, core);
+#endif
+}
+
+static void VS_CC saveGraphSnapshot(const VSMap *nodes, const char *filename, VSMap *out) VS_NOEXCEPT {
+    assert(nodes && filename && out);
+    try {
+        writeGraphSnapshot(nodes, filename);
+    } catch (VSException &e) {
+        out->setError(e.what());
+    }
+}
+
+static void VS_CC loadGraphSnapshot(const char *filename, VSCore *core, VSMap *out) VS_NOEXCEPT {
+    assert(filename && core && out);
+    try {
+        readGraphSnapshot(filename, core, out);
+    } catch (VSException &e) {
+        out->setError(e.what());
+    }
+}
+
 const VSPLUGINAPI vs_internal_vspapi {
     &getAPIVersion,
     &configPlugin,
@@ -1195,7 +1330,13 @@ const VSAPI vs_internal_vsapi = {
     &getNodeFilterMode,
     &getNodeFilterTime,
     &getNodeDependencies,
-    &getNumNodeDependencies
+    &getNumNodeDependencies,
+    &getNodeStatistics,
+    &getCoreStatistics,
+    &writeTrace,
+
+    &saveGraphSnapshot,
+    &loadGraphSnapshot
 };
 
 const vs3::VSAPI3 vs_internal_vsapi3 = {
@@ -1348,6 +1489,10 @@ static const VSCAPI vsc_internal_api = {
     &pluginRenameFunc,
     &createPlugin,
     &setNodeName,
+
+    &getFramesAsync,
+    &newVideoFrameFromBuffers,
+    &getLiveStatistics,
 };
 ///////////////////////////////
 
@@ -1376,7 +1521,7 @@ const VSAPI *VS_CC getVapourSynthAPI(int version) VS_NOEXCEPT {
         return &vs_internal_vsapi;
     } else if (apiMajor == VAPOURSYNTH3_API_MAJOR && apiMinor <= VAPOURSYNTH3_API_MINOR) {
         return reinterpret_cast<const VSAPI *>(&vs_internal_vsapi3);
-    } else if (version == VAPOURSYNTHC_API_VERSION) {
+    } else if (version == VAPOURSYNTHC_API_VERSION || version == VAPOURSYNTHC_API_VERSION2) {
         return reinterpret_cast<const VSAPI *>(&vsc_internal_api);
     } else {
         return nullptr;
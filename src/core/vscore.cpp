@@ -22,6 +22,7 @@
 #include "VSHelper4.h"
 #include "version.h"
 #include "cpufeatures.h"
+#include "vsplugincache.h"
 #ifndef VS_TARGET_OS_WINDOWS
 #include <dirent.h>
 #include <cstddef>
@@ -31,6 +32,7 @@
 #include <cassert>
 #include <queue>
 #include <bitset>
+#include <cmath>
 
 #ifdef VS_TARGET_CPU_X86
 #include "x86utils.h"
@@ -136,9 +138,27 @@ bool VSFrameContext::setError(const std::string &errorMsg) {
 
 ///////////////
 
+const char *VSMapKey::intern(std::string_view key, size_t &length) noexcept {
+    // Sorted so it can be searched, these are set on nearly every frame
+    static const char *const reserved[] = {
+        "_AbsoluteTime", "_Alpha", "_ChromaLocation", "_ColorRange", "_Combed", "_DurationDen", "_DurationNum", "_Error",
+        "_Field", "_FieldBased", "_Matrix", "_PictType", "_Primaries", "_SARDen", "_SARNum", "_SceneChangeNext",
+        "_SceneChangePrev", "_Transfer"
+    };
+
+    if (key.empty() || key[0] != '_')
+        return nullptr;
+    auto it = std::lower_bound(std::begin(reserved), std::end(reserved), key, [](const char *a, std::string_view b) { return std::string_view(a) < b; });
+    if (it != std::end(reserved) && key == *it) {
+        length = key.size();
+        return *it;
+    }
+    return nullptr;
+}
+
 bool VSMap::isV3Compatible() const noexcept {
     for (const auto &iter : data->data) {
-        if (iter.second->type() == ptAudioNode || iter.second->type() == ptAudioFrame || iter.second->type() == ptUnset)
+        if (iter.value->type() == ptAudioNode || iter.value->type() == ptAudioFrame || iter.value->type() == ptUnset)
             return false;
     }
     return true;
@@ -373,6 +393,13 @@ size_t MemoryUse::getLimit() {
     return maxMemoryUse;
 }
 
+void MemoryUse::getState(size_t &usedBytes, size_t &unusedBytes, size_t &limit) {
+    std::lock_guard<std::mutex> lock(mutex);
+    usedBytes = used;
+    unusedBytes = unusedBufferSize;
+    limit = maxMemoryUse;
+}
+
 int64_t MemoryUse::setMaxMemoryUse(int64_t bytes) {
     std::lock_guard<std::mutex> lock(mutex);
     if (bytes > 0 && static_cast<uint64_t>(bytes) <= SIZE_MAX)
@@ -416,6 +443,17 @@ MemoryUse::~MemoryUse() {
 
 ///////////////
 
+// The node whose getFrame is running on this thread, only set when graph inspection or tracing is enabled
+static thread_local VSNode *statisticsNode = nullptr;
+
+void VSNode::addAllocatedBytes(size_t bytes) {
+    if (statisticsNode) {
+        statisticsNode->allocatedBytes.fetch_add(bytes, std::memory_order_relaxed);
+        if (statisticsNode->core->tracer)
+            statisticsNode->core->tracer->addEvent(VSTraceEventType::Allocation, statisticsNode->traceId, -1, VSTracer::now(), 0, bytes);
+    }
+}
+
 VSPlaneData::VSPlaneData(size_t dataSize, MemoryUse &mem) noexcept : refcount(1), mem(mem), size(dataSize + 2 * VSFrame::guardSpace) {
 #ifdef VS_FRAME_POOL
     data = mem.allocBuffer(size + 2 * VSFrame::guardSpace);
@@ -427,6 +465,7 @@ VSPlaneData::VSPlaneData(size_t dataSize, MemoryUse &mem) noexcept : refcount(1)
         VS_FATAL_ERROR("Failed to allocate memory for plane. Out of memory.");
 
     mem.add(size);
+    VSNode::addAllocatedBytes(size);
 #ifdef VS_FRAME_GUARD
     for (size_t i = 0; i < VSFrame::guardSpace / sizeof(VS_FRAME_GUARD_PATTERN); i++) {
         reinterpret_cast<uint32_t *>(data)[i] = VS_FRAME_GUARD_PATTERN;
@@ -435,6 +474,12 @@ VSPlaneData::VSPlaneData(size_t dataSize, MemoryUse &mem) noexcept : refcount(1)
 #endif
 }
 
+// External planes never have guard space, newVideoFrameFromBuffers() copies them in builds that use it
+VSPlaneData::VSPlaneData(uint8_t *externalData, size_t dataSize, VSExternalBuffer *external, MemoryUse &mem) noexcept : refcount(1), mem(mem), external(external), data(externalData), size(dataSize) {
+    mem.add(size);
+    VSNode::addAllocatedBytes(size);
+}
+
 VSPlaneData::VSPlaneData(const VSPlaneData &d) noexcept : refcount(1), mem(d.mem), size(d.size) {
 #ifdef VS_FRAME_POOL
     data = mem.allocBuffer(size);
@@ -446,10 +491,16 @@ VSPlaneData::VSPlaneData(const VSPlaneData &d) noexcept : refcount(1), mem(d.mem
         VS_FATAL_ERROR("Failed to allocate memory for plane in copy constructor. Out of memory.");
 
     mem.add(size);
+    VSNode::addAllocatedBytes(size);
     memcpy(data, d.data, size);
 }
 
 VSPlaneData::~VSPlaneData() {
+    if (external) {
+        external->release();
+        mem.subtract(size);
+        return;
+    }
 #ifdef VS_FRAME_POOL
     mem.freeBuffer(data);
 #else
@@ -459,7 +510,8 @@ VSPlaneData::~VSPlaneData() {
 }
 
 bool VSPlaneData::unique() noexcept {
-    return (refcount == 1);
+    // external memory is never written to so it always gets copied first
+    return (refcount == 1 && !external);
 }
 
 void VSPlaneData::add_ref() noexcept {
@@ -525,6 +577,7 @@ VSFrame::VSFrame(const VSVideoFormat &f, int width, int height, const VSFrame *
                 core->logFatal("Error in frame creation: dimensions of plane " + std::to_string(plane[i]) + " do not match. Source: " + std::to_string(planeSrc[i]->getWidth(plane[i])) + "x" + std::to_string(planeSrc[i]->getHeight(plane[i])) + "; destination: " + std::to_string(getWidth(i)) + "x" + std::to_string(getHeight(i)));
             data[i] = planeSrc[i]->data[plane[i]];
             data[i]->add_ref();
+            stride[i] = planeSrc[i]->stride[plane[i]];
         } else {
             if (i == 0) {
                 data[i] = new VSPlaneData(stride[i] * height, *core->memory);
@@ -535,6 +588,19 @@ VSFrame::VSFrame(const VSVideoFormat &f, int width, int height, const VSFrame *
     }
 }
 
+VSFrame::VSFrame(const VSVideoFormat &f, int width, int height, uint8_t * const *planeData, const ptrdiff_t *strides, VSExternalBuffer *buffer, const VSFrame *propSrc, VSCore *core) noexcept : refcount(1), contentType(mtVideo), v3format(nullptr), width(width), height(height), properties(propSrc ? &propSrc->properties : nullptr), core(core) {
+    if (width <= 0 || height <= 0)
+        core->logFatal("Error in frame creation: dimensions are negative (" + std::to_string(width) + "x" + std::to_string(height) + ")");
+
+    format.vf = f;
+    numPlanes = format.vf.numPlanes;
+
+    for (int i = 0; i < numPlanes; i++) {
+        stride[i] = strides[i];
+        data[i] = new VSPlaneData(planeData[i], strides[i] * getHeight(i), buffer, *core->memory);
+    }
+}
+
 VSFrame::VSFrame(const VSAudioFormat &f, int numSamples, const VSFrame *propSrc, VSCore *core) noexcept
     : refcount(1), contentType(mtAudio), v3format(nullptr), properties(propSrc ? &propSrc->properties : nullptr), core(core) {
     if (numSamples <= 0)
@@ -777,6 +843,10 @@ VSPluginFunction::VSPluginFunction(const std::string &name, const std::string &a
         parseArgString(returnType, retArgs, plugin->apiMajor);
 }
 
+VSPluginFunction::VSPluginFunction(const std::string &name, const std::string &argString, const std::string &returnType, const std::vector<FilterArgument> &inArgs, const std::vector<FilterArgument> &retArgs, VSPlugin *plugin)
+    : func(nullptr), functionData(nullptr), plugin(plugin), name(name), argString(argString), returnType(returnType), inArgs(inArgs), retArgs(retArgs) {
+}
+
 VSMap *VSPluginFunction::invoke(const VSMap &args) {
     VSMap *v = new VSMap;
 
@@ -827,7 +897,7 @@ VSMap *VSPluginFunction::invoke(const VSMap &args) {
         bool enableGraphInspection = plugin->core->enableGraphInspection;
         if (enableGraphInspection) {
             std::string fullName = plugin->getNamespace() + "." + name;
-            plugin->core->functionFrame = std::make_shared<VSFunctionFrame>(fullName, new VSMap(&args), plugin->core->functionFrame);
+            plugin->core->functionFrame = std::make_shared<VSFunctionFrame>(fullName, plugin->getID(), name, new VSMap(&args), plugin->core->functionFrame);
         }
 
         {
@@ -837,8 +907,23 @@ VSMap *VSPluginFunction::invoke(const VSMap &args) {
         }
 
         if (enableGraphInspection) {
-            assert(plugin->core->functionFrame);
-            plugin->core->functionFrame = plugin->core->functionFrame->next;
+            PVSFunctionFrame frame = plugin->core->functionFrame;
+            assert(frame);
+            plugin->core->functionFrame = frame->next;
+
+            // nodes created by an outermost call can only be referenced through what it returned
+            if (!frame->next) {
+                for (size_t i = 0; i < v->size(); i++) {
+                    const char *key = v->key(i);
+                    VSArrayBase *arr = v->find(key);
+                    for (size_t j = 0; j < arr->size(); j++) {
+                        if (arr->type() == ptVideoNode)
+                            static_cast<VSVideoNodeArray *>(arr)->at(j)->setCreationReturnPosition(frame.get(), key, static_cast<int>(j));
+                        else if (arr->type() == ptAudioNode)
+                            static_cast<VSAudioNodeArray *>(arr)->at(j)->setCreationReturnPosition(frame.get(), key, static_cast<int>(j));
+                    }
+                }
+            }
         }
 
         if (plugin->apiMajor == VAPOURSYNTH3_API_MAJOR && !args.isV3Compatible())
@@ -957,7 +1042,7 @@ struct MakeLinearWrapper {
 };
 
 VSNode::VSNode(const VSMap *in, VSMap *out, const std::string &name, vs3::VSFilterInit init, VSFilterGetFrame getFrame, VSFilterFree freeFunc, VSFilterMode filterMode, int flags, void *instanceData, int apiMajor, VSCore *core) :
-    refcount(1), nodeType(mtVideo), instanceData(instanceData), name(name), filterGetFrame(getFrame), freeFunc(freeFunc), filterMode(filterMode), apiMajor(apiMajor), core(core), serialFrame(-1), processingTime(0) {
+    refcount(1), nodeType(mtVideo), instanceData(instanceData), name(name), filterGetFrame(getFrame), freeFunc(freeFunc), filterMode(filterMode), apiMajor(apiMajor), core(core), serialFrame(-1), processingTime(0), numCalls(0), numFrames(0), allocatedBytes(0) {
 
     if (flags & ~(vs3::nfNoCache | vs3::nfIsCache | vs3::nfMakeLinear))
         throw VSException("Filter " + name  + " specified unknown flags");
@@ -1015,11 +1100,15 @@ VSNode::VSNode(const VSMap *in, VSMap *out, const std::string &name, vs3::VSFilt
 
     if (core->enableGraphInspection) {
         functionFrame = core->functionFrame;
+        latencyHistogram.reset(new std::atomic<uint32_t>[numLatencyBuckets]());
     }
+
+    if (core->tracer)
+        traceId = core->tracer->registerNode(name);
 }
 
 VSNode::VSNode(const std::string &name, const VSVideoInfo *vi, VSFilterGetFrame getFrame, VSFilterFree freeFunc, VSFilterMode filterMode, const VSFilterDependency *dependencies, int numDeps, void *instanceData, int apiMajor, VSCore *core) :
-    refcount(1), nodeType(mtVideo), instanceData(instanceData), name(name), filterGetFrame(getFrame), freeFunc(freeFunc), filterMode(filterMode), apiMajor(apiMajor), core(core), serialFrame(-1), processingTime(0) {
+    refcount(1), nodeType(mtVideo), instanceData(instanceData), name(name), filterGetFrame(getFrame), freeFunc(freeFunc), filterMode(filterMode), apiMajor(apiMajor), core(core), serialFrame(-1), processingTime(0), numCalls(0), numFrames(0), allocatedBytes(0) {
 
     if (!core->isValidVideoInfo(*vi))
         throw VSException("The VSVideoInfo structure passed by " + name + " is invalid.");
@@ -1038,11 +1127,15 @@ VSNode::VSNode(const std::string &name, const VSVideoInfo *vi, VSFilterGetFrame
 
     if (core->enableGraphInspection) {
         functionFrame = core->functionFrame;
+        latencyHistogram.reset(new std::atomic<uint32_t>[numLatencyBuckets]());
     }
+
+    if (core->tracer)
+        traceId = core->tracer->registerNode(name);
 }
 
 VSNode::VSNode(const std::string &name, const VSAudioInfo *ai, VSFilterGetFrame getFrame, VSFilterFree freeFunc, VSFilterMode filterMode, const VSFilterDependency *dependencies, int numDeps, void *instanceData, int apiMajor, VSCore *core) :
-    refcount(1), nodeType(mtAudio), instanceData(instanceData), name(name), filterGetFrame(getFrame), freeFunc(freeFunc), filterMode(filterMode), apiMajor(apiMajor), core(core), serialFrame(-1), processingTime(0) {
+    refcount(1), nodeType(mtAudio), instanceData(instanceData), name(name), filterGetFrame(getFrame), freeFunc(freeFunc), filterMode(filterMode), apiMajor(apiMajor), core(core), serialFrame(-1), processingTime(0), numCalls(0), numFrames(0), allocatedBytes(0) {
 
     if (!core->isValidAudioInfo(*ai))
         throw VSException("The VSAudioInfo structure passed by " + name + " is invalid.");
@@ -1064,7 +1157,11 @@ VSNode::VSNode(const std::string &name, const VSAudioInfo *ai, VSFilterGetFrame
 
     if (core->enableGraphInspection) {
         functionFrame = core->functionFrame;
+        latencyHistogram.reset(new std::atomic<uint32_t>[numLatencyBuckets]());
     }
+
+    if (core->tracer)
+        traceId = core->tracer->registerNode(name);
 }
 
 VSNode::~VSNode() {
@@ -1123,6 +1220,10 @@ void VSNode::getFrame(const PVSFrameContext &ct) {
     core->threadPool->startExternal(ct);
 }
 
+void VSNode::getFrames(const std::vector<PVSFrameContext> &contexts) {
+    core->threadPool->startExternal(contexts);
+}
+
 const VSVideoInfo &VSNode::getVideoInfo() const {
     return vi;
 }
@@ -1186,15 +1287,35 @@ const VSMap *VSNode::getCreationFunctionArguments(int level) const {
     return nullptr;
 }
 
+const VSFunctionFrame *VSNode::getOutermostCreationFrame() const {
+    const VSFunctionFrame *frame = functionFrame.get();
+    while (frame && frame->next)
+        frame = frame->next.get();
+    return frame;
+}
+
+void VSNode::setCreationReturnPosition(const VSFunctionFrame *frame, const std::string &key, int index) {
+    // filters that return one of their inputs unchanged don't move where it was created
+    if (creationReturnIndex < 0 && getOutermostCreationFrame() == frame) {
+        creationReturnKey = key;
+        creationReturnIndex = index;
+    }
+}
+
 int VSNode::setLinear() {
-    std::lock_guard<std::mutex> lock(cacheMutex);
-    cacheLinear = true;
-    cacheOverride = true;
-    cacheEnabled = true;
-    cache.setFixedSize(true);
-    cache.setMaxFrames(static_cast<int>(core->threadPool->threadCount()) * 2 + 20);
-    registerCache(cacheEnabled);
-    return cache.getMaxFrames() / 2;
+    int maxFrames;
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        cacheLinear = true;
+        cacheOverride = true;
+        cacheEnabled = true;
+        cache.setFixedSize(true);
+        cache.setMaxFrames(static_cast<int>(core->threadPool->threadCount()) * 2 + 20);
+        maxFrames = cache.getMaxFrames();
+    }
+    // the core's cache lock is always taken first
+    registerCache(true);
+    return maxFrames / 2;
 }
 
 void VSNode::setCacheMode(int mode) {
@@ -1237,6 +1358,61 @@ void VSNode::setCacheOptions(int fixedSize, int maxSize, int maxHistorySize) {
         cache.setMaxHistory(maxHistorySize);
 }
 
+// Buckets 0-7 hold exact values, above that every power of two is split into 8 buckets
+static int getLatencyBucket(int64_t ns) {
+    uint64_t v = static_cast<uint64_t>(std::max<int64_t>(ns, 0));
+    if (v < 8)
+        return static_cast<int>(v);
+    int e = 63;
+    while (!(v >> e))
+        e--;
+    return (e - 2) * 8 + static_cast<int>((v >> (e - 3)) & 7);
+}
+
+// Returns the middle of the bucket
+static int64_t getLatencyBucketValue(int bucket) {
+    if (bucket < 8)
+        return bucket;
+    int e = bucket / 8 + 2;
+    uint64_t lower = static_cast<uint64_t>(8 + bucket % 8) << (e - 3);
+    return static_cast<int64_t>(lower + ((static_cast<uint64_t>(1) << (e - 3)) >> 1));
+}
+
+void VSNode::getStatistics(VSMap *out) {
+    int64_t frames = numFrames;
+    vs_internal_vsapi.mapSetInt(out, "calls", numCalls, maReplace);
+    vs_internal_vsapi.mapSetInt(out, "frames", frames, maReplace);
+    vs_internal_vsapi.mapSetInt(out, "time", processingTime, maReplace);
+    vs_internal_vsapi.mapSetInt(out, "allocated_bytes", allocatedBytes, maReplace);
+
+    const char *percentileNames[] = { "latency_p50", "latency_p95", "latency_p99" };
+    const double percentiles[] = { .50, .95, .99 };
+    for (int i = 0; i < 3; i++) {
+        int64_t result = 0;
+        if (latencyHistogram && frames > 0) {
+            int64_t target = static_cast<int64_t>(std::ceil(frames * percentiles[i]));
+            int64_t seen = 0;
+            for (int b = 0; b < numLatencyBuckets; b++) {
+                seen += latencyHistogram[b];
+                if (seen >= target) {
+                    result = getLatencyBucketValue(b);
+                    break;
+                }
+            }
+        }
+        vs_internal_vsapi.mapSetInt(out, percentileNames[i], result, maReplace);
+    }
+
+    int64_t hits, nearMisses, farMisses;
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        cache.getTotalStats(hits, nearMisses, farMisses);
+    }
+    vs_internal_vsapi.mapSetInt(out, "cache_hits", hits, maReplace);
+    vs_internal_vsapi.mapSetInt(out, "cache_near_misses", nearMisses, maReplace);
+    vs_internal_vsapi.mapSetInt(out, "cache_far_misses", farMisses, maReplace);
+}
+
 PVSFrame VSNode::getCachedFrameInternal(int n) {
     std::lock_guard<std::mutex> lock(cacheMutex);
     if (cacheEnabled) {
@@ -1244,6 +1420,8 @@ PVSFrame VSNode::getCachedFrameInternal(int n) {
         nvtx3::mark_in<vs_cache_domain>(f ? vs_cache_hit_cat : vs_cache_miss_cat,
                                         name,
                                         nvtx3::payload(n));
+        if (core->tracer)
+            core->tracer->addEvent(f ? VSTraceEventType::CacheHit : VSTraceEventType::CacheMiss, traceId, n, VSTracer::now());
         return f;
     } else
         return nullptr;
@@ -1283,16 +1461,37 @@ PVSFrame VSNode::getFrameInternal(int n, int activationReason, VSFrameContext *f
 #endif
 
     std::chrono::time_point<std::chrono::high_resolution_clock> startTime;
+    VSNode *prevStatisticsNode = statisticsNode;
     bool enableGraphInspection = core->enableGraphInspection;
+    VSTracer *tracer = core->tracer;
+    int64_t traceStart = 0;
+    if (enableGraphInspection || tracer)
+        statisticsNode = this;
     if (enableGraphInspection)
         startTime = std::chrono::high_resolution_clock::now();
+    if (tracer)
+        traceStart = VSTracer::now();
 
     const VSFrame *r = (apiMajor == VAPOURSYNTH_API_MAJOR) ? filterGetFrame(n, activationReason, instanceData, frameCtx->frameContext, frameCtx, core, &vs_internal_vsapi) : reinterpret_cast<vs3::VSFilterGetFrame>(filterGetFrame)(n, activationReason, &instanceData, frameCtx->frameContext, frameCtx, core, &vs_internal_vsapi3);
 
     if (enableGraphInspection) {
         std::chrono::nanoseconds duration = std::chrono::high_resolution_clock::now() - startTime;
         processingTime.fetch_add(duration.count(), std::memory_order_relaxed);
+        numCalls.fetch_add(1, std::memory_order_relaxed);
+        // only the activation that produces the frame is representative, the others mostly just request input frames
+        if (r) {
+            numFrames.fetch_add(1, std::memory_order_relaxed);
+            latencyHistogram[getLatencyBucket(duration.count())].fetch_add(1, std::memory_order_relaxed);
+        }
     }
+    if (tracer) {
+        // api4 has no frame ready activation so its reasons are recorded using the api3 numbering
+        int traceReason = activationReason;
+        if (apiMajor == VAPOURSYNTH_API_MAJOR)
+            traceReason = (activationReason == arInitial) ? vs3::arInitial : (activationReason == arAllFramesReady) ? vs3::arAllFramesReady : (activationReason == arError) ? vs3::arError : 1000000;
+        tracer->addEvent(VSTraceEventType::Activation, traceId, n, traceStart, VSTracer::now() - traceStart, traceReason);
+    }
+    statisticsNode = prevStatisticsNode;
 #ifdef VS_TARGET_OS_WINDOWS
     if (!vs_isSSEStateOk())
         core->logFatal("Bad SSE state detected after return from "+ name);
@@ -1835,6 +2034,64 @@ void VSCore::getCoreInfo(VSCoreInfo &info) {
     info.usedFramebufferSize = memory->memoryUse();
 }
 
+void VSCore::getStatistics(VSMap *out) {
+    int64_t idleTime, lockWaitTime;
+    threadPool->getStatistics(idleTime, lockWaitTime);
+    vs_internal_vsapi.mapSetInt(out, "threads", threadPool->threadCount(), maReplace);
+    vs_internal_vsapi.mapSetInt(out, "idle_time", idleTime, maReplace);
+    vs_internal_vsapi.mapSetInt(out, "lock_wait_time", lockWaitTime, maReplace);
+    vs_internal_vsapi.mapSetInt(out, "framebuffer_used", memory->memoryUse(), maReplace);
+}
+
+// Every group of values is read under the lock that protects it so they're consistent with each other, the locks are
+// only held long enough to copy the numbers so it's cheap enough to call while frames are being processed
+void VSCore::getLiveStatistics(VSMap *out) {
+    size_t numThreads, numActive, numIdle, numTasks, numContexts;
+    threadPool->getQueueState(numThreads, numActive, numIdle, numTasks, numContexts);
+    vs_internal_vsapi.mapSetInt(out, "threads", numThreads, maReplace);
+    vs_internal_vsapi.mapSetInt(out, "active_threads", numActive, maReplace);
+    vs_internal_vsapi.mapSetInt(out, "idle_threads", numIdle, maReplace);
+    vs_internal_vsapi.mapSetInt(out, "queued_tasks", numTasks, maReplace);
+    vs_internal_vsapi.mapSetInt(out, "frame_contexts", numContexts, maReplace);
+
+    size_t usedBytes, unusedBytes, limit;
+    memory->getState(usedBytes, unusedBytes, limit);
+    vs_internal_vsapi.mapSetInt(out, "framebuffer_max", limit, maReplace);
+    vs_internal_vsapi.mapSetInt(out, "framebuffer_used", usedBytes, maReplace);
+    vs_internal_vsapi.mapSetInt(out, "framebuffer_unused", unusedBytes, maReplace);
+
+    vs_internal_vsapi.mapDeleteKey(out, "cache_name");
+    vs_internal_vsapi.mapSetEmpty(out, "cache_name", ptData);
+    const char *cacheKeys[] = { "cache_frames", "cache_history", "cache_max_frames", "cache_max_history", "cache_hits", "cache_near_misses", "cache_far_misses" };
+    for (const char *key : cacheKeys) {
+        vs_internal_vsapi.mapDeleteKey(out, key);
+        vs_internal_vsapi.mapSetEmpty(out, key, ptInt);
+    }
+
+    // nodes remove themselves from the set before anything is destroyed so holding the lock keeps them valid
+    std::lock_guard<std::mutex> lock(cacheLock);
+    for (VSNode *node : caches) {
+        int64_t hits, nearMisses, farMisses;
+        int frames, history, maxFrames, maxHistory;
+        {
+            std::lock_guard<std::mutex> nodeLock(node->cacheMutex);
+            node->cache.getTotalStats(hits, nearMisses, farMisses);
+            frames = node->cache.getCurrentFrames();
+            history = node->cache.getCurrentHistory();
+            maxFrames = node->cache.getMaxFrames();
+            maxHistory = node->cache.getMaxHistory();
+        }
+        vs_internal_vsapi.mapSetData(out, "cache_name", node->name.c_str(), static_cast<int>(node->name.size()), dtUtf8, maAppend);
+        vs_internal_vsapi.mapSetInt(out, "cache_frames", frames, maAppend);
+        vs_internal_vsapi.mapSetInt(out, "cache_history", history, maAppend);
+        vs_internal_vsapi.mapSetInt(out, "cache_max_frames", maxFrames, maAppend);
+        vs_internal_vsapi.mapSetInt(out, "cache_max_history", maxHistory, maAppend);
+        vs_internal_vsapi.mapSetInt(out, "cache_hits", hits, maAppend);
+        vs_internal_vsapi.mapSetInt(out, "cache_near_misses", nearMisses, maAppend);
+        vs_internal_vsapi.mapSetInt(out, "cache_far_misses", farMisses, maAppend);
+    }
+}
+
 bool VSCore::getAudioFormatName(const VSAudioFormat &format, char *buffer) noexcept {
     if (!isValidAudioFormat(format.sampleType, format.bitsPerSample, format.channelLayout))
         return false;
@@ -2093,7 +2350,8 @@ VSCore::VSCore(int flags) :
     videoFormatIdOffset(1000),
     cpuLevel(INT_MAX),
     memory(new MemoryUse()),
-    enableGraphInspection(flags & ccfEnableGraphInspection) {
+    enableGraphInspection(flags & ccfEnableGraphInspection),
+    tracer((flags & ccfEnableTracing) ? new VSTracer() : nullptr) {
 #ifdef VS_TARGET_OS_WINDOWS
     if (!vs_isSSEStateOk())
         logFatal("Bad SSE state detected when creating new core");
@@ -2133,6 +2391,8 @@ VSCore::VSCore(int flags) :
     textInitialize(p, &vs_internal_vspapi);
     plugins.insert(std::make_pair(p->getID(), p));
 
+    pluginCache = new VSPluginCache(VSPluginCache::getDefaultPath());
+
 #ifdef VS_TARGET_OS_WINDOWS
 
     const std::wstring filter = L"*.dll";
@@ -2252,6 +2512,10 @@ VSCore::VSCore(int flags) :
 
     vs_internal_vsapi.freeMap(settings);
 #endif
+
+    pluginCache->save();
+    delete pluginCache;
+    pluginCache = nullptr;
 }
 
 void VSCore::freeCore() {
@@ -2276,6 +2540,7 @@ void VSCore::freeCore() {
 VSCore::~VSCore() {
     memory->signalFree();
     delete threadPool;
+    delete tracer;
     for(const auto &iter : plugins)
         delete iter.second;
     plugins.clear();
@@ -2412,6 +2677,9 @@ VSPlugin::VSPlugin(const std::string &relFilename, const std::string &forcedName
 }
 
 void VSPlugin::load(const std::string &relFilename, bool lazy) {
+    // plugins loaded with a forced id or namespace could register differently so only the normal ones are cached
+    bool cacheable = id.empty() && fnamespace.empty();
+
 #ifdef VS_TARGET_OS_WINDOWS
     std::wstring wPath = utf16_from_utf8(relFilename);
     std::vector<wchar_t> fullPathBuffer(32767 + 1); // add 1 since msdn sucks at mentioning whether or not it includes the final null
@@ -2422,6 +2690,8 @@ void VSPlugin::load(const std::string &relFilename, bool lazy) {
         if (iter == '\\')
             iter = '/';
 
+    bool cached = lazy && loadFromCache();
+
     libHandle = LoadLibraryEx(wPath.c_str(), nullptr, altSearchPath ? 0 : (LOAD_LIBRARY_SEARCH_DEFAULT_DIRS | LOAD_LIBRARY_SEARCH_DLL_LOAD_DIR));
 
     if (libHandle == nullptr) {
@@ -2456,6 +2726,8 @@ void VSPlugin::load(const std::string &relFilename, bool lazy) {
     else
         filename = relFilename;
 
+    bool cached = lazy && loadFromCache();
+
     libHandle = dlopen(filename.c_str(), RTLD_LAZY | RTLD_LOCAL);
 
     if (!libHandle) {
@@ -2480,6 +2752,13 @@ void VSPlugin::load(const std::string &relFilename, bool lazy) {
 
 
 #endif
+    // The library is still opened so plugins that can't be loaded anymore, for example because a library they depend
+    // on is missing, fail here just like they would without the cache. Only running the init is put off.
+    if (cached) {
+        unload(true);
+        return;
+    }
+
     if (pluginInit)
         pluginInit(this, &vs_internal_vspapi);
     else
@@ -2510,10 +2789,45 @@ void VSPlugin::load(const std::string &relFilename, bool lazy) {
         if (unload(true)) {
             hasConfig = false;
             readOnly = false;
+            if (cacheable)
+                addToCache();
         }
     }
 }
 
+bool VSPlugin::loadFromCache() {
+    int64_t mtime, size;
+    if (!core->pluginCache || !id.empty() || !fnamespace.empty() || getenv("VSC_DISABLE_LAZY_PLUGIN") || !VSPluginCache::getFileStamp(filename, mtime, size))
+        return false;
+
+    const VSPluginCacheEntry *e = core->pluginCache->find(filename, mtime, size);
+    if (!e)
+        return false;
+
+    id = e->id;
+    fnamespace = e->fnamespace;
+    fullname = e->fullname;
+    pluginVersion = e->pluginVersion;
+    apiMajor = e->apiMajor;
+    apiMinor = e->apiMinor;
+    readOnlySet = e->readOnly;
+    for (const auto &iter : e->functions)
+        funcs.emplace(std::make_pair(iter.name, VSPluginFunction(iter.name, iter.argString, iter.returnType, iter.inArgs, iter.retArgs, this)));
+    libHandle = nullptr;
+    return true;
+}
+
+void VSPlugin::addToCache() {
+    int64_t mtime, size;
+    if (!core->pluginCache || !VSPluginCache::getFileStamp(filename, mtime, size))
+        return;
+
+    VSPluginCacheEntry e = { mtime, size, id, fnamespace, fullname, pluginVersion, apiMajor, apiMinor, readOnlySet, {} };
+    for (const auto &iter : funcs)
+        e.functions.push_back({ iter.first, iter.second.getArguments(), iter.second.getReturnType(), iter.second.getInArgs(), iter.second.getRetArgs() });
+    core->pluginCache->insert(filename, e);
+}
+
 bool VSPlugin::unload(bool lazy) {
 #ifdef VS_TARGET_OS_WINDOWS
     if (libHandle != INVALID_HANDLE_VALUE && !core->disableLibraryUnloading)
@@ -2611,11 +2925,26 @@ bool VSPlugin::registerFunction(const std::string &name, const std::string &args
 VSMap *VSPlugin::invoke(const std::string &funcName, const VSMap &args) {
     auto it = funcs.find(funcName);
     if (it != funcs.end()) {
-        std::call_once(lazyOnce, [&it, this]() {
-            if (it->second.isLazy()) {
-                load(filename, false);
-            }
-        });
+        std::string error;
+        try {
+            std::call_once(lazyOnce, [&it, this]() {
+                if (it->second.isLazy()) {
+                    load(filename, false);
+                }
+            });
+            if (it->second.isLazy())
+                error = "Function '" + funcName + "' is no longer registered by " + filename;
+        } catch (VSException &e) {
+            error = e.what();
+        }
+
+        if (!error.empty()) {
+            // The plugin changed since its functions were cached, the next core loads it normally
+            VSPluginCache::invalidate(filename);
+            VSMap *v = new VSMap();
+            vs_internal_vsapi.mapSetError(v, error.c_str());
+            return v;
+        }
         return it->second.invoke(args);
     } else {
         VSMap *v = new VSMap();
@@ -23,11 +23,14 @@
 
 #include "VapourSynth4.h"
 #include "VapourSynth3.h"
+#include "VapourSynthC.h"
 #include "vslog.h"
+#include "vstrace.h"
 #include "intrusive_ptr.h"
 #include <cstdlib>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 #include <cstring>
 #include <cassert>
 #include <vector>
@@ -70,6 +73,7 @@ class VSThreadPool;
 struct VSFrameContext;
 struct VSFunction;
 class VSMapData;
+class VSPluginCache;
 
 typedef vs_intrusive_ptr<VSFrame> PVSFrame;
 typedef vs_intrusive_ptr<VSNode> PVSNode;
@@ -230,11 +234,40 @@ typedef VSArray<PVSFrame, ptVideoFrame> VSVideoFrameArray;
 typedef VSArray<PVSFrame, ptAudioFrame> VSAudioFrameArray;
 typedef VSArray<PVSFunction, ptFunction> VSFunctionArray;
 
+// Property keys, the reserved frame property names point to a shared table so copying them never allocates
+class VSMapKey {
+private:
+    size_t internedLength = 0;
+    const char *interned;
+    std::string owned;
+    static const char *intern(std::string_view key, size_t &length) noexcept;
+public:
+    explicit VSMapKey(std::string_view key) : interned(intern(key, internedLength)) {
+        if (!interned)
+            owned = key;
+    }
+
+    std::string_view view() const noexcept {
+        return interned ? std::string_view(interned, internedLength) : std::string_view(owned);
+    }
+
+    const char *c_str() const noexcept {
+        return interned ? interned : owned.c_str();
+    }
+};
+
+struct VSMapEntry {
+    VSMapKey key;
+    PVSArrayBase value;
+};
+
+// The entries are kept sorted by key in a flat vector so copying a map for writing is a single allocation
+// and the values are shared until they're modified
 class VSMapStorage {
 private:
     std::atomic<long> refcount;
 public:
-    std::map<std::string, PVSArrayBase> data;
+    std::vector<VSMapEntry> data;
     bool error;
 
     explicit VSMapStorage() : refcount(1), error(false) {}
@@ -242,6 +275,15 @@ public:
     explicit VSMapStorage(const VSMapStorage &s) : refcount(1), data(s.data), error(s.error) {
     }
 
+    std::vector<VSMapEntry>::iterator lowerBound(std::string_view key) noexcept {
+        return std::lower_bound(data.begin(), data.end(), key, [](const VSMapEntry &e, std::string_view k) { return e.key.view() < k; });
+    }
+
+    VSMapEntry *find(std::string_view key) noexcept {
+        auto it = lowerBound(key);
+        return (it != data.end() && it->key.view() == key) ? &*it : nullptr;
+    }
+
     bool unique() noexcept {
         return (refcount == 1);
     };
@@ -279,50 +321,55 @@ public:
         return false;
     }
 
-    VSArrayBase *find(const std::string &key) const {
-        auto it = data->data.find(key);
-        return (it == data->data.end()) ? nullptr : it->second.get();
+    VSArrayBase *find(std::string_view key) const {
+        VSMapEntry *e = data->find(key);
+        return e ? e->value.get() : nullptr;
     }
 
-    VSArrayBase *detach(const std::string &key) {
+    VSArrayBase *detach(std::string_view key) {
         detach();
-        auto it = data->data.find(key);
-        if (it != data->data.end()) {
-            if (!it->second->unique())
-                it->second = it->second->copy();
-            return it->second.get();
+        VSMapEntry *e = data->find(key);
+        if (e) {
+            if (!e->value->unique())
+                e->value = e->value->copy();
+            return e->value.get();
         }
         return nullptr;
     }
 
-    bool erase(const std::string &key) {
-        auto it = data->data.find(key);
-        if (it != data->data.end()) {
-            if (detach())
-                it = data->data.find(key);
-            data->data.erase(it);
-            return true;
-        }
-        return false;
+    bool erase(std::string_view key) {
+        if (!data->find(key))
+            return false;
+        detach();
+        data->data.erase(data->lowerBound(key));
+        return true;
     }
 
-    void insert(const std::string &key, VSArrayBase *val) {
+    void insert(std::string_view key, VSArrayBase *val) {
         detach();
-        auto it = data->data.find(key);
-        if (it != data->data.end()) {
-            it->second = val;
-        } else {
-            data->data.insert(std::make_pair(key, val));
-        }
+        auto it = data->lowerBound(key);
+        if (it != data->data.end() && it->key.view() == key)
+            it->value = val;
+        else
+            data->data.insert(it, { VSMapKey(key), val });
     }
 
     void copy(const VSMap *src) {
         if (src == this)
             return;
-        
+
         detach();
-        for (auto &iter : src->data->data)
-            data->data[iter.first] = iter.second;
+        if (data->data.empty()) {
+            data->data = src->data->data;
+            return;
+        }
+        for (const auto &iter : src->data->data) {
+            auto it = data->lowerBound(iter.key.view());
+            if (it != data->data.end() && it->key.view() == iter.key.view())
+                it->value = iter.value;
+            else
+                data->data.insert(it, iter);
+        }
     }
 
     size_t size() const {
@@ -340,16 +387,14 @@ public:
     const char *key(size_t n) const {
         if (n >= size())
             return nullptr;
-        auto iter = data->data.cbegin();
-        std::advance(iter, n);
-        return iter->first.c_str();
+        return data->data[n].key.c_str();
     }
 
     void setError(const std::string &errMsg) {
         clear();
         VSDataArray *arr = new VSDataArray();
         arr->push_back({ dtUtf8, errMsg });
-        data->data.insert(std::make_pair("_Error", arr));
+        data->data.push_back({ VSMapKey("_Error"), arr });
         data->error = true;
     }
 
@@ -359,7 +404,7 @@ public:
 
     const char *getErrorMessage() const {
         if (data->error) {
-            return reinterpret_cast<VSDataArray *>(data->data.at("_Error").get())->at(0).data.c_str();
+            return reinterpret_cast<VSDataArray *>(find("_Error"))->at(0).data.c_str();
         } else {
             return nullptr;
         }
@@ -414,6 +459,7 @@ public:
     void freeBuffer(uint8_t *buf);
     size_t memoryUse();
     size_t getLimit();
+    void getState(size_t &usedBytes, size_t &unusedBytes, size_t &limit);
     int64_t setMaxMemoryUse(int64_t bytes);
     bool isOverLimit();
     void signalFree();
@@ -421,14 +467,33 @@ public:
     ~MemoryUse();
 };
 
+// Memory passed to newVideoFrameFromBuffers(), it's handed back once no plane uses it anymore
+class VSExternalBuffer {
+private:
+    std::atomic<int> refcount;
+    VSExternalBufferFree freeBuffer;
+    void *userData;
+public:
+    VSExternalBuffer(int numPlanes, VSExternalBufferFree freeBuffer, void *userData) noexcept : refcount(numPlanes), freeBuffer(freeBuffer), userData(userData) {}
+    void release() noexcept {
+        if (!--refcount) {
+            if (freeBuffer)
+                freeBuffer(userData);
+            delete this;
+        }
+    }
+};
+
 class VSPlaneData {
 private:
     std::atomic<long> refcount;
     MemoryUse &mem;
+    VSExternalBuffer *external = nullptr;
 public:
     uint8_t *data;
     const size_t size;
     VSPlaneData(size_t dataSize, MemoryUse &mem) noexcept;
+    VSPlaneData(uint8_t *externalData, size_t dataSize, VSExternalBuffer *external, MemoryUse &mem) noexcept;
     VSPlaneData(const VSPlaneData &d) noexcept;
     ~VSPlaneData();
     bool unique() noexcept;
@@ -463,6 +528,7 @@ public:
 
     VSFrame(const VSVideoFormat &f, int width, int height, const VSFrame *propSrc, VSCore *core) noexcept;
     VSFrame(const VSVideoFormat &f, int width, int height, const VSFrame * const *planeSrc, const int *plane, const VSFrame *propSrc, VSCore *core) noexcept;
+    VSFrame(const VSVideoFormat &f, int width, int height, uint8_t * const *planeData, const ptrdiff_t *strides, VSExternalBuffer *buffer, const VSFrame *propSrc, VSCore *core) noexcept;
     VSFrame(const VSAudioFormat &f, int numSamples, const VSFrame *propSrc, VSCore *core) noexcept;
     VSFrame(const VSAudioFormat &f, int numSamples, const VSFrame * const *channelSrc, const int *channel, const VSFrame *propSrc, VSCore *core) noexcept;
     VSFrame(const VSFrame &f) noexcept;
@@ -651,8 +717,10 @@ typedef std::shared_ptr<VSFunctionFrame> PVSFunctionFrame;
 
 struct VSFunctionFrame {
     std::string name;
+    std::string pluginId;
+    std::string functionName;
     const VSMap *args;
-    VSFunctionFrame(const std::string &name, const VSMap *args, PVSFunctionFrame next) : name(name), args(args), next(next) {};
+    VSFunctionFrame(const std::string &name, const std::string &pluginId, const std::string &functionName, const VSMap *args, PVSFunctionFrame next) : name(name), pluginId(pluginId), functionName(functionName), args(args), next(next) {};
     ~VSFunctionFrame() { delete args; }
     PVSFunctionFrame next;
 };
@@ -693,6 +761,11 @@ private:
         int nearMiss;
         int farMiss;
 
+        // never cleared, only used for statistics
+        int64_t totalHits = 0;
+        int64_t totalNearMiss = 0;
+        int64_t totalFarMiss = 0;
+
         inline void unlink(Node &n) {
             if (&n == weakpoint)
                 weakpoint = weakpoint->nextNode;
@@ -722,6 +795,7 @@ private:
 
             if (i == hash.end()) {
                 farMiss++;
+                totalFarMiss++;
                 return nullptr;
             }
 
@@ -729,10 +803,12 @@ private:
 
             if (!n.frame) {
                 nearMiss++;
+                totalNearMiss++;
                 return nullptr;
             }
 
             hits++;
+            totalHits++;
             Node *origWeakPoint = weakpoint;
 
             if (&n == origWeakPoint)
@@ -807,6 +883,14 @@ private:
             return hash.size();
         }
 
+        inline int getCurrentFrames() const {
+            return currentSize;
+        }
+
+        inline int getCurrentHistory() const {
+            return historySize;
+        }
+
         inline void clear() {
             hash.clear();
             first = nullptr;
@@ -823,6 +907,12 @@ private:
             farMiss = 0;
         }
 
+        inline void getTotalStats(int64_t &totalHits, int64_t &totalNearMiss, int64_t &totalFarMiss) const {
+            totalHits = this->totalHits;
+            totalNearMiss = this->totalNearMiss;
+            totalFarMiss = this->totalFarMiss;
+        }
+
         bool insert(const int key, const PVSFrame &object);
         PVSFrame object(const int key);
         inline bool contains(const int key) const {
@@ -848,6 +938,9 @@ private:
     int apiMajor;
     VSCore *core;
     PVSFunctionFrame functionFrame;
+    // where the node is in what the outermost function call returned, used to find it again when loading graph snapshots
+    std::string creationReturnKey;
+    int creationReturnIndex = -1;
     VSVideoInfo vi;
     VSAudioInfo ai;
 
@@ -861,6 +954,16 @@ private:
 
     std::atomic<int64_t> processingTime;
 
+    // only collected when graph inspection is enabled, the latencies of the activations that return a frame are kept in a log scale histogram with 8 buckets per power of two
+    static constexpr int numLatencyBuckets = 64 * 8;
+    std::atomic<int64_t> numCalls;
+    std::atomic<int64_t> numFrames;
+    std::atomic<int64_t> allocatedBytes;
+    std::unique_ptr<std::atomic<uint32_t>[]> latencyHistogram;
+
+    // index of the name in the tracer, only set when tracing is enabled
+    int traceId = -1;
+
     std::mutex cacheMutex;
     bool cacheLinear = false;
     bool cacheOverride = false;
@@ -908,6 +1011,9 @@ public:
         return processingTime;
     }
 
+    void getStatistics(VSMap *out);
+    static void addAllocatedBytes(size_t bytes);
+
     const VSFilterDependency *getDependencies() const {
         return dependencies.data();
     }
@@ -921,6 +1027,7 @@ public:
     }
 
     void getFrame(const PVSFrameContext &ct);
+    void getFrames(const std::vector<PVSFrameContext> &contexts);
 
     const VSVideoInfo &getVideoInfo() const;
     const vs3::VSVideoInfo &getVideoInfo3() const;
@@ -935,6 +1042,14 @@ public:
 
     const char *getCreationFunctionName(int level) const;
     const VSMap *getCreationFunctionArguments(int level) const;
+    const VSFunctionFrame *getOutermostCreationFrame() const;
+    void setCreationReturnPosition(const VSFunctionFrame *frame, const std::string &key, int index);
+    const std::string &getCreationReturnKey() const {
+        return creationReturnKey;
+    }
+    int getCreationReturnIndex() const {
+        return creationReturnIndex;
+    }
 
     int setLinear();
     void setCacheMode(int mode);
@@ -966,9 +1081,14 @@ private:
     std::atomic<bool> stopThreads;
     std::atomic<size_t> ticks;
     std::atomic<size_t> nextAdjTicks;
+    std::atomic<int64_t> idleTime;
+    std::atomic<int64_t> lockWaitTime;
     size_t getNumAvailableThreads();
     void queueTask(const PVSFrameContext &ctx);
     void wakeThread();
+    void addWaitTime(VSTraceEventType type, int64_t start);
+    template<typename T>
+    void lockTaskQueue(T &lock);
     void startInternalRequest(const PVSFrameContext &notify, NodeOutputKey key);
     void spawnThread();
     static void runTasksWrapper(VSThreadPool *owner, std::atomic<bool> &stop);
@@ -981,10 +1101,13 @@ public:
     size_t threadCount();
     size_t setThreadCount(size_t threads);
     void startExternal(const PVSFrameContext &context);
+    void startExternal(const std::vector<PVSFrameContext> &contexts);
     void releaseThread();
     void reserveThread();
     bool isWorkerThread();
     void waitForDone();
+    void getStatistics(int64_t &idleTime, int64_t &lockWaitTime) const;
+    void getQueueState(size_t &numThreads, size_t &numActive, size_t &numIdle, size_t &numTasks, size_t &numContexts);
 };
 
 struct VSPluginFunction {
@@ -1000,10 +1123,14 @@ private:
     static void parseArgString(const std::string &argString, std::vector<FilterArgument> &argsOut, int apiMajor);
 public:
     VSPluginFunction(const std::string &name, const std::string &argString, const std::string &returnType, VSPublicFunction func, void *functionData, VSPlugin *plugin);
+    // restored from the plugin cache with the arguments already parsed, it stays lazy until the plugin is loaded
+    VSPluginFunction(const std::string &name, const std::string &argString, const std::string &returnType, const std::vector<FilterArgument> &inArgs, const std::vector<FilterArgument> &retArgs, VSPlugin *plugin);
     VSMap *invoke(const VSMap &args);
     const std::string &getName() const;
     const std::string &getArguments() const;
     const std::string &getReturnType() const;
+    const std::vector<FilterArgument> &getInArgs() const { return inArgs; }
+    const std::vector<FilterArgument> &getRetArgs() const { return retArgs; }
     bool isV3Compatible() const;
     std::string getV4ArgString() const;
     std::string getV3ArgString() const;
@@ -1039,6 +1166,8 @@ private:
     std::mutex functionLock;
     VSCore *core;
     std::once_flag lazyOnce;
+    bool loadFromCache();
+    void addToCache();
 public:
     explicit VSPlugin(VSCore *core);
     VSPlugin(const std::string &relFilename, const std::string &forcedNamespace, const std::string &forcedId, bool altSearchPath, VSCore *core, bool lazy = false);
@@ -1102,6 +1231,9 @@ public:
     VSThreadPool *threadPool;
     MemoryUse *memory;
 
+    // only set while the plugins are autoloaded
+    VSPluginCache *pluginCache = nullptr;
+
     bool disableLibraryUnloading;
 
     // Used only for graph inspection
@@ -1109,6 +1241,9 @@ public:
     static thread_local PVSFunctionFrame functionFrame;
     //
 
+    // Only set when the core was created with tracing enabled
+    VSTracer *tracer;
+
     void notifyCaches(bool needMemory);
     const vs3::VSVideoFormat *getV3VideoFormat(int id);
     const vs3::VSVideoFormat *getVideoFormat3(int id);
@@ -1166,6 +1301,8 @@ public:
 
     const VSCoreInfo &getCoreInfo3();
     void getCoreInfo(VSCoreInfo &info);
+    void getStatistics(VSMap *out);
+    void getLiveStatistics(VSMap *out);
 
     static bool getAudioFormatName(const VSAudioFormat &format, char *buffer) noexcept;
     static bool getVideoFormatName(const VSVideoFormat &format, char *buffer) noexcept;
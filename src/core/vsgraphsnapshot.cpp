@@ -0,0 +1,314 @@
+/*
+* Copyright (c) 2026 vapoursynth-classic contributors
+*
+* This file is part of VapourSynth.
+*
+* VapourSynth is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 2.1 of the License, or (at your option) any later version.
+*
+* VapourSynth is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with VapourSynth; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+
+#include "vsgraphsnapshot.h"
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <vector>
+
+#ifdef VS_TARGET_OS_WINDOWS
+#include "../common/vsutf16.h"
+#endif
+
+/* The file is plain text with one tab separated record per line after the header:
+ *   C <plugin id> <function>              a function call, they're implicitly numbered from 0 in the order they appear
+ *   A <key> <type> <count> <values>...    an argument of the preceding call
+ *   R <key> <type> <count> <values>...    an entry in the saved map
+ *   E                                     the end of the file
+ * The type is i, f, d, v or a. Data values are written as <type hint>:<hex> and nodes as <call>:<key>:<index>
+ * which refers to a node in what the call returned. */
+
+// Bump when the format changes
+static const int snapshotFormatVersion = 2;
+
+static std::string getHeader() {
+    return "VSGraphSnapshot\t" + std::to_string(snapshotFormatVersion);
+}
+
+static std::vector<std::string> splitFields(const std::string &line, char sep) {
+    std::vector<std::string> result;
+    size_t start = 0;
+    while (true) {
+        size_t end = line.find(sep, start);
+        result.push_back(line.substr(start, end - start));
+        if (end == std::string::npos)
+            break;
+        start = end + 1;
+    }
+    return result;
+}
+
+static std::string toHex(const char *data, size_t size) {
+    static const char digits[] = "0123456789abcdef";
+    std::string result;
+    result.reserve(size * 2);
+    for (size_t i = 0; i < size; i++) {
+        result += digits[static_cast<uint8_t>(data[i]) >> 4];
+        result += digits[static_cast<uint8_t>(data[i]) & 15];
+    }
+    return result;
+}
+
+static int hexDigitValue(char c) {
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    else if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    throw VSException("invalid hex digit");
+}
+
+static std::string fromHex(const std::string &s) {
+    if (s.size() % 2)
+        throw VSException("invalid hex string");
+    std::string result;
+    result.reserve(s.size() / 2);
+    for (size_t i = 0; i < s.size(); i += 2)
+        result += static_cast<char>(hexDigitValue(s[i]) * 16 + hexDigitValue(s[i + 1]));
+    return result;
+}
+
+namespace {
+
+class VSGraphSnapshotWriter {
+private:
+    std::map<const VSFunctionFrame *, int> callIds;
+
+    std::string nodeReference(VSNode *node) {
+        const VSFunctionFrame *frame = node->getOutermostCreationFrame();
+        if (!frame)
+            throw VSException("Node '" + node->getName() + "' wasn't created by a plugin function, graph snapshots require a core created with ccfEnableGraphInspection");
+        if (node->getCreationReturnIndex() < 0)
+            throw VSException("Node '" + node->getName() + "' was created by " + frame->name + " but isn't part of what it returned");
+        addCall(frame);
+        return std::to_string(callIds[frame]) + ":" + node->getCreationReturnKey() + ":" + std::to_string(node->getCreationReturnIndex());
+    }
+
+    void addCall(const VSFunctionFrame *frame) {
+        if (callIds.count(frame))
+            return;
+        // the calls producing the arguments get added first so everything is in creation order
+        std::string records = mapRecords('A', frame->args, frame->name);
+        int id = static_cast<int>(callIds.size());
+        callIds[frame] = id;
+        data += "C\t" + frame->pluginId + "\t" + frame->functionName + "\n" + records;
+    }
+public:
+    std::string data;
+
+    std::string mapRecords(char tag, const VSMap *map, const std::string &context) {
+        std::string records;
+        int numKeys = vs_internal_vsapi.mapNumKeys(map);
+        for (int i = 0; i < numKeys; i++) {
+            const char *key = vs_internal_vsapi.mapGetKey(map, i);
+            int type = vs_internal_vsapi.mapGetType(map, key);
+            int numElements = vs_internal_vsapi.mapNumElements(map, key);
+            const VSArrayBase *arr = map->find(key);
+
+            std::string record = std::string(1, tag) + "\t" + key + "\t";
+            switch (type) {
+                case ptInt: record += 'i'; break;
+                case ptFloat: record += 'f'; break;
+                case ptData: record += 'd'; break;
+                case ptVideoNode: record += 'v'; break;
+                case ptAudioNode: record += 'a'; break;
+                case ptFunction: throw VSException(context + ": argument '" + std::string(key) + "' is a function which can't be saved in a graph snapshot");
+                default: throw VSException(context + ": argument '" + std::string(key) + "' is a frame which can't be saved in a graph snapshot");
+            }
+            record += "\t" + std::to_string(numElements);
+
+            for (int j = 0; j < numElements; j++) {
+                record += '\t';
+                if (type == ptInt) {
+                    record += std::to_string(vs_internal_vsapi.mapGetInt(map, key, j, nullptr));
+                } else if (type == ptFloat) {
+                    char buffer[32];
+                    snprintf(buffer, sizeof(buffer), "%.17g", vs_internal_vsapi.mapGetFloat(map, key, j, nullptr));
+                    record += buffer;
+                } else if (type == ptData) {
+                    record += std::to_string(vs_internal_vsapi.mapGetDataTypeHint(map, key, j, nullptr)) + ":";
+                    record += toHex(vs_internal_vsapi.mapGetData(map, key, j, nullptr), vs_internal_vsapi.mapGetDataSize(map, key, j, nullptr));
+                } else if (type == ptVideoNode) {
+                    record += nodeReference(static_cast<const VSVideoNodeArray *>(arr)->at(j).get());
+                } else {
+                    record += nodeReference(static_cast<const VSAudioNodeArray *>(arr)->at(j).get());
+                }
+            }
+
+            records += record + "\n";
+        }
+        return records;
+    }
+};
+
+}
+
+void writeGraphSnapshot(const VSMap *nodes, const std::string &filename) {
+    int numKeys = vs_internal_vsapi.mapNumKeys(nodes);
+    for (int i = 0; i < numKeys; i++) {
+        int type = vs_internal_vsapi.mapGetType(nodes, vs_internal_vsapi.mapGetKey(nodes, i));
+        if (type != ptVideoNode && type != ptAudioNode)
+            throw VSException("Only nodes can be saved in a graph snapshot but '" + std::string(vs_internal_vsapi.mapGetKey(nodes, i)) + "' isn't one");
+    }
+
+    VSGraphSnapshotWriter writer;
+    std::string records = writer.mapRecords('R', nodes, "Graph snapshot");
+    std::string data = getHeader() + "\n" + writer.data + records + "E\n";
+
+#ifdef VS_TARGET_OS_WINDOWS
+    FILE *f = _wfopen(utf16_from_utf8(filename).c_str(), L"wb");
+#else
+    FILE *f = fopen(filename.c_str(), "wb");
+#endif
+    if (!f)
+        throw VSException("Failed to open '" + filename + "' for writing");
+    bool success = fwrite(data.data(), 1, data.size(), f) == data.size();
+    if (fclose(f) || !success)
+        throw VSException("Failed to write graph snapshot to '" + filename + "'");
+}
+
+static void setRecord(VSMap *map, const std::vector<std::string> &fields, const std::vector<std::unique_ptr<VSMap>> &results) {
+    if (fields.size() < 4 || fields[2].size() != 1)
+        throw VSException("invalid record");
+
+    const char *key = fields[1].c_str();
+    char type = fields[2][0];
+    size_t numElements = std::stoul(fields[3]);
+    if (fields.size() != numElements + 4)
+        throw VSException("invalid number of values");
+
+    if (numElements == 0) {
+        int propType = ptUnset;
+        switch (type) {
+            case 'i': propType = ptInt; break;
+            case 'f': propType = ptFloat; break;
+            case 'd': propType = ptData; break;
+            case 'v': propType = ptVideoNode; break;
+            case 'a': propType = ptAudioNode; break;
+        }
+        if (vs_internal_vsapi.mapSetEmpty(map, key, propType))
+            throw VSException("invalid empty array");
+        return;
+    }
+
+    for (size_t i = 4; i < fields.size(); i++) {
+        const std::string &value = fields[i];
+        if (type == 'i') {
+            vs_internal_vsapi.mapSetInt(map, key, std::stoll(value), maAppend);
+        } else if (type == 'f') {
+            vs_internal_vsapi.mapSetFloat(map, key, strtod(value.c_str(), nullptr), maAppend);
+        } else if (type == 'd') {
+            size_t sep = value.find(':');
+            if (sep == std::string::npos)
+                throw VSException("invalid data value");
+            std::string data = fromHex(value.substr(sep + 1));
+            vs_internal_vsapi.mapSetData(map, key, data.c_str(), static_cast<int>(data.size()), std::stoi(value.substr(0, sep)), maAppend);
+        } else if (type == 'v' || type == 'a') {
+            std::vector<std::string> ref = splitFields(value, ':');
+            if (ref.size() != 3)
+                throw VSException("invalid node reference");
+            size_t call = std::stoul(ref[0]);
+            if (call >= results.size() || vs_internal_vsapi.mapGetType(results[call].get(), ref[1].c_str()) != (type == 'v' ? ptVideoNode : ptAudioNode))
+                throw VSException("invalid node reference");
+            int err;
+            VSNode *node = vs_internal_vsapi.mapGetNode(results[call].get(), ref[1].c_str(), std::stoi(ref[2]), &err);
+            if (err)
+                throw VSException("invalid node reference");
+            vs_internal_vsapi.mapConsumeNode(map, key, node, maAppend);
+        } else {
+            throw VSException("invalid type");
+        }
+    }
+}
+
+void readGraphSnapshot(const std::string &filename, VSCore *core, VSMap *out) {
+#ifdef VS_TARGET_OS_WINDOWS
+    FILE *f = _wfopen(utf16_from_utf8(filename).c_str(), L"rb");
+#else
+    FILE *f = fopen(filename.c_str(), "rb");
+#endif
+    if (!f)
+        throw VSException("Failed to open graph snapshot '" + filename + "'");
+
+    std::string data;
+    char buffer[65536];
+    size_t read;
+    while ((read = fread(buffer, 1, sizeof(buffer), f)) > 0)
+        data.append(buffer, read);
+    fclose(f);
+
+    std::vector<std::string> lines = splitFields(data, '\n');
+    if (lines.empty() || lines[0] != getHeader())
+        throw VSException("'" + filename + "' isn't a graph snapshot or was written by a different version");
+
+    // A file that was cut short could still replay without errors and silently lose outputs
+    size_t end = lines.size() - 1;
+    while (end > 0 && lines[end].empty())
+        end--;
+    if (lines[end] != "E")
+        throw VSException("Graph snapshot '" + filename + "' is truncated");
+
+    std::vector<std::unique_ptr<VSMap>> results;
+    VSPlugin *plugin = nullptr;
+    std::string functionName;
+    std::unique_ptr<VSMap> args;
+
+    auto invokePending = [&]() {
+        if (!plugin)
+            return;
+        results.emplace_back(plugin->invoke(functionName, *args));
+        if (results.back()->hasError())
+            throw VSException("Failed to recreate " + plugin->getNamespace() + "." + functionName + " from the graph snapshot: " + results.back()->getErrorMessage());
+        plugin = nullptr;
+    };
+
+    for (size_t i = 1; i < end; i++) {
+        if (lines[i].empty())
+            continue;
+        std::string location = "Invalid graph snapshot '" + filename + "' on line " + std::to_string(i + 1);
+        std::vector<std::string> fields = splitFields(lines[i], '\t');
+        if (fields[0] == "C" && fields.size() == 3) {
+            invokePending();
+            plugin = core->getPluginByID(fields[1]);
+            if (!plugin)
+                throw VSException("Plugin '" + fields[1] + "' used by the graph snapshot isn't loaded");
+            functionName = fields[2];
+            args.reset(new VSMap());
+            continue;
+        } else if (fields[0] == "R") {
+            invokePending();
+        } else if (fields[0] != "A" || !plugin) {
+            throw VSException(location);
+        }
+
+        try {
+            setRecord(fields[0] == "R" ? out : args.get(), fields, results);
+        } catch (VSException &e) {
+            throw VSException(location + ": " + e.what());
+        } catch (std::logic_error &) {
+            // thrown by the string to number conversions
+            throw VSException(location);
+        }
+    }
+
+    invokePending();
+}
@@ -0,0 +1,35 @@
+/*
+* Copyright (c) 2026 vapoursynth-classic contributors
+*
+* This file is part of VapourSynth.
+*
+* VapourSynth is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 2.1 of the License, or (at your option) any later version.
+*
+* VapourSynth is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with VapourSynth; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+
+#ifndef VSGRAPHSNAPSHOT_H
+#define VSGRAPHSNAPSHOT_H
+
+#include "vscore.h"
+#include <string>
+
+// Experimental snapshots of an evaluated filter graph. Every node in the saved map is traced back to the outermost
+// plugin function call that created it and the calls are written in creation order together with their arguments,
+// loading a snapshot simply invokes them again. Saving only works for cores created with ccfEnableGraphInspection
+// and both functions throw a VSException when something can't be stored or recreated.
+void writeGraphSnapshot(const VSMap *nodes, const std::string &filename);
+void readGraphSnapshot(const std::string &filename, VSCore *core, VSMap *out);
+
+#endif
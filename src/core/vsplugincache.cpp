@@ -0,0 +1,257 @@
+/*
+* Copyright (c) 2026 vapoursynth-classic contributors
+*
+* This file is part of VapourSynth.
+*
+* VapourSynth is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 2.1 of the License, or (at your option) any later version.
+*
+* VapourSynth is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with VapourSynth; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "vsplugincache.h"
+#include "version.h"
+#include <cstdio>
+#include <cstdlib>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#ifdef VS_TARGET_OS_WINDOWS
+#include <shlobj.h>
+#include "../common/vsutf16.h"
+#else
+#include <unistd.h>
+#endif
+
+// Bump when the format changes, the core version is also part of the header since the parsed signatures depend on it
+static const int cacheFormatVersion = 1;
+
+static std::vector<std::string> splitFields(const std::string &line, char sep) {
+    std::vector<std::string> result;
+    size_t start = 0;
+    while (true) {
+        size_t end = line.find(sep, start);
+        result.push_back(line.substr(start, end - start));
+        if (end == std::string::npos)
+            break;
+        start = end + 1;
+    }
+    return result;
+}
+
+static std::string serializeArgs(const std::vector<FilterArgument> &args) {
+    std::string result;
+    for (const FilterArgument &a : args) {
+        if (!result.empty())
+            result += ';';
+        result += a.name + ',' + std::to_string(static_cast<int>(a.type)) + ',' + (a.arr ? '1' : '0') + ',' + (a.empty ? '1' : '0') + ',' + (a.opt ? '1' : '0');
+    }
+    return result;
+}
+
+static std::vector<FilterArgument> parseArgs(const std::string &s) {
+    std::vector<FilterArgument> result;
+    if (s.empty())
+        return result;
+    for (const std::string &arg : splitFields(s, ';')) {
+        std::vector<std::string> parts = splitFields(arg, ',');
+        if (parts.size() != 5)
+            throw std::runtime_error("invalid argument");
+        result.emplace_back(parts[0], static_cast<VSPropertyType>(std::stoi(parts[1])), parts[2] == "1", parts[3] == "1", parts[4] == "1");
+    }
+    return result;
+}
+
+static bool isStorable(const std::string &s) {
+    return s.find_first_of("\t\r\n") == std::string::npos;
+}
+
+static std::string getHeader() {
+    return "VSPluginCache\t" + std::to_string(cacheFormatVersion) + "\t" + std::to_string(VAPOURSYNTH_CORE_VERSION) + "\t" + std::to_string(VAPOURSYNTH_API_VERSION);
+}
+
+VSPluginCache::VSPluginCache(const std::string &path) : path(path) {
+    if (path.empty())
+        return;
+
+#ifdef VS_TARGET_OS_WINDOWS
+    FILE *f = _wfopen(utf16_from_utf8(path).c_str(), L"rb");
+#else
+    FILE *f = fopen(path.c_str(), "rb");
+#endif
+    if (!f)
+        return;
+
+    std::string data;
+    char buffer[65536];
+    size_t read;
+    while ((read = fread(buffer, 1, sizeof(buffer), f)) > 0)
+        data.append(buffer, read);
+    fclose(f);
+
+    try {
+        std::vector<std::string> lines = splitFields(data, '\n');
+        if (lines.empty() || lines[0] != getHeader())
+            return;
+
+        VSPluginCacheEntry *current = nullptr;
+        for (size_t i = 1; i < lines.size(); i++) {
+            if (lines[i].empty())
+                continue;
+            std::vector<std::string> fields = splitFields(lines[i], '\t');
+            if (fields[0] == "P" && fields.size() == 11) {
+                VSPluginCacheEntry &e = entries[fields[1]];
+                e.mtime = std::stoll(fields[2]);
+                e.size = std::stoll(fields[3]);
+                e.id = fields[4];
+                e.fnamespace = fields[5];
+                e.fullname = fields[6];
+                e.pluginVersion = std::stoi(fields[7]);
+                e.apiMajor = std::stoi(fields[8]);
+                e.apiMinor = std::stoi(fields[9]);
+                e.readOnly = fields[10] == "1";
+                current = &e;
+            } else if (fields[0] == "F" && fields.size() == 6 && current) {
+                current->functions.push_back({ fields[1], fields[2], fields[3], parseArgs(fields[4]), parseArgs(fields[5]) });
+            } else {
+                throw std::runtime_error("invalid line");
+            }
+        }
+    } catch (std::exception &) {
+        // a damaged cache is simply rebuilt
+        entries.clear();
+        modified = true;
+    }
+}
+
+const VSPluginCacheEntry *VSPluginCache::find(const std::string &filename, int64_t mtime, int64_t size) {
+    auto it = entries.find(filename);
+    if (it == entries.end() || it->second.mtime != mtime || it->second.size != size)
+        return nullptr;
+    used.insert(filename);
+    return &it->second;
+}
+
+void VSPluginCache::insert(const std::string &filename, const VSPluginCacheEntry &entry) {
+    bool storable = isStorable(filename) && isStorable(entry.id) && isStorable(entry.fnamespace) && isStorable(entry.fullname);
+    for (const auto &iter : entry.functions)
+        storable = storable && isStorable(iter.name) && isStorable(iter.argString) && isStorable(iter.returnType);
+    if (!storable)
+        return;
+    entries[filename] = entry;
+    used.insert(filename);
+    modified = true;
+}
+
+void VSPluginCache::save() {
+    if (path.empty() || (!modified && used.size() == entries.size()))
+        return;
+
+    std::string data = getHeader() + "\n";
+    for (const auto &iter : entries) {
+        if (!used.count(iter.first))
+            continue;
+        const VSPluginCacheEntry &e = iter.second;
+        data += "P\t" + iter.first + "\t" + std::to_string(e.mtime) + "\t" + std::to_string(e.size) + "\t" + e.id + "\t" + e.fnamespace + "\t" + e.fullname + "\t" +
+            std::to_string(e.pluginVersion) + "\t" + std::to_string(e.apiMajor) + "\t" + std::to_string(e.apiMinor) + "\t" + (e.readOnly ? "1" : "0") + "\n";
+        for (const auto &f : e.functions)
+            data += "F\t" + f.name + "\t" + f.argString + "\t" + f.returnType + "\t" + serializeArgs(f.inArgs) + "\t" + serializeArgs(f.retArgs) + "\n";
+    }
+
+    // Several processes may start at the same time so the file is replaced in one step
+#ifdef VS_TARGET_OS_WINDOWS
+    std::wstring wPath = utf16_from_utf8(path);
+    std::wstring wDir = wPath.substr(0, wPath.find_last_of(L'\\'));
+    CreateDirectoryW(wDir.c_str(), nullptr);
+    std::wstring tmpPath = wPath + L"." + std::to_wstring(GetCurrentProcessId()) + L".tmp";
+    FILE *f = _wfopen(tmpPath.c_str(), L"wb");
+#else
+    std::string dir = path.substr(0, path.find_last_of('/'));
+    mkdir(dir.substr(0, dir.find_last_of('/')).c_str(), 0755);
+    mkdir(dir.c_str(), 0755);
+    std::string tmpPath = path + "." + std::to_string(getpid()) + ".tmp";
+    FILE *f = fopen(tmpPath.c_str(), "wb");
+#endif
+    if (!f)
+        return;
+
+    bool success = fwrite(data.data(), 1, data.size(), f) == data.size();
+    if (fclose(f))
+        success = false;
+
+#ifdef VS_TARGET_OS_WINDOWS
+    if (!success || !MoveFileExW(tmpPath.c_str(), wPath.c_str(), MOVEFILE_REPLACE_EXISTING))
+        DeleteFileW(tmpPath.c_str());
+#else
+    if (!success || rename(tmpPath.c_str(), path.c_str()))
+        unlink(tmpPath.c_str());
+#endif
+}
+
+void VSPluginCache::invalidate(const std::string &filename) {
+    VSPluginCache cache(getDefaultPath());
+    if (!cache.entries.erase(filename))
+        return;
+    for (const auto &iter : cache.entries)
+        cache.used.insert(iter.first);
+    cache.modified = true;
+    cache.save();
+}
+
+bool VSPluginCache::getFileStamp(const std::string &filename, int64_t &mtime, int64_t &size) {
+#ifdef VS_TARGET_OS_WINDOWS
+    struct _stat64 st;
+    if (_wstat64(utf16_from_utf8(filename).c_str(), &st))
+        return false;
+    mtime = st.st_mtime;
+#else
+    struct stat st;
+    if (stat(filename.c_str(), &st))
+        return false;
+#if defined(VS_TARGET_OS_DARWIN)
+    mtime = static_cast<int64_t>(st.st_mtimespec.tv_sec) * 1000000000 + st.st_mtimespec.tv_nsec;
+#else
+    mtime = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+#endif
+#endif
+    size = st.st_size;
+    return true;
+}
+
+std::string VSPluginCache::getDefaultPath() {
+    if (getenv("VSC_DISABLE_PLUGIN_CACHE"))
+        return std::string();
+
+#ifdef VS_TARGET_OS_WINDOWS
+    std::vector<wchar_t> appDataBuffer(MAX_PATH + 1);
+    if (SHGetFolderPath(nullptr, CSIDL_LOCAL_APPDATA, nullptr, SHGFP_TYPE_CURRENT, appDataBuffer.data()) != S_OK)
+        return std::string();
+#ifdef _WIN64
+    return utf16_to_utf8(std::wstring(appDataBuffer.data()) + L"\\VapourSynth\\plugincache64");
+#else
+    return utf16_to_utf8(std::wstring(appDataBuffer.data()) + L"\\VapourSynth\\plugincache32");
+#endif
+#else
+    const char *home = getenv("HOME");
+#ifdef VS_TARGET_OS_DARWIN
+    if (home)
+        return std::string(home) + "/Library/Caches/VapourSynth/plugincache";
+#else
+    const char *xdg_cache_home = getenv("XDG_CACHE_HOME");
+    if (xdg_cache_home)
+        return std::string(xdg_cache_home) + "/vapoursynth/plugincache";
+    else if (home)
+        return std::string(home) + "/.cache/vapoursynth/plugincache";
+#endif
+    return std::string();
+#endif
+}
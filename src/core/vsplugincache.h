@@ -0,0 +1,74 @@
+/*
+* Copyright (c) 2026 vapoursynth-classic contributors
+*
+* This file is part of VapourSynth.
+*
+* VapourSynth is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 2.1 of the License, or (at your option) any later version.
+*
+* VapourSynth is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with VapourSynth; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef VSPLUGINCACHE_H
+#define VSPLUGINCACHE_H
+
+#include "vscore.h"
+#include <cstdint>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+struct VSPluginCacheFunction {
+    std::string name;
+    std::string argString;
+    std::string returnType;
+    std::vector<FilterArgument> inArgs;
+    std::vector<FilterArgument> retArgs;
+};
+
+struct VSPluginCacheEntry {
+    int64_t mtime;
+    int64_t size;
+    std::string id;
+    std::string fnamespace;
+    std::string fullname;
+    int pluginVersion;
+    int apiMajor;
+    int apiMinor;
+    bool readOnly;
+    std::vector<VSPluginCacheFunction> functions;
+};
+
+// What autoloaded plugins registered the last time they were loaded, keyed by their full path. Entries are only used
+// when the file's modification time and size still match so plugins only have to be loaded again once one of their
+// functions is invoked. The file is a simple tab separated text format that's thrown away when anything doesn't parse.
+class VSPluginCache {
+private:
+    std::string path;
+    std::map<std::string, VSPluginCacheEntry> entries;
+    std::set<std::string> used;
+    bool modified = false;
+public:
+    explicit VSPluginCache(const std::string &path);
+    const VSPluginCacheEntry *find(const std::string &filename, int64_t mtime, int64_t size);
+    void insert(const std::string &filename, const VSPluginCacheEntry &entry);
+    // writes the file if anything was added or an entry wasn't used, failures are silently ignored
+    void save();
+    // removes the plugin from the file and keeps everything else, for plugins that fail to load after they were cached
+    static void invalidate(const std::string &filename);
+
+    static bool getFileStamp(const std::string &filename, int64_t &mtime, int64_t &size);
+    static std::string getDefaultPath();
+};
+
+#endif
@@ -66,13 +66,29 @@ void VSThreadPool::runTasksWrapper(VSThreadPool *owner, std::atomic<bool> &stop)
     owner->runTasks(stop);
 }
 
+// Every place a worker takes the task lock goes through this so all of the waiting ends up in the lock wait time
+template<typename T>
+void VSThreadPool::lockTaskQueue(T &lock) {
+    if (core->enableGraphInspection || core->tracer) {
+        int64_t lockStart = VSTracer::now();
+        lock.lock();
+        addWaitTime(VSTraceEventType::QueueLockWait, lockStart);
+    } else {
+        lock.lock();
+    }
+}
+
 void VSThreadPool::runTasks(std::atomic<bool> &stop) {
 #ifdef VS_TARGET_OS_WINDOWS
     if (!vs_isSSEStateOk())
         core->logFatal("Bad SSE state detected after creating new thread");
 #endif
 
-    std::unique_lock<std::mutex> lock(taskLock);
+    if (core->tracer)
+        core->tracer->setThreadName("worker");
+
+    std::unique_lock<std::mutex> lock(taskLock, std::defer_lock);
+    lockTaskQueue(lock);
 
     while (true) {
         bool ranTask = false;
@@ -193,7 +209,7 @@ void VSThreadPool::runTasks(std::atomic<bool> &stop) {
             if (f && requestedFrames)
                 core->logFatal("A frame was returned at the end of processing by " + node->name + " but there are still outstanding requests");
 
-            lock.lock();
+            lockTaskQueue(lock);
 
             if (requestedFrames) {
                 assert(frameContext->numFrameRequests == 0);
@@ -259,14 +275,20 @@ void VSThreadPool::runTasks(std::atomic<bool> &stop) {
             if (++idleThreads == allThreads.size())
                 allIdle.notify_one();
 
-            newWork.wait(lock);
+            if (core->enableGraphInspection || core->tracer) {
+                int64_t idleStart = VSTracer::now();
+                newWork.wait(lock);
+                addWaitTime(VSTraceEventType::Idle, idleStart);
+            } else {
+                newWork.wait(lock);
+            }
             --idleThreads;
             ++activeThreads;
         }
     }
 }
 
-VSThreadPool::VSThreadPool(VSCore *core) : core(core), activeThreads(0), idleThreads(0), reqCounter(0), stopThreads(false), ticks(0), nextAdjTicks(50) {
+VSThreadPool::VSThreadPool(VSCore *core) : core(core), activeThreads(0), idleThreads(0), reqCounter(0), stopThreads(false), ticks(0), nextAdjTicks(50), idleTime(0), lockWaitTime(0) {
     setThreadCount(0);
 }
 
@@ -306,6 +328,28 @@ void VSThreadPool::wakeThread() {
     }
 }
 
+void VSThreadPool::addWaitTime(VSTraceEventType type, int64_t start) {
+    int64_t duration = VSTracer::now() - start;
+    if (core->enableGraphInspection)
+        ((type == VSTraceEventType::Idle) ? idleTime : lockWaitTime).fetch_add(duration, std::memory_order_relaxed);
+    if (core->tracer)
+        core->tracer->addEvent(type, -1, -1, start, duration);
+}
+
+void VSThreadPool::getStatistics(int64_t &idleTime, int64_t &lockWaitTime) const {
+    idleTime = this->idleTime;
+    lockWaitTime = this->lockWaitTime;
+}
+
+void VSThreadPool::getQueueState(size_t &numThreads, size_t &numActive, size_t &numIdle, size_t &numTasks, size_t &numContexts) {
+    std::lock_guard<std::mutex> l(taskLock);
+    numThreads = maxThreads;
+    numActive = activeThreads;
+    numIdle = idleThreads;
+    numTasks = tasks.size();
+    numContexts = allContexts.size();
+}
+
 void VSThreadPool::releaseThread() {
     --activeThreads;
 }
@@ -323,6 +367,18 @@ void VSThreadPool::startExternal(const PVSFrameContext &context) {
     wakeThread();
 }
 
+void VSThreadPool::startExternal(const std::vector<PVSFrameContext> &contexts) {
+    std::lock_guard<std::mutex> l(taskLock);
+    size_t reqOrder = reqCounter.fetch_add(contexts.size());
+    for (const auto &iter : contexts) {
+        assert(iter);
+        iter->reqOrder = ++reqOrder;
+        tasks.push_back(iter);
+    }
+    for (size_t i = 0; i < std::min(contexts.size(), maxThreads); i++)
+        wakeThread();
+}
+
 void VSThreadPool::returnFrame(const VSFrameContext *rCtx, const PVSFrame &f) {
     assert(rCtx->frameDone);
     bool outputLock = rCtx->lockOnOutput;
@@ -343,7 +399,7 @@ void VSThreadPool::returnFrame(const VSFrameContext *rCtx, const PVSFrame &f) {
         if (outputLock)
             callbackLock.unlock();
     }
-    taskLock.lock();
+    lockTaskQueue(taskLock);
 }
 
 void VSThreadPool::startInternalRequest(const PVSFrameContext &notify, NodeOutputKey key) {
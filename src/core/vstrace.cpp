@@ -0,0 +1,175 @@
+/*
+* Copyright (c) 2026 vapoursynth-classic contributors
+*
+* This file is part of VapourSynth.
+*
+* VapourSynth is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 2.1 of the License, or (at your option) any later version.
+*
+* VapourSynth is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with VapourSynth; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "vstrace.h"
+#include <cinttypes>
+#include <cstdio>
+
+#ifdef VS_TARGET_OS_WINDOWS
+#include "../common/vsutf16.h"
+#endif
+
+VSTraceBuffer::VSTraceBuffer(int tid, std::atomic<int64_t> &freeChunks) : head(new Chunk()), tail(head), freeChunks(freeChunks), tid(tid) {
+}
+
+VSTraceBuffer::~VSTraceBuffer() {
+    while (head) {
+        Chunk *next = head->next.load(std::memory_order_relaxed);
+        delete head;
+        head = next;
+    }
+}
+
+// Tracers get a unique id instead of being identified by their address so a thread can't mistake a new tracer
+// allocated in the same place as an old one for the one it already has a buffer in
+static std::atomic<uint64_t> nextTracerId(1);
+
+struct VSThreadTraceBuffer {
+    uint64_t tracerId = 0;
+    VSTraceBuffer *buffer = nullptr;
+};
+
+static thread_local VSThreadTraceBuffer threadTraceBuffer;
+
+VSTracer::VSTracer() : id(nextTracerId++), startTime(now()), freeChunks(maxChunks) {
+}
+
+VSTracer::~VSTracer() {
+    for (auto &iter : buffers)
+        delete iter.second;
+}
+
+VSTraceBuffer *VSTracer::getThreadBuffer() {
+    if (threadTraceBuffer.tracerId == id)
+        return threadTraceBuffer.buffer;
+
+    std::lock_guard<std::mutex> guard(lock);
+    VSTraceBuffer *&buffer = buffers[std::this_thread::get_id()];
+    if (!buffer) {
+        int tid = static_cast<int>(buffers.size());
+        buffer = new VSTraceBuffer(tid, freeChunks);
+        buffer->name = "thread " + std::to_string(tid);
+    }
+    threadTraceBuffer.tracerId = id;
+    threadTraceBuffer.buffer = buffer;
+    return buffer;
+}
+
+int VSTracer::registerNode(const std::string &name) {
+    std::lock_guard<std::mutex> guard(lock);
+    nodeNames.push_back(name);
+    return static_cast<int>(nodeNames.size() - 1);
+}
+
+void VSTracer::setThreadName(const std::string &name) {
+    VSTraceBuffer *buffer = getThreadBuffer();
+    std::lock_guard<std::mutex> guard(lock);
+    buffer->name = name + " " + std::to_string(buffer->tid);
+}
+
+static std::string escapeJSON(const std::string &s) {
+    std::string result = "\"";
+    for (char c : s) {
+        if (c == '"' || c == '\\') {
+            result += '\\';
+            result += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char buffer[8];
+            snprintf(buffer, sizeof(buffer), "\\u%04x", static_cast<int>(c));
+            result += buffer;
+        } else {
+            result += c;
+        }
+    }
+    return result + "\"";
+}
+
+static const char *activationReasonToString(int64_t reason) {
+    switch (reason) {
+    case 0: return "initial";
+    case 1: return "frame ready";
+    case 2: return "all frames ready";
+    case -1: return "error";
+    default: return "unknown";
+    }
+}
+
+// Writes the Chrome trace event format which can be opened directly in Perfetto and chrome://tracing, times are in microseconds
+bool VSTracer::writeChromeTrace(const std::string &filename) {
+#ifdef VS_TARGET_OS_WINDOWS
+    FILE *f = _wfopen(utf16_from_utf8(filename).c_str(), L"wb");
+#else
+    FILE *f = fopen(filename.c_str(), "wb");
+#endif
+    if (!f)
+        return false;
+
+    std::lock_guard<std::mutex> guard(lock);
+
+    std::vector<std::string> names;
+    names.reserve(nodeNames.size());
+    for (const auto &iter : nodeNames)
+        names.push_back(escapeJSON(iter));
+
+    int64_t dropped = 0;
+    for (const auto &iter : buffers)
+        dropped += iter.second->getDropped();
+
+    fprintf(f, "{\"displayTimeUnit\": \"ns\", \"otherData\": {\"droppedEvents\": %" PRId64 "}, \"traceEvents\": [\n", dropped);
+    fprintf(f, "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 1, \"args\": {\"name\": \"VapourSynth\"}}");
+
+    for (const auto &iter : buffers) {
+        const VSTraceBuffer *buffer = iter.second;
+        int tid = buffer->tid;
+        fprintf(f, ",\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %d, \"args\": {\"name\": %s}}", tid, escapeJSON(buffer->name).c_str());
+        fprintf(f, ",\n{\"name\": \"thread_sort_index\", \"ph\": \"M\", \"pid\": 1, \"tid\": %d, \"args\": {\"sort_index\": %d}}", tid, tid);
+
+        buffer->forEach([&](const VSTraceEvent &e) {
+            double ts = (e.start - startTime) / 1000.;
+            double dur = e.duration / 1000.;
+            switch (e.type) {
+            case VSTraceEventType::Activation:
+                fprintf(f, ",\n{\"name\": %s, \"cat\": \"filter\", \"ph\": \"X\", \"ts\": %.3f, \"dur\": %.3f, \"pid\": 1, \"tid\": %d, \"args\": {\"frame\": %d, \"reason\": \"%s\"}}",
+                    names[e.node].c_str(), ts, dur, tid, e.n, activationReasonToString(e.arg));
+                break;
+            case VSTraceEventType::CacheHit:
+            case VSTraceEventType::CacheMiss:
+                fprintf(f, ",\n{\"name\": \"%s\", \"cat\": \"cache\", \"ph\": \"i\", \"s\": \"t\", \"ts\": %.3f, \"pid\": 1, \"tid\": %d, \"args\": {\"node\": %s, \"frame\": %d}}",
+                    (e.type == VSTraceEventType::CacheHit) ? "cache hit" : "cache miss", ts, tid, names[e.node].c_str(), e.n);
+                break;
+            case VSTraceEventType::Allocation:
+                fprintf(f, ",\n{\"name\": \"allocate\", \"cat\": \"memory\", \"ph\": \"i\", \"s\": \"t\", \"ts\": %.3f, \"pid\": 1, \"tid\": %d, \"args\": {\"node\": %s, \"bytes\": %" PRId64 "}}",
+                    ts, tid, names[e.node].c_str(), e.arg);
+                break;
+            case VSTraceEventType::QueueLockWait:
+            case VSTraceEventType::Idle:
+                fprintf(f, ",\n{\"name\": \"%s\", \"cat\": \"scheduler\", \"ph\": \"X\", \"ts\": %.3f, \"dur\": %.3f, \"pid\": 1, \"tid\": %d}",
+                    (e.type == VSTraceEventType::Idle) ? "idle" : "task lock wait", ts, dur, tid);
+                break;
+            }
+        });
+    }
+
+    fprintf(f, "\n]}\n");
+    bool success = !ferror(f);
+    if (fclose(f))
+        success = false;
+    return success;
+}
@@ -0,0 +1,140 @@
+/*
+* Copyright (c) 2026 vapoursynth-classic contributors
+*
+* This file is part of VapourSynth.
+*
+* VapourSynth is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 2.1 of the License, or (at your option) any later version.
+*
+* VapourSynth is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with VapourSynth; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef VSTRACE_H
+#define VSTRACE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+enum class VSTraceEventType : uint8_t {
+    Activation,     // arg is the activation reason using the api3 numbering so frame ready can be told apart
+    CacheHit,
+    CacheMiss,
+    Allocation,     // arg is the size in bytes
+    QueueLockWait,
+    Idle
+};
+
+struct VSTraceEvent {
+    int64_t start;
+    int64_t duration;
+    int64_t arg;
+    int node;
+    int n;
+    VSTraceEventType type;
+};
+
+// Events are only ever appended by the thread that owns the buffer. Full chunks are linked together and never move
+// so the buffer can be read while the owner keeps adding to it. New chunks are taken from a budget shared by all
+// buffers of a tracer, once it's used up further events are only counted.
+class VSTraceBuffer {
+public:
+    static constexpr size_t chunkSize = 4096;
+private:
+    struct Chunk {
+        VSTraceEvent events[chunkSize];
+        std::atomic<size_t> count{0};
+        std::atomic<Chunk *> next{nullptr};
+    };
+
+    Chunk *head;
+    Chunk *tail;
+    std::atomic<int64_t> &freeChunks;
+    bool full = false;
+    std::atomic<int64_t> dropped{0};
+public:
+    int tid;
+    std::string name;
+
+    VSTraceBuffer(int tid, std::atomic<int64_t> &freeChunks);
+    ~VSTraceBuffer();
+
+    void add(const VSTraceEvent &event) {
+        size_t count = tail->count.load(std::memory_order_relaxed);
+        if (count == chunkSize) {
+            if (full || freeChunks.fetch_sub(1, std::memory_order_relaxed) <= 0) {
+                full = true;
+                dropped.store(dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                return;
+            }
+            Chunk *next = new Chunk();
+            tail->next.store(next, std::memory_order_release);
+            tail = next;
+            count = 0;
+        }
+        tail->events[count] = event;
+        tail->count.store(count + 1, std::memory_order_release);
+    }
+
+    int64_t getDropped() const {
+        return dropped.load(std::memory_order_relaxed);
+    }
+
+    template<typename T>
+    void forEach(T func) const {
+        for (const Chunk *c = head; c; c = c->next.load(std::memory_order_acquire)) {
+            size_t count = c->count.load(std::memory_order_acquire);
+            for (size_t i = 0; i < count; i++)
+                func(c->events[i]);
+        }
+    }
+};
+
+// Collects filter activations, cache lookups, frame allocations and thread pool waits for a single core. Every
+// thread gets its own buffer so recording an event never takes a lock after the first one.
+class VSTracer {
+private:
+    // Around a million events, more than that is too slow to open in most trace viewers anyway
+    static constexpr int64_t maxChunks = 256;
+
+    const uint64_t id;
+    const int64_t startTime;
+    std::atomic<int64_t> freeChunks;
+    std::mutex lock;
+    std::vector<std::string> nodeNames;
+    std::map<std::thread::id, VSTraceBuffer *> buffers;
+
+    VSTraceBuffer *getThreadBuffer();
+public:
+    VSTracer();
+    ~VSTracer();
+
+    static int64_t now() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    int registerNode(const std::string &name);
+    void setThreadName(const std::string &name);
+
+    void addEvent(VSTraceEventType type, int node, int n, int64_t start, int64_t duration = 0, int64_t arg = 0) {
+        getThreadBuffer()->add(VSTraceEvent{ start, duration, arg, node, n, type });
+    }
+
+    bool writeChromeTrace(const std::string &filename);
+};
+
+#endif
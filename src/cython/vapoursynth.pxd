@@ -215,6 +215,15 @@ cdef extern from "include/VapourSynth4.h" nogil:
         arAllFramesReady
         arError
 
+    enum VSRequestPattern:
+        rpGeneral
+        rpNoFrameReuse
+        rpStrictSpatial
+
+    ctypedef struct VSFilterDependency:
+        VSNode *source
+        int requestPattern
+
     cpdef enum MessageType "VSMessageType":
         MESSAGE_TYPE_DEBUG "mtDebug"
         MESSAGE_TYPE_INFORMATION "mtInformation"
@@ -226,6 +235,7 @@ cdef extern from "include/VapourSynth4.h" nogil:
         ccfEnableGraphInspection
         ccfDisableAutoLoading
         ccfDisableLibraryUnloading
+        ccfEnableTracing
 
     enum VSPluginConfigFlags:
         pcModifiable
@@ -256,10 +266,10 @@ cdef extern from "include/VapourSynth4.h" nogil:
         
     ctypedef struct VSAPI:
         # Audio and video filter
-        void createVideoFilter(VSMap *out, const char *name, const VSVideoInfo *vi, VSFilterGetFrame getFrame, VSFilterFree free, int filterMode, int flags, void *instanceData, VSCore *core) nogil
-        VSNode *createVideoFilter2(const char *name, const VSVideoInfo *vi, VSFilterGetFrame getFrame, VSFilterFree free, int filterMode, int flags, void *instanceData, VSCore *core) nogil
-        void createAudioFilter(VSMap *out, const char *name, const VSAudioInfo *ai, VSFilterGetFrame getFrame, VSFilterFree free, int filterMode, int flags, void *instanceData, VSCore *core) nogil
-        VSNode *createAudioFilter2(const char *name, const VSAudioInfo *ai, VSFilterGetFrame getFrame, VSFilterFree free, int filterMode, int flags, void *instanceData, VSCore *core) nogil
+        void createVideoFilter(VSMap *out, const char *name, const VSVideoInfo *vi, VSFilterGetFrame getFrame, VSFilterFree free, int filterMode, const VSFilterDependency *dependencies, int numDeps, void *instanceData, VSCore *core) nogil
+        VSNode *createVideoFilter2(const char *name, const VSVideoInfo *vi, VSFilterGetFrame getFrame, VSFilterFree free, int filterMode, const VSFilterDependency *dependencies, int numDeps, void *instanceData, VSCore *core) nogil
+        void createAudioFilter(VSMap *out, const char *name, const VSAudioInfo *ai, VSFilterGetFrame getFrame, VSFilterFree free, int filterMode, const VSFilterDependency *dependencies, int numDeps, void *instanceData, VSCore *core) nogil
+        VSNode *createAudioFilter2(const char *name, const VSAudioInfo *ai, VSFilterGetFrame getFrame, VSFilterFree free, int filterMode, const VSFilterDependency *dependencies, int numDeps, void *instanceData, VSCore *core) nogil
         int setLinearFilter(VSNode *node) nogil
 
         void freeNode(VSNode *node) nogil
@@ -395,12 +405,27 @@ cdef extern from "include/VapourSynth4.h" nogil:
 
     const VSAPI *getVapourSynthAPI(int version) nogil
 
+cdef extern from "src/common/requestwindow.h" nogil:
+    ctypedef struct VSRequestWindow:
+        int window
+        int maxWindow
+
+    void vsRequestWindowInit(VSRequestWindow *w, int numThreads, double now)
+    int vsRequestWindowFrameDone(VSRequestWindow *w, double now)
+    void vsRequestWindowAdjust(VSRequestWindow *w, double now, int overLimit)
+
 cdef extern from "include/VapourSynthC.h" nogil:
     enum:
         VAPOURSYNTHC_API_VERSION
+        VAPOURSYNTHC_API_VERSION2
+    ctypedef void (__stdcall *VSExternalBufferFree)(void *userData)
     ctypedef struct VSCAPI:
         int getPluginAPIVersion(VSPlugin *) nogil
         int pluginSetRO(VSPlugin *, int) nogil
         int pluginRenameFunc(VSPlugin *, const char *, const char *) nogil
         VSPlugin *createPlugin(const char *id, const char *ns, int version, VSCore *core) nogil
         void setNodeName(VSNode *node, const char *name) nogil
+        # VAPOURSYNTHC_API_VERSION2
+        void getFramesAsync(const int *frames, int numFrames, VSNode *node, VSFrameDoneCallback callback, void *userData) nogil
+        VSFrame *newVideoFrameFromBuffers(const VSVideoFormat *format, int width, int height, uint8_t * const *planeData, const ptrdiff_t *strides, VSExternalBufferFree freeBuffer, void *userData, const VSFrame *propSrc, VSCore *core) nogil
+        void getLiveStatistics(VSCore *core, VSMap *out) nogil
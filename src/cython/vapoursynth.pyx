@@ -35,6 +35,10 @@ from cpython.memoryview cimport PyMemoryView_GET_BUFFER
 from cpython.number cimport PyIndex_Check
 from cpython.number cimport PyNumber_Index
 from cpython.ref cimport Py_INCREF, Py_DECREF
+from cpython.pycapsule cimport PyCapsule_New, PyCapsule_IsValid, PyCapsule_GetPointer
+from cpython.pythread cimport PyThread_type_lock, PyThread_allocate_lock, PyThread_acquire_lock, PyThread_release_lock, WAIT_LOCK
+from libc.stdlib cimport malloc, calloc, free
+from libc.string cimport memcpy, memset, strlen
 import os
 import enum
 import ctypes
@@ -48,6 +52,7 @@ import atexit
 import contextlib
 import logging
 import functools
+import time
 from threading import local as ThreadLocal, Lock, RLock
 from types import MappingProxyType
 from collections import namedtuple
@@ -173,6 +178,8 @@ cdef object _policy = None
 
 cdef const VSAPI *_vsapi = NULL
 cdef const VSCAPI *_vscapi = NULL
+# Only set when the core also has the functions after setNodeName
+cdef const VSCAPI *_vscapi2 = NULL
 
 
 cdef void _set_logger(EnvironmentData env, VSLogHandler handler, VSLogHandlerFree free, void *userData):
@@ -960,6 +967,60 @@ cdef VideoFormat createVideoFormat(const VSVideoFormat *f, const VSAPI *funcs, V
     instance.id = funcs.queryVideoFormatID(instance.color_family, instance.sample_type, instance.bits_per_sample, instance.subsampling_w, instance.subsampling_h, core)
     return instance
 
+# Property names are looked up over and over again with the same few strings so their encoded form is cached
+cdef dict _propKeys = {}
+
+cdef bytes _propKey(str name):
+    b = _propKeys.get(name)
+    if b is None:
+        if len(_propKeys) >= 1024:
+            _propKeys.clear()
+        b = name.encode('utf-8')
+        _propKeys[name] = b
+    return <bytes>b
+
+# Single values are by far the most common so they're returned without building a list first
+cdef object _propGet(const VSMap *m, const char *key, int numelem, const VSAPI *funcs, VSCore *core):
+    cdef int t = funcs.mapGetType(m, key)
+    cdef const int64_t *intArray
+    cdef const double *floatArray
+    cdef const char *data
+    cdef list ol
+
+    if numelem == 1:
+        if t == ptInt:
+            return funcs.mapGetInt(m, key, 0, NULL)
+        elif t == ptFloat:
+            return funcs.mapGetFloat(m, key, 0, NULL)
+
+    ol = []
+    if t == ptInt:
+        if numelem > 0:
+            intArray = funcs.mapGetIntArray(m, key, NULL)
+            ol = [intArray[i] for i in range(numelem)]
+    elif t == ptFloat:
+        if numelem > 0:
+            floatArray = funcs.mapGetFloatArray(m, key, NULL)
+            ol = [floatArray[i] for i in range(numelem)]
+    elif t == ptData:
+        for i in range(numelem):
+            data = funcs.mapGetData(m, key, i, NULL)
+            ol.append(data[:funcs.mapGetDataSize(m, key, i, NULL)])
+    elif t == ptVideoNode or t == ptAudioNode:
+        for i in range(numelem):
+            ol.append(createNode(funcs.mapGetNode(m, key, i, NULL), funcs, _get_core()))
+    elif t == ptVideoFrame or t == ptAudioFrame:
+        for i in range(numelem):
+            ol.append(createConstFrame(funcs.mapGetFrame(m, key, i, NULL), funcs, core))
+    elif t == ptFunction:
+        for i in range(numelem):
+            ol.append(createFuncRef(funcs.mapGetFunction(m, key, i, NULL), funcs))
+
+    if len(ol) == 1:
+        return ol[0]
+    else:
+        return ol
+
 cdef class FrameProps(object):
     cdef const VSFrame *constf
     cdef VSFrame *f
@@ -976,56 +1037,43 @@ cdef class FrameProps(object):
 
     def __contains__(self, str name):
         cdef const VSMap *m = self.funcs.getFramePropertiesRO(self.constf)
-        cdef bytes b = name.encode('utf-8')
-        cdef int numelem = self.funcs.mapNumElements(m, b)
-        return numelem > 0
+        return self.funcs.mapNumElements(m, _propKey(name)) > 0
 
     def __getitem__(self, str name):
         cdef const VSMap *m = self.funcs.getFramePropertiesRO(self.constf)
-        cdef bytes b = name.encode('utf-8')
-        cdef list ol = []
+        cdef bytes b = _propKey(name)
         cdef int numelem = self.funcs.mapNumElements(m, b)
-        cdef const int64_t *intArray
-        cdef const double *floatArray
-        cdef const char *data
-
         if numelem < 0:
             raise KeyError('No key named ' + name + ' exists')
-        cdef int t = self.funcs.mapGetType(m, b)
-        if t == ptInt:
-            if numelem > 0:
-                intArray = self.funcs.mapGetIntArray(m, b, NULL)
-                for i in range(numelem):
-                    ol.append(intArray[i])
-        elif t == ptFloat:
-            if numelem > 0:
-                floatArray = self.funcs.mapGetFloatArray(m, b, NULL)
-                for i in range(numelem):
-                    ol.append(floatArray[i])
-        elif t == ptData:
-            for i in range(numelem):
-                data = self.funcs.mapGetData(m, b, i, NULL)
-                ol.append(data[:self.funcs.mapGetDataSize(m, b, i, NULL)])
-        elif t == ptVideoNode or t == ptAudioNode:
-            for i in range(numelem):
-                ol.append(createNode(self.funcs.mapGetNode(m, b, i, NULL), self.funcs, _get_core()))
-        elif t == ptVideoFrame or t == ptAudioFrame:
-            for i in range(numelem):
-                ol.append(createConstFrame(self.funcs.mapGetFrame(m, b, i, NULL), self.funcs, self.core))
-        elif t == ptFunction:
-            for i in range(numelem):
-                ol.append(createFuncRef(self.funcs.mapGetFunction(m, b, i, NULL), self.funcs))
-
-        if len(ol) == 1:
-            return ol[0]
+        return _propGet(m, b, numelem, self.funcs, self.core)
+
+    def to_dict(self, keys=None):
+        """
+        Returns the properties as a dict, or only the ones named in keys that exist. This reads
+        everything in a single call which is a lot faster than looking up the keys one by one.
+        """
+        cdef const VSMap *m = self.funcs.getFramePropertiesRO(self.constf)
+        cdef const char *key
+        cdef bytes b
+        cdef int numelem
+        cdef dict result = {}
+        if keys is None:
+            for i in range(self.funcs.mapNumKeys(m)):
+                key = self.funcs.mapGetKey(m, i)
+                result[key.decode('utf-8')] = _propGet(m, key, self.funcs.mapNumElements(m, key), self.funcs, self.core)
         else:
-            return ol
+            for name in keys:
+                b = _propKey(name)
+                numelem = self.funcs.mapNumElements(m, b)
+                if numelem >= 0:
+                    result[name] = _propGet(m, b, numelem, self.funcs, self.core)
+        return result
 
     def __setitem__(self, str name, value):
         if self.readonly:
             raise Error('Cannot delete properties of a read only object')
         cdef VSMap *m = self.funcs.getFramePropertiesRW(self.f)
-        cdef bytes b = name.encode('utf-8')
+        cdef bytes b = _propKey(name)
         cdef const VSAPI *funcs = self.funcs
         val = value
         if isinstance(val, (str, bytes, bytearray, RawNode, RawFrame, enum.Flag)):
@@ -1072,9 +1120,7 @@ cdef class FrameProps(object):
     def __delitem__(self, str name):
         if self.readonly:
             raise Error('Cannot delete properties of a read only object')
-        cdef VSMap *m = self.funcs.getFramePropertiesRW(self.f)
-        cdef bytes b = name.encode('utf-8')
-        self.funcs.mapDeleteKey(m, b)
+        self.funcs.mapDeleteKey(self.funcs.getFramePropertiesRW(self.f), _propKey(name))
 
     def __setattr__(self, name, value):
         self[name] = value
@@ -1165,7 +1211,7 @@ cdef class FrameProps(object):
         """
         We can't copy VideoFrames directly, so we're just gonna return a real dictionary.
         """
-        return dict(self)
+        return self.to_dict()
 
     def __iter__(self):
         yield from self.keys()
@@ -1178,7 +1224,7 @@ cdef class FrameProps(object):
         return super(FrameProps, self).__dir__() + list(self.keys())
 
     def __repr__(self):
-        return "<vapoursynth.FrameProps %r>" % dict(self)
+        return "<vapoursynth.FrameProps %r>" % self.to_dict()
 
 cdef FrameProps createFrameProps(RawFrame f):
     cdef FrameProps instance = FrameProps.__new__(FrameProps)
@@ -1195,6 +1241,140 @@ cdef FrameProps createFrameProps(RawFrame f):
 # Make sure the FrameProps-Object quacks like a Mapping.
 Mapping.register(FrameProps)
 
+# Zero copy export of frame data through __array_interface__ and DLPack. The exported arrays are always read only and
+# keep a reference to the object they came from so the frame stays alive for as long as they're in use.
+# DLPack ABI, see https://github.com/dmlc/dlpack/blob/main/include/dlpack/dlpack.h
+ctypedef struct DLDevice:
+    int device_type
+    int32_t device_id
+
+ctypedef struct DLDataType:
+    uint8_t code
+    uint8_t bits
+    uint16_t lanes
+
+ctypedef struct DLTensor:
+    void *data
+    DLDevice device
+    int32_t ndim
+    DLDataType dtype
+    int64_t *shape
+    int64_t *strides
+    uint64_t byte_offset
+
+ctypedef struct DLManagedTensor:
+    DLTensor dl_tensor
+    void *manager_ctx
+    void (*deleter)(DLManagedTensor *) noexcept nogil
+
+ctypedef struct DLPackVersion:
+    uint32_t major
+    uint32_t minor
+
+ctypedef struct DLManagedTensorVersioned:
+    DLPackVersion version
+    void *manager_ctx
+    void (*deleter)(DLManagedTensorVersioned *) noexcept nogil
+    uint64_t flags
+    DLTensor dl_tensor
+
+cdef enum:
+    _kDLInt = 0
+    _kDLUInt = 1
+    _kDLFloat = 2
+    _kDLCPU = 1
+    _DLPACK_FLAG_BITMASK_READ_ONLY = 1
+
+ctypedef struct _ArrayDesc:
+    void *data
+    int ndim
+    ssize_t shape[2]
+    ssize_t strides[2] # in bytes
+    int itemsize
+    uint8_t code # DLPack type code
+
+cdef str _byteorder = '<' if sys.byteorder == 'little' else '>'
+
+cdef dict _arrayInterface(_ArrayDesc *desc):
+    kind = 'f' if desc.code == _kDLFloat else ('i' if desc.code == _kDLInt else 'u')
+    return {
+        'version': 3,
+        'shape': tuple(desc.shape[i] for i in range(desc.ndim)),
+        'strides': tuple(desc.strides[i] for i in range(desc.ndim)),
+        'typestr': _byteorder + kind + str(desc.itemsize),
+        'data': (<uintptr_t>desc.data, True)
+    }
+
+cdef void _dlpackDeleter(DLManagedTensor *tensor) noexcept nogil:
+    with gil:
+        Py_DECREF(<object>tensor.manager_ctx)
+    free(tensor)
+
+cdef void _dlpackDeleterVersioned(DLManagedTensorVersioned *tensor) noexcept nogil:
+    with gil:
+        Py_DECREF(<object>tensor.manager_ctx)
+    free(tensor)
+
+# Only called when the capsule was never consumed, a consumer renames it and takes over the deleter
+cdef void _dlpackCapsuleDestructor(object capsule) noexcept:
+    cdef DLManagedTensor *tensor
+    cdef DLManagedTensorVersioned *versioned
+    if PyCapsule_IsValid(capsule, 'dltensor'):
+        tensor = <DLManagedTensor *>PyCapsule_GetPointer(capsule, 'dltensor')
+        tensor.deleter(tensor)
+    elif PyCapsule_IsValid(capsule, 'dltensor_versioned'):
+        versioned = <DLManagedTensorVersioned *>PyCapsule_GetPointer(capsule, 'dltensor_versioned')
+        versioned.deleter(versioned)
+
+cdef void _dlpackFillTensor(DLTensor *tensor, int64_t *shape, _ArrayDesc *desc) noexcept:
+    cdef int i
+    tensor.data = desc.data
+    tensor.device.device_type = _kDLCPU
+    tensor.device.device_id = 0
+    tensor.ndim = desc.ndim
+    tensor.dtype.code = desc.code
+    tensor.dtype.bits = desc.itemsize * 8
+    tensor.dtype.lanes = 1
+    tensor.shape = shape
+    tensor.strides = shape + desc.ndim
+    tensor.byte_offset = 0
+    # DLPack strides are counted in elements
+    for i in range(desc.ndim):
+        tensor.shape[i] = desc.shape[i]
+        tensor.strides[i] = desc.strides[i] // desc.itemsize
+
+cdef object _dlpackCapsule(object owner, _ArrayDesc *desc, object max_version, object dl_device, object copy):
+    cdef DLManagedTensor *tensor
+    cdef DLManagedTensorVersioned *versioned
+    if copy:
+        raise BufferError('Frames can only be exported without copying')
+    if dl_device is not None and tuple(dl_device) != (_kDLCPU, 0):
+        raise BufferError('Frames can only be exported to the CPU')
+
+    # The shape and strides are stored right after the struct so everything is freed in one go
+    if max_version is not None and max_version[0] >= 1:
+        versioned = <DLManagedTensorVersioned *>malloc(sizeof(DLManagedTensorVersioned) + 2 * desc.ndim * sizeof(int64_t))
+        if versioned == NULL:
+            raise MemoryError()
+        versioned.version.major = 1
+        versioned.version.minor = 0
+        versioned.manager_ctx = <void *>owner
+        versioned.deleter = _dlpackDeleterVersioned
+        versioned.flags = _DLPACK_FLAG_BITMASK_READ_ONLY
+        _dlpackFillTensor(&versioned.dl_tensor, <int64_t *>(versioned + 1), desc)
+        Py_INCREF(owner)
+        return PyCapsule_New(versioned, 'dltensor_versioned', _dlpackCapsuleDestructor)
+    else:
+        tensor = <DLManagedTensor *>malloc(sizeof(DLManagedTensor) + 2 * desc.ndim * sizeof(int64_t))
+        if tensor == NULL:
+            raise MemoryError()
+        tensor.manager_ctx = <void *>owner
+        tensor.deleter = _dlpackDeleter
+        _dlpackFillTensor(&tensor.dl_tensor, <int64_t *>(tensor + 1), desc)
+        Py_INCREF(owner)
+        return PyCapsule_New(tensor, 'dltensor', _dlpackCapsuleDestructor)
+
+
 cdef class RawFrame(object):
     cdef const VSFrame *constf
     cdef VSFrame *f
@@ -1336,10 +1516,24 @@ cdef class VideoFrame(RawFrame):
         s += '\tHeight: ' + str(self.height) + '\n'
         return s
 
-    def planes(self): # undocumented api3
-        cdef int x
-        for x in range(self.format.num_planes):
-            yield VideoPlane.__new__(VideoPlane, self, x)
+    def planes(self):
+        return tuple(VideoPlane.__new__(VideoPlane, self, x) for x in range(self.format.num_planes))
+
+    # Only frames with a single plane can be described as one array, the others have to go through planes()
+    cdef VideoPlane _only_plane(self, exc):
+        if self.format.num_planes != 1:
+            raise exc('Only frames with a single plane can be exported as an array, use planes() instead')
+        return VideoPlane.__new__(VideoPlane, self, 0)
+
+    @property
+    def __array_interface__(self):
+        return self._only_plane(AttributeError).__array_interface__
+
+    def __dlpack__(self, *, stream=None, max_version=None, dl_device=None, copy=None):
+        return self._only_plane(BufferError).__dlpack__(stream=stream, max_version=max_version, dl_device=dl_device, copy=copy)
+
+    def __dlpack_device__(self):
+        return (_kDLCPU, 0)
 
     def get_read_array(self, int index):
         return memoryview2(self.__getitem__(index), True)
@@ -1379,9 +1573,11 @@ cdef VideoFrame createVideoFrame(VSFrame *f, const VSAPI *funcs, VSCore *core):
 cdef class VideoPlane:
     cdef:
         object data
+        uint8_t dtype_code
 
-    def __cinit__(self, *args, **kwargs):
-        self.data = VideoFrame.__getitem__(*args, **kwargs)
+    def __cinit__(self, VideoFrame frame, int plane):
+        self.data = frame[plane].toreadonly()
+        self.dtype_code = _kDLFloat if frame.format.sample_type == FLOAT else _kDLUInt
 
     @property
     def width(self):
@@ -1397,6 +1593,31 @@ cdef class VideoPlane:
         # forward the request to the memoryview instance
         PyObject_GetBuffer(self.data, view, flags)
 
+    cdef void _describe(self, _ArrayDesc *desc):
+        cdef Py_buffer *buf = PyMemoryView_GET_BUFFER(self.data)
+        desc.data = buf.buf
+        desc.ndim = 2
+        desc.shape[0] = buf.shape[0]
+        desc.shape[1] = buf.shape[1]
+        desc.strides[0] = buf.strides[0]
+        desc.strides[1] = buf.strides[1]
+        desc.itemsize = buf.itemsize
+        desc.code = self.dtype_code
+
+    @property
+    def __array_interface__(self):
+        cdef _ArrayDesc desc
+        self._describe(&desc)
+        return _arrayInterface(&desc)
+
+    def __dlpack__(self, *, stream=None, max_version=None, dl_device=None, copy=None):
+        cdef _ArrayDesc desc
+        self._describe(&desc)
+        return _dlpackCapsule(self, &desc, max_version, dl_device, copy)
+
+    def __dlpack_device__(self):
+        return (_kDLCPU, 0)
+
 @cython.final
 @cython.internal
 cdef class _frame:
@@ -1534,6 +1755,36 @@ cdef class AudioFrame(RawFrame):
     def __str__(self):
         return 'AudioFrame\n'
 
+    # All channels are in a single allocation so the whole frame is one (channels, samples) array
+    cdef void _describe(self, _ArrayDesc *desc):
+        cdef const VSAudioFormat *format = self.funcs.getAudioFrameFormat(self.constf)
+        cdef int length = self.funcs.getFrameLength(self.constf)
+        desc.data = <void *>self.funcs.getReadPtr(self.constf, 0)
+        desc.ndim = 2
+        desc.shape[0] = format.numChannels
+        desc.shape[1] = length
+        if format.numChannels > 1:
+            desc.strides[0] = self.funcs.getReadPtr(self.constf, 1) - self.funcs.getReadPtr(self.constf, 0)
+        else:
+            desc.strides[0] = length * format.bytesPerSample
+        desc.strides[1] = format.bytesPerSample
+        desc.itemsize = format.bytesPerSample
+        desc.code = _kDLFloat if format.sampleType == FLOAT else _kDLInt
+
+    @property
+    def __array_interface__(self):
+        cdef _ArrayDesc desc
+        self._describe(&desc)
+        return _arrayInterface(&desc)
+
+    def __dlpack__(self, *, stream=None, max_version=None, dl_device=None, copy=None):
+        cdef _ArrayDesc desc
+        self._describe(&desc)
+        return _dlpackCapsule(self, &desc, max_version, dl_device, copy)
+
+    def __dlpack_device__(self):
+        return (_kDLCPU, 0)
+
 
 cdef AudioFrame createConstAudioFrame(const VSFrame *constf, const VSAPI *funcs, VSCore *core):
     cdef AudioFrame instance = AudioFrame.__new__(AudioFrame)
@@ -1630,6 +1881,162 @@ cdef class _audio:
         view.buf = _frame.getdata(frame, channel, flags, lib)
 
 
+# Shares the adaptive request window logic with vspipe, see src/common/requestwindow.h
+@cython.final
+@cython.internal
+cdef class _RequestWindow:
+    cdef VSRequestWindow window
+    cdef Core core
+
+    def __init__(self, Core core):
+        self.core = core
+        vsRequestWindowInit(&self.window, core.num_threads, time.perf_counter())
+
+    @property
+    def size(self):
+        return self.window.window
+
+    @property
+    def max_size(self):
+        return self.window.maxWindow
+
+    def frame_done(self):
+        cdef VSCoreInfo info
+        cdef double now = time.perf_counter()
+        if vsRequestWindowFrameDone(&self.window, now):
+            self.core.funcs.getCoreInfo(self.core.core, &info)
+            vsRequestWindowAdjust(&self.window, now, info.usedFramebufferSize > info.maxFramebufferSize)
+        return self.window.window
+
+
+cdef extern from "pythread.h" nogil:
+    void PyThread_free_lock(PyThread_type_lock lock)
+
+# The state behind RawNode.frames(). It's plain C so the frame callbacks never have to take the GIL, they store the
+# frame in its slot, request more frames to keep prefetch of them running and wake up the iterator when it's waiting
+# for exactly that frame. The iterator and the callbacks share ownership, whoever is done with it last frees it.
+ctypedef struct _FrameQueue:
+    PyThread_type_lock lock # protects everything below
+    PyThread_type_lock ready # held except when a callback wakes up a waiting iterator
+    const VSAPI *funcs
+    VSNode *node
+    int numFrames
+    int capacity # size of the slot arrays, the backlog can never be bigger
+    const VSFrame **frames # indexed by frame number modulo capacity
+    char **errors
+    char *done
+    int nextFrame # the next frame the iterator will return
+    int requested # frames below this number have been requested
+    int running # requested but not returned by the core yet
+    int prefetch
+    int backlog
+    bint waiting
+    bint failed
+    bint closed
+
+cdef void _frameQueueFree(_FrameQueue *q) noexcept nogil:
+    cdef int i
+    for i in range(q.capacity):
+        q.funcs.freeFrame(q.frames[i])
+        free(q.errors[i])
+    q.funcs.freeNode(q.node)
+    PyThread_free_lock(q.lock)
+    PyThread_free_lock(q.ready)
+    free(q.frames)
+    free(q.errors)
+    free(q.done)
+    free(q)
+
+# Must be called with the lock held, returns without it. Requests as many frames as the prefetch and backlog allow
+# in one batch, the numbers are reserved before letting go of the lock so several threads can do this at once.
+cdef void _frameQueueRequest(_FrameQueue *q) noexcept nogil:
+    cdef int first = q.requested
+    cdef int count = min(q.prefetch - q.running, q.backlog - (q.requested - q.nextFrame), q.numFrames - q.requested)
+    cdef int *reqs
+    cdef int i
+    if q.failed or q.closed or count <= 0:
+        PyThread_release_lock(q.lock)
+        return
+    q.requested += count
+    q.running += count
+    PyThread_release_lock(q.lock)
+
+    if _vscapi2 == NULL:
+        for i in range(count):
+            q.funcs.getFrameAsync(first + i, q.node, _frameQueueCallback, q)
+        return
+    reqs = <int *>malloc(count * sizeof(int))
+    for i in range(count):
+        reqs[i] = first + i
+    _vscapi2.getFramesAsync(reqs, count, q.node, _frameQueueCallback, q)
+    free(reqs)
+
+cdef void __stdcall _frameQueueCallback(void *userData, const VSFrame *f, int n, VSNode *node, const char *errormsg) noexcept nogil:
+    cdef _FrameQueue *q = <_FrameQueue *>userData
+    cdef int slot = n % q.capacity
+    cdef size_t length
+    PyThread_acquire_lock(q.lock, WAIT_LOCK)
+    q.running -= 1
+    if q.closed:
+        q.funcs.freeFrame(f)
+        if q.running == 0:
+            PyThread_release_lock(q.lock)
+            _frameQueueFree(q)
+        else:
+            PyThread_release_lock(q.lock)
+        return
+
+    q.frames[slot] = f
+    q.done[slot] = 1
+    if f == NULL:
+        if errormsg == NULL:
+            errormsg = 'Internal error - no error message.'
+        length = strlen(errormsg) + 1
+        q.errors[slot] = <char *>malloc(length)
+        memcpy(q.errors[slot], errormsg, length)
+        q.failed = True
+    if q.waiting and n == q.nextFrame:
+        q.waiting = False
+        PyThread_release_lock(q.ready)
+    _frameQueueRequest(q)
+
+# Blocks until the next frame is done and takes it out of its slot, the error is set instead when it failed
+cdef const VSFrame *_frameQueueTake(_FrameQueue *q, char **error) noexcept nogil:
+    cdef int slot = q.nextFrame % q.capacity
+    cdef const VSFrame *f
+    PyThread_acquire_lock(q.lock, WAIT_LOCK)
+    _frameQueueRequest(q)
+    PyThread_acquire_lock(q.lock, WAIT_LOCK)
+    while not q.done[slot]:
+        q.waiting = True
+        PyThread_release_lock(q.lock)
+        PyThread_acquire_lock(q.ready, WAIT_LOCK)
+        PyThread_acquire_lock(q.lock, WAIT_LOCK)
+    f = q.frames[slot]
+    error[0] = q.errors[slot]
+    q.frames[slot] = NULL
+    q.errors[slot] = NULL
+    q.done[slot] = 0
+    q.nextFrame += 1
+    PyThread_release_lock(q.lock)
+    return f
+
+cdef void _frameQueueResize(_FrameQueue *q, int prefetch, int backlog) noexcept nogil:
+    PyThread_acquire_lock(q.lock, WAIT_LOCK)
+    q.prefetch = prefetch
+    q.backlog = backlog
+    PyThread_release_lock(q.lock)
+
+cdef void _frameQueueClose(_FrameQueue *q) noexcept nogil:
+    cdef bint last
+    PyThread_acquire_lock(q.lock, WAIT_LOCK)
+    q.closed = True
+    last = q.running == 0
+    PyThread_release_lock(q.lock)
+    if last:
+        _frameQueueFree(q)
+
+
 cdef class RawNode(object):
     cdef VSNode *node
     cdef const VSAPI *funcs
@@ -1673,85 +2080,58 @@ cdef class RawNode(object):
         except Exception as e:
             fut.set_exception(e)
 
-        gc.collect()
-
         return fut
 
     def frames(self, prefetch=None, backlog=None):
+        # Without an explicit prefetch the number of frames in flight follows the throughput and memory use
+        window = None
         if prefetch is None or prefetch <= 0:
-            prefetch = self.core.num_threads
+            window = _RequestWindow(self.core)
+            prefetch = window.size
+        user_backlog = backlog if backlog is not None and backlog >= 0 else None
         if backlog is None or backlog < 0:
             backlog = prefetch*3
         elif backlog < prefetch:
             backlog = prefetch
 
-        enum_fut = enumerate((self.get_frame_async(frameno) for frameno in range(self.num_frames)))
-
-        finished = False
-        running = 0
-        lock = RLock()
-        reorder = {}
-
-        def _request_next():
-            nonlocal finished, running
-            with lock:
-                if finished:
-                    return
+        cdef int capacity = backlog
+        if window is not None:
+            capacity = window.max_size*3 if user_backlog is None else max(user_backlog, window.max_size)
+
+        cdef _FrameQueue *q = <_FrameQueue *>calloc(1, sizeof(_FrameQueue))
+        q.lock = PyThread_allocate_lock()
+        q.ready = PyThread_allocate_lock()
+        PyThread_acquire_lock(q.ready, WAIT_LOCK)
+        q.funcs = self.funcs
+        q.node = self.funcs.addNodeRef(self.node)
+        q.numFrames = self.num_frames
+        q.capacity = capacity
+        q.frames = <const VSFrame **>calloc(capacity, sizeof(VSFrame *))
+        q.errors = <char **>calloc(capacity, sizeof(char *))
+        q.done = <char *>calloc(capacity, sizeof(char))
+        q.prefetch = prefetch
+        q.backlog = backlog
 
-                ni = next(enum_fut, None)
-                if ni is None:
-                    finished = True
-                    return
-
-                running += 1
-
-                idx, fut = ni
-                reorder[idx] = fut
-                fut.add_done_callback(_finished)
-
-        def _finished(f):
-            nonlocal finished, running
-            with lock:
-                running -= 1
-                if finished:
-                    return
-
-                if f.exception() is not None:
-                    finished = True
-                    return
-                
-                _refill()
-
-        def _refill():
-            if finished:
-                return
-
-            with lock:
-                # Two rules: 1. Don't exceed the concurrency barrier.
-                #            2. Don't exceed unused-frames-backlog
-                while (not finished) and (running < prefetch) and len(reorder)<backlog:
-                    _request_next()
-        _refill()
-
-        sidx = 0
+        cdef const VSFrame *f
+        cdef char *error
         try:
-            while (not finished) or (len(reorder)>0) or running>0:
-                if sidx not in reorder:
-                    # Spin. Reorder being empty should never happen.
-                    continue
-
-                # Get next requested frame
-                fut = reorder[sidx]
-
-                result = fut.result()
-                del reorder[sidx]
-                _refill()
-
-                sidx += 1
-                yield result
-
+            for n in range(self.num_frames):
+                with nogil:
+                    f = _frameQueueTake(q, &error)
+                if f == NULL:
+                    message = error.decode('utf-8')
+                    free(error)
+                    raise Error(message)
+
+                if window is not None:
+                    prefetch = window.frame_done()
+                    backlog = prefetch*3 if user_backlog is None else max(user_backlog, prefetch)
+                    _frameQueueResize(q, prefetch, backlog)
+
+                yield createConstFrame(f, self.funcs, self.core.core)
         finally:
-            finished = True
+            with nogil:
+                _frameQueueClose(q)
             gc.collect()
 
     def __dealloc__(self):
@@ -1759,6 +2139,330 @@ cdef class RawNode(object):
             self.funcs.freeNode(self.node)
 
 
+# Copies one plane of every frame straight into a buffer from the frame callbacks, the GIL isn't needed at all
+ctypedef struct _ArrayFillState:
+    PyThread_type_lock lock # protects the request counters and error
+    PyThread_type_lock ready # released by the last callback
+    const VSAPI *funcs
+    VSNode *node
+    int start
+    int step
+    int numFrames
+    int plane
+    size_t rowSize
+    int height
+    char *dst
+    ssize_t frameStride
+    ssize_t rowStride
+    int prefetch
+    int requested
+    int running
+    char *error
+
+# Must be called with the lock held, returns without it
+cdef void _arrayFillRequest(_ArrayFillState *q) noexcept nogil:
+    cdef int first = q.requested
+    cdef int count = 0 if q.error else min(q.prefetch - q.running, q.numFrames - q.requested)
+    cdef int *reqs
+    cdef int i
+    if count > 0:
+        q.requested += count
+        q.running += count
+    elif q.running == 0:
+        PyThread_release_lock(q.ready)
+    PyThread_release_lock(q.lock)
+    if count <= 0:
+        return
+
+    if _vscapi2 == NULL:
+        for i in range(count):
+            q.funcs.getFrameAsync(q.start + (first + i) * q.step, q.node, _arrayFillCallback, q)
+        return
+    reqs = <int *>malloc(count * sizeof(int))
+    for i in range(count):
+        reqs[i] = q.start + (first + i) * q.step
+    _vscapi2.getFramesAsync(reqs, count, q.node, _arrayFillCallback, q)
+    free(reqs)
+
+cdef void __stdcall _arrayFillCallback(void *userData, const VSFrame *f, int n, VSNode *node, const char *errormsg) noexcept nogil:
+    cdef _ArrayFillState *q = <_ArrayFillState *>userData
+    cdef char *dst
+    cdef const uint8_t *src
+    cdef ptrdiff_t stride
+    cdef int y
+    cdef size_t length
+    if f != NULL:
+        dst = q.dst + <ssize_t>((n - q.start) // q.step) * q.frameStride
+        src = q.funcs.getReadPtr(f, q.plane)
+        stride = q.funcs.getStride(f, q.plane)
+        for y in range(q.height):
+            memcpy(dst, src, q.rowSize)
+            dst += q.rowStride
+            src += stride
+        q.funcs.freeFrame(f)
+
+    PyThread_acquire_lock(q.lock, WAIT_LOCK)
+    q.running -= 1
+    if f == NULL and q.error == NULL:
+        if errormsg == NULL:
+            errormsg = 'Internal error - no error message.'
+        length = strlen(errormsg) + 1
+        q.error = <char *>malloc(length)
+        memcpy(q.error, errormsg, length)
+    _arrayFillRequest(q)
+
+cdef void _arrayFill(const VSAPI *funcs, VSNode *node, int start, int step, int numFrames, int plane, size_t rowSize, int height, char *dst, ssize_t frameStride, ssize_t rowStride, int prefetch) except *:
+    cdef _ArrayFillState q
+    if numFrames == 0:
+        return
+    memset(&q, 0, sizeof(q))
+    q.lock = PyThread_allocate_lock()
+    q.ready = PyThread_allocate_lock()
+    q.funcs = funcs
+    q.node = node
+    q.start = start
+    q.step = step
+    q.numFrames = numFrames
+    q.plane = plane
+    q.rowSize = rowSize
+    q.height = height
+    q.dst = dst
+    q.frameStride = frameStride
+    q.rowStride = rowStride
+    q.prefetch = prefetch
+
+    with nogil:
+        PyThread_acquire_lock(q.ready, WAIT_LOCK)
+        PyThread_acquire_lock(q.lock, WAIT_LOCK)
+        _arrayFillRequest(&q)
+        PyThread_acquire_lock(q.ready, WAIT_LOCK)
+        # the last callback may still be about to let go of the lock
+        PyThread_acquire_lock(q.lock, WAIT_LOCK)
+        PyThread_release_lock(q.lock)
+        PyThread_release_lock(q.ready)
+
+    PyThread_free_lock(q.lock)
+    PyThread_free_lock(q.ready)
+    if q.error != NULL:
+        message = q.error.decode('utf-8')
+        free(q.error)
+        raise Error(message)
+
+
+# VideoNode.modify_props() evaluates the selector once for every batch of frames and keeps the resulting property
+# changes around until every frame in the batch has been returned, the GIL is only taken to evaluate a batch. Batches
+# whose frames aren't all requested would stay around forever so only the most recently evaluated ones are kept.
+cdef struct _PropBatch:
+    VSMap **updates # per frame, NULL when nothing is set
+    VSMap **deletes # the keys are the properties to delete, NULL when there are none
+    char *returned # per frame, set once the frame has been returned
+    int remaining
+    char *error
+    int index
+    int refs # getFrame calls using the batch, it's only freed once it's out of the list and this is 0
+    _PropBatch *prev
+    _PropBatch *next
+
+ctypedef struct _ModifyPropsData:
+    PyThread_type_lock lock # protects batches, the list and the batch fields after evaluation
+    PyThread_type_lock evalLock # so a batch isn't evaluated by several threads at once
+    const VSAPI *funcs
+    VSNode *node
+    int numFrames
+    int batchSize
+    _PropBatch **batches
+    _PropBatch *oldest # the batches in the order they were evaluated
+    _PropBatch *newest
+    int liveBatches
+    int maxBatches
+    void *selector # a (selector, environment) tuple
+
+cdef void _propBatchFree(_ModifyPropsData *d, _PropBatch *b) noexcept nogil:
+    cdef int i
+    for i in range(d.batchSize):
+        d.funcs.freeMap(b.updates[i])
+        d.funcs.freeMap(b.deletes[i])
+    free(b.updates)
+    free(b.deletes)
+    free(b.returned)
+    free(b.error)
+    free(b)
+
+cdef void _propBatchSelect(_ModifyPropsData *d, _PropBatch *b, int first, int count, VSFrameContext *frameCtx, VSCore *core) noexcept with gil:
+    cdef const VSFrame *f
+    cdef int i
+    selector, env = <tuple>d.selector
+    try:
+        with use_environment(env).use():
+            frames = []
+            for i in range(count):
+                f = d.funcs.getFrameFilter(first + i, d.node, frameCtx)
+                frames.append(createConstVideoFrame(f, d.funcs, core))
+            ret = selector(n=list(range(first, first + count)), f=frames)
+            if not isinstance(ret, (list, tuple)) or len(ret) != count:
+                raise Error('modify_props: the selector must return a list with one entry per frame')
+            for i in range(count):
+                props = ret[i]
+                if props is None:
+                    continue
+                if not isinstance(props, Mapping):
+                    raise Error('modify_props: the selector must return a dict or None for every frame')
+                b.updates[i] = d.funcs.createMap()
+                dictToMap({k: v for k, v in props.items() if v is not None}, b.updates[i], core, d.funcs)
+                deleted = [k for k, v in props.items() if v is None]
+                if deleted:
+                    b.deletes[i] = d.funcs.createMap()
+                    dictToMap(dict.fromkeys(deleted, 0), b.deletes[i], core, d.funcs)
+    except BaseException as e:
+        emsg = (str(e) + '\n\n' + traceback.format_exc()).encode('utf-8')
+        b.error = <char *>malloc(len(emsg) + 1)
+        memcpy(b.error, <const char *>emsg, len(emsg) + 1)
+
+# Must be called with the lock held, returns whether the batch can be freed
+cdef bint _propBatchRemove(_ModifyPropsData *d, _PropBatch *b) noexcept nogil:
+    if b.prev != NULL:
+        b.prev.next = b.next
+    else:
+        d.oldest = b.next
+    if b.next != NULL:
+        b.next.prev = b.prev
+    else:
+        d.newest = b.prev
+    d.batches[b.index] = NULL
+    d.liveBatches -= 1
+    return b.refs == 0
+
+# Must be called with the lock held
+cdef void _propBatchInsert(_ModifyPropsData *d, _PropBatch *b) noexcept nogil:
+    cdef _PropBatch *oldest
+    if d.liveBatches == d.maxBatches:
+        # The frames still pending from the dropped batch evaluate it again
+        oldest = d.oldest
+        if _propBatchRemove(d, oldest):
+            _propBatchFree(d, oldest)
+    b.prev = d.newest
+    if d.newest != NULL:
+        d.newest.next = b
+    else:
+        d.oldest = b
+    d.newest = b
+    d.batches[b.index] = b
+    d.liveBatches += 1
+
+cdef _PropBatch *_propBatchEvaluate(_ModifyPropsData *d, int first, int count, VSFrameContext *frameCtx, VSCore *core) noexcept nogil:
+    cdef _PropBatch *b = <_PropBatch *>calloc(1, sizeof(_PropBatch))
+    b.updates = <VSMap **>calloc(d.batchSize, sizeof(VSMap *))
+    b.deletes = <VSMap **>calloc(d.batchSize, sizeof(VSMap *))
+    b.returned = <char *>calloc(d.batchSize, sizeof(char))
+    b.remaining = count
+    b.index = first // d.batchSize
+    b.refs = 1
+    _propBatchSelect(d, b, first, count, frameCtx, core)
+    return b
+
+cdef const VSFrame *__stdcall _modifyPropsGetFrame(int n, int activationReason, void *instanceData, void **frameData, VSFrameContext *frameCtx, VSCore *core, const VSAPI *vsapi) noexcept nogil:
+    cdef _ModifyPropsData *d = <_ModifyPropsData *>instanceData
+    cdef int index = n // d.batchSize
+    cdef int first = index * d.batchSize
+    cdef int count = min(d.batchSize, d.numFrames - first)
+    cdef _PropBatch *b
+    cdef const VSFrame *src
+    cdef VSFrame *dst
+    cdef VSMap *props
+    cdef bint failed
+    cdef bint release
+    cdef int i
+
+    if activationReason == arInitial:
+        PyThread_acquire_lock(d.lock, WAIT_LOCK)
+        b = d.batches[index]
+        PyThread_release_lock(d.lock)
+        if b != NULL:
+            vsapi.requestFrameFilter(n, d.node, frameCtx)
+        else:
+            # The whole batch is needed to evaluate it
+            frameData[0] = <void *>1
+            for i in range(count):
+                vsapi.requestFrameFilter(first + i, d.node, frameCtx)
+        return NULL
+
+    if activationReason != arAllFramesReady:
+        return NULL
+
+    # A reference is taken under the lock so the batch can't be freed while it's used here
+    PyThread_acquire_lock(d.lock, WAIT_LOCK)
+    b = d.batches[index]
+    if b != NULL:
+        b.refs += 1
+    PyThread_release_lock(d.lock)
+    if b == NULL and frameData[0] == NULL:
+        # It was dropped after the first request so the rest of the batch has to be requested now
+        frameData[0] = <void *>1
+        for i in range(count):
+            vsapi.requestFrameFilter(first + i, d.node, frameCtx)
+        return NULL
+    if b == NULL:
+        PyThread_acquire_lock(d.evalLock, WAIT_LOCK)
+        PyThread_acquire_lock(d.lock, WAIT_LOCK)
+        b = d.batches[index]
+        if b != NULL:
+            b.refs += 1
+        PyThread_release_lock(d.lock)
+        if b == NULL:
+            b = _propBatchEvaluate(d, first, count, frameCtx, core)
+            PyThread_acquire_lock(d.lock, WAIT_LOCK)
+            _propBatchInsert(d, b)
+            PyThread_release_lock(d.lock)
+        PyThread_release_lock(d.evalLock)
+
+    dst = NULL
+    src = vsapi.getFrameFilter(n, d.node, frameCtx)
+    PyThread_acquire_lock(d.lock, WAIT_LOCK)
+    failed = b.error != NULL
+    if failed:
+        vsapi.setFilterError(b.error, frameCtx)
+    elif b.updates[n - first] != NULL or b.deletes[n - first] != NULL:
+        dst = vsapi.copyFrame(src, core)
+        props = vsapi.getFramePropertiesRW(dst)
+        if b.updates[n - first] != NULL:
+            vsapi.copyMap(b.updates[n - first], props)
+        if b.deletes[n - first] != NULL:
+            for i in range(vsapi.mapNumKeys(b.deletes[n - first])):
+                vsapi.mapDeleteKey(props, vsapi.mapGetKey(b.deletes[n - first], i))
+    if not b.returned[n - first]:
+        b.returned[n - first] = 1
+        b.remaining -= 1
+        if b.remaining == 0 and d.batches[index] == b:
+            _propBatchRemove(d, b)
+    b.refs -= 1
+    release = b.refs == 0 and d.batches[index] != b
+    PyThread_release_lock(d.lock)
+    if release:
+        _propBatchFree(d, b)
+
+    if dst != NULL:
+        vsapi.freeFrame(src)
+        return dst
+    elif failed:
+        vsapi.freeFrame(src)
+        return NULL
+    return src
+
+cdef void __stdcall _modifyPropsFree(void *instanceData, VSCore *core, const VSAPI *vsapi) noexcept nogil:
+    cdef _ModifyPropsData *d = <_ModifyPropsData *>instanceData
+    cdef int i
+    for i in range((d.numFrames + d.batchSize - 1) // d.batchSize):
+        if d.batches[i] != NULL:
+            _propBatchFree(d, d.batches[i])
+    vsapi.freeNode(d.node)
+    PyThread_free_lock(d.lock)
+    PyThread_free_lock(d.evalLock)
+    free(d.batches)
+    with gil:
+        Py_DECREF(<object>d.selector)
+    free(d)
+
+
 cdef class VideoNode(RawNode):
     cdef const VSVideoInfo *vi
     cdef readonly VideoFormat format
@@ -1808,6 +2512,67 @@ cdef class VideoNode(RawNode):
         else:
             return createConstVideoFrame(f, self.funcs, self.core.core)
 
+    def to_array(self, frames, out=None, int plane=0, prefetch=None):
+        if not isinstance(frames, range):
+            raise TypeError('frames must be a range')
+        if self.vi.format.colorFamily == UNDEFINED or self.vi.width == 0:
+            raise Error('to_array() needs a clip with constant format and dimensions')
+        if not 0 <= plane < self.vi.format.numPlanes:
+            raise IndexError('Specified plane index out of range')
+        for n in (frames[0], frames[-1]) if len(frames) else ():
+            self.ensure_valid_frame_number(n)
+
+        cdef int width = self.vi.width >> (self.vi.format.subSamplingW if plane else 0)
+        cdef int height = self.vi.height >> (self.vi.format.subSamplingH if plane else 0)
+        cdef int bytesPerSample = self.vi.format.bytesPerSample
+        if out is None:
+            # memoryview can't be cast to half precision so those get their raw bits as 'H'
+            if self.vi.format.sampleType == FLOAT and bytesPerSample == 4:
+                fmt = 'f'
+            else:
+                fmt = {1: 'B', 2: 'H', 4: 'I'}[bytesPerSample]
+            out = PyMemoryView_FromObject(bytearray(len(frames) * height * width * bytesPerSample)).cast(fmt, (len(frames), height, width))
+
+        cdef Py_buffer view
+        PyObject_GetBuffer(out, &view, PyBUF_RECORDS)
+        try:
+            if view.ndim != 3 or view.shape[0] != len(frames) or view.shape[1] != height or view.shape[2] != width:
+                raise ValueError('out must have the shape ({}, {}, {})'.format(len(frames), height, width))
+            if view.itemsize != bytesPerSample or view.strides[2] != bytesPerSample:
+                raise ValueError('out must have {} byte samples and contiguous rows'.format(bytesPerSample))
+            _arrayFill(self.funcs, self.node, frames.start, frames.step, len(frames), plane, width * bytesPerSample, height, <char *>view.buf, view.strides[0], view.strides[1], prefetch if prefetch is not None and prefetch > 0 else self.core.num_threads)
+        finally:
+            PyBuffer_Release(&view)
+        return out
+
+    def modify_props(self, selector not None, int batch = 16):
+        if batch < 1:
+            raise ValueError('batch must be at least 1')
+        if self.num_frames <= 0:
+            raise Error('modify_props() needs a clip with a known length')
+
+        cdef _ModifyPropsData *d = <_ModifyPropsData *>calloc(1, sizeof(_ModifyPropsData))
+        d.lock = PyThread_allocate_lock()
+        d.evalLock = PyThread_allocate_lock()
+        d.funcs = self.funcs
+        d.node = self.funcs.addNodeRef(self.node)
+        d.numFrames = self.num_frames
+        d.batchSize = batch
+        d.batches = <_PropBatch **>calloc((self.num_frames + batch - 1) // batch, sizeof(_PropBatch *))
+        d.maxBatches = max(16, 4 * self.core.num_threads)
+        state = (selector, _env_current())
+        Py_INCREF(state)
+        d.selector = <void *>state
+
+        cdef VSFilterDependency dep
+        dep.source = self.node
+        dep.requestPattern = rpGeneral
+        cdef VSNode *node = self.funcs.createVideoFilter2('ModifyProps', self.vi, _modifyPropsGetFrame, _modifyPropsFree, fmParallel, &dep, 1, d, self.core.core)
+        if node == NULL:
+            _modifyPropsFree(d, self.core.core, self.funcs)
+            raise Error('Failed to create the ModifyProps filter')
+        return createVideoNode(node, self.funcs, self.core)
+
     def set_output(self, int index = 0, VideoNode alpha = None, int alt_output = 0):
         cdef const VSVideoFormat *aformat = NULL
         clip = self
@@ -2195,6 +2960,15 @@ cdef void __stdcall log_handler_free(void *userData) noexcept nogil:
     with gil:
         Py_DECREF(<LogHandle>userData)
 
+cdef void __stdcall _releaseBuffers(void *userData) noexcept nogil:
+    cdef Py_buffer *views = <Py_buffer *>userData
+    cdef int i
+    with gil:
+        for i in range(3):
+            PyBuffer_Release(&views[i])
+    free(views)
+
+
 cdef class Core(object):
     cdef VSCore *core
     cdef const VSAPI *funcs
@@ -2243,6 +3017,28 @@ cdef class Core(object):
         self.funcs.getCoreInfo(self.core, &v)
         return v.usedFramebufferSize
 
+    def stats(self):
+        if _vscapi2 == NULL:
+            raise Error('Live statistics aren\'t supported by this version of the core')
+        cdef VSMap *m = self.funcs.createMap()
+        with nogil:
+            _vscapi2.getLiveStatistics(self.core, m)
+        try:
+            result = {}
+            for key in (b'threads', b'active_threads', b'idle_threads', b'queued_tasks', b'frame_contexts', b'framebuffer_max', b'framebuffer_used', b'framebuffer_unused'):
+                result[key.decode('utf-8')] = self.funcs.mapGetInt(m, key, 0, NULL)
+            caches = []
+            for i in range(self.funcs.mapNumElements(m, b'cache_name')):
+                cache = { 'name': self.funcs.mapGetData(m, b'cache_name', i, NULL).decode('utf-8') }
+                for key in (b'frames', b'history', b'max_frames', b'max_history', b'hits', b'near_misses', b'far_misses'):
+                    ckey = b'cache_' + key
+                    cache[key.decode('utf-8')] = self.funcs.mapGetInt(m, ckey, i, NULL)
+                caches.append(cache)
+            result['caches'] = caches
+            return result
+        finally:
+            self.funcs.freeMap(m)
+
     def __getattr__(self, name):
         cdef VSPlugin *plugin
         tname = name.encode('utf-8')
@@ -2318,6 +3114,51 @@ cdef class Core(object):
         else:
             return createVideoFormat(&fmt, self.funcs, self.core)
 
+    def frame_from_buffer(self, VideoFormat format, planes, VideoFrame prop_src=None):
+        cdef VSVideoFormat fmt
+        cdef Py_buffer *views
+        cdef uint8_t *planeData[3]
+        cdef ptrdiff_t strides[3]
+        cdef VSFrame *f
+        cdef int i, y
+        cdef int width = 0
+        cdef int height = 0
+        if not self.funcs.getVideoFormatByID(&fmt, format.id, self.core):
+            raise Error('Invalid format specified')
+        if len(planes) != fmt.numPlanes:
+            raise ValueError('{} planes needed but {} given'.format(fmt.numPlanes, len(planes)))
+
+        # Released by the core once no frame uses the planes anymore
+        views = <Py_buffer *>calloc(3, sizeof(Py_buffer))
+        try:
+            for i in range(fmt.numPlanes):
+                PyObject_GetBuffer(planes[i], &views[i], PyBUF_RECORDS_RO)
+                if i == 0:
+                    width = views[0].shape[1] if views[0].ndim == 2 else 0
+                    height = views[0].shape[0] if views[0].ndim == 2 else 0
+                if views[i].ndim != 2 or views[i].shape[0] != height >> (fmt.subSamplingH if i else 0) or views[i].shape[1] != width >> (fmt.subSamplingW if i else 0):
+                    raise ValueError('Plane {} has the wrong dimensions'.format(i))
+                if views[i].itemsize != fmt.bytesPerSample or views[i].strides[1] != fmt.bytesPerSample or views[i].strides[0] <= 0:
+                    raise ValueError('Plane {} must have {} byte samples, contiguous rows and a positive stride'.format(i, fmt.bytesPerSample))
+                planeData[i] = <uint8_t *>views[i].buf
+                strides[i] = views[i].strides[0]
+        except:
+            _releaseBuffers(views)
+            raise
+
+        f = NULL
+        if _vscapi2 != NULL:
+            f = _vscapi2.newVideoFrameFromBuffers(&fmt, width, height, planeData, strides, _releaseBuffers, views, prop_src.constf if prop_src is not None else NULL, self.core)
+        if f == NULL:
+            # The buffers aren't aligned well enough to be used directly or the core can't do it
+            f = self.funcs.newVideoFrame(&fmt, width, height, prop_src.constf if prop_src is not None else NULL, self.core)
+            for i in range(fmt.numPlanes):
+                for y in range(views[i].shape[0]):
+                    memcpy(self.funcs.getWritePtr(f, i) + y * self.funcs.getStride(f, i), planeData[i] + y * strides[i], views[i].shape[1] * fmt.bytesPerSample)
+            _releaseBuffers(views)
+        # Read only so accessing the planes doesn't trigger a copy, use copy() to get a writable frame
+        return createConstVideoFrame(f, self.funcs, self.core)
+
     def get_format(self, uint32_t id):
         #import warnings
         #warnings.warn("get_format() is deprecated. Use \"get_video_format\" instead.", DeprecationWarning)
@@ -3252,11 +4093,12 @@ cdef public api const VSAPI *vpy4_getVSAPI(int version) nogil:
     return getVapourSynthAPI(version)
     
 cdef const VSAPI *getVSAPIInternal() nogil:
-    global _vsapi, _vscapi
+    global _vsapi, _vscapi, _vscapi2
     if _vsapi == NULL:
         _vsapi = getVapourSynthAPI(VAPOURSYNTH_API_VERSION)
     if _vscapi == NULL:
         _vscapi = <const VSCAPI *>getVapourSynthAPI(VAPOURSYNTHC_API_VERSION)
+        _vscapi2 = <const VSCAPI *>getVapourSynthAPI(VAPOURSYNTHC_API_VERSION2)
     return _vsapi
 
 cdef public api int vpy4_getVariable(VSScript *se, const char *name, VSMap *dst) nogil:
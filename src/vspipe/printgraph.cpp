@@ -19,6 +19,7 @@
 */
 
 #include "printgraph.h"
+#include "vsjson.h"
 #include <set>
 #include <map>
 #include <list>
@@ -162,17 +163,21 @@ struct NodeTimeRecord {
     }
 };
 
-static void printNodeTimesHelper(std::list<NodeTimeRecord> &lines, std::set<VSNode *> &visited, VSNode *node, const VSAPI *vsapi) {
-    if (!visited.insert(node).second)
-        return;
-
+static std::string getFilterName(VSNode *node, const VSAPI *vsapi) {
     std::string plgName = vsapi->getNodeCreationFunctionName(node, 0);
     std::string nodeName = vsapi->getNodeName(node);
     if (nodeName.find(plgName) == 0)
         plgName = nodeName;
     if (plgName.find(nodeName) == plgName.npos)
         plgName += "@" + nodeName;
-    lines.push_back(NodeTimeRecord{ plgName, vsapi->getNodeFilterMode(node), vsapi->getNodeFilterTime(node) } );
+    return plgName;
+}
+
+static void printNodeTimesHelper(std::list<NodeTimeRecord> &lines, std::set<VSNode *> &visited, VSNode *node, const VSAPI *vsapi) {
+    if (!visited.insert(node).second)
+        return;
+
+    lines.push_back(NodeTimeRecord{ getFilterName(node, vsapi), vsapi->getNodeFilterMode(node), vsapi->getNodeFilterTime(node) } );
 
     int numDeps = vsapi->getNumNodeDependencies(node);
     const VSFilterDependency *deps = vsapi->getNodeDependencies(node);
@@ -229,4 +234,32 @@ std::string printNodeTimes(VSNode *node, double processingTime, const VSAPI *vsa
         s += extendStringRight(it.filterName, 20) + " " + extendStringRight(filterModeToString(it.filterMode), 10) + " " + extendStringLeft(printWithTwoDecimals((it.nanoSeconds) / (processingTime * 10000000)), 10) + " " + extendStringLeft(printWithTwoDecimals(it.nanoSeconds / 1000000000.), 10) + "\n";
 
     return s;
-}
\ No newline at end of file
+}
+
+static void printNodeStatisticsHelper(std::string &s, std::set<VSNode *> &visited, VSNode *node, const VSAPI *vsapi) {
+    if (!visited.insert(node).second)
+        return;
+
+    VSMap *stats = vsapi->createMap();
+    std::string name = getFilterName(node, vsapi);
+    std::string mode = filterModeToString(vsapi->getNodeFilterMode(node));
+    vsapi->mapSetData(stats, "name", name.c_str(), static_cast<int>(name.size()), dtUtf8, maReplace);
+    vsapi->mapSetData(stats, "mode", mode.c_str(), static_cast<int>(mode.size()), dtUtf8, maReplace);
+    vsapi->getNodeStatistics(node, stats);
+    s += std::string(visited.size() > 1 ? ",\n" : "") + "\t\t" + convertVSMapToJSON(stats, vsapi);
+    vsapi->freeMap(stats);
+
+    int numDeps = vsapi->getNumNodeDependencies(node);
+    const VSFilterDependency *deps = vsapi->getNodeDependencies(node);
+
+    for (int i = 0; i < numDeps; i++)
+        printNodeStatisticsHelper(s, visited, deps[i].source, vsapi);
+}
+
+std::string printNodeStatistics(VSNode *node, const VSAPI *vsapi) {
+    std::set<VSNode *> visited;
+    std::string s = "[\n";
+    printNodeStatisticsHelper(s, visited, node, vsapi);
+    s += "\n\t]";
+    return s;
+}
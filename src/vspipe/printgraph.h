@@ -26,5 +26,6 @@
 
 std::string printNodeGraph(bool simple, VSNode *node, const VSAPI *vsapi);
 std::string printNodeTimes(VSNode *node, double processingTime, const VSAPI *vsapi);
+std::string printNodeStatistics(VSNode *node, const VSAPI *vsapi); /* JSON array with one object per node, requires graph inspection */
 
 #endif
@@ -21,28 +21,47 @@
 #include "VapourSynth4.h"
 #include "VSHelper4.h"
 #include "VSScript4.h"
+#include "VapourSynthC.h"
 #include "../core/version.h"
 #include "../core/VapourSynth3.h"
 #include "printgraph.h"
 #include "vsjson.h"
 extern "C" {
 #include "md5.h"
+#include "xxhash64.h"
 }
 #include <string>
-#include <map>
 #include <vector>
 #include <mutex>
 #include <condition_variable>
+#include <thread>
 #include <algorithm>
+#include <cctype>
 #include <chrono>
+#include <atomic>
+#include <memory>
 #include <locale>
 #include <sstream>
+#include <fstream>
+#include <climits>
+#include <csignal>
 #include "../common/wave.h"
+#include "../common/requestwindow.h"
+#include "../common/videopack.h"
 #ifdef VS_TARGET_OS_WINDOWS
 #include <io.h>
 #include <fcntl.h>
 #include "../common/vsutf16.h"
 #endif
+#ifdef VS_TARGET_OS_LINUX
+#include <deque>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#endif
 
 #define __STDC_FORMAT_MACROS
 #include <cstdio>
@@ -69,6 +88,19 @@ static BOOL WINAPI HandlerRoutine(DWORD dwCtrlType) {
 }
 #endif
 
+// Batched requests are only used when the core has them
+static const VSCAPI *vscapi = nullptr;
+
+// Ctrl-C elsewhere only sets this, the writer threads check it between frames so what was written so far gets flushed
+static std::atomic<bool> interrupted(false);
+static std::once_flag interruptReported;
+
+#ifndef VS_TARGET_OS_WINDOWS
+static void sigintHandler(int) {
+    interrupted = true;
+}
+#endif
+
 #ifdef VS_TARGET_OS_WINDOWS
 typedef std::wstring nstring;
 #define NSTRING(x) L##x
@@ -93,7 +125,8 @@ enum class VSPipeMode {
     PrintHelp,
     PrintInfo,
     PrintSimpleGraph,
-    PrintFullGraph
+    PrintFullGraph,
+    Benchmark
 };
 
 enum class VSPipeHeaders {
@@ -103,14 +136,26 @@ enum class VSPipeHeaders {
     WAVE64
 };
 
+enum class VSPipePack {
+    None,
+    RGB24,
+    BGRA,
+    YUYV,
+    V210,
+    P010
+};
+
 // Struct used to return the parsed command line options
 struct VSPipeOptions {
     VSPipeMode mode = VSPipeMode::Output;
     VSPipeHeaders outputHeaders = VSPipeHeaders::None;
+    VSPipePack pack = VSPipePack::None;
     int64_t startPos = 0;
     int64_t endPos = -1;
     int outputIndex = 0;
+    std::vector<std::pair<int, nstring>> outputs; // index and filename pairs for rendering several outputs at once
     int requests = 0;
+    int segments = 0;
     int logLevel = // api3
 #ifdef NDEBUG
         vs3::mtWarning
@@ -121,20 +166,91 @@ struct VSPipeOptions {
     bool printProgress = false;
     bool printFilterTime = false;
     bool calculateMD5 = false;
+    bool checksumProperties = false;
     bool preserveCwd = false;
+    bool directOutput = false;
     nstring scriptFilename;
     nstring outputFilename;
+    nstring outputPattern;
     nstring timecodesFilename;
     nstring jsonFilename;
+    nstring checksumFilename;
+    nstring verifyFilename;
+    nstring traceFilename;
+    nstring saveGraphFilename;
+    nstring loadGraphFilename;
     std::vector<std::pair<std::string, std::string>> scriptArgs;
+    std::vector<int> threadsSweep;
+};
+
+// The output nodes either come from evaluating the script or from recreating a graph snapshot without it
+
+struct VSPipeSource {
+    const VSSCRIPTAPI *vssapi = nullptr;
+    const VSAPI *vsapi = nullptr;
+    VSCore *core = nullptr;
+    VSScript *se = nullptr;
+    VSMap *snapshot = nullptr;
+
+    VSNode *getOutputNode(int index) const {
+        if (se)
+            return vssapi->getOutputNode(se, index);
+        int err;
+        return vsapi->mapGetNode(snapshot, ("clip" + std::to_string(index)).c_str(), 0, &err);
+    }
+
+    VSNode *getOutputAlphaNode(int index) const {
+        if (se)
+            return vssapi->getOutputAlphaNode(se, index);
+        int err;
+        return vsapi->mapGetNode(snapshot, ("alpha" + std::to_string(index)).c_str(), 0, &err);
+    }
+
+    // the script owns the core so it's only freed separately when there is none
+    void free() {
+        if (se) {
+            vssapi->freeScript(se);
+        } else {
+            vsapi->freeMap(snapshot);
+            vsapi->freeCore(core);
+        }
+    }
+};
+
+// Per frame checksums, filled in by a pass-through filter on the worker threads and read by the writer in output order.
+// The writer releases every entry once it's done with it so only the frames in flight take up memory.
+struct VSPipeChecksums {
+    bool hashProperties = false;
+    std::vector<std::string> planes;
+    std::vector<std::string> properties;
+};
+
+struct VSPipeChecksumFilterData {
+    VSNode *node;
+    VSPipeChecksums *checksums;
 };
 
 // All state used for outputting frames
 
+struct VSPipeOutputData;
+
+// Outputs rendered together from the same script. Each one only requests frames while it's at most its number of
+// requests ahead of the others so shared upstream filters see the requests at about the same time and the frames
+// are still in the cache when the other outputs get to them.
+struct VSPipeOutputGroup {
+    std::vector<VSPipeOutputData *> outputs;
+
+    /* Frame callbacks may touch the other outputs so everything has to stay alive until the last one has returned */
+    std::mutex mutex;
+    std::condition_variable condition;
+    int activeCallbacks = 0;
+};
+
 struct VSPipeOutputData {
     /* Core fields */
     const VSAPI *vsapi = nullptr;
     VSPipeHeaders outputHeaders = VSPipeHeaders::None;
+    VSPipePack pack = VSPipePack::None;
     FILE *outFile = nullptr;
     VSNode *node = nullptr;
     VSNode *alphaNode = nullptr;
@@ -144,27 +260,49 @@ struct VSPipeOutputData {
     int64_t totalSamples = -1;
 
     /* Fields used for keeping track of how many frames have been requested and completed and how to reorder them */
+    int requests = 0;
     int outputFrames = 0;
     int requestedFrames = 0;
     int completedFrames = 0;
     int completedAlphaFrames = 0;
-    std::map<int, std::pair<const VSFrame *, const VSFrame *>> reorderMap;
+    std::vector<std::pair<const VSFrame *, const VSFrame *>> ring; // frame n goes in slot n % ring.size()
+
+    /* Set when rendered together with other outputs, requestPosition is the fraction of frames requested */
+    VSPipeOutputGroup *group = nullptr;
+    std::atomic<double> requestPosition{ 0 };
+
+    /* Adaptive number of requests, only used when it isn't set on the command line */
+    VSCore *core = nullptr;
+    bool adaptiveRequests = false;
+    VSRequestWindow requestWindow = {};
 
     /* Error reporting */
     bool outputError = false;
     std::string errorMessage;
 
-    /* Only used to keep the main thread waiting during processing */
+    /* Protects all of the above, the writer thread waits on the condition for frames to arrive */
     std::condition_variable condition;
     std::mutex mutex;
 
-    /* Buffer used to interleave audio or to pack together video where the rowsize isn't the same as pitch due to multiple calls to stdout being very slow */
+    /* Buffer used to interleave audio or to pack together video where the rowsize isn't the same as pitch due to multiple calls to stdout being very slow,
+       also holds the whole frame when it's converted to a packed format */
     std::vector<uint8_t> buffer;
 
+    /* Direct video output, frames are submitted with writev() or vmsplice() straight from the frame memory without packing them first, Linux only */
+    bool directOutput = false;
+#ifdef VS_TARGET_OS_LINUX
+    bool spliceOutput = false;
+    int pipeSize = 0;
+    int outFd = -1;
+    std::vector<struct iovec> iov;
+    std::deque<std::pair<uint64_t, const VSFrame *>> splicedFrames; // output offset after the frame's last byte and a reference to keep its pages unchanged until read
+#endif
+
     /* Statistics */
     bool calculateMD5 = false;
     MD5_CTX md5Ctx = {};
     bool printProgress = false;
+    std::atomic<uint64_t> outputBytes{ 0 };
     std::chrono::time_point<std::chrono::steady_clock> startTime;
     std::chrono::time_point<std::chrono::steady_clock> lastFPSReportTime;
 
@@ -175,6 +313,14 @@ struct VSPipeOutputData {
 
     /* JSON output */
     FILE *jsonFile = nullptr;
+
+    /* Checksum manifest, written to checksumFile and/or compared against verifyRecords */
+    VSPipeChecksums checksums;
+    VSPipeChecksums alphaChecksums;
+    FILE *checksumFile = nullptr;
+    bool verifyChecksums = false;
+    std::string checksumHeader;
+    std::vector<std::string> verifyRecords;
 };
 
 /////////////////////////////////////////////
@@ -239,8 +385,97 @@ static bool isCompletedFrame(const std::pair<const VSFrame *, const VSFrame *> &
     return (f.first && (!hasAlpha || f.second));
 }
 
-static void outputFrame(const VSFrame *frame, VSPipeOutputData *data) {
-    if (!data->outputError && data->outFile) {
+// Must be called with the mutex held
+static void setOutputError(VSPipeOutputData *data, const std::string &message) {
+    if (data->errorMessage.empty())
+        data->errorMessage = message;
+    data->totalFrames = data->requestedFrames;
+    data->outputError = true;
+}
+
+// Must be called with the mutex held. Outputs rendered together may only get a window ahead of the slowest
+// one so they keep requesting frames from roughly the same part of the shared filters.
+static bool isAheadOfGroup(const VSPipeOutputData *data) {
+    if (!data->group)
+        return false;
+    double position = (data->requestedFrames - data->requests) / static_cast<double>(data->totalFrames);
+    for (const VSPipeOutputData *other : data->group->outputs) {
+        if (other != data && position > other->requestPosition)
+            return true;
+    }
+    return false;
+}
+
+// Must be called with the mutex held. Claims the next frames to request so that at most data->requests frames
+// are in flight and no requested frame can land in a ring slot that hasn't been written yet. The caller issues
+// the returned range with requestFrames() after releasing the mutex.
+static int claimRequests(VSPipeOutputData *data, int &first) {
+    first = data->requestedFrames;
+    int inFlight = data->requestedFrames - std::min(data->completedFrames, data->completedAlphaFrames);
+    int ringSize = static_cast<int>(data->ring.size());
+    while (data->requestedFrames < data->totalFrames && inFlight < data->requests && data->requestedFrames - data->outputFrames < ringSize && !data->outputError && !isAheadOfGroup(data)) {
+        data->requestedFrames++;
+        inFlight++;
+    }
+    if (data->group)
+        data->requestPosition = (data->requestedFrames >= data->totalFrames) ? 2 : data->requestedFrames / static_cast<double>(data->totalFrames);
+    return data->requestedFrames - first;
+}
+
+// Must be called with the mutex held
+static void updateRequestWindow(VSPipeOutputData *data) {
+    double now = std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    if (vsRequestWindowFrameDone(&data->requestWindow, now)) {
+        VSCoreInfo info;
+        data->vsapi->getCoreInfo(data->core, &info);
+        vsRequestWindowAdjust(&data->requestWindow, now, info.usedFramebufferSize > info.maxFramebufferSize);
+        data->requests = data->requestWindow.window;
+    }
+}
+
+static void VS_CC frameDoneCallback(void *userData, const VSFrame *f, int n, VSNode *rnode, const char *errorMsg);
+
+static void requestFrames(VSPipeOutputData *data, int first, int count) {
+    if (!vscapi) {
+        for (int i = 0; i < count; i++) {
+            data->vsapi->getFrameAsync(first + i, data->node, frameDoneCallback, data);
+            if (data->alphaNode)
+                data->vsapi->getFrameAsync(first + i, data->alphaNode, frameDoneCallback, data);
+        }
+        return;
+    }
+
+    std::vector<int> frames(count);
+    for (int i = 0; i < count; i++)
+        frames[i] = first + i;
+    vscapi->getFramesAsync(frames.data(), count, data->node, frameDoneCallback, data);
+    if (data->alphaNode)
+        vscapi->getFramesAsync(frames.data(), count, data->alphaNode, frameDoneCallback, data);
+}
+
+// Called after an output in a group has requested more frames since that may allow the others to continue, which in
+// turn may allow more outputs to continue so it keeps going until nothing more can be requested
+static void requestGroupFrames(VSPipeOutputGroup *group) {
+    bool requested = true;
+    while (requested) {
+        requested = false;
+        for (VSPipeOutputData *data : group->outputs) {
+            int first;
+            int count;
+            {
+                std::lock_guard<std::mutex> lock(data->mutex);
+                count = claimRequests(data, first);
+            }
+            if (count) {
+                requestFrames(data, first, count);
+                requested = true;
+            }
+        }
+    }
+}
+
+static bool outputFrame(const VSFrame *frame, VSPipeOutputData *data, int n, std::string &error) {
+    if (data->outFile) {
         if (data->vsapi->getFrameType(frame) == mtVideo) {
             const VSVideoFormat *fi = data->vsapi->getVideoFrameFormat(frame);
             const int rgbRemap[] = { 1, 2, 0 };
@@ -260,13 +495,11 @@ static void outputFrame(const VSFrame *frame, VSPipeOutputData *data) {
                     MD5_Update(&data->md5Ctx, readPtr, rowSize * height);
 
                 if (fwrite(readPtr, 1, rowSize * height, data->outFile) != static_cast<size_t>(rowSize * height)) {
-                    if (data->errorMessage.empty())
-                        data->errorMessage = "Error: fwrite() call failed when writing frame: " + std::to_string(data->outputFrames) + ", plane: " + std::to_string(p) +
+                    error = "Error: fwrite() call failed when writing frame: " + std::to_string(n) + ", plane: " + std::to_string(p) +
                         ", errno: " + std::to_string(errno);
-                    data->totalFrames = data->requestedFrames;
-                    data->outputError = true;
-                    break;
+                    return false;
                 }
+                data->outputBytes += rowSize * height;
             }
         } else if (data->vsapi->getFrameType(frame) == mtAudio) {
             const VSAudioFormat *fi = data->vsapi->getAudioFrameFormat(frame);
@@ -292,157 +525,472 @@ static void outputFrame(const VSFrame *frame, VSPipeOutputData *data) {
                 MD5_Update(&data->md5Ctx, data->buffer.data(), static_cast<unsigned long>(toOutput));
 
             if (fwrite(data->buffer.data(), 1, toOutput, data->outFile) != toOutput) {
-                if (data->errorMessage.empty())
-                    data->errorMessage = "Error: fwrite() call failed when writing frame: " + std::to_string(data->outputFrames) + ", errno: " + std::to_string(errno);
-                data->totalFrames = data->requestedFrames;
-                data->outputError = true;
+                error = "Error: fwrite() call failed when writing frame: " + std::to_string(n) + ", errno: " + std::to_string(errno);
+                return false;
             }
+            data->outputBytes += toOutput;
         }
     }
+    return true;
 }
 
-static void VS_CC frameDoneCallback(void *userData, const VSFrame *f, int n, VSNode *rnode, const char *errorMsg) {
-    VSPipeOutputData *data = reinterpret_cast<VSPipeOutputData *>(userData);
+static size_t packedFrameSize(VSPipePack pack, int width, int height) {
+    switch (pack) {
+    case VSPipePack::RGB24:
+        return static_cast<size_t>(width) * height * 3;
+    case VSPipePack::BGRA:
+        return static_cast<size_t>(width) * height * 4;
+    case VSPipePack::YUYV:
+        return static_cast<size_t>(width) * height * 2;
+    case VSPipePack::V210:
+        return V210RowSize(width) * height;
+    case VSPipePack::P010:
+        return static_cast<size_t>(width) * height * 3;
+    default:
+        return 0;
+    }
+}
+
+// Interleaves the planes into the buffer and writes the whole frame at once, this replaces the copy that's otherwise done to remove the stride padding
+static bool outputPackedFrame(const VSFrame *frame, const VSFrame *alphaFrame, VSPipeOutputData *data, int n, std::string &error) {
+    const VSAPI *vsapi = data->vsapi;
+    int width = vsapi->getFrameWidth(frame, 0);
+    int height = vsapi->getFrameHeight(frame, 0);
+    uint8_t *dst = data->buffer.data();
+
+    const uint8_t *src[4] = {};
+    ptrdiff_t stride[4] = {};
+    for (int p = 0; p < 3; p++) {
+        src[p] = vsapi->getReadPtr(frame, p);
+        stride[p] = vsapi->getStride(frame, p);
+    }
+    if (alphaFrame) {
+        src[3] = vsapi->getReadPtr(alphaFrame, 0);
+        stride[3] = vsapi->getStride(alphaFrame, 0);
+    }
+
+    for (int y = 0; y < height; y++) {
+        switch (data->pack) {
+        case VSPipePack::RGB24:
+            PackRowRGB24(src[0] + y * stride[0], src[1] + y * stride[1], src[2] + y * stride[2], dst, width);
+            dst += width * 3;
+            break;
+        case VSPipePack::BGRA:
+            PackRowBGRA(src[0] + y * stride[0], src[1] + y * stride[1], src[2] + y * stride[2], src[3] ? src[3] + y * stride[3] : nullptr, dst, width);
+            dst += width * 4;
+            break;
+        case VSPipePack::YUYV:
+            PackRowYUYV(src[0] + y * stride[0], src[1] + y * stride[1], src[2] + y * stride[2], dst, width);
+            dst += width * 2;
+            break;
+        case VSPipePack::V210:
+            PackRowV210(reinterpret_cast<const uint16_t *>(src[0] + y * stride[0]), reinterpret_cast<const uint16_t *>(src[1] + y * stride[1]),
+                reinterpret_cast<const uint16_t *>(src[2] + y * stride[2]), dst, width);
+            dst += V210RowSize(width);
+            break;
+        case VSPipePack::P010:
+            PackRowP010Luma(reinterpret_cast<const uint16_t *>(src[0] + y * stride[0]), dst, width);
+            dst += width * 2;
+            break;
+        default:
+            break;
+        }
+    }
+
+    if (data->pack == VSPipePack::P010) {
+        for (int y = 0; y < height / 2; y++) {
+            PackRowP010Chroma(reinterpret_cast<const uint16_t *>(src[1] + y * stride[1]), reinterpret_cast<const uint16_t *>(src[2] + y * stride[2]), dst, width / 2);
+            dst += width * 2;
+        }
+    }
+
+    size_t size = dst - data->buffer.data();
 
-    bool printToConsole = false;
-    bool hasMeaningfulFPS = false;
-    double fps = 0;
+    if (data->calculateMD5)
+        MD5_Update(&data->md5Ctx, data->buffer.data(), static_cast<unsigned long>(size));
 
-    if (data->printProgress) {
-        printToConsole = (n == 0);
+    if (fwrite(data->buffer.data(), 1, size, data->outFile) != size) {
+        error = "Error: fwrite() call failed when writing frame: " + std::to_string(n) + ", errno: " + std::to_string(errno);
+        return false;
+    }
+    data->outputBytes += size;
+    return true;
+}
 
-        std::chrono::time_point<std::chrono::steady_clock> currentTime(std::chrono::steady_clock::now());
-        std::chrono::duration<double> elapsedSeconds = currentTime - data->lastFPSReportTime;
-        std::chrono::duration<double> elapsedSecondsFromStart = currentTime - data->startTime;
+#ifdef VS_TARGET_OS_LINUX
+// Adds one entry per plane, or one per row when the stride is padded, so nothing has to be packed into the buffer first
+static void addVideoFrameIOV(const VSFrame *frame, VSPipeOutputData *data) {
+    const VSVideoFormat *fi = data->vsapi->getVideoFrameFormat(frame);
+    const int rgbRemap[] = { 1, 2, 0 };
+    for (int rp = 0; rp < fi->numPlanes; rp++) {
+        int p = (fi->colorFamily == cfRGB) ? rgbRemap[rp] : rp;
+        ptrdiff_t stride = data->vsapi->getStride(frame, p);
+        const uint8_t *readPtr = data->vsapi->getReadPtr(frame, p);
+        size_t rowSize = data->vsapi->getFrameWidth(frame, p) * fi->bytesPerSample;
+        int height = data->vsapi->getFrameHeight(frame, p);
+
+        if (static_cast<ptrdiff_t>(rowSize) == stride) {
+            data->iov.push_back({ const_cast<uint8_t *>(readPtr), rowSize * height });
+            if (data->calculateMD5)
+                MD5_Update(&data->md5Ctx, readPtr, static_cast<unsigned long>(rowSize * height));
+        } else {
+            for (int y = 0; y < height; y++) {
+                data->iov.push_back({ const_cast<uint8_t *>(readPtr), rowSize });
+                if (data->calculateMD5)
+                    MD5_Update(&data->md5Ctx, readPtr, static_cast<unsigned long>(rowSize));
+                readPtr += stride;
+            }
+        }
+    }
+}
 
-        if (elapsedSeconds.count() > .5) {
-            printToConsole = true;
-            data->lastFPSReportTime = currentTime;
+static bool submitIOV(VSPipeOutputData *data, int n, bool splice, std::string &error) {
+    struct iovec *iov = data->iov.data();
+    size_t count = data->iov.size();
+
+    while (count > 0) {
+        int chunk = static_cast<int>(std::min<size_t>(count, IOV_MAX));
+        ssize_t written = splice ? vmsplice(data->outFd, iov, chunk, 0) : writev(data->outFd, iov, chunk);
+        if (written < 0 && errno == EINTR)
+            continue;
+        if (written <= 0) {
+            error = std::string("Error: ") + (splice ? "vmsplice()" : "writev()") + " call failed when writing frame: " + std::to_string(n) + ", errno: " + std::to_string(errno);
+            data->iov.clear();
+            return false;
         }
 
-        if (elapsedSecondsFromStart.count() > 8) {
-            hasMeaningfulFPS = true;
-            fps = data->completedFrames / elapsedSecondsFromStart.count();
+        data->outputBytes += written;
+        size_t remaining = static_cast<size_t>(written);
+        while (count > 0 && remaining >= iov->iov_len) {
+            remaining -= iov->iov_len;
+            iov++;
+            count--;
+        }
+        if (count > 0) {
+            iov->iov_base = static_cast<uint8_t *>(iov->iov_base) + remaining;
+            iov->iov_len -= remaining;
         }
     }
 
-    // completed frames simply correspond to how many times the completion callback is called
-    if (rnode == data->node) {
-        data->completedFrames++;
-        if (!data->alphaNode)
-            data->completedAlphaFrames++;
+    data->iov.clear();
+    return true;
+}
+
+// Pages handed to vmsplice() stay referenced by the pipe until the reader gets to them. A write only returns once the
+// pipe has room for it so no more than the pipe size can be unread, a frame that ends at least that far back has been
+// read and can be returned to the core.
+static void releaseSplicedFrames(VSPipeOutputData *data, bool drain) {
+    while (!data->splicedFrames.empty() && data->splicedFrames.front().first + data->pipeSize <= data->outputBytes) {
+        data->vsapi->freeFrame(data->splicedFrames.front().second);
+        data->splicedFrames.pop_front();
+    }
+
+    if (!drain)
+        return;
+
+    // The end of the output is never spliced so frames are only left here when it stopped early. Wait for the
+    // reader to get to them anyway, POLLERR is set on the write end once all readers are gone.
+    int unread = 0;
+    struct pollfd pfd = { data->outFd, 0, 0 };
+    while (!data->splicedFrames.empty() && !ioctl(data->outFd, FIONREAD, &unread) && data->outputBytes - unread < data->splicedFrames.back().first && !(poll(&pfd, 1, 0) > 0 && (pfd.revents & POLLERR)))
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    for (auto &iter : data->splicedFrames)
+        data->vsapi->freeFrame(iter.second);
+    data->splicedFrames.clear();
+}
+
+static bool outputFrameDirect(const VSFrame *frame, const VSFrame *alphaFrame, VSPipeOutputData *data, int n, std::string &error) {
+    static const char frameHeader[] = "FRAME\n";
+    if (data->outputHeaders == VSPipeHeaders::Y4M)
+        data->iov.push_back({ const_cast<char *>(frameHeader), 6 });
+
+    addVideoFrameIOV(frame, data);
+    if (alphaFrame)
+        addVideoFrameIOV(alphaFrame, data);
+
+    // Only frames followed by at least a pipe's worth of output are spliced, the rest is copied. That way everything
+    // spliced has been read by the time the output is complete and the frames don't have to wait for the reader.
+    uint64_t frameBytes = 0;
+    for (const auto &iter : data->iov)
+        frameBytes += iter.iov_len;
+    bool splice = data->spliceOutput && static_cast<uint64_t>(data->totalFrames - 1 - n) * frameBytes >= static_cast<uint64_t>(data->pipeSize);
+
+    if (!submitIOV(data, n, splice, error))
+        return false;
+
+    if (splice) {
+        data->splicedFrames.emplace_back(data->outputBytes, data->vsapi->addFrameRef(frame));
+        if (alphaFrame)
+            data->splicedFrames.emplace_back(data->outputBytes, data->vsapi->addFrameRef(alphaFrame));
+    }
+    if (data->spliceOutput)
+        releaseSplicedFrames(data, false);
+
+    return true;
+}
+#endif
+
+// Writes everything belonging to output frame n. Only called from the writer thread.
+static bool writeFrame(const VSFrame *frame, const VSFrame *alphaFrame, int n, bool lastFrame, VSPipeOutputData *data, std::string &error) {
+#ifdef VS_TARGET_OS_LINUX
+    if (data->directOutput) {
+        if (!outputFrameDirect(frame, alphaFrame, data, n, error))
+            return false;
     } else {
-        data->completedAlphaFrames++;
+#else
+    {
+#endif
+        if (data->outputHeaders == VSPipeHeaders::Y4M && data->outFile) {
+            if (fwrite("FRAME\n", 1, 6, data->outFile) != 6) {
+                error = "Error: fwrite() call failed when writing header, errno: " + std::to_string(errno);
+                return false;
+            }
+        }
+
+        if (data->pack != VSPipePack::None) {
+            if (data->outFile && !outputPackedFrame(frame, alphaFrame, data, n, error))
+                return false;
+        } else {
+            if (!outputFrame(frame, data, n, error))
+                return false;
+            if (alphaFrame && !outputFrame(alphaFrame, data, n, error))
+                return false;
+        }
     }
 
-    if (f) {
-        if (rnode == data->node)
-            data->reorderMap[n].first = f;
-        else
-            data->reorderMap[n].second = f;
+    if (data->timecodesFile) {
+        std::ostringstream stream;
+        stream.imbue(std::locale("C"));
+        stream.setf(std::ios::fixed, std::ios::floatfield);
+        stream << (data->currentTimecodeNum * 1000 / static_cast<double>(data->currentTimecodeDen));
+        if (fprintf(data->timecodesFile, "%s\n", stream.str().c_str()) < 0) {
+            error = "Error: failed to write timecode for frame " + std::to_string(n) + ". errno: " + std::to_string(errno);
+            return false;
+        }
 
-        bool completed = isCompletedFrame(data->reorderMap[n], !!data->alphaNode);
+        const VSMap *props = data->vsapi->getFramePropertiesRO(frame);
+        int err_num, err_den;
+        int64_t duration_num = data->vsapi->mapGetInt(props, "_DurationNum", 0, &err_num);
+        int64_t duration_den = data->vsapi->mapGetInt(props, "_DurationDen", 0, &err_den);
 
-        if (completed && data->requestedFrames < data->totalFrames) {
-            data->vsapi->getFrameAsync(data->requestedFrames, data->node, frameDoneCallback, userData);
-            if (data->alphaNode)
-                data->vsapi->getFrameAsync(data->requestedFrames, data->alphaNode, frameDoneCallback, userData);
-            data->requestedFrames++;
-        }
-
-        while (data->reorderMap.count(data->outputFrames) && isCompletedFrame(data->reorderMap[data->outputFrames], !!data->alphaNode)) {
-            const VSFrame *frame = data->reorderMap[data->outputFrames].first;
-            const VSFrame *alphaFrame = data->reorderMap[data->outputFrames].second;
-            data->reorderMap.erase(data->outputFrames);
-            if (!data->outputError) {
-                if (data->outputHeaders == VSPipeHeaders::Y4M && data->outFile) {
-                    if (fwrite("FRAME\n", 1, 6, data->outFile) != 6) {
-                        if (data->errorMessage.empty())
-                            data->errorMessage = "Error: fwrite() call failed when writing header, errno: " + std::to_string(errno);
-                        data->totalFrames = data->requestedFrames;
-                        data->outputError = true;
-                    }
-                }
+        if (err_num || err_den) {
+            error = "Error: missing duration at frame " + std::to_string(n);
+            return false;
+        } else if (!duration_den) {
+            error = "Error: duration denominator is zero at frame " + std::to_string(n);
+            return false;
+        }
 
-                outputFrame(frame, data);
-                if (alphaFrame)
-                    outputFrame(alphaFrame, data);
-
-                if (data->timecodesFile && !data->outputError) {
-                    std::ostringstream stream;
-                    stream.imbue(std::locale("C"));
-                    stream.setf(std::ios::fixed, std::ios::floatfield);
-                    stream << (data->currentTimecodeNum * 1000 / static_cast<double>(data->currentTimecodeDen));
-                    if (fprintf(data->timecodesFile, "%s\n", stream.str().c_str()) < 0) {
-                        if (data->errorMessage.empty())
-                            data->errorMessage = "Error: failed to write timecode for frame " + std::to_string(data->outputFrames) + ". errno: " + std::to_string(errno);
-                        data->totalFrames = data->requestedFrames;
-                        data->outputError = true;
-                    } else {
-                        const VSMap *props = data->vsapi->getFramePropertiesRO(frame);
-                        int err_num, err_den;
-                        int64_t duration_num = data->vsapi->mapGetInt(props, "_DurationNum", 0, &err_num);
-                        int64_t duration_den = data->vsapi->mapGetInt(props, "_DurationDen", 0, &err_den);
-
-                        if (err_num || err_den || !duration_den) {
-                            if (data->errorMessage.empty()) {
-                                if (err_num || err_den)
-                                    data->errorMessage = "Error: missing duration at frame ";
-                                else if (!duration_den)
-                                    data->errorMessage = "Error: duration denominator is zero at frame ";
-                                data->errorMessage += std::to_string(data->outputFrames);
-                            }
-
-                            data->totalFrames = data->requestedFrames;
-                            data->outputError = true;
-                        } else {
-                            addRational(&data->currentTimecodeNum, &data->currentTimecodeDen, duration_num, duration_den);
-                        }
-                    }
-                }
+        addRational(&data->currentTimecodeNum, &data->currentTimecodeDen, duration_num, duration_den);
+    }
 
-                if (data->jsonFile && !data->outputError) {
-                    if (fprintf(data->jsonFile, "\t%s%s\n", convertVSMapToJSON(data->vsapi->getFramePropertiesRO(frame), data->vsapi).c_str(), (data->totalFrames - 1 != data->outputFrames) ? "," : "") < 0) {
-                        if (data->errorMessage.empty())
-                            data->errorMessage = "Error: failed to write JSON for frame " + std::to_string(data->outputFrames) + ". errno: " + std::to_string(errno);
-                        data->totalFrames = data->requestedFrames;
-                        data->outputError = true;
-                    }
-                }
+    if (data->jsonFile) {
+        if (fprintf(data->jsonFile, "\t%s%s\n", convertVSMapToJSON(data->vsapi->getFramePropertiesRO(frame), data->vsapi).c_str(), lastFrame ? "" : ",") < 0) {
+            error = "Error: failed to write JSON for frame " + std::to_string(n) + ". errno: " + std::to_string(errno);
+            return false;
+        }
+    }
+
+    if (data->checksumFile || data->verifyChecksums) {
+        std::string record = std::to_string(n) + " " + data->checksums.planes[n];
+        std::string().swap(data->checksums.planes[n]);
+        if (alphaFrame) {
+            record += " " + data->alphaChecksums.planes[n];
+            std::string().swap(data->alphaChecksums.planes[n]);
+        }
+        if (data->checksums.hashProperties) {
+            record += " " + data->checksums.properties[n];
+            std::string().swap(data->checksums.properties[n]);
+        }
+
+        if (data->checksumFile && fprintf(data->checksumFile, "%s\n", record.c_str()) < 0) {
+            error = "Error: failed to write checksums for frame " + std::to_string(n) + ". errno: " + std::to_string(errno);
+            return false;
+        }
+
+        if (data->verifyChecksums) {
+            if (static_cast<size_t>(n) >= data->verifyRecords.size()) {
+                error = "Error: frame " + std::to_string(n) + " is missing from the checksum manifest";
+                return false;
+            } else if (record != data->verifyRecords[n]) {
+                error = "Error: checksum mismatch at frame " + std::to_string(n) + "\nExpected: " + data->verifyRecords[n] + "\nGot:      " + record;
+                return false;
             }
-            data->vsapi->freeFrame(frame);
-            data->vsapi->freeFrame(alphaFrame);
-            data->outputFrames++;
+            std::string().swap(data->verifyRecords[n]);
         }
+    }
+
+    return true;
+}
+
+static void printProgress(VSPipeOutputData *data, int completedFrames, int totalFrames, uint64_t outputBytes) {
+    std::chrono::time_point<std::chrono::steady_clock> currentTime(std::chrono::steady_clock::now());
+    std::chrono::duration<double> elapsedSeconds = currentTime - data->lastFPSReportTime;
+    std::chrono::duration<double> elapsedSecondsFromStart = currentTime - data->startTime;
+
+    if (completedFrames > 1 && elapsedSeconds.count() <= .5)
+        return;
+    data->lastFPSReportTime = currentTime;
+
+    bool hasMeaningfulFPS = (elapsedSecondsFromStart.count() > 8);
+    double fps = hasMeaningfulFPS ? completedFrames / elapsedSecondsFromStart.count() : 0;
+    double gbps = hasMeaningfulFPS ? outputBytes / elapsedSecondsFromStart.count() / 1e9 : 0;
+
+    if (data->vsapi->getNodeType(data->node) == mtVideo) {
+        if (hasMeaningfulFPS && data->outFile)
+            fprintf(stderr, "Frame: %d/%d (%.2f fps, %.2f GB/s)\r", completedFrames, totalFrames, fps, gbps);
+        else if (hasMeaningfulFPS)
+            fprintf(stderr, "Frame: %d/%d (%.2f fps)\r", completedFrames, totalFrames, fps);
+        else
+            fprintf(stderr, "Frame: %d/%d\r", completedFrames, totalFrames);
     } else {
-        data->outputError = true;
-        data->totalFrames = data->requestedFrames;
-        if (data->errorMessage.empty()) {
-            if (errorMsg)
-                data->errorMessage = "Error: Failed to retrieve frame " + std::to_string(n) + " with error: " + errorMsg;
-            else
-                data->errorMessage = "Error: Failed to retrieve frame " + std::to_string(n);
-        }
+        if (hasMeaningfulFPS)
+            fprintf(stderr, "Sample: %" PRId64 "/%" PRId64 " (%.2f sps)\r", static_cast<int64_t>(completedFrames * VS_AUDIO_FRAME_SAMPLES), static_cast<int64_t>(totalFrames * VS_AUDIO_FRAME_SAMPLES), fps);
+        else
+            fprintf(stderr, "Sample: %" PRId64 "/%" PRId64 "\r", static_cast<int64_t>(completedFrames * VS_AUDIO_FRAME_SAMPLES), static_cast<int64_t>(totalFrames * VS_AUDIO_FRAME_SAMPLES));
+    }
+}
+
+// We must *not* proceed to cleanup here: the worker threads might still be running, and cleaning up will probably
+// just trigger SIGSEGV in them. exit() still flushes the frames that were completely written.
+static void exitInterrupted(VSPipeOutputData *data) {
+    std::call_once(interruptReported, [data] {
+        fprintf(stderr, "%sInterrupted after %d/%d frames\n", data->printProgress ? "\n" : "", data->outputFrames, data->totalFrames);
+        exit(1);
+    });
+}
+
+// Waits on the condition like the writer otherwise would but wakes up now and then to check for Ctrl-C
+template <typename Predicate>
+static void waitOrInterrupt(VSPipeOutputData *data, std::unique_lock<std::mutex> &lock, Predicate predicate) {
+    while (!data->condition.wait_for(lock, std::chrono::milliseconds(100), predicate)) {
+        if (interrupted)
+            exitInterrupted(data);
+    }
+}
+
+// Frame callbacks only park the frame in its ring slot and top up the requests, all writing happens here
+static void writerThread(VSPipeOutputData *data) {
+    bool hasAlpha = !!data->alphaNode;
+    size_t ringSize = data->ring.size();
+    std::unique_lock<std::mutex> lock(data->mutex);
+
+    while (true) {
+        if (interrupted)
+            exitInterrupted(data);
+
+        waitOrInterrupt(data, lock, [data, hasAlpha, ringSize] {
+            return data->outputError || data->outputFrames >= data->totalFrames || isCompletedFrame(data->ring[data->outputFrames % ringSize], hasAlpha);
+        });
+
+        if (data->outputError || data->outputFrames >= data->totalFrames)
+            break;
+
+        int n = data->outputFrames;
+        std::pair<const VSFrame *, const VSFrame *> slot = data->ring[n % ringSize];
+        data->ring[n % ringSize] = {};
+        bool lastFrame = (n == data->totalFrames - 1);
+        lock.unlock();
+
+        std::string error;
+        bool success = writeFrame(slot.first, slot.second, n, lastFrame, data, error);
+        data->vsapi->freeFrame(slot.first);
+        data->vsapi->freeFrame(slot.second);
+
+        lock.lock();
+        data->outputFrames++;
+        if (!success)
+            setOutputError(data, error);
+
+        int first;
+        int count = claimRequests(data, first);
+        int completedFrames = data->completedFrames;
+        int totalFrames = data->totalFrames;
+        bool outputError = data->outputError;
+
+        lock.unlock();
+        requestFrames(data, first, count);
+        // A failed output no longer holds the others back, they may be waiting for it
+        if ((count || !success) && data->group)
+            requestGroupFrames(data->group);
+        if (data->printProgress && !outputError)
+            printProgress(data, completedFrames, totalFrames, data->outputBytes);
+        lock.lock();
+    }
+
+    // Wait for the outstanding requests so every frame still in the ring can be released
+    waitOrInterrupt(data, lock, [data] {
+        return data->completedFrames == data->requestedFrames && data->completedAlphaFrames == data->requestedFrames;
+    });
+
+    for (auto &iter : data->ring) {
+        data->vsapi->freeFrame(iter.first);
+        data->vsapi->freeFrame(iter.second);
+        iter = {};
     }
 
-    if (printToConsole && !data->outputError) {
-        if (data->vsapi->getNodeType(rnode) == mtVideo) {
-            if (hasMeaningfulFPS)
-                fprintf(stderr, "Frame: %d/%d (%.2f fps)\r", data->completedFrames, data->totalFrames, fps);
+#ifdef VS_TARGET_OS_LINUX
+    lock.unlock();
+    releaseSplicedFrames(data, true);
+#endif
+}
+
+static void VS_CC frameDoneCallback(void *userData, const VSFrame *f, int n, VSNode *rnode, const char *errorMsg) {
+    VSPipeOutputData *data = reinterpret_cast<VSPipeOutputData *>(userData);
+    VSPipeOutputGroup *group = data->group;
+
+    if (group) {
+        std::lock_guard<std::mutex> lock(group->mutex);
+        group->activeCallbacks++;
+    }
+
+    int first;
+    int count;
+
+    {
+        std::lock_guard<std::mutex> lock(data->mutex);
+
+        // completed frames simply correspond to how many times the completion callback is called
+        if (rnode == data->node) {
+            data->completedFrames++;
+            if (!data->alphaNode)
+                data->completedAlphaFrames++;
+        } else {
+            data->completedAlphaFrames++;
+        }
+
+        if (f) {
+            auto &slot = data->ring[n % data->ring.size()];
+            if (rnode == data->node)
+                slot.first = f;
             else
-                fprintf(stderr, "Frame: %d/%d\r", data->completedFrames, data->totalFrames);
+                slot.second = f;
         } else {
-            if (hasMeaningfulFPS)
-                fprintf(stderr, "Sample: %" PRId64 "/%" PRId64 " (%.2f sps)\r", static_cast<int64_t>(data->completedFrames * VS_AUDIO_FRAME_SAMPLES), static_cast<int64_t>(data->totalFrames * VS_AUDIO_FRAME_SAMPLES), fps);
+            if (errorMsg)
+                setOutputError(data, "Error: Failed to retrieve frame " + std::to_string(n) + " with error: " + errorMsg);
             else
-                fprintf(stderr, "Sample: %" PRId64 "/%" PRId64 "\r", static_cast<int64_t>(data->completedFrames * VS_AUDIO_FRAME_SAMPLES), static_cast<int64_t>(data->totalFrames * VS_AUDIO_FRAME_SAMPLES));
+                setOutputError(data, "Error: Failed to retrieve frame " + std::to_string(n));
         }
-    }
 
-    if (data->totalFrames == data->completedFrames && data->totalFrames == data->completedAlphaFrames) {
-        std::lock_guard<std::mutex> lock(data->mutex);
+        if (data->adaptiveRequests && f && rnode == data->node)
+            updateRequestWindow(data);
+
+        count = claimRequests(data, first);
         data->condition.notify_one();
     }
+
+    // Only touch data when new requests were claimed, the writer may already be done with it otherwise
+    if (count)
+        requestFrames(data, first, count);
+
+    if (group) {
+        if (count || !f)
+            requestGroupFrames(group);
+        std::lock_guard<std::mutex> lock(group->mutex);
+        group->activeCallbacks--;
+        group->condition.notify_all();
+    }
 }
 
 static std::string floatBitsToLetter(int bits) {
@@ -472,6 +1020,50 @@ static bool initializeVideoOutput(VSPipeOutputData *data) {
         return false;
     }
 
+    if (data->pack != VSPipePack::None) {
+        static const struct {
+            VSPipePack pack;
+            const char *name;
+            int colorFamily;
+            int bits;
+            int subSamplingW;
+            int subSamplingH;
+        } packFormats[] = {
+            { VSPipePack::RGB24, "rgb24", cfRGB, 8, 0, 0 },
+            { VSPipePack::BGRA, "bgra", cfRGB, 8, 0, 0 },
+            { VSPipePack::YUYV, "yuyv", cfYUV, 8, 1, 0 },
+            { VSPipePack::V210, "v210", cfYUV, 10, 1, 0 },
+            { VSPipePack::P010, "p010", cfYUV, 10, 1, 1 }
+        };
+
+        for (const auto &iter : packFormats) {
+            if (iter.pack != data->pack)
+                continue;
+
+            if (vi->format.colorFamily != iter.colorFamily || vi->format.sampleType != stInteger || vi->format.bitsPerSample != iter.bits ||
+                vi->format.subSamplingW != iter.subSamplingW || vi->format.subSamplingH != iter.subSamplingH || !vi->width || !vi->height) {
+                char nameBuffer[32];
+                VSVideoFormat format;
+                data->vsapi->queryVideoFormat(&format, iter.colorFamily, stInteger, iter.bits, iter.subSamplingW, iter.subSamplingH, nullptr);
+                data->vsapi->getVideoFormatName(&format, nameBuffer);
+                fprintf(stderr, "Error: %s output requires a constant size %s clip\n", iter.name, nameBuffer);
+                return false;
+            }
+
+            if (data->alphaNode && data->pack != VSPipePack::BGRA) {
+                fprintf(stderr, "Error: alpha can only be output packed together with the color planes as bgra\n");
+                return false;
+            }
+        }
+
+        if (data->outputHeaders == VSPipeHeaders::Y4M) {
+            fprintf(stderr, "Error: y4m headers can't be combined with packed output\n");
+            return false;
+        }
+
+        data->buffer.resize(packedFrameSize(data->pack, vi->width, vi->height) + VideoPackOverwrite);
+    }
+
     std::string y4mFormat;
 
     if (data->outputHeaders == VSPipeHeaders::Y4M) {
@@ -524,114 +1116,768 @@ static bool initializeVideoOutput(VSPipeOutputData *data) {
         }
     }
 
-    if (data->timecodesFile && !data->outputError) {
-        if (fprintf(data->timecodesFile, "# timecode format v2\n") < 0) {
-            fprintf(stderr, "Error: failed to write timecodes file header, errno: %d\n", errno);
+    if (data->timecodesFile && !data->outputError) {
+        if (fprintf(data->timecodesFile, "# timecode format v2\n") < 0) {
+            fprintf(stderr, "Error: failed to write timecodes file header, errno: %d\n", errno);
+            return false;
+        }
+    }
+
+    if (data->jsonFile && !data->outputError) {
+        if (fprintf(data->jsonFile, "%s", "[\n") < 0) {
+            fprintf(stderr, "Error: failed to write JSON file header, errno: %d\n", errno);
+            return false;
+        }
+    }
+
+    // Packed frames are written from the shared buffer so they always go through stdio
+    if (data->pack != VSPipePack::None) {
+        data->directOutput = false;
+        return true;
+    }
+
+#ifdef VS_TARGET_OS_LINUX
+    // Everything after the headers bypasses stdio, vmsplice() is used when the output is a pipe
+    if (data->outFile && data->directOutput) {
+        if (fflush(data->outFile)) {
+            fprintf(stderr, "Error: fflush() call failed when writing initial header, errno: %d\n", errno);
+            return false;
+        }
+
+        struct stat st;
+        data->outFd = fileno(data->outFile);
+        if (!fstat(data->outFd, &st) && S_ISFIFO(st.st_mode))
+            data->pipeSize = fcntl(data->outFd, F_GETPIPE_SZ);
+        data->spliceOutput = data->pipeSize > 0;
+        return true;
+    }
+#endif
+    data->directOutput = false;
+
+    data->buffer.resize(vi->width * vi->height * vi->format.bytesPerSample);
+    return true;
+}
+
+static bool finalizeVideoOutput(VSPipeOutputData *data) {
+    if (data->jsonFile && !data->outputError) {
+        if (fprintf(data->jsonFile, "%s", "]\n") < 0) {
+            fprintf(stderr, "Error: failed to finalize JSON file, errno: %d\n", errno);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool initializeAudioOutput(VSPipeOutputData *data) {
+    if (data->outputHeaders != VSPipeHeaders::None && data->outputHeaders != VSPipeHeaders::WAVE && data->outputHeaders != VSPipeHeaders::WAVE64) {
+        fprintf(stderr, "Error: can't apply apply selected header type to audio\n");
+        return false;
+    }
+
+    if (data->pack != VSPipePack::None) {
+        fprintf(stderr, "Error: packed output can only be used with video\n");
+        return false;
+    }
+
+    const VSAudioInfo *ai = data->vsapi->getAudioInfo(data->node);
+
+    if (data->outputHeaders == VSPipeHeaders::WAVE64) {
+        Wave64Header header;
+        if (!CreateWave64Header(header, ai->format.sampleType == stFloat, ai->format.bitsPerSample, ai->sampleRate, ai->format.channelLayout, ai->numSamples)) {
+            fprintf(stderr, "Error: cannot create valid w64 header\n");
+            return false;
+        }
+        if (data->outFile) {
+            if (fwrite(&header, 1, sizeof(header), data->outFile) != sizeof(header)) {
+                fprintf(stderr, "Error: fwrite() call failed when writing initial header, errno: %d\n", errno);
+                return false;
+            }
+        }
+    } else if (data->outputHeaders == VSPipeHeaders::WAVE) {
+        WaveHeader header;
+        if (!CreateWaveHeader(header, ai->format.sampleType == stFloat, ai->format.bitsPerSample, ai->sampleRate, ai->format.channelLayout, ai->numSamples)) {
+            fprintf(stderr, "Error: cannot create valid wav header\n");
+            return false;
+        }
+
+        if (data->outFile) {
+            if (fwrite(&header, 1, sizeof(header), data->outFile) != sizeof(header)) {
+                fprintf(stderr, "Error: fwrite() call failed when writing initial header, errno: %d\n", errno);
+                return false;
+            }
+        }
+    }
+
+    data->buffer.resize(ai->format.numChannels * VS_AUDIO_FRAME_SAMPLES * ai->format.bytesPerSample);
+    return true;
+}
+
+static std::string hashToString(uint64_t hash) {
+    char buf[17];
+    snprintf(buf, sizeof(buf), "%016" PRIx64, hash);
+    return buf;
+}
+
+static const VSFrame *VS_CC checksumGetFrame(int n, int activationReason, void *instanceData, void **frameData, VSFrameContext *frameCtx, VSCore *core, const VSAPI *vsapi) {
+    VSPipeChecksumFilterData *d = reinterpret_cast<VSPipeChecksumFilterData *>(instanceData);
+
+    if (activationReason == arInitial) {
+        vsapi->requestFrameFilter(n, d->node, frameCtx);
+    } else if (activationReason == arAllFramesReady) {
+        const VSFrame *frame = vsapi->getFrameFilter(n, d->node, frameCtx);
+
+        std::string planes;
+        if (vsapi->getFrameType(frame) == mtVideo) {
+            const VSVideoFormat *fi = vsapi->getVideoFrameFormat(frame);
+            for (int p = 0; p < fi->numPlanes; p++) {
+                const uint8_t *readPtr = vsapi->getReadPtr(frame, p);
+                ptrdiff_t stride = vsapi->getStride(frame, p);
+                size_t rowSize = vsapi->getFrameWidth(frame, p) * fi->bytesPerSample;
+                int height = vsapi->getFrameHeight(frame, p);
+
+                XXH64_CTX ctx;
+                XXH64_Init(&ctx, 0);
+                if (static_cast<ptrdiff_t>(rowSize) == stride) {
+                    XXH64_Update(&ctx, readPtr, rowSize * height);
+                } else {
+                    for (int y = 0; y < height; y++)
+                        XXH64_Update(&ctx, readPtr + y * stride, rowSize);
+                }
+                planes += (p ? " " : "") + hashToString(XXH64_Final(&ctx));
+            }
+        } else {
+            const VSAudioFormat *fi = vsapi->getAudioFrameFormat(frame);
+            size_t size = static_cast<size_t>(vsapi->getFrameLength(frame)) * fi->bytesPerSample;
+            for (int c = 0; c < fi->numChannels; c++) {
+                XXH64_CTX ctx;
+                XXH64_Init(&ctx, 0);
+                XXH64_Update(&ctx, vsapi->getReadPtr(frame, c), size);
+                planes += (c ? " " : "") + hashToString(XXH64_Final(&ctx));
+            }
+        }
+        d->checksums->planes[n] = std::move(planes);
+
+        if (d->checksums->hashProperties) {
+            std::string props = convertVSMapToJSON(vsapi->getFramePropertiesRO(frame), vsapi);
+            XXH64_CTX ctx;
+            XXH64_Init(&ctx, 0);
+            XXH64_Update(&ctx, props.data(), props.size());
+            d->checksums->properties[n] = hashToString(XXH64_Final(&ctx));
+        }
+
+        return frame;
+    }
+
+    return nullptr;
+}
+
+static void VS_CC checksumFree(void *instanceData, VSCore *core, const VSAPI *vsapi) {
+    VSPipeChecksumFilterData *d = reinterpret_cast<VSPipeChecksumFilterData *>(instanceData);
+    vsapi->freeNode(d->node);
+    delete d;
+}
+
+// Puts a pass-through filter after the node that hashes every frame on the worker thread that produced it
+static VSNode *createChecksumNode(VSNode *node, VSPipeChecksums *checksums, const VSAPI *vsapi, VSCore *core) {
+    VSPipeChecksumFilterData *d = new VSPipeChecksumFilterData{ vsapi->addNodeRef(node), checksums };
+    VSFilterDependency deps[] = { { node, rpStrictSpatial } };
+    if (vsapi->getNodeType(node) == mtVideo) {
+        checksums->planes.resize(vsapi->getVideoInfo(node)->numFrames);
+        return vsapi->createVideoFilter2("VSPipeChecksum", vsapi->getVideoInfo(node), checksumGetFrame, checksumFree, fmParallel, deps, 1, d, core);
+    } else {
+        checksums->planes.resize(vsapi->getAudioInfo(node)->numFrames);
+        return vsapi->createAudioFilter2("VSPipeChecksum", vsapi->getAudioInfo(node), checksumGetFrame, checksumFree, fmParallel, deps, 1, d, core);
+    }
+}
+
+static bool initializeChecksums(const VSPipeOptions &opts, VSPipeOutputData *data, VSCore *core) {
+    if (opts.checksumFilename.empty() && opts.verifyFilename.empty())
+        return true;
+
+    const VSAPI *vsapi = data->vsapi;
+    int numPlanes = (vsapi->getNodeType(data->node) == mtVideo) ? vsapi->getVideoInfo(data->node)->format.numPlanes : vsapi->getAudioInfo(data->node)->format.numChannels;
+    int numAlphaPlanes = data->alphaNode ? vsapi->getVideoInfo(data->alphaNode)->format.numPlanes : 0;
+    data->checksumHeader = "# vspipe checksum manifest xxh64 planes=" + std::to_string(numPlanes) + " alpha=" + std::to_string(numAlphaPlanes) + " props=" + (opts.checksumProperties ? "1" : "0");
+
+    if (!opts.verifyFilename.empty()) {
+#ifdef VS_TARGET_OS_WINDOWS
+        std::ifstream file(opts.verifyFilename.c_str());
+#else
+        std::ifstream file(opts.verifyFilename);
+#endif
+        std::string line;
+        if (!file || !std::getline(file, line)) {
+            fprintf(stderr, "Failed to read checksum manifest\n");
+            return false;
+        } else if (line != data->checksumHeader) {
+            fprintf(stderr, "Checksum manifest settings don't match the output, expected: %s\n", data->checksumHeader.c_str());
+            return false;
+        }
+
+        while (std::getline(file, line))
+            data->verifyRecords.push_back(line);
+        data->verifyChecksums = true;
+    }
+
+    if (!opts.checksumFilename.empty()) {
+#ifdef VS_TARGET_OS_WINDOWS
+        data->checksumFile = _wfopen(opts.checksumFilename.c_str(), L"wb");
+#else
+        data->checksumFile = fopen(opts.checksumFilename.c_str(), "wb");
+#endif
+        if (!data->checksumFile) {
+            fprintf(stderr, "Failed to open checksum manifest for writing\n");
+            return false;
+        }
+
+        if (fprintf(data->checksumFile, "%s\n", data->checksumHeader.c_str()) < 0) {
+            fprintf(stderr, "Error: failed to write checksum manifest header, errno: %d\n", errno);
+            return false;
+        }
+    }
+
+    data->checksums.hashProperties = opts.checksumProperties;
+    data->node = createChecksumNode(data->node, &data->checksums, vsapi, core);
+    if (data->checksums.hashProperties)
+        data->checksums.properties.resize(data->checksums.planes.size());
+    if (data->alphaNode)
+        data->alphaNode = createChecksumNode(data->alphaNode, &data->alphaChecksums, vsapi, core);
+    return true;
+}
+
+static int getDefaultRequests(const VSPipeOptions &opts, const VSAPI *vsapi, VSCore *core) {
+    if (opts.requests > 0)
+        return opts.requests;
+    VSCoreInfo info;
+    vsapi->getCoreInfo(core, &info);
+    return info.numThreads;
+}
+
+// Starts the writer thread and issues the first requests, the rest is driven by the frame callbacks. Passing a core
+// makes the number of requests adapt to the throughput and memory use, starting out at requests.
+static std::thread startOutput(VSPipeOutputData *data, int requests, VSCore *adaptiveCore) {
+#ifndef VS_TARGET_OS_WINDOWS
+    signal(SIGINT, sigintHandler);
+#endif
+
+    // Outputs in a group may already be asked to request frames by the others
+    std::unique_lock<std::mutex> lock(data->mutex);
+
+    data->requests = requests;
+    data->core = adaptiveCore;
+    data->adaptiveRequests = !!adaptiveCore;
+    if (data->adaptiveRequests)
+        vsRequestWindowInit(&data->requestWindow, requests, std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count());
+
+    // Frames that are done but not yet written wait in the ring, twice the number of requests leaves room
+    // for the writer to fall behind a bit before fewer frames are requested
+    int maxRequests = data->adaptiveRequests ? data->requestWindow.maxWindow : requests;
+    data->ring.assign(static_cast<size_t>(maxRequests) * 2, {});
+
+    data->startTime = std::chrono::steady_clock::now();
+    data->lastFPSReportTime = std::chrono::steady_clock::now();
+
+    int first;
+    int count = claimRequests(data, first);
+    lock.unlock();
+
+    std::thread writer(writerThread, data);
+    requestFrames(data, first, count);
+    if (count && data->group)
+        requestGroupFrames(data->group);
+
+    return writer;
+}
+
+static bool finishOutput(VSPipeOutputData *data, std::thread &writer) {
+    writer.join();
+
+    if (data->outputError)
+        fprintf(stderr, "%s\n", data->errorMessage.c_str());
+
+    return data->outputError;
+}
+
+static bool outputNode(const VSPipeOptions &opts, VSPipeOutputData *data, VSCore *core) {
+    VSNode *node = data->node;
+    VSNode *alphaNode = data->alphaNode;
+
+    data->startTime = std::chrono::steady_clock::now();
+    bool error = !initializeChecksums(opts, data, core);
+    if (!error) {
+        std::thread writer = startOutput(data, getDefaultRequests(opts, data->vsapi, core), (opts.requests > 0) ? nullptr : core);
+        error = finishOutput(data, writer);
+    }
+
+    if (!error && data->verifyChecksums && data->verifyRecords.size() != static_cast<size_t>(data->totalFrames)) {
+        fprintf(stderr, "Error: checksum manifest has %d frames but %d were output\n", static_cast<int>(data->verifyRecords.size()), data->totalFrames);
+        error = true;
+    } else if (!error && data->verifyChecksums) {
+        fprintf(stderr, "Checksums match for all %d frames\n", data->totalFrames);
+    }
+
+    // Drop the checksum filters again, the caller still owns the original nodes
+    if (data->node != node) {
+        data->vsapi->freeNode(data->node);
+        data->node = node;
+    }
+    if (data->alphaNode != alphaNode) {
+        data->vsapi->freeNode(data->alphaNode);
+        data->alphaNode = alphaNode;
+    }
+    if (data->checksumFile) {
+        fclose(data->checksumFile);
+        data->checksumFile = nullptr;
+    }
+
+    return error;
+}
+
+// Expands the single %d field in a segment output pattern, zero padding and a width are allowed and %% is a literal %
+static bool formatSegmentFilename(const nstring &pattern, int index, nstring &result) {
+    result.clear();
+    int fields = 0;
+    for (size_t i = 0; i < pattern.size(); i++) {
+        if (pattern[i] != '%') {
+            result += pattern[i];
+            continue;
+        }
+
+        if (++i < pattern.size() && pattern[i] == '%') {
+            result += '%';
+            continue;
+        }
+
+        bool zeroPad = (i < pattern.size() && pattern[i] == '0');
+        if (zeroPad)
+            i++;
+        size_t width = 0;
+        while (i < pattern.size() && pattern[i] >= '0' && pattern[i] <= '9' && width < 100)
+            width = width * 10 + (pattern[i++] - '0');
+        if (i >= pattern.size() || pattern[i] != 'd')
+            return false;
+
+        std::string number = std::to_string(index);
+        if (number.size() < width)
+            number.insert(0, width - number.size(), zeroPad ? '0' : ' ');
+        result.append(number.begin(), number.end());
+        fields++;
+    }
+    return fields == 1;
+}
+
+static VSNode *trimNode(VSNode *node, int64_t first, int64_t last, VSPlugin *stdPlugin, const VSAPI *vsapi) {
+    VSMap *args = vsapi->createMap();
+    vsapi->mapSetNode(args, "clip", node, maAppend);
+    vsapi->mapSetInt(args, "first", first, maAppend);
+    vsapi->mapSetInt(args, "last", last, maAppend);
+    VSMap *result = vsapi->invoke(stdPlugin, (vsapi->getNodeType(node) == mtVideo) ? "Trim" : "AudioTrim", args);
+    vsapi->freeMap(args);
+
+    VSNode *trimmed = nullptr;
+    if (vsapi->mapGetError(result))
+        fprintf(stderr, "%s\n", vsapi->mapGetError(result));
+    else
+        trimmed = vsapi->mapGetNode(result, "clip", 0, nullptr);
+    vsapi->freeMap(result);
+    return trimmed;
+}
+
+// Renders several prepared outputs at the same time and waits for all of them to finish
+static bool runOutputs(const VSPipeOptions &opts, std::vector<std::unique_ptr<VSPipeOutputData>> &outputs, int requests, VSCore *core) {
+    std::vector<std::thread> writers;
+    for (auto &data : outputs)
+        writers.push_back(startOutput(data.get(), requests, (opts.requests > 0) ? nullptr : core));
+
+    // The writers don't report progress themselves since they'd overwrite each other's lines
+    while (opts.printProgress) {
+        int completedFrames = 0;
+        int totalFrames = 0;
+        uint64_t outputBytes = 0;
+        bool done = true;
+        for (auto &data : outputs) {
+            std::lock_guard<std::mutex> lock(data->mutex);
+            completedFrames += data->completedFrames;
+            totalFrames += data->totalFrames;
+            outputBytes += data->outputBytes;
+            done = done && (data->outputError || data->outputFrames >= data->totalFrames);
+        }
+        if (done)
+            break;
+        printProgress(outputs.front().get(), completedFrames, totalFrames, outputBytes);
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+
+    bool success = true;
+    for (size_t i = 0; i < outputs.size(); i++) {
+        if (finishOutput(outputs[i].get(), writers[i]))
+            success = false;
+    }
+
+    VSPipeOutputGroup *group = outputs.front()->group;
+    if (group) {
+        std::unique_lock<std::mutex> lock(group->mutex);
+        group->condition.wait(lock, [group] { return group->activeCallbacks == 0; });
+    }
+
+    return success;
+}
+
+// Splits the range into consecutive segments that are rendered to separate outputs at the same time. They all share
+// one core so the script is only evaluated once and the caches and memory budget are shared, the requests are divided
+// evenly between them.
+static bool outputSegments(const VSPipeOptions &opts, VSNode *node, VSNode *alphaNode, const VSAPI *vsapi, VSCore *core) {
+    int nodeType = vsapi->getNodeType(node);
+    int64_t length;
+    if (nodeType == mtVideo) {
+        const VSVideoInfo *vi = vsapi->getVideoInfo(node);
+        if (!isConstantVideoFormat(vi)) {
+            fprintf(stderr, "Cannot output clips with varying dimensions\n");
             return false;
         }
+        length = vi->numFrames;
+    } else {
+        length = vsapi->getAudioInfo(node)->numSamples;
     }
 
-    if (data->jsonFile && !data->outputError) {
-        if (fprintf(data->jsonFile, "%s", "[\n") < 0) {
-            fprintf(stderr, "Error: failed to write JSON file header, errno: %d\n", errno);
-            return false;
+    int64_t first = opts.startPos;
+    int64_t last = (opts.endPos > -1) ? opts.endPos : length - 1;
+    if (first > last || last >= length) {
+        fprintf(stderr, "Invalid range specified\n");
+        return false;
+    } else if (opts.segments > last - first + 1) {
+        fprintf(stderr, "Cannot split %" PRId64 " %s into %d segments\n", last - first + 1, (nodeType == mtVideo) ? "frames" : "samples", opts.segments);
+        return false;
+    }
+
+    VSPlugin *stdPlugin = vsapi->getPluginByID(VSH_STD_PLUGIN_ID, core);
+    int requests = std::max(1, getDefaultRequests(opts, vsapi, core) / opts.segments);
+
+    std::vector<std::unique_ptr<VSPipeOutputData>> segments;
+    bool success = true;
+
+    for (int i = 0; i < opts.segments && success; i++) {
+        int64_t segmentFirst = first + (last - first + 1) * i / opts.segments;
+        int64_t segmentLast = first + (last - first + 1) * (i + 1) / opts.segments - 1;
+
+        segments.emplace_back(new VSPipeOutputData());
+        VSPipeOutputData *data = segments.back().get();
+        data->vsapi = vsapi;
+        data->outputHeaders = opts.outputHeaders;
+        data->pack = opts.pack;
+        data->directOutput = opts.directOutput;
+        data->calculateMD5 = opts.calculateMD5;
+        MD5_Init(&data->md5Ctx);
+
+        data->node = trimNode(node, segmentFirst, segmentLast, stdPlugin, vsapi);
+        if (data->node && alphaNode)
+            data->alphaNode = trimNode(alphaNode, segmentFirst, segmentLast, stdPlugin, vsapi);
+        if (!data->node || (alphaNode && !data->alphaNode)) {
+            success = false;
+            break;
+        }
+
+        nstring filename;
+        formatSegmentFilename(opts.outputPattern, i, filename);
+#ifdef VS_TARGET_OS_WINDOWS
+        data->outFile = _wfopen(filename.c_str(), L"wb");
+#else
+        data->outFile = fopen(filename.c_str(), "wb");
+#endif
+        if (!data->outFile) {
+            fprintf(stderr, "Failed to open output for writing: %s\n", nstringToUtf8(filename).c_str());
+            success = false;
+            break;
+        }
+
+        if (nodeType == mtVideo) {
+            data->totalFrames = vsapi->getVideoInfo(data->node)->numFrames;
+            success = initializeVideoOutput(data);
+        } else {
+            data->totalFrames = vsapi->getAudioInfo(data->node)->numFrames;
+            data->totalSamples = vsapi->getAudioInfo(data->node)->numSamples;
+            success = initializeAudioOutput(data);
         }
     }
 
-    data->buffer.resize(vi->width * vi->height * vi->format.bytesPerSample);
-    return true;
-}
+    std::chrono::time_point<std::chrono::steady_clock> startTime(std::chrono::steady_clock::now());
 
-static bool finalizeVideoOutput(VSPipeOutputData *data) {
-    if (data->jsonFile && !data->outputError) {
-        if (fprintf(data->jsonFile, "%s", "]\n") < 0) {
-            fprintf(stderr, "Error: failed to finalize JSON file, errno: %d\n", errno);
-            return false;
+    if (success)
+        success = runOutputs(opts, segments, requests, core);
+
+    std::chrono::duration<double> elapsedSeconds = std::chrono::steady_clock::now() - startTime;
+
+    int totalFrames = 0;
+    int64_t totalSamples = 0;
+    uint64_t outputBytes = 0;
+    for (size_t i = 0; i < segments.size(); i++) {
+        VSPipeOutputData *data = segments[i].get();
+        if (success && nodeType == mtVideo)
+            success = finalizeVideoOutput(data);
+
+        unsigned char md5[16];
+        MD5_Final(md5, &data->md5Ctx);
+        if (success && opts.calculateMD5) {
+            fprintf(stderr, "MD5 (segment %d): ", static_cast<int>(i));
+            for (int j = 0; j < 16; j++)
+                fprintf(stderr, "%02x", (int)md5[j]);
+            fprintf(stderr, "\n");
         }
+
+        totalFrames += data->totalFrames;
+        totalSamples += data->totalSamples;
+        outputBytes += data->outputBytes;
+
+        if (data->outFile)
+            fclose(data->outFile);
+        vsapi->freeNode(data->node);
+        vsapi->freeNode(data->alphaNode);
     }
 
-    return true;
+    if (success) {
+        if (nodeType == mtVideo)
+            fprintf(stderr, "Output %d frames in %d segments in %.2f seconds (%.2f fps)\n", totalFrames, opts.segments, elapsedSeconds.count(), totalFrames / elapsedSeconds.count());
+        else
+            fprintf(stderr, "Output %" PRId64 " samples in %d segments in %.2f seconds (%.2f sps)\n", totalSamples, opts.segments, elapsedSeconds.count(), (totalFrames / elapsedSeconds.count()) * VS_AUDIO_FRAME_SAMPLES);
+        if (opts.printProgress)
+            fprintf(stderr, "Wrote %.2f GB (%.2f GB/s)\n", outputBytes / 1e9, outputBytes / elapsedSeconds.count() / 1e9);
+    }
+
+    return success;
 }
 
-static bool initializeAudioOutput(VSPipeOutputData *data) {
-    if (data->outputHeaders != VSPipeHeaders::None && data->outputHeaders != VSPipeHeaders::WAVE && data->outputHeaders != VSPipeHeaders::WAVE64) {
-        fprintf(stderr, "Error: can't apply apply selected header type to audio\n");
-        return false;
-    }
+static VSPipeHeaders headersFromExtension(const nstring &filename) {
+    size_t dotPos = filename.rfind(NSTRING("."));
+    if (dotPos == nstring::npos)
+        return VSPipeHeaders::None;
+    std::string extension = nstringToUtf8(filename.substr(dotPos + 1));
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return std::tolower(c); });
+    if (extension == "y4m")
+        return VSPipeHeaders::Y4M;
+    else if (extension == "wav")
+        return VSPipeHeaders::WAVE;
+    else if (extension == "w64")
+        return VSPipeHeaders::WAVE64;
+    return VSPipeHeaders::None;
+}
 
-    const VSAudioInfo *ai = data->vsapi->getAudioInfo(data->node);
+// Renders several outputs of the script to their own files in a single pass, the requests are divided evenly between them.
+// Since the outputs can be of different types the container headers are picked by the file extension.
+static bool outputMultiple(const VSPipeOptions &opts, const VSPipeSource &source, const VSAPI *vsapi) {
+    VSCore *core = source.core;
+    int requests = std::max(1, getDefaultRequests(opts, vsapi, core) / static_cast<int>(opts.outputs.size()));
 
-    if (data->outputHeaders == VSPipeHeaders::WAVE64) {
-        Wave64Header header;
-        if (!CreateWave64Header(header, ai->format.sampleType == stFloat, ai->format.bitsPerSample, ai->sampleRate, ai->format.channelLayout, ai->numSamples)) {
-            fprintf(stderr, "Error: cannot create valid w64 header\n");
-            return false;
+    VSPipeOutputGroup group;
+    std::vector<std::unique_ptr<VSPipeOutputData>> outputs;
+    bool success = true;
+
+    for (const auto &iter : opts.outputs) {
+        outputs.emplace_back(new VSPipeOutputData());
+        VSPipeOutputData *data = outputs.back().get();
+        data->vsapi = vsapi;
+        data->calculateMD5 = opts.calculateMD5;
+        MD5_Init(&data->md5Ctx);
+        data->group = &group;
+        group.outputs.push_back(data);
+
+        data->node = source.getOutputNode(iter.first);
+        if (!data->node) {
+            fprintf(stderr, "Failed to retrieve output node %d. Invalid index specified?\n", iter.first);
+            success = false;
+            break;
         }
-        if (data->outFile) {
-            if (fwrite(&header, 1, sizeof(header), data->outFile) != sizeof(header)) {
-                fprintf(stderr, "Error: fwrite() call failed when writing initial header, errno: %d\n", errno);
-                return false;
+        data->alphaNode = source.getOutputAlphaNode(iter.first);
+
+        if (iter.second == NSTRING("-")) {
+            data->outFile = stdout;
+        } else if (iter.second != NSTRING(".")) {
+#ifdef VS_TARGET_OS_WINDOWS
+            data->outFile = _wfopen(iter.second.c_str(), L"wb");
+#else
+            data->outFile = fopen(iter.second.c_str(), "wb");
+#endif
+            if (!data->outFile) {
+                fprintf(stderr, "Failed to open output for writing: %s\n", nstringToUtf8(iter.second).c_str());
+                success = false;
+                break;
             }
         }
-    } else if (data->outputHeaders == VSPipeHeaders::WAVE) {
-        WaveHeader header;
-        if (!CreateWaveHeader(header, ai->format.sampleType == stFloat, ai->format.bitsPerSample, ai->sampleRate, ai->format.channelLayout, ai->numSamples)) {
-            fprintf(stderr, "Error: cannot create valid wav header\n");
-            return false;
-        }
 
-        if (data->outFile) {
-            if (fwrite(&header, 1, sizeof(header), data->outFile) != sizeof(header)) {
-                fprintf(stderr, "Error: fwrite() call failed when writing initial header, errno: %d\n", errno);
-                return false;
+        if (vsapi->getNodeType(data->node) == mtVideo) {
+            const VSVideoInfo *vi = vsapi->getVideoInfo(data->node);
+            if (!isConstantVideoFormat(vi)) {
+                fprintf(stderr, "Cannot output clips with varying dimensions\n");
+                success = false;
+                break;
             }
+            data->outputHeaders = headersFromExtension(iter.second);
+            data->pack = opts.pack;
+            data->directOutput = opts.directOutput;
+            data->totalFrames = vi->numFrames;
+            success = initializeVideoOutput(data);
+        } else {
+            data->outputHeaders = headersFromExtension(iter.second);
+            data->totalFrames = vsapi->getAudioInfo(data->node)->numFrames;
+            data->totalSamples = vsapi->getAudioInfo(data->node)->numSamples;
+            success = initializeAudioOutput(data);
         }
+
+        if (!success)
+            break;
     }
 
-    data->buffer.resize(ai->format.numChannels * VS_AUDIO_FRAME_SAMPLES * ai->format.bytesPerSample);
-    return true;
-}
+    std::chrono::time_point<std::chrono::steady_clock> startTime(std::chrono::steady_clock::now());
 
-static bool outputNode(const VSPipeOptions &opts, VSPipeOutputData *data, VSCore *core) {
-    int requests = opts.requests;
-    if (requests < 1) {
-        VSCoreInfo info;
-        data->vsapi->getCoreInfo(core, &info);
-        requests = info.numThreads;
+    if (success)
+        success = runOutputs(opts, outputs, requests, core);
+
+    std::chrono::duration<double> elapsedSeconds = std::chrono::steady_clock::now() - startTime;
+
+    uint64_t outputBytes = 0;
+    for (size_t i = 0; i < outputs.size(); i++) {
+        VSPipeOutputData *data = outputs[i].get();
+        if (success && vsapi->getNodeType(data->node) == mtVideo)
+            success = finalizeVideoOutput(data);
+
+        if (success) {
+            if (vsapi->getNodeType(data->node) == mtVideo)
+                fprintf(stderr, "Output %d frames from output %d\n", data->totalFrames, opts.outputs[i].first);
+            else
+                fprintf(stderr, "Output %" PRId64 " samples from output %d\n", data->totalSamples, opts.outputs[i].first);
+        }
+
+        unsigned char md5[16];
+        MD5_Final(md5, &data->md5Ctx);
+        if (success && opts.calculateMD5 && data->outFile) {
+            fprintf(stderr, "MD5 (output %d): ", opts.outputs[i].first);
+            for (int j = 0; j < 16; j++)
+                fprintf(stderr, "%02x", (int)md5[j]);
+            fprintf(stderr, "\n");
+        }
+
+        outputBytes += data->outputBytes;
+
+        if (data->outFile == stdout)
+            fflush(stdout);
+        else if (data->outFile)
+            fclose(data->outFile);
+        vsapi->freeNode(data->node);
+        vsapi->freeNode(data->alphaNode);
     }
 
-    data->startTime = std::chrono::steady_clock::now();
-    data->lastFPSReportTime = std::chrono::steady_clock::now();
+    if (success) {
+        fprintf(stderr, "Rendered %d outputs in %.2f seconds\n", static_cast<int>(outputs.size()), elapsedSeconds.count());
+        if (opts.printProgress)
+            fprintf(stderr, "Wrote %.2f GB (%.2f GB/s)\n", outputBytes / 1e9, outputBytes / elapsedSeconds.count() / 1e9);
+    }
 
-    std::unique_lock<std::mutex> lock(data->mutex);
+    return success;
+}
 
-    int intitalRequestSize = std::min(requests, data->totalFrames);
-    data->requestedFrames = intitalRequestSize;
-    for (int n = 0; n < intitalRequestSize; n++) {
-        data->vsapi->getFrameAsync(n, data->node, frameDoneCallback, data);
-        if (data->alphaNode)
-            data->vsapi->getFrameAsync(n, data->alphaNode, frameDoneCallback, data);
+// Renders the node without writing anything, used to time the processing alone
+static bool renderNode(const VSPipeOptions &opts, VSNode *node, VSNode *alphaNode, const VSAPI *vsapi, VSCore *core, double &seconds) {
+    std::unique_ptr<VSPipeOutputData> data(new VSPipeOutputData());
+    data->vsapi = vsapi;
+    data->printProgress = opts.printProgress;
+    data->node = node;
+    data->alphaNode = alphaNode;
+    if (vsapi->getNodeType(node) == mtVideo) {
+        data->totalFrames = vsapi->getVideoInfo(node)->numFrames;
+    } else {
+        data->totalFrames = vsapi->getAudioInfo(node)->numFrames;
+        data->totalSamples = vsapi->getAudioInfo(node)->numSamples;
     }
 
-    data->condition.wait(lock);
+    std::thread writer = startOutput(data.get(), getDefaultRequests(opts, vsapi, core), (opts.requests > 0) ? nullptr : core);
+    bool error = finishOutput(data.get(), writer);
+    seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - data->startTime).count();
+    return !error;
+}
 
-    // We must check for spurious wakeups (e.g. SIGINT received), and do *not* proceed to cleanup:
-    // the worker threads might still be running, and cleaning up will probably just trigger SIGSEGV
-    // in the worker threads.
-    if (data->totalFrames != data->completedFrames || data->totalFrames != data->completedAlphaFrames) {
-        fprintf(stderr, "Interrupted\n");
-        exit(1);
+static std::string mapToJSON(VSMap *map, const VSAPI *vsapi) {
+    std::string result = convertVSMapToJSON(map, vsapi);
+    vsapi->freeMap(map);
+    return result;
+}
+
+// Renders the output once with graph inspection enabled and writes the per node and core statistics as JSON,
+// optionally followed by more runs with different thread counts to show how well the script scales
+static bool outputBenchmark(const VSPipeOptions &opts, VSNode *node, VSNode *alphaNode, FILE *outFile, const VSAPI *vsapi, VSCore *core) {
+    int nodeType = vsapi->getNodeType(node);
+    int64_t length = (nodeType == mtVideo) ? vsapi->getVideoInfo(node)->numFrames : vsapi->getAudioInfo(node)->numSamples;
+
+    if (opts.startPos != 0 || opts.endPos != -1) {
+        VSPlugin *stdPlugin = vsapi->getPluginByID(VSH_STD_PLUGIN_ID, core);
+        int64_t last = (opts.endPos > -1) ? opts.endPos : length - 1;
+        node = trimNode(node, opts.startPos, last, stdPlugin, vsapi);
+        if (node && alphaNode)
+            alphaNode = trimNode(alphaNode, opts.startPos, last, stdPlugin, vsapi);
+        else
+            alphaNode = nullptr;
+        if (!node) {
+            vsapi->freeNode(alphaNode);
+            return false;
+        }
+    } else {
+        node = vsapi->addNodeRef(node);
+        alphaNode = alphaNode ? vsapi->addNodeRef(alphaNode) : nullptr;
     }
 
-    if (data->outputError) {
-        for (auto &iter : data->reorderMap) {
-            data->vsapi->freeFrame(iter.second.first);
-            data->vsapi->freeFrame(iter.second.second);
+    int numFrames = (nodeType == mtVideo) ? vsapi->getVideoInfo(node)->numFrames : vsapi->getAudioInfo(node)->numFrames;
+
+    double seconds = 0;
+    bool success = renderNode(opts, node, alphaNode, vsapi, core, seconds);
+
+    std::string json;
+    if (success) {
+        VSMap *summary = vsapi->createMap();
+        vsapi->mapSetInt(summary, "frames", numFrames, maReplace);
+        vsapi->mapSetFloat(summary, "time", seconds, maReplace);
+        vsapi->mapSetFloat(summary, "fps", numFrames / seconds, maReplace);
+        json = mapToJSON(summary, vsapi);
+        json = "{\n\t" + json.substr(1, json.size() - 2);
+
+        VSMap *coreStats = vsapi->createMap();
+        vsapi->getCoreStatistics(core, coreStats);
+        json += ",\n\t\"core\": " + mapToJSON(coreStats, vsapi);
+        json += ",\n\t\"nodes\": " + printNodeStatistics(node, vsapi);
+        if (alphaNode)
+            json += ",\n\t\"alpha_nodes\": " + printNodeStatistics(alphaNode, vsapi);
+        fprintf(stderr, "Benchmarked %d frames in %.2f seconds (%.2f fps)\n", numFrames, seconds, numFrames / seconds);
+    }
+
+    // The frame caches only hold a few recently used frames so every run still does practically all the work again
+    if (success && !opts.threadsSweep.empty()) {
+        json += ",\n\t\"threads_sweep\": [";
+        VSCoreInfo info;
+        vsapi->getCoreInfo(core, &info);
+        double baseline = 0;
+        for (size_t i = 0; i < opts.threadsSweep.size() && success; i++) {
+            vsapi->setThreadCount(opts.threadsSweep[i], core);
+            success = renderNode(opts, node, alphaNode, vsapi, core, seconds);
+            if (i == 0)
+                baseline = seconds;
+
+            VSMap *run = vsapi->createMap();
+            vsapi->mapSetInt(run, "threads", opts.threadsSweep[i], maReplace);
+            vsapi->mapSetFloat(run, "time", seconds, maReplace);
+            vsapi->mapSetFloat(run, "fps", numFrames / seconds, maReplace);
+            vsapi->mapSetFloat(run, "speedup", baseline / seconds, maReplace);
+            json += std::string(i ? "," : "") + "\n\t\t" + mapToJSON(run, vsapi);
+            if (success)
+                fprintf(stderr, "%d threads: %.2f fps (%.2fx)\n", opts.threadsSweep[i], numFrames / seconds, baseline / seconds);
         }
-        fprintf(stderr, "%s\n", data->errorMessage.c_str());
+        json += "\n\t]";
+        vsapi->setThreadCount(info.numThreads, core);
     }
 
-    return data->outputError;
+    if (success && outFile)
+        fprintf(outFile, "%s\n}\n", json.c_str());
+
+    vsapi->freeNode(node);
+    vsapi->freeNode(alphaNode);
+    return success;
 }
 
 static const char *colorFamilyToString(int colorFamily) {
@@ -669,6 +1915,40 @@ static bool nstringToInt(const nstring &ns, int &result) {
     return pos == s.length();
 }
 
+// Saves the calls that created the outputs used by this run so --load-graph can skip the script evaluation next time
+static bool saveGraphSnapshot(const VSPipeOptions &opts, const VSPipeSource &source, const VSAPI *vsapi) {
+    std::vector<int> indices;
+    if (opts.outputs.empty()) {
+        indices.push_back(opts.outputIndex);
+    } else {
+        for (const auto &iter : opts.outputs)
+            indices.push_back(iter.first);
+    }
+
+    VSMap *nodes = vsapi->createMap();
+    for (int index : indices) {
+        VSNode *node = source.getOutputNode(index);
+        if (!node) {
+            fprintf(stderr, "Failed to retrieve output node %d. Invalid index specified?\n", index);
+            vsapi->freeMap(nodes);
+            return false;
+        }
+        vsapi->mapConsumeNode(nodes, ("clip" + std::to_string(index)).c_str(), node, maReplace);
+        VSNode *alphaNode = source.getOutputAlphaNode(index);
+        if (alphaNode)
+            vsapi->mapConsumeNode(nodes, ("alpha" + std::to_string(index)).c_str(), alphaNode, maReplace);
+    }
+
+    VSMap *result = vsapi->createMap();
+    vsapi->saveGraphSnapshot(nodes, nstringToUtf8(opts.saveGraphFilename).c_str(), result);
+    bool success = !vsapi->mapGetError(result);
+    if (!success)
+        fprintf(stderr, "Failed to save graph snapshot: %s\n", vsapi->mapGetError(result));
+    vsapi->freeMap(result);
+    vsapi->freeMap(nodes);
+    return success;
+}
+
 static bool printVersion(const VSAPI *vsapi) {
     VSCore *core = vsapi->createCore(0);
     if (!core) {
@@ -694,15 +1974,29 @@ static void printHelp() {
         "  -s, --start N                    Set output frame/sample range start\n"
         "  -e, --end N                      Set output frame/sample range end (inclusive)\n"
         "  -o, --outputindex N              Select output index\n"
-        "  -r, --requests N                 Set number of concurrent frame requests\n"
+        "  -o, --outputindex N=FILE         Write output N to FILE, can be given several times to render the outputs together,\n"
+        "                                   .y4m, .wav and .w64 files get headers for the format\n"
+        "  -r, --requests N                 Set a fixed number of concurrent frame requests, adapts to the throughput by default\n"
+        "      --segments N                 Split the range into N parts that are rendered to separate files at the same time\n"
+        "      --output-pattern PATTERN     Output filename pattern for segments, %%d is replaced with the segment number\n"
         "  -c, --container <y4m/wav/w64>    Add headers for the specified format to the output\n"
+        "      --pack FORMAT                Write video interleaved as rgb24, bgra, yuyv, v210 or p010 instead of planar\n"
         "  -c, --preserve-cwd               Don't temporarily change the working directory to the script directory\n"
+        "      --direct                     Write video straight from the frame memory with writev or vmsplice, Linux only\n"
         "  -t, --timecodes FILE             Write timecodes v2 file\n"
         "  -j, --json FILE                  Write properties of output frames to JSON file\n"
         "  -p, --progress                   Print progress to stderr\n"
+        "      --checksum-manifest FILE     Write per frame xxh64 checksums of every plane to FILE\n"
+        "      --checksum-props             Also include a checksum of the frame properties in the manifest\n"
+        "      --verify-manifest FILE       Compare the output against a checksum manifest and stop at the first mismatch\n"
         "      --filter-time                Prints time spent in individual filters after processing\n"
+        "      --trace FILE                 Record filter activations, cache lookups, allocations and thread waits to a Chrome trace JSON file\n"
+        "      --save-graph FILE            Save the function calls that created the selected outputs as a graph snapshot (experimental)\n"
+        "      --load-graph FILE            Recreate the outputs from a graph snapshot instead of evaluating a script\n"
         "  -i, --info                       Show output node info and exit\n"
         "  -g  --graph <simple/full>        Print output node filter graph in dot format and exit\n"
+        "      --benchmark                  Render without output and write per filter statistics as JSON to outfile\n"
+        "      --threads-sweep N,N,...      Repeat the benchmark with each of the given thread counts\n"
         "  -v, --version                    Show version info and exit\n"
         "\n"
         "Examples:\n"
@@ -716,6 +2010,17 @@ static void printHelp() {
         "    vspipe --start 5 --end 100 script.vpy output.raw\n"
         "  Pass values to a script:\n"
         "    vspipe --arg deinterlace=yes --arg \"message=fluffy kittens\" script.vpy output.raw\n"
+        "  Write frames in 8 segments that are rendered at the same time:\n"
+        "    vspipe --segments 8 --output-pattern out_%%03d.y4m -c y4m script.vpy\n"
+        "  Write video and audio in a single pass:\n"
+        "    vspipe -o 0=video.y4m -o 1=audio.wav script.vpy\n"
+        "  Benchmark a script and see how it scales with the number of threads:\n"
+        "    vspipe --benchmark --threads-sweep 1,2,4,8 script.vpy stats.json\n"
+        "  Render parts of a script in separate jobs without evaluating it every time:\n"
+        "    vspipe --save-graph script.vsgraph --info script.vpy\n"
+        "    vspipe --load-graph script.vsgraph --start 1000 --end 1999 -c y4m part2.y4m\n"
+        "  Pipe packed RGB to ffmpeg:\n"
+        "    vspipe --pack rgb24 script.vpy - | ffmpeg -f rawvideo -pix_fmt rgb24 -s 1920x1080 -i - output.mkv\n"
         "  Pipe to x264 and write timecodes file:\n"
         "    vspipe script.vpy - -c y4m --timecodes timecodes.txt | x264 --demuxer y4m -o script.mkv -\n"
         );
@@ -732,6 +2037,8 @@ static int parseOptions(VSPipeOptions &opts, int argc, T **argv) {
             }
 
             opts.mode = VSPipeMode::PrintVersion;
+        } else if (argString == NSTRING("--direct")) {
+            opts.directOutput = true;
         } else if (argString == NSTRING("--preserve-cwd")) {
             opts.preserveCwd = true;
         } else if (argString == NSTRING("-c") || argString == NSTRING("--container")) {
@@ -759,6 +2066,29 @@ static int parseOptions(VSPipeOptions &opts, int argc, T **argv) {
                 return 1;
             }
 
+            arg++;
+        } else if (argString == NSTRING("--pack")) {
+            if (argc <= arg + 1) {
+                fprintf(stderr, "No packed format specified\n");
+                return 1;
+            }
+
+            std::string packString = nstringToUtf8(argv[arg + 1]);
+            if (packString == "rgb24") {
+                opts.pack = VSPipePack::RGB24;
+            } else if (packString == "bgra") {
+                opts.pack = VSPipePack::BGRA;
+            } else if (packString == "yuyv") {
+                opts.pack = VSPipePack::YUYV;
+            } else if (packString == "v210") {
+                opts.pack = VSPipePack::V210;
+            } else if (packString == "p010") {
+                opts.pack = VSPipePack::P010;
+            } else {
+                fprintf(stderr, "Unknown packed format specified: %s\n", packString.c_str());
+                return 1;
+            }
+
             arg++;
         } else if (argString == NSTRING("-y") || argString == NSTRING("--y4m")) { // secret option for compatibility with V3
             //fprintf(stderr, "Deprecated option --y4m specified, use -c y4m instead\n");
@@ -767,8 +2097,55 @@ static int parseOptions(VSPipeOptions &opts, int argc, T **argv) {
             opts.printProgress = true;
         } else if (argString == NSTRING("--md5")) {
             opts.calculateMD5 = true;
+        } else if (argString == NSTRING("--checksum-props")) {
+            opts.checksumProperties = true;
+        } else if (argString == NSTRING("--checksum-manifest")) {
+            if (argc <= arg + 1) {
+                fprintf(stderr, "No checksum manifest file specified\n");
+                return 1;
+            }
+
+            opts.checksumFilename = argv[arg + 1];
+
+            arg++;
+        } else if (argString == NSTRING("--verify-manifest")) {
+            if (argc <= arg + 1) {
+                fprintf(stderr, "No checksum manifest file specified\n");
+                return 1;
+            }
+
+            opts.verifyFilename = argv[arg + 1];
+
+            arg++;
         } else if (argString == NSTRING("--filter-time")) {
             opts.printFilterTime = true;
+        } else if (argString == NSTRING("--save-graph")) {
+            if (argc <= arg + 1) {
+                fprintf(stderr, "No graph snapshot file specified\n");
+                return 1;
+            }
+
+            opts.saveGraphFilename = argv[arg + 1];
+
+            arg++;
+        } else if (argString == NSTRING("--load-graph")) {
+            if (argc <= arg + 1) {
+                fprintf(stderr, "No graph snapshot file specified\n");
+                return 1;
+            }
+
+            opts.loadGraphFilename = argv[arg + 1];
+
+            arg++;
+        } else if (argString == NSTRING("--trace")) {
+            if (argc <= arg + 1) {
+                fprintf(stderr, "No trace file specified\n");
+                return 1;
+            }
+
+            opts.traceFilename = argv[arg + 1];
+
+            arg++;
         } else if (argString == NSTRING("-i") || argString == NSTRING("--info")) {
             if (opts.mode == VSPipeMode::PrintSimpleGraph || opts.mode == VSPipeMode::PrintFullGraph) {
                 fprintf(stderr, "Cannot combine graph and info arguments\n");
@@ -796,6 +2173,35 @@ static int parseOptions(VSPipeOptions &opts, int argc, T **argv) {
                 return 1;
             }
 
+            arg++;
+        } else if (argString == NSTRING("--benchmark")) {
+            if (opts.mode != VSPipeMode::Output) {
+                fprintf(stderr, "Cannot combine benchmark with info or graph arguments\n");
+                return 1;
+            }
+
+            opts.mode = VSPipeMode::Benchmark;
+        } else if (argString == NSTRING("--threads-sweep")) {
+            if (argc <= arg + 1) {
+                fprintf(stderr, "No thread counts specified\n");
+                return 1;
+            }
+
+            std::string list = nstringToUtf8(argv[arg + 1]);
+            size_t pos = 0;
+            do {
+                size_t end = list.find(',', pos);
+                std::string item = list.substr(pos, (end == std::string::npos) ? std::string::npos : end - pos);
+                char *itemEnd = nullptr;
+                long threads = strtol(item.c_str(), &itemEnd, 10);
+                if (item.empty() || *itemEnd || threads < 1 || threads > INT_MAX) {
+                    fprintf(stderr, "Couldn't convert %s to a list of thread counts\n", list.c_str());
+                    return 1;
+                }
+                opts.threadsSweep.push_back(static_cast<int>(threads));
+                pos = (end == std::string::npos) ? std::string::npos : end + 1;
+            } while (pos != std::string::npos);
+
             arg++;
         } else if (argString == NSTRING("-h") || argString == NSTRING("--help")) {
             if (argc > 2) {
@@ -844,7 +2250,21 @@ static int parseOptions(VSPipeOptions &opts, int argc, T **argv) {
                 return 1;
             }
 
-            if (!nstringToInt(argv[arg + 1], opts.outputIndex)) {
+            // index=file adds another output to render at the same time
+            nstring outputString = argv[arg + 1];
+            size_t equalsPos = outputString.find(NSTRING("="));
+            if (equalsPos != nstring::npos) {
+                int index;
+                nstring filename = outputString.substr(equalsPos + 1);
+                if (!nstringToInt(outputString.substr(0, equalsPos), index)) {
+                    fprintf(stderr, "Couldn't convert %s to an integer (index)\n", nstringToUtf8(outputString.substr(0, equalsPos)).c_str());
+                    return 1;
+                } else if (filename.empty()) {
+                    fprintf(stderr, "No output file specified for output %d\n", index);
+                    return 1;
+                }
+                opts.outputs.emplace_back(index, filename);
+            } else if (!nstringToInt(outputString, opts.outputIndex)) {
                 fprintf(stderr, "Couldn't convert %s to an integer (index)\n", nstringToUtf8(argv[arg + 1]).c_str());
                 return 1;
             }
@@ -861,6 +2281,38 @@ static int parseOptions(VSPipeOptions &opts, int argc, T **argv) {
                 return 1;
             }
 
+            arg++;
+        } else if (argString == NSTRING("--segments")) {
+            if (argc <= arg + 1) {
+                fprintf(stderr, "Number of segments not specified\n");
+                return 1;
+            }
+
+            if (!nstringToInt(argv[arg + 1], opts.segments)) {
+                fprintf(stderr, "Couldn't convert %s to an integer (segments)\n", nstringToUtf8(argv[arg + 1]).c_str());
+                return 1;
+            }
+
+            if (opts.segments < 1) {
+                fprintf(stderr, "Number of segments must be at least 1\n");
+                return 1;
+            }
+
+            arg++;
+        } else if (argString == NSTRING("--output-pattern")) {
+            if (argc <= arg + 1) {
+                fprintf(stderr, "No output pattern specified\n");
+                return 1;
+            }
+
+            nstring filename;
+            if (!formatSegmentFilename(argv[arg + 1], 0, filename)) {
+                fprintf(stderr, "Output pattern must contain exactly one %%d field: %s\n", nstringToUtf8(argv[arg + 1]).c_str());
+                return 1;
+            }
+
+            opts.outputPattern = argv[arg + 1];
+
             arg++;
         } else if (argString == NSTRING("-a") || argString == NSTRING("--arg")) {
             if (argc <= arg + 1) {
@@ -910,12 +2362,73 @@ static int parseOptions(VSPipeOptions &opts, int argc, T **argv) {
     if (argc <= 1)
         opts.mode = VSPipeMode::PrintHelp;
 
-    if ((opts.mode == VSPipeMode::Output || opts.mode == VSPipeMode::PrintInfo || opts.mode == VSPipeMode::PrintSimpleGraph || opts.mode == VSPipeMode::PrintFullGraph) && opts.scriptFilename.empty()) {
+    // A snapshot replaces the script so the first positional argument is the output
+    if (!opts.loadGraphFilename.empty()) {
+        if (!opts.scriptFilename.empty() && !opts.outputFilename.empty()) {
+            fprintf(stderr, "Cannot combine a script with a graph snapshot\n");
+            return 1;
+        } else if (!opts.scriptArgs.empty()) {
+            fprintf(stderr, "Cannot pass arguments to a graph snapshot\n");
+            return 1;
+        }
+        if (!opts.scriptFilename.empty())
+            opts.outputFilename = opts.scriptFilename;
+        opts.scriptFilename.clear();
+    }
+
+    if ((opts.mode == VSPipeMode::Output || opts.mode == VSPipeMode::PrintInfo || opts.mode == VSPipeMode::PrintSimpleGraph || opts.mode == VSPipeMode::PrintFullGraph || opts.mode == VSPipeMode::Benchmark) && opts.scriptFilename.empty() && opts.loadGraphFilename.empty()) {
         fprintf(stderr, "No script file specified\n");
         return 1;
-    } else if (opts.mode == VSPipeMode::Output && opts.outputFilename.empty()) {
+    } else if (opts.mode == VSPipeMode::Output && opts.outputFilename.empty() && opts.outputPattern.empty() && opts.outputs.empty()) {
         fprintf(stderr, "No output file specified\n");
         return 1;
+    } else if (!opts.threadsSweep.empty() && opts.mode != VSPipeMode::Benchmark) {
+        fprintf(stderr, "Thread sweeps can only be used together with benchmark\n");
+        return 1;
+    }
+
+    if (!opts.outputPattern.empty()) {
+        if (opts.mode != VSPipeMode::Output || !opts.outputFilename.empty()) {
+            fprintf(stderr, "Output pattern can only be used for output and not together with an output file\n");
+            return 1;
+        } else if (!opts.timecodesFilename.empty() || !opts.jsonFilename.empty() || !opts.checksumFilename.empty() || !opts.verifyFilename.empty()) {
+            fprintf(stderr, "Cannot write timecodes, JSON or checksum files when outputting segments\n");
+            return 1;
+        }
+
+        if (opts.segments < 1)
+            opts.segments = 1;
+    } else if (opts.segments > 0) {
+        fprintf(stderr, "Segments require an output pattern\n");
+        return 1;
+    }
+
+    if (!opts.outputs.empty()) {
+        int stdoutOutputs = 0;
+        for (const auto &iter : opts.outputs) {
+            if (iter.second == NSTRING("-"))
+                stdoutOutputs++;
+        }
+
+        if (opts.mode != VSPipeMode::Output || !opts.outputFilename.empty() || !opts.outputPattern.empty()) {
+            fprintf(stderr, "Multiple outputs can only be used for output and not together with an output file or pattern\n");
+            return 1;
+        } else if (!opts.timecodesFilename.empty() || !opts.jsonFilename.empty() || !opts.checksumFilename.empty() || !opts.verifyFilename.empty()) {
+            fprintf(stderr, "Cannot write timecodes, JSON or checksum files when rendering multiple outputs\n");
+            return 1;
+        } else if (opts.outputHeaders != VSPipeHeaders::None) {
+            fprintf(stderr, "Containers are picked by the file extension (.y4m, .wav or .w64) when rendering multiple outputs\n");
+            return 1;
+        } else if (opts.startPos != 0 || opts.endPos != -1) {
+            fprintf(stderr, "Cannot set a range when rendering multiple outputs\n");
+            return 1;
+        } else if (opts.printFilterTime) {
+            fprintf(stderr, "Cannot print filter times when rendering multiple outputs\n");
+            return 1;
+        } else if (stdoutOutputs > 1) {
+            fprintf(stderr, "Only one output can be written to stdout\n");
+            return 1;
+        }
     }
 
     return 0;
@@ -943,6 +2456,7 @@ int main(int argc, char **argv) {
         fprintf(stderr, "Failed to get VapourSynth API pointer\n");
         return 1;
     }
+    vscapi = reinterpret_cast<const VSCAPI *>(vssapi->getVSAPI(VAPOURSYNTHC_API_VERSION2));
 
     VSPipeOptions opts{};
     int parseResult = parseOptions(opts, argc, argv);
@@ -959,7 +2473,9 @@ int main(int argc, char **argv) {
     FILE *outFile = nullptr;
     bool closeOutFile = false;
 
-    if (opts.outputFilename.empty() || opts.outputFilename == NSTRING("-")) {
+    if (!opts.outputPattern.empty() || !opts.outputs.empty()) {
+        // each segment or output opens its own file
+    } else if (opts.outputFilename.empty() || opts.outputFilename == NSTRING("-")) {
         outFile = stdout;
     } else if (opts.outputFilename == NSTRING(".")) {
         // do nothing
@@ -1023,35 +2539,64 @@ int main(int argc, char **argv) {
         }
     }
 
-    VSCore *core = vsapi->createCore((opts.mode == VSPipeMode::PrintSimpleGraph || opts.mode == VSPipeMode::PrintFullGraph || opts.printFilterTime) ? ccfEnableGraphInspection : 0);
+    int coreFlags = (opts.mode == VSPipeMode::PrintSimpleGraph || opts.mode == VSPipeMode::PrintFullGraph || opts.mode == VSPipeMode::Benchmark || opts.printFilterTime || !opts.saveGraphFilename.empty()) ? ccfEnableGraphInspection : 0;
+    if (!opts.traceFilename.empty())
+        coreFlags |= ccfEnableTracing;
+    VSCore *core = vsapi->createCore(coreFlags);
     //vsapi->addLogHandler(logMessageHandler, nullptr, (void*)&opts, core);
-    VSScript *se = vssapi->createScript(core);
-    vssapi->evalSetWorkingDir(se, opts.preserveCwd ? 0:1);
-    if (opts.scriptArgs.size()) {
-        VSMap *foldedArgs = vsapi->createMap();
-        for (const auto &iter : opts.scriptArgs)
-            vsapi->mapSetData(foldedArgs, iter.first.c_str(), iter.second.c_str(), static_cast<int>(iter.second.size()), dtUtf8, maAppend);
-        vssapi->setVariables(se, foldedArgs);
-        vsapi->freeMap(foldedArgs);
+    VSPipeSource source;
+    source.vssapi = vssapi;
+    source.vsapi = vsapi;
+    source.core = core;
+
+    if (!opts.loadGraphFilename.empty()) {
+        source.snapshot = vsapi->createMap();
+        vsapi->loadGraphSnapshot(nstringToUtf8(opts.loadGraphFilename).c_str(), core, source.snapshot);
+        if (vsapi->mapGetError(source.snapshot)) {
+            fprintf(stderr, "Loading graph snapshot failed:\n%s\n", vsapi->mapGetError(source.snapshot));
+            source.free();
+            return 1;
+        }
+    } else {
+        VSScript *se = vssapi->createScript(core);
+        source.se = se;
+        vssapi->evalSetWorkingDir(se, opts.preserveCwd ? 0:1);
+        if (opts.scriptArgs.size()) {
+            VSMap *foldedArgs = vsapi->createMap();
+            for (const auto &iter : opts.scriptArgs)
+                vsapi->mapSetData(foldedArgs, iter.first.c_str(), iter.second.c_str(), static_cast<int>(iter.second.size()), dtUtf8, maAppend);
+            vssapi->setVariables(se, foldedArgs);
+            vsapi->freeMap(foldedArgs);
+        }
+        vssapi->evaluateFile(se, nstringToUtf8(opts.scriptFilename).c_str());
+
+        if (vssapi->getError(se)) {
+            int code = vssapi->getExitCode(se);
+            if (code == 0) code = 1;
+            fprintf(stderr, "Script evaluation failed:\n%s\n", vssapi->getError(se));
+            source.free();
+            return code;
+        }
     }
-    vssapi->evaluateFile(se, nstringToUtf8(opts.scriptFilename).c_str());
 
-    if (vssapi->getError(se)) {
-        int code = vssapi->getExitCode(se);
-        if (code == 0) code = 1;
-        fprintf(stderr, "Script evaluation failed:\n%s\n", vssapi->getError(se));
-        vssapi->freeScript(se);
-        return code;
+    if (!opts.saveGraphFilename.empty() && !saveGraphSnapshot(opts, source, vsapi)) {
+        source.free();
+        return 1;
     }
 
-    VSNode *node = vssapi->getOutputNode(se, opts.outputIndex);
-    if (!node) {
-       fprintf(stderr, "Failed to retrieve output node. Invalid index specified?\n");
-       vssapi->freeScript(se);
-       return 1;
-    }
+    VSNode *node = nullptr;
+    VSNode *alphaNode = nullptr;
+
+    if (opts.outputs.empty()) {
+        node = source.getOutputNode(opts.outputIndex);
+        if (!node) {
+           fprintf(stderr, "Failed to retrieve output node. Invalid index specified?\n");
+           source.free();
+           return 1;
+        }
 
-    VSNode *alphaNode = vssapi->getOutputAlphaNode(se, opts.outputIndex);
+        alphaNode = source.getOutputAlphaNode(opts.outputIndex);
+    }
 
     std::chrono::duration<double> scriptEvaluationTime = std::chrono::steady_clock::now() - scriptEvaluationStart;
     if (opts.printProgress)
@@ -1059,7 +2604,9 @@ int main(int argc, char **argv) {
 
     bool success = true;
 
-    if (opts.mode == VSPipeMode::PrintSimpleGraph) {
+    if (!opts.outputs.empty()) {
+        success = outputMultiple(opts, source, vsapi);
+    } else if (opts.mode == VSPipeMode::PrintSimpleGraph) {
         std::string graph = printNodeGraph(true, node, vsapi);
         if (outFile)
             fprintf(outFile, "%s\n", graph.c_str());
@@ -1067,6 +2614,10 @@ int main(int argc, char **argv) {
         std::string graph = printNodeGraph(false, node, vsapi);
         if (outFile)
             fprintf(outFile, "%s\n", graph.c_str());
+    } else if (opts.mode == VSPipeMode::Benchmark) {
+        success = outputBenchmark(opts, node, alphaNode, outFile, vsapi, core);
+    } else if (opts.mode == VSPipeMode::Output && opts.segments > 0) {
+        success = outputSegments(opts, node, alphaNode, vsapi, core);
     } else {
         int nodeType = vsapi->getNodeType(node);
 
@@ -1078,7 +2629,7 @@ int main(int argc, char **argv) {
             if (opts.endPos > -1)
                 vsapi->mapSetInt(args, "last", opts.endPos, maAppend);
 
-            VSPlugin *stdPlugin = vsapi->getPluginByID(VSH_STD_PLUGIN_ID, vssapi->getCore(se));
+            VSPlugin *stdPlugin = vsapi->getPluginByID(VSH_STD_PLUGIN_ID, core);
             VSMap *result = vsapi->invoke(stdPlugin, (nodeType == mtVideo) ? "Trim" : "AudioTrim", args);
 
             VSMap *alphaResult = nullptr;
@@ -1099,7 +2650,7 @@ int main(int argc, char **argv) {
                 if (alphaResult) vsapi->freeMap(alphaResult);
                 vsapi->freeNode(node);
                 vsapi->freeNode(alphaNode);
-                vssapi->freeScript(se);
+                source.free();
                 return 1;
             } else {
                 vsapi->freeNode(node);
@@ -1117,6 +2668,8 @@ int main(int argc, char **argv) {
 
         data->vsapi = vsapi;
         data->outputHeaders = opts.outputHeaders;
+        data->pack = opts.pack;
+        data->directOutput = opts.directOutput;
         data->calculateMD5 = opts.calculateMD5;
         MD5_Init(&data->md5Ctx);
         data->printProgress = opts.printProgress;
@@ -1164,7 +2717,7 @@ int main(int argc, char **argv) {
                     fprintf(stderr, "Cannot output clips with varying dimensions\n");
                     vsapi->freeNode(node);
                     vsapi->freeNode(alphaNode);
-                    vssapi->freeScript(se);
+                    source.free();
                     return 1;
                 }
 
@@ -1173,7 +2726,7 @@ int main(int argc, char **argv) {
                 success = initializeVideoOutput(data.get());
                 if (success) {
                     data->lastFPSReportTime = std::chrono::steady_clock::now();
-                    success = !outputNode(opts, data.get(), vssapi->getCore(se));
+                    success = !outputNode(opts, data.get(), core);
                 }
                 if (success)
                     success = finalizeVideoOutput(data.get());
@@ -1201,7 +2754,7 @@ int main(int argc, char **argv) {
                 success = initializeAudioOutput(data.get());
                 if (success) {
                     
-                    success = !outputNode(opts, data.get(), vssapi->getCore(se));
+                    success = !outputNode(opts, data.get(), core);
                 }
             }
         }
@@ -1222,6 +2775,8 @@ int main(int argc, char **argv) {
                 fprintf(stderr, "Output %d frames in %.2f seconds (%.2f fps)\n", data->totalFrames, elapsedSeconds.count(), data->totalFrames / elapsedSeconds.count());
             else
                 fprintf(stderr, "Output %" PRId64 " samples in %.2f seconds (%.2f sps)\n", data->totalSamples, elapsedSeconds.count(), (data->totalFrames / elapsedSeconds.count()) * VS_AUDIO_FRAME_SAMPLES);
+            if (opts.printProgress && outFile)
+                fprintf(stderr, "Wrote %.2f GB (%.2f GB/s)\n", data->outputBytes / 1e9, data->outputBytes / elapsedSeconds.count() / 1e9);
         }
 
         if (opts.calculateMD5 && outFile) {
@@ -1237,6 +2792,11 @@ int main(int argc, char **argv) {
             fprintf(stderr, "%s", printNodeTimes(node, elapsedSeconds.count(), vsapi).c_str());
     }
 
+    if (!opts.traceFilename.empty() && !vsapi->writeTrace(core, nstringToUtf8(opts.traceFilename).c_str())) {
+        fprintf(stderr, "Failed to write trace file: %s\n", nstringToUtf8(opts.traceFilename).c_str());
+        success = false;
+    }
+
     if (outFile && closeOutFile)
         fclose(outFile);
     if (timecodesFile)
@@ -1246,7 +2806,7 @@ int main(int argc, char **argv) {
 
     vsapi->freeNode(node);
     vsapi->freeNode(alphaNode);
-    vssapi->freeScript(se);
+    source.free();
 
     return success ? 0 : 1;
 }
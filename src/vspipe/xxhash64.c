@@ -0,0 +1,153 @@
+/*
+* Copyright (c) 2026 vapoursynth-classic contributors
+*
+* This file is part of VapourSynth.
+*
+* VapourSynth is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 2.1 of the License, or (at your option) any later version.
+*
+* VapourSynth is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with VapourSynth; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include <string.h>
+
+#include "xxhash64.h"
+
+#define PRIME64_1 0x9E3779B185EBCA87ULL
+#define PRIME64_2 0xC2B2AE3D27D4EB4FULL
+#define PRIME64_3 0x165667B19E3779F9ULL
+#define PRIME64_4 0x85EBCA77C2B2AE63ULL
+#define PRIME64_5 0x27D4EB2F165667C5ULL
+
+static uint64_t rotl64(uint64_t x, int r) {
+	return (x << r) | (x >> (64 - r));
+}
+
+/* Byte by byte so the result doesn't depend on endianness, compilers turn this into a single load */
+static uint64_t read64(const unsigned char *p) {
+	return (uint64_t)p[0] | ((uint64_t)p[1] << 8) | ((uint64_t)p[2] << 16) | ((uint64_t)p[3] << 24) |
+		((uint64_t)p[4] << 32) | ((uint64_t)p[5] << 40) | ((uint64_t)p[6] << 48) | ((uint64_t)p[7] << 56);
+}
+
+static uint32_t read32(const unsigned char *p) {
+	return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint64_t round64(uint64_t acc, uint64_t input) {
+	acc += input * PRIME64_2;
+	acc = rotl64(acc, 31);
+	return acc * PRIME64_1;
+}
+
+static uint64_t merge_round64(uint64_t acc, uint64_t val) {
+	acc ^= round64(0, val);
+	return acc * PRIME64_1 + PRIME64_4;
+}
+
+/* The four lanes are independent so the loop keeps several multipliers busy at once */
+static const unsigned char *consume_stripes(uint64_t v[4], const unsigned char *p, const unsigned char *end) {
+	uint64_t v1 = v[0], v2 = v[1], v3 = v[2], v4 = v[3];
+
+	while (end - p >= 32) {
+		v1 = round64(v1, read64(p));
+		v2 = round64(v2, read64(p + 8));
+		v3 = round64(v3, read64(p + 16));
+		v4 = round64(v4, read64(p + 24));
+		p += 32;
+	}
+
+	v[0] = v1;
+	v[1] = v2;
+	v[2] = v3;
+	v[3] = v4;
+	return p;
+}
+
+void XXH64_Init(XXH64_CTX *ctx, uint64_t seed) {
+	memset(ctx, 0, sizeof(*ctx));
+	ctx->seed = seed;
+	ctx->v[0] = seed + PRIME64_1 + PRIME64_2;
+	ctx->v[1] = seed + PRIME64_2;
+	ctx->v[2] = seed;
+	ctx->v[3] = seed - PRIME64_1;
+}
+
+void XXH64_Update(XXH64_CTX *ctx, const void *data, size_t size) {
+	const unsigned char *p = (const unsigned char *)data;
+	const unsigned char *end = p + size;
+
+	ctx->total_len += size;
+
+	if (ctx->buffer_size + size < 32) {
+		memcpy(ctx->buffer + ctx->buffer_size, p, size);
+		ctx->buffer_size += (unsigned)size;
+		return;
+	}
+
+	if (ctx->buffer_size) {
+		size_t fill = 32 - ctx->buffer_size;
+		memcpy(ctx->buffer + ctx->buffer_size, p, fill);
+		consume_stripes(ctx->v, ctx->buffer, ctx->buffer + 32);
+		p += fill;
+		ctx->buffer_size = 0;
+	}
+
+	p = consume_stripes(ctx->v, p, end);
+
+	if (p < end) {
+		memcpy(ctx->buffer, p, end - p);
+		ctx->buffer_size = (unsigned)(end - p);
+	}
+}
+
+uint64_t XXH64_Final(const XXH64_CTX *ctx) {
+	const unsigned char *p = ctx->buffer;
+	const unsigned char *end = p + ctx->buffer_size;
+	uint64_t h;
+
+	if (ctx->total_len >= 32) {
+		h = rotl64(ctx->v[0], 1) + rotl64(ctx->v[1], 7) + rotl64(ctx->v[2], 12) + rotl64(ctx->v[3], 18);
+		h = merge_round64(h, ctx->v[0]);
+		h = merge_round64(h, ctx->v[1]);
+		h = merge_round64(h, ctx->v[2]);
+		h = merge_round64(h, ctx->v[3]);
+	} else {
+		h = ctx->seed + PRIME64_5;
+	}
+
+	h += ctx->total_len;
+
+	while (end - p >= 8) {
+		h ^= round64(0, read64(p));
+		h = rotl64(h, 27) * PRIME64_1 + PRIME64_4;
+		p += 8;
+	}
+
+	if (end - p >= 4) {
+		h ^= (uint64_t)read32(p) * PRIME64_1;
+		h = rotl64(h, 23) * PRIME64_2 + PRIME64_3;
+		p += 4;
+	}
+
+	while (p < end) {
+		h ^= (*p) * PRIME64_5;
+		h = rotl64(h, 11) * PRIME64_1;
+		p++;
+	}
+
+	h ^= h >> 33;
+	h *= PRIME64_2;
+	h ^= h >> 29;
+	h *= PRIME64_3;
+	h ^= h >> 32;
+	return h;
+}
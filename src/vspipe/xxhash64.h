@@ -0,0 +1,44 @@
+/*
+* Copyright (c) 2026 vapoursynth-classic contributors
+*
+* This file is part of VapourSynth.
+*
+* VapourSynth is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 2.1 of the License, or (at your option) any later version.
+*
+* VapourSynth is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with VapourSynth; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+/*
+ * Streaming implementation of the XXH64 hash, output is identical to
+ * XXH64() from the reference xxHash library.
+ */
+
+#ifndef XXHASH64_H
+#define XXHASH64_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct {
+	uint64_t total_len;
+	uint64_t v[4];
+	uint64_t seed;
+	unsigned char buffer[32];
+	unsigned buffer_size;
+} XXH64_CTX;
+
+extern void XXH64_Init(XXH64_CTX *ctx, uint64_t seed);
+extern void XXH64_Update(XXH64_CTX *ctx, const void *data, size_t size);
+extern uint64_t XXH64_Final(const XXH64_CTX *ctx);
+
+#endif
@@ -1,4 +1,5 @@
 import unittest
+import platform
 import vapoursynth as vs
 
 class FilterTestSequence(unittest.TestCase):
@@ -20,6 +21,245 @@ class FilterTestSequence(unittest.TestCase):
         clip = self.BlankClip(format=vs.YUV444PS, color=[0, 0, 0], width=1156, height=752)
         self.Transpose(clip).get_frame(0)
 
+    def test_turn(self):
+        text = self.BlankClip(format=vs.YUV444P8, width=1156, height=752, color=[30, 120, 200], length=1).text.Text("VapourSynth " * 40, alignment=7, scale=3)
+        clips = [self.BlankClip(format=vs.YUV420P8, width=1156, height=752, length=1).text.Text("VapourSynth " * 40, alignment=7, scale=3),
+                 text.std.Expr("x 257 *", format=vs.YUV444P16),
+                 text.std.Expr("x 255 /", format=vs.YUV444PS)]
+        for clip in clips:
+            left = clip.std.TurnLeft()
+            right = clip.std.TurnRight()
+            self.assertEqual((left.width, left.height), (clip.height, clip.width))
+            for turned, ref in [(left, self.Transpose(clip).std.FlipVertical()), (right, self.Transpose(clip).std.FlipHorizontal())]:
+                for plane in range(clip.format.num_planes):
+                    props = turned.std.PlaneStats(ref, plane=plane).get_frame(0).props
+                    self.assertEqual(props["PlaneStatsDiff"], 0)
+
+    def test_convolution_reference(self):
+        # Compares every convolution path against a direct 2D sum with mirrored edges, the values are kept
+        # small so nothing is clipped and the results must match exactly. 5x5 and 1D matrices of up to 25
+        # elements keep their old handling of the bottom and right edges, which isn't a true mirror.
+        width, height = 150, 41
+        seed = 1
+        values = []
+        for i in range(width * height):
+            seed = (seed * 1103515245 + 12345) & 0x7FFFFFFF
+            values.append((seed >> 16) % 64)
+
+        def mirror(i, size):
+            return -i if i < 0 else 2 * (size - 1) - i if i >= size else i
+
+        def legacy_mirror(pos, offset, size):
+            return min(-pos - offset, size - 1) if pos + offset < 0 else max(size - 1 - offset, 0) if pos + offset >= size else pos + offset
+
+        def reference(rows, legacy):
+            size = len(rows)
+            result = []
+            for y in range(height):
+                for x in range(width):
+                    total = 0
+                    for ky in range(size):
+                        dy = ky - size // 2
+                        line = (legacy_mirror(y, dy, height) if legacy else mirror(y + dy, height)) * width
+                        for kx, coeff in enumerate(rows[ky]):
+                            dx = kx - len(rows[ky]) // 2
+                            if coeff:
+                                total += coeff * values[line + (legacy_mirror(x, dx, width) if legacy else mirror(x + dx, width))]
+                    result.append(total)
+            return result
+
+        h = [1, 1, 2, 3, 2, 1, 1]
+        v = [1, 2, 3, 4, 3, 2, 1]
+        # 5x5 and 9x9 aren't separable so they use the 2D kernels
+        irregular5 = [(i * 7) % 5 + 1 for i in range(25)]
+        irregular9 = [(i * 5) % 3 for i in range(81)]
+        long = [i % 3 + 1 for i in range(27)]
+        cases = [([a * b for a in v for b in h], "s", [[a * b for b in h] for a in v], False),
+                 (irregular5, "s", [irregular5[i:i + 5] for i in range(0, 25, 5)], True),
+                 (irregular9, "s", [irregular9[i:i + 9] for i in range(0, 81, 9)], False),
+                 (h, "h", [h], True),
+                 (v, "v", [[c] for c in v], True),
+                 (long, "h", [long], False),
+                 (long, "v", [[c] for c in long], False)]
+
+        blank = self.BlankClip(format=vs.GRAY16, width=width, height=height, length=1)
+        frame = blank.get_frame(0).copy()
+        plane = frame[0]
+        for y in range(height):
+            for x in range(width):
+                plane[y, x] = values[y * width + x]
+        clip = blank.std.ModifyFrame(blank, lambda n, f: frame)
+
+        # SetMaxCPU returns the previous level so it can be put back afterwards
+        previous = self.core.std.SetMaxCPU("none")
+        try:
+            for cpu in ["none", "sse2", "avx2", "avx512"]:
+                self.core.std.SetMaxCPU(cpu)
+                for matrix, mode, rows, legacy in cases:
+                    expected = reference(rows, legacy)
+                    for src in [clip, clip.std.Expr("x", format=vs.GRAYS)]:
+                        result = src.std.Convolution(matrix, mode=mode, divisor=1)
+                        out = result.get_frame(0)[0]
+                        got = [int(out[y, x]) for y in range(height) for x in range(width)]
+                        self.assertEqual(got, expected, "cpu={} mode={} matrix size={} format={}".format(cpu, mode, len(matrix), result.format.name))
+        finally:
+            self.core.std.SetMaxCPU(previous)
+
+    def test_simd_matches_c(self):
+        # Every filter with SIMD kernels has to produce exactly what the C versions produce, on aarch64 this is
+        # what exercises the NEON kernels and elsewhere the levels that don't exist simply fall back to the best one
+        levels = ["neon"] if platform.machine().lower() in ("aarch64", "arm64") else ["sse2", "avx2", "avx512"]
+        # odd sizes so the scalar tails after the vector loops are covered too
+        width, height = 203, 37
+
+        def noise(seed):
+            blank = self.BlankClip(format=vs.YUV444P8, width=width, height=height, length=1)
+            frame = blank.get_frame(0).copy()
+            for p in range(3):
+                plane = frame[p]
+                for y in range(height):
+                    for x in range(width):
+                        seed = (seed * 1103515245 + 12345) & 0x7FFFFFFF
+                        plane[y, x] = (seed >> 16) & 0xFF
+            return blank.std.ModifyFrame(blank, lambda n, f: frame)
+
+        a8, b8, m8 = noise(1), noise(2), noise(3)
+        sources = [(a8, b8, m8)]
+        sources.append(tuple(c.std.Expr(["x 257 * {} -".format(i * 37)], format=vs.YUV444P16) for i, c in enumerate((a8, b8, m8))))
+        sources.append(tuple(c.std.Expr(["x 255 /"], format=vs.YUV444PS) for c in (a8, b8, m8)))
+
+        filters = [("Prewitt", lambda a, b, m: a.std.Prewitt()),
+                   ("Sobel", lambda a, b, m: a.std.Sobel()),
+                   ("Minimum", lambda a, b, m: a.std.Minimum()),
+                   ("Maximum", lambda a, b, m: a.std.Maximum(threshold=20 if a.format.sample_type == vs.INTEGER else 0.1)),
+                   ("Median", lambda a, b, m: a.std.Median()),
+                   ("Median radius=2", lambda a, b, m: a.std.Median(radius=2)),
+                   ("Percentile", lambda a, b, m: a.std.Percentile(30, radius=2)),
+                   ("Deflate", lambda a, b, m: a.std.Deflate()),
+                   ("Inflate", lambda a, b, m: a.std.Inflate()),
+                   ("Convolution 3x3", lambda a, b, m: a.std.Convolution([1, -2, 3, 4, 5, -6, 7, 8, 9])),
+                   ("Convolution 5x5", lambda a, b, m: a.std.Convolution([1, 2, 3, 2, 1] * 5, saturate=False)),
+                   ("Convolution h", lambda a, b, m: a.std.Convolution([1, 3, 5, 3, 1], mode="h")),
+                   ("Convolution v", lambda a, b, m: a.std.Convolution([2, 1, 2], mode="v")),
+                   ("Merge", lambda a, b, m: a.std.Merge(b, 0.3)),
+                   ("MaskedMerge", lambda a, b, m: a.std.MaskedMerge(b, m)),
+                   ("MaskedMerge premultiplied", lambda a, b, m: a.std.MaskedMerge(b, m, premultiplied=True)),
+                   ("PreMultiply", lambda a, b, m: a.std.PreMultiply(m.std.ShufflePlanes(0, vs.GRAY))),
+                   ("MakeDiff", lambda a, b, m: a.std.MakeDiff(b)),
+                   ("MergeDiff", lambda a, b, m: a.std.MergeDiff(b)),
+                   ("Transpose", lambda a, b, m: a.std.Transpose()),
+                   ("AverageFrames", lambda a, b, m: self.core.std.AverageFrames([a, b, m], [1, 2, 1]))]
+
+        def planes(clip):
+            frame = clip.get_frame(0)
+            return [memoryview(frame[p]).tolist() for p in range(frame.format.num_planes)]
+
+        def compare(got, expected, name, cpu, message):
+            if isinstance(got[0][0][0], float):
+                # float results may differ in the last bits depending on the order of operations and sqrt precision
+                for plane_got, plane_expected in zip(got, expected):
+                    for row_got, row_expected in zip(plane_got, plane_expected):
+                        for x, y in zip(row_got, row_expected):
+                            self.assertLessEqual(abs(x - y), 1e-5 * max(1, abs(y)), message)
+            elif (name == "AverageFrames" and cpu == levels[0]) or (name in ("Prewitt", "Sobel") and cpu == "avx2"):
+                # the first SIMD level of AverageFrames rounds differently from C and every later level matches it
+                # instead, the AVX2 Prewitt and Sobel let the compiler fuse the squares into an FMA, so integer
+                # output is allowed to be off by one
+                for plane_got, plane_expected in zip(got, expected):
+                    for row_got, row_expected in zip(plane_got, plane_expected):
+                        self.assertLessEqual(max(abs(x - y) for x, y in zip(row_got, row_expected)), 1, message)
+            else:
+                self.assertEqual(got, expected, message)
+
+        def stats(a, b):
+            props = a.std.PlaneStats(b).get_frame(0).props
+            return [props[k] for k in ("PlaneStatsMin", "PlaneStatsMax", "PlaneStatsAverage", "PlaneStatsDiff")]
+
+        previous = self.core.std.SetMaxCPU("none")
+        try:
+            expected = [[planes(f(*src)) for _, f in filters] + [stats(src[0], src[1])] for src in sources]
+            for cpu in levels:
+                self.core.std.SetMaxCPU(cpu)
+                for src, ref in zip(sources, expected):
+                    for i, (name, f) in enumerate(filters):
+                        got = planes(f(*src))
+                        compare(got, ref[i], name, cpu, "cpu={} filter={} format={}".format(cpu, name, src[0].format.name))
+                        if name == "AverageFrames" and cpu == levels[0]:
+                            ref[i] = got
+                    for got, value in zip(stats(src[0], src[1]), ref[-1]):
+                        if src[0].format.sample_type == vs.FLOAT:
+                            self.assertAlmostEqual(got, value, delta=1e-6 * max(1, abs(value)), msg="cpu={} filter=PlaneStats format={}".format(cpu, src[0].format.name))
+                        else:
+                            self.assertEqual(got, value, "cpu={} filter=PlaneStats format={}".format(cpu, src[0].format.name))
+        finally:
+            self.core.std.SetMaxCPU(previous)
+
+    def test_percentile(self):
+        text = self.BlankClip(format=vs.YUV444P8, width=1156, height=752, color=[30, 120, 200], length=1).text.Text("VapourSynth " * 40, alignment=7, scale=3)
+        clips = [text, text.std.Expr("x 257 *", format=vs.YUV444P16), text.std.Expr("x 255 /", format=vs.YUV444PS)]
+        for clip in clips:
+            for filtered, ref in [(clip.std.Percentile(50), clip.std.Median()),
+                                  (clip.std.Percentile(0), clip.std.Minimum()),
+                                  (clip.std.Percentile(100), clip.std.Maximum()),
+                                  (clip.std.Percentile(50, radius=2), clip.std.Median(radius=2))]:
+                for plane in range(clip.format.num_planes):
+                    props = filtered.std.PlaneStats(ref, plane=plane).get_frame(0).props
+                    self.assertEqual(props["PlaneStatsDiff"], 0)
+
+    def test_rank_reference(self):
+        # Compares the histogram rank filters against sorting every window. Some samples are above the maximum of the
+        # format, those have to be treated as the maximum instead of indexing past the histograms.
+        width, height = 45, 23
+        levels = ["neon"] if platform.machine().lower() in ("aarch64", "arm64") else ["sse2", "avx2", "avx512"]
+
+        def mirror(i, size):
+            return -i if i < 0 else 2 * (size - 1) - i if i >= size else i
+
+        def reference(values, maxval, radius, percentile):
+            size = (2 * radius + 1) ** 2
+            rank = int(percentile / 100 * (size - 1) + 0.5)
+            result = []
+            for y in range(height):
+                for x in range(width):
+                    window = sorted(min(values[mirror(y + dy, height) * width + mirror(x + dx, width)], maxval)
+                                    for dy in range(-radius, radius + 1) for dx in range(-radius, radius + 1))
+                    result.append(window[rank])
+            return result
+
+        cases = [(2, 50), (3, 50), (1, 0), (1, 30), (2, 100), (2, 75)]
+
+        previous = self.core.std.SetMaxCPU("none")
+        try:
+            for format, maxval in [(vs.GRAY8, 255), (vs.GRAY10, 1023), (vs.GRAY16, 65535)]:
+                blank = self.BlankClip(format=format, width=width, height=height, length=1)
+                frame = blank.get_frame(0).copy()
+                plane = frame[0]
+                seed = 1
+                values = []
+                for y in range(height):
+                    for x in range(width):
+                        seed = (seed * 1103515245 + 12345) & 0x7FFFFFFF
+                        value = (seed >> 8) % (maxval + 1)
+                        if maxval == 1023 and x % 5 == 0:
+                            value = 1024 + (seed >> 4) % 64512
+                        plane[y, x] = value
+                        values.append(value)
+                clip = blank.std.ModifyFrame(blank, lambda n, f: frame)
+
+                for radius, percentile in cases:
+                    expected = reference(values, maxval, radius, percentile)
+                    for level in ["none"] + levels:
+                        self.core.std.SetMaxCPU(level)
+                        if percentile == 50:
+                            result = clip.std.Median(radius=radius)
+                        else:
+                            result = clip.std.Percentile(percentile, radius=radius)
+                        out = result.get_frame(0)[0]
+                        got = [out[y, x] for y in range(height) for x in range(width)]
+                        self.assertEqual(got, expected, "cpu={} radius={} percentile={} format={}".format(level, radius, percentile, clip.format.name))
+        finally:
+            self.core.std.SetMaxCPU(previous)
+
     def test_setframeprops(self):
         """ https://github.com/vapoursynth/vapoursynth/issues/1046 """
         matrix = vs.MatrixCoefficients.MATRIX_ST170_M
@@ -0,0 +1,151 @@
+import os
+import shutil
+import subprocess
+import sys
+import sysconfig
+import tempfile
+import unittest
+
+# Autoloaded plugins have their functions cached on disk so their init only runs once one of the functions is used.
+# Every check runs in a new process with its own plugin and cache directories and a tiny plugin that logs every
+# time its init runs.
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+SOURCE = '''
+#include <stdio.h>
+#include <stdlib.h>
+#include "VapourSynth4.h"
+
+static void VS_CC echo(const VSMap *in, VSMap *out, void *userData, VSCore *core, const VSAPI *vsapi) {
+    vsapi->mapSetInt(out, "val", vsapi->mapGetInt(in, "val", 0, NULL), maReplace);
+}
+
+VS_EXTERNAL_API(void) VapourSynthPluginInit2(VSPlugin *plugin, const VSPLUGINAPI *vspapi) {
+    FILE *f = fopen(getenv("CACHETEST_LOG"), "a");
+    fputs("init\\n", f);
+    fclose(f);
+    vspapi->configPlugin("com.vapoursynth.cachetest", "cachetest", "Plugin cache test", VS_MAKE_VERSION(1, 0), VAPOURSYNTH_API_VERSION, 0, plugin);
+#ifndef NO_ECHO
+    vspapi->registerFunction("Echo", "val:int;", "val:int;", echo, NULL, plugin);
+#endif
+#ifdef EXTRA
+    vspapi->registerFunction("Extra", "val:int;", "val:int;", echo, NULL, plugin);
+#endif
+}
+'''
+
+# Prints how often the init ran after creating the core and after invoking Echo
+SCRIPT = '''
+import os, sys
+import vapoursynth as vs
+plugin = vs.core.cachetest
+log = os.environ['CACHETEST_LOG']
+def inits():
+    return open(log).read().count('init') if os.path.exists(log) else 0
+print(inits(), sorted(f.name for f in plugin.functions()))
+if len(sys.argv) > 1:
+    os.replace(sys.argv[1], os.environ['CACHETEST_PLUGIN'])
+try:
+    result = plugin.Echo(val=3)
+except vs.Error as e:
+    result = 'error ' + str(e).splitlines()[0]
+print(inits(), result)
+'''
+
+class PluginCacheTestSequence(unittest.TestCase):
+
+    @classmethod
+    def setUpClass(cls):
+        cls.tmpdir = tempfile.mkdtemp()
+        cls.source = os.path.join(cls.tmpdir, 'cachetest.c')
+        with open(cls.source, 'w') as f:
+            f.write(SOURCE)
+        cls.cc = os.environ.get('CC') or (sysconfig.get_config_var('CC') or 'cc').split()[0]
+        try:
+            cls.build(os.path.join(cls.tmpdir, 'probe.so'))
+        except (OSError, subprocess.CalledProcessError):
+            shutil.rmtree(cls.tmpdir)
+            raise unittest.SkipTest('no C compiler available')
+
+    @classmethod
+    def tearDownClass(cls):
+        shutil.rmtree(cls.tmpdir)
+
+    @classmethod
+    def build(cls, library, *defines):
+        subprocess.run([cls.cc, '-shared', '-fPIC', '-O2', '-I', os.path.join(ROOT, 'include')] + ['-D' + d for d in defines] + ['-o', library, cls.source], check=True, capture_output=True)
+
+    def setUp(self):
+        self.dir = tempfile.mkdtemp(dir=self.tmpdir)
+        os.makedirs(os.path.join(self.dir, 'config', 'vapoursynth'))
+        os.makedirs(os.path.join(self.dir, 'plugins'))
+        with open(os.path.join(self.dir, 'config', 'vapoursynth', 'vapoursynth.conf'), 'w') as f:
+            f.write('UserPluginDir={}\nAutoloadSystemPluginDir=false\n'.format(os.path.join(self.dir, 'plugins')))
+        self.plugin = os.path.join(self.dir, 'plugins', 'cachetest.so')
+        self.build(self.plugin)
+        self.env = dict(os.environ, XDG_CONFIG_HOME=os.path.join(self.dir, 'config'), XDG_CACHE_HOME=os.path.join(self.dir, 'cache'),
+                        CACHETEST_LOG=os.path.join(self.dir, 'log'), CACHETEST_PLUGIN=self.plugin)
+        self.env.pop('VSC_DISABLE_PLUGIN_CACHE', None)
+        self.env.pop('VSC_DISABLE_LAZY_PLUGIN', None)
+
+    def run_script(self, *args):
+        result = subprocess.run([sys.executable, '-c', SCRIPT] + list(args), env=self.env, capture_output=True, text=True, timeout=60)
+        self.assertEqual(result.returncode, 0, result.stderr)
+        return result.stdout.splitlines()
+
+    def cached_plugins(self):
+        with open(os.path.join(self.dir, 'cache', 'vapoursynth', 'plugincache')) as f:
+            return [line.split('\t')[1] for line in f if line.startswith('P\t')]
+
+    def test_cache_hit(self):
+        # the first core has to run the init to find the functions, it's loaded again when Echo is used
+        self.assertEqual(self.run_script(), ["1 ['Echo']", "2 3"])
+        self.assertEqual(self.cached_plugins(), [self.plugin])
+        # after that the functions come from the cache and the init only runs for Echo
+        self.assertEqual(self.run_script(), ["2 ['Echo']", "3 3"])
+        self.assertEqual(self.run_script(), ["3 ['Echo']", "4 3"])
+
+    def test_stale_entry(self):
+        self.run_script()
+        # a different size or modification time means the cached functions can't be trusted anymore
+        self.build(self.plugin, 'EXTRA')
+        self.assertEqual(self.run_script(), ["3 ['Echo', 'Extra']", "4 3"])
+        self.assertEqual(self.run_script(), ["4 ['Echo', 'Extra']", "5 3"])
+        stat = os.stat(self.plugin)
+        os.utime(self.plugin, ns=(stat.st_atime_ns, stat.st_mtime_ns + 1000000000))
+        self.assertEqual(self.run_script(), ["6 ['Echo', 'Extra']", "7 3"])
+
+    def test_failed_load(self):
+        self.run_script()
+        # the plugin is replaced after the core was created from the cache so the load only fails once Echo is
+        # used, that has to be an error and not take down the process, and the entry is dropped from the cache
+        broken = os.path.join(self.dir, 'broken.so')
+        with open(broken, 'wb') as f:
+            f.write(b'not a library')
+        lines = self.run_script(broken)
+        self.assertEqual(lines[0], "2 ['Echo']")
+        self.assertTrue(lines[1].startswith('2 error Failed to load ' + self.plugin), lines[1])
+        self.assertEqual(self.cached_plugins(), [])
+
+        # a plugin that no longer registers the function
+        self.build(self.plugin)
+        self.run_script()
+        self.build(broken, 'NO_ECHO')
+        lines = self.run_script(broken)
+        self.assertEqual(lines[0], "4 ['Echo']")
+        self.assertEqual(lines[1], "5 error Function 'Echo' is no longer registered by " + self.plugin)
+        self.assertEqual(self.cached_plugins(), [])
+
+        # cached plugins are still opened when the core is created so one that can't be loaded anymore is skipped
+        # like any other, the size and modification time are kept so the cache entry still matches
+        self.build(self.plugin)
+        self.run_script()
+        stat = os.stat(self.plugin)
+        with open(self.plugin, 'r+b') as f:
+            f.write(b'garbage!')
+        os.utime(self.plugin, ns=(stat.st_atime_ns, stat.st_mtime_ns))
+        result = subprocess.run([sys.executable, '-c', 'import vapoursynth as vs; print(hasattr(vs.core, "cachetest"))'], env=self.env, capture_output=True, text=True, timeout=60)
+        self.assertEqual(result.stdout, 'False\n', result.stderr)
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,135 @@
+import ctypes
+import os
+import shutil
+import subprocess
+import sysconfig
+import tempfile
+import unittest
+
+# src/common/requestwindow.h is header only so it gets compiled into a tiny library here and driven with made up
+# timings, that way the adjustments can be checked without depending on how fast the machine happens to be
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+SOURCE = '''
+#include "src/common/requestwindow.h"
+void init(VSRequestWindow *w, int numThreads, double now) { vsRequestWindowInit(w, numThreads, now); }
+int frame_done(VSRequestWindow *w, double now) { return vsRequestWindowFrameDone(w, now); }
+void adjust(VSRequestWindow *w, double now, int overLimit) { vsRequestWindowAdjust(w, now, overLimit); }
+'''
+
+class VSRequestWindow(ctypes.Structure):
+    _fields_ = [('window', ctypes.c_int),
+                ('minWindow', ctypes.c_int),
+                ('maxWindow', ctypes.c_int),
+                ('direction', ctypes.c_int),
+                ('completedFrames', ctypes.c_int),
+                ('periodStart', ctypes.c_double),
+                ('lastThroughput', ctypes.c_double)]
+
+class RequestWindowTestSequence(unittest.TestCase):
+
+    @classmethod
+    def setUpClass(cls):
+        cls.tmpdir = tempfile.mkdtemp()
+        source = os.path.join(cls.tmpdir, 'requestwindow.c')
+        library = os.path.join(cls.tmpdir, 'requestwindow.so')
+        with open(source, 'w') as f:
+            f.write(SOURCE)
+        cc = os.environ.get('CC') or (sysconfig.get_config_var('CC') or 'cc').split()[0]
+        try:
+            subprocess.run([cc, '-shared', '-fPIC', '-O2', '-I', ROOT, '-o', library, source], check=True, capture_output=True)
+        except (OSError, subprocess.CalledProcessError):
+            shutil.rmtree(cls.tmpdir)
+            raise unittest.SkipTest('no C compiler available')
+        cls.lib = ctypes.CDLL(library)
+        for name, args in [('init', [ctypes.c_int, ctypes.c_double]), ('frame_done', [ctypes.c_double]), ('adjust', [ctypes.c_double, ctypes.c_int])]:
+            getattr(cls.lib, name).argtypes = [ctypes.POINTER(VSRequestWindow)] + args
+        cls.lib.frame_done.restype = ctypes.c_int
+        cls.lib.init.restype = None
+        cls.lib.adjust.restype = None
+
+    @classmethod
+    def tearDownClass(cls):
+        shutil.rmtree(cls.tmpdir)
+
+    def setUp(self):
+        self.w = VSRequestWindow()
+        self.now = 100.0
+        self.lib.init(ctypes.byref(self.w), 8, self.now)
+
+    # Completes frames at the given throughput in frames per second until the period is over and returns the new window
+    def period(self, throughput, over_limit=False):
+        frames = 0
+        done = False
+        while not done:
+            self.now += 1 / throughput
+            frames += 1
+            done = self.lib.frame_done(ctypes.byref(self.w), self.now)
+        self.assertGreaterEqual(frames, 2 * self.w.window)
+        self.lib.adjust(ctypes.byref(self.w), self.now, over_limit)
+        return self.w.window
+
+    def test_init(self):
+        self.assertEqual((self.w.window, self.w.minWindow, self.w.maxWindow, self.w.direction), (8, 1, 32, 1))
+        self.lib.init(ctypes.byref(self.w), 0, self.now)
+        self.assertEqual((self.w.window, self.w.maxWindow), (1, 4))
+
+    def test_period_length(self):
+        # twice the window in frames isn't enough, at least 50ms also has to pass
+        for i in range(15):
+            self.assertFalse(self.lib.frame_done(ctypes.byref(self.w), self.now + 1))
+        self.assertFalse(self.lib.frame_done(ctypes.byref(self.w), self.now + 0.04))
+        self.assertTrue(self.lib.frame_done(ctypes.byref(self.w), self.now + 0.06))
+
+    def test_hill_climbing(self):
+        # the first period has nothing to compare with so the window grows by an eighth
+        self.assertEqual(self.period(100), 9)
+        # keeps growing as long as it gets faster
+        self.assertEqual(self.period(110), 10)
+        self.assertEqual(self.period(120), 11)
+        # turns around when it gets slower
+        self.assertEqual(self.period(100), 10)
+        self.assertEqual(self.period(110), 9)
+        # no measurable change prefers the smaller window
+        self.assertEqual(self.period(110.5), 8)
+        self.assertEqual(self.w.direction, -1)
+
+    def test_over_limit_shrinks(self):
+        self.period(100)
+        self.period(200)
+        self.period(400)
+        self.assertEqual(self.w.window, 11)
+        # shrinks by a quarter even though it got faster and forgets the throughput measured while over the limit
+        self.assertEqual(self.period(800, True), 9)
+        self.assertEqual(self.w.direction, -1)
+        self.assertEqual(self.w.lastThroughput, 0)
+        # with no reference the next period keeps going in the same direction
+        self.assertEqual(self.period(1), 8)
+
+    def test_clamps(self):
+        for i in range(20):
+            self.period(100, True)
+        self.assertEqual(self.w.window, self.w.minWindow)
+        # bouncing off the bottom turns it around
+        self.assertEqual(self.w.direction, 1)
+
+        # keeps getting faster so it grows until it stops at the top and turns around there
+        throughput = 100
+        for i in range(40):
+            throughput *= 1.1
+            if self.period(throughput) == self.w.maxWindow:
+                break
+        self.assertEqual(self.w.window, self.w.maxWindow)
+        self.assertEqual(self.w.direction, -1)
+        self.assertEqual(self.period(throughput * 1.1), self.w.maxWindow - self.w.maxWindow // 8)
+
+    def test_converges(self):
+        # throughput that peaks at a window of 20 and falls off on both sides, it should end up circling around the peak
+        windows = []
+        for i in range(40):
+            windows.append(self.period(1000 / (1 + 0.05 * abs(self.w.window - 20))))
+        for window in windows[-10:]:
+            self.assertLessEqual(abs(window - 20), 2)
+
+if __name__ == '__main__':
+    unittest.main()
@@ -1,4 +1,6 @@
 import unittest
+import random
+import time
 import vapoursynth as vs
 
 def float_lut(x):
@@ -27,6 +29,161 @@ class CoreTestSequence(unittest.TestCase):
             self.assertIsInstance(frame, vs.VideoFrame)
         self.assertEqual(e, 199)
 
+    def frames_clip(self, length, fail=None, requested=None):
+        # Frames finish in random order and carry their number in a property
+        def mark(n, f):
+            if requested is not None:
+                requested.append(n)
+            if n == fail:
+                raise vs.Error('frame {} failed on purpose'.format(n))
+            time.sleep(random.random() * 0.002)
+            fout = f.copy()
+            fout.props['N'] = n
+            return fout
+        clip = self.core.std.BlankClip(format=vs.GRAY8, width=64, height=48, length=length)
+        return clip.std.ModifyFrame(clip, mark)
+
+    def test_frames_order(self):
+        clip = self.frames_clip(200)
+        for prefetch, backlog in [(None, None), (1, None), (4, 4), (4, 32), (16, 1)]:
+            frames = list(clip.frames(prefetch, backlog))
+            # frames stay valid after the iterator is done with them
+            self.assertEqual([f.props['N'] for f in frames], list(range(200)), (prefetch, backlog))
+
+    def test_frames_early_exit(self):
+        requested = []
+        clip = self.frames_clip(1000, requested=requested)
+        frames = clip.frames(4, 8)
+        for n, f in enumerate(frames):
+            self.assertEqual(f.props['N'], n)
+            if n == 9:
+                break
+        frames.close()
+        # nothing more is requested once the frames in flight have finished
+        time.sleep(0.2)
+        count = len(requested)
+        self.assertLess(count, 10 + 8 + 4)
+        time.sleep(0.2)
+        self.assertEqual(len(requested), count)
+        self.assertEqual(self.core.stats()['queued_tasks'], 0)
+        # and the clip can be iterated again
+        self.assertEqual([f.props['N'] for f in clip.frames(4, 8)][:20], list(range(20)))
+
+    def test_frames_error(self):
+        clip = self.frames_clip(100, fail=37)
+        for prefetch in [None, 1, 8]:
+            seen = []
+            with self.assertRaisesRegex(vs.Error, 'frame 37 failed on purpose'):
+                for f in clip.frames(prefetch):
+                    seen.append(f.props['N'])
+            # everything before the failing frame is still delivered in order
+            self.assertEqual(seen, list(range(37)), prefetch)
+
+    def test_frames_adaptive_window(self):
+        # Frames finish out of order and the request window gets adjusted along the way, the second pass is
+        # over the cache limit nearly all the time so the window keeps shrinking instead
+        def mark(n, f):
+            time.sleep(random.random() * 0.002)
+            fout = f.copy()
+            fout.props['N'] = n
+            return fout
+        clip = self.core.std.BlankClip(format=vs.YUV420P8, width=640, height=480, length=600)
+        clip = clip.std.ModifyFrame(clip, mark)
+        old_cache_size = self.core.max_cache_size
+        try:
+            for cache_size in [old_cache_size, 1]:
+                self.core.max_cache_size = cache_size
+                self.assertEqual([f.props['N'] for f in clip.frames()], list(range(600)))
+        finally:
+            self.core.max_cache_size = old_cache_size
+
+    def test_array_interface(self):
+        frame = self.core.std.BlankClip(format=vs.YUV420P16, width=64, height=48).get_frame(0)
+        planes = frame.planes()
+        self.assertEqual(len(planes), 3)
+        interface = planes[1].__array_interface__
+        self.assertEqual(interface['shape'], (24, 32))
+        self.assertEqual(interface['strides'][0], frame.get_stride(1))
+        self.assertEqual(interface['data'], (frame.get_read_ptr(1).value, True))
+        self.assertTrue(memoryview(planes[1]).readonly)
+        with self.assertRaises(AttributeError):
+            frame.__array_interface__
+        with self.assertRaises(BufferError):
+            frame.__dlpack__()
+
+    def test_frame_from_buffer(self):
+        src = self.core.std.BlankClip(format=vs.YUV420P8, width=50, height=30, color=[10, 20, 30]).get_frame(0)
+        frame = self.core.frame_from_buffer(src.format, src.planes(), prop_src=src)
+        self.assertTrue(frame.readonly)
+        self.assertEqual((frame.width, frame.height), (50, 30))
+        self.assertEqual(frame.get_read_ptr(2).value, src.get_read_ptr(2).value)
+        self.assertEqual(frame[2][14, 24], 30)
+        with self.assertRaises(ValueError):
+            self.core.frame_from_buffer(src.format, src.planes()[:1])
+
+    def test_to_array(self):
+        clip = self.core.std.Splice([self.core.std.BlankClip(format=vs.GRAY8, width=16, height=8, color=i, length=1) for i in range(10)])
+        out = clip.to_array(range(1, 10, 2))
+        self.assertEqual(out.shape, (5, 8, 16))
+        self.assertEqual([out[i, 7, 15] for i in range(5)], [1, 3, 5, 7, 9])
+        with self.assertRaises(ValueError):
+            clip.to_array(range(3), out)
+
+    def test_modify_props(self):
+        clip = self.core.std.BlankClip(format=vs.GRAY8, length=10).std.SetFrameProp(prop='Old', intval=1)
+        batches = []
+        def selector(n, f):
+            batches.append(n)
+            return [{'Num': x, 'Old': None} if x % 2 else None for x in n]
+        clip = clip.modify_props(selector, batch=4)
+        props = [dict(f.props) for f in clip.frames()]
+        self.assertEqual(sorted(batches), [[0, 1, 2, 3], [4, 5, 6, 7], [8, 9]])
+        self.assertEqual(props[3]['Num'], 3)
+        self.assertNotIn('Old', props[3])
+        self.assertNotIn('Num', props[4])
+        self.assertEqual(props[4]['Old'], 1)
+
+    def test_modify_props_sparse(self):
+        # only one frame of every batch is requested so the batches are never complete and only the newest are kept
+        clip = self.core.std.BlankClip(format=vs.GRAY8, width=8, height=8, length=400)
+        batches = []
+        def selector(n, f):
+            batches.append(n[0])
+            return [{'Num': x} for x in n]
+        clip = clip.modify_props(selector, batch=4)
+        for n in range(0, 400, 4):
+            self.assertEqual(clip.get_frame(n).props['Num'], n)
+        self.assertEqual(batches, list(range(0, 400, 4)))
+        self.assertEqual(clip.get_frame(397).props['Num'], 397)
+        self.assertEqual(clip.get_frame(1).props['Num'], 1)
+        self.assertEqual(batches.count(396), 1)
+        self.assertEqual(batches.count(0), 2)
+
+        # the same frames requested many times at once
+        futures = [clip.get_frame_async(n % 37) for n in range(400)]
+        for i, future in enumerate(futures):
+            self.assertEqual(future.result().props['Num'], i % 37)
+
+    def test_props_to_dict(self):
+        clip = self.core.std.BlankClip(length=1).std.SetFrameProp(prop='Arr', intval=[1, 2]).std.SetFrameProp(prop='Data', data='x')
+        props = clip.get_frame(0).props
+        self.assertEqual(props.to_dict(), dict(props))
+        self.assertEqual(props.to_dict(['Arr', 'Missing', '_DurationNum']), {'Arr': [1, 2], '_DurationNum': 1})
+        self.assertEqual(props['_DurationDen'], 24)
+
+    def test_core_stats(self):
+        clip = self.core.std.BlankClip(length=10)
+        spliced = self.core.std.Splice([clip, clip])
+        for f in spliced.frames():
+            pass
+        stats = self.core.stats()
+        self.assertEqual(stats['threads'], 10)
+        self.assertEqual(stats['queued_tasks'], 0)
+        self.assertGreater(stats['framebuffer_max'], 0)
+        self.assertIn('BlankClip', [c['name'] for c in stats['caches']])
+        for c in stats['caches']:
+            self.assertLessEqual(c['history'], c['max_history'])
+
 ### Filter-Call-Tests
 
     def test_func1(self):
@@ -0,0 +1,507 @@
+import array
+import json
+import os
+import shutil
+import signal
+import subprocess
+import tempfile
+import time
+import unittest
+import vapoursynth as vs
+
+# Runs the vspipe binary found in the path, or the one pointed to by VSPIPE, on a small script and compares what
+# it writes with the frames the same script produces when evaluated here
+VSPIPE = os.environ.get('VSPIPE') or shutil.which('vspipe')
+
+SCRIPT = '''
+import random
+import time
+import vapoursynth as vs
+core = vs.core
+
+def plane(width, height, color, alignment):
+    return core.std.BlankClip(format=vs.GRAY8, width=width, height=height, length=40, color=color).text.FrameNum(alignment=alignment)
+
+# every plane gets its own content and the widths leave padding at the end of the rows
+def source(subw, subh, bits):
+    planes = [plane(134, 100, 16, 7), plane(134 >> subw, 100 >> subh, 128, 5), plane(134 >> subw, 100 >> subh, 200, 3)]
+    clip = core.std.ShufflePlanes(planes, [0, 0, 0], vs.YUV)
+    if bits > 8:
+        clip = clip.std.Expr('x 4 * 3 +', format=core.query_video_format(vs.YUV, vs.INTEGER, bits, subw, subh).id)
+    return clip
+
+# frames finish in random order so the output has to be put back in order
+def jitter(n, f):
+    if n == int(globals().get('fail', -1)):
+        raise vs.Error('frame {} failed on purpose'.format(n))
+    time.sleep(float(globals().get('slow', 0)) + random.random() * 0.002)
+    if n == int(globals().get('change', -1)):
+        f = f.copy()
+        memoryview(f[1])[0, 0] ^= 1
+    return f
+
+yuv420p8 = source(1, 1, 8)
+yuv420p8 = yuv420p8.std.ModifyFrame(yuv420p8, jitter)
+yuv420p8.set_output(0)
+yuv420p10 = source(1, 1, 10)
+yuv420p10.set_output(1)
+rgb24 = core.std.ShufflePlanes(source(0, 0, 8), [0, 1, 2], vs.RGB)
+rgb24.set_output(2)
+alpha = plane(134, 100, 77, 1)
+rgb24.set_output(3, alpha=alpha)
+yuv422p8 = source(1, 0, 8)
+yuv422p8.set_output(4)
+yuv422p10 = source(1, 0, 10)
+yuv422p10.set_output(5)
+core.std.BlankAudio(length=48000).set_output(6)
+'''
+
+@unittest.skipIf(VSPIPE is None, 'vspipe not found')
+class VSPipeTestSequence(unittest.TestCase):
+
+    @classmethod
+    def setUpClass(cls):
+        cls.tmpdir = tempfile.mkdtemp()
+        cls.script = os.path.join(cls.tmpdir, 'script.vpy')
+        with open(cls.script, 'w') as f:
+            f.write(SCRIPT)
+        cls.clips = {}
+        exec(SCRIPT, cls.clips)
+        vs.clear_outputs()
+
+    @classmethod
+    def tearDownClass(cls):
+        shutil.rmtree(cls.tmpdir)
+
+    def run_vspipe(self, *args):
+        return subprocess.run([VSPIPE] + list(args), stdout=subprocess.PIPE, stderr=subprocess.PIPE, timeout=120)
+
+    def output_path(self, name='out.raw'):
+        return os.path.join(self.tmpdir, name)
+
+    def read_output(self, name='out.raw'):
+        with open(self.output_path(name), 'rb') as f:
+            return f.read()
+
+    def expected(self, clip, first=0, last=None):
+        last = clip.num_frames - 1 if last is None else last
+        data = bytearray()
+        for n in range(first, last + 1):
+            frame = clip.get_frame(n)
+            for p in range(frame.format.num_planes):
+                data += bytes(frame[p])
+        return bytes(data)
+
+    def test_output(self):
+        expected = self.expected(self.clips['yuv420p8'])
+        for requests in [[], ['-r', '1'], ['-r', '3'], ['-r', '64']]:
+            result = self.run_vspipe(*requests, self.script, self.output_path())
+            self.assertEqual(result.returncode, 0, result.stderr)
+            self.assertEqual(self.read_output(), expected, requests)
+
+    def test_range(self):
+        result = self.run_vspipe('-s', '5', '-e', '9', self.script, self.output_path())
+        self.assertEqual(result.returncode, 0, result.stderr)
+        self.assertEqual(self.read_output(), self.expected(self.clips['yuv420p8'], 5, 9))
+
+    def test_y4m(self):
+        result = self.run_vspipe('-c', 'y4m', '-s', '3', '-e', '12', self.script, self.output_path())
+        self.assertEqual(result.returncode, 0, result.stderr)
+        header, data = self.read_output().split(b'\n', 1)
+        self.assertTrue(header.startswith(b'YUV4MPEG2 C420 W134 H100 F24:1 '), header)
+        clip = self.clips['yuv420p8']
+        self.assertEqual(data, b''.join(b'FRAME\n' + self.expected(clip, n, n) for n in range(3, 13)))
+
+    def test_slow_reader(self):
+        # the reader falls behind so the writer thread blocks and the number of requests in flight has to back off
+        expected = self.expected(self.clips['yuv420p8'])
+        for direct in [[], ['--direct']]:
+            data = bytearray()
+            with subprocess.Popen([VSPIPE, '-r', '4'] + direct + [self.script, '-'], stdout=subprocess.PIPE, stderr=subprocess.PIPE) as process:
+                while True:
+                    chunk = process.stdout.read(8192)
+                    if not chunk:
+                        break
+                    data += chunk
+                    time.sleep(0.002)
+                stderr = process.stderr.read()
+                self.assertEqual(process.wait(timeout=60), 0, stderr)
+            self.assertEqual(bytes(data), expected, direct)
+
+    def test_frame_error(self):
+        result = self.run_vspipe('-a', 'fail=20', self.script, self.output_path())
+        self.assertNotEqual(result.returncode, 0)
+        self.assertIn(b'frame 20 failed on purpose', result.stderr)
+        # everything before the failing frame was still written in order
+        output = self.read_output()
+        self.assertEqual(output, self.expected(self.clips['yuv420p8'], 0, len(output) // (134 * 100 * 3 // 2) - 1))
+
+    @unittest.skipIf(os.name == 'nt', 'Ctrl-C terminates vspipe on Windows')
+    def test_interrupt(self):
+        # Ctrl-C stops the output between two frames and whatever was written until then is still complete
+        if os.path.exists(self.output_path()):
+            os.remove(self.output_path())
+        with subprocess.Popen([VSPIPE, '-r', '2', '-a', 'slow=0.05', self.script, self.output_path()], stdout=subprocess.PIPE, stderr=subprocess.PIPE) as process:
+            deadline = time.monotonic() + 30
+            while not os.path.exists(self.output_path()) or os.path.getsize(self.output_path()) == 0:
+                self.assertLess(time.monotonic(), deadline)
+                time.sleep(0.01)
+            process.send_signal(signal.SIGINT)
+            stderr = process.communicate(timeout=60)[1]
+        self.assertEqual(process.returncode, 1, stderr)
+        self.assertIn(b'Interrupted after', stderr)
+        output = self.read_output()
+        frames = len(output) // (134 * 100 * 3 // 2)
+        self.assertLess(frames, 40)
+        self.assertEqual(output, self.expected(self.clips['yuv420p8'], 0, frames - 1))
+
+    def test_checksum_manifest(self):
+        manifest = self.output_path('manifest.txt')
+        for props in [[], ['--checksum-props']]:
+            result = self.run_vspipe(*props, '--checksum-manifest', manifest, self.script, self.output_path())
+            self.assertEqual(result.returncode, 0, result.stderr)
+            self.assertEqual(self.read_output(), self.expected(self.clips['yuv420p8']))
+            with open(manifest) as f:
+                lines = f.read().splitlines()
+            self.assertEqual(lines[0], '# vspipe checksum manifest xxh64 planes=3 alpha=0 props={}'.format(1 if props else 0))
+            self.assertEqual([line.split()[0] for line in lines[1:]], [str(n) for n in range(40)])
+            self.assertEqual(len(lines[1].split()), 5 if props else 4)
+
+            result = self.run_vspipe(*props, '--verify-manifest', manifest, self.script, '.')
+            self.assertEqual(result.returncode, 0, result.stderr)
+            self.assertIn(b'Checksums match for all 40 frames', result.stderr)
+
+            # a single changed sample in the second plane of frame 17 is caught there
+            result = self.run_vspipe(*props, '-a', 'change=17', '--verify-manifest', manifest, self.script, self.output_path())
+            self.assertNotEqual(result.returncode, 0)
+            self.assertIn(b'checksum mismatch at frame 17\nExpected: ' + lines[18].encode(), result.stderr)
+            # the mismatching frame itself has already been written but nothing after it
+            expected = self.expected(self.clips['yuv420p8'], 0, 16)
+            output = self.read_output()
+            self.assertEqual(len(output), len(expected) * 18 // 17)
+            self.assertEqual(output[:len(expected)], expected)
+
+        for args, message in [(['-o', '3', '--verify-manifest', manifest, self.script, '.'], b"Checksum manifest settings don't match the output"),
+                              (['-o', '1', '--verify-manifest', manifest, self.script, '.'], b'checksum mismatch at frame 0'),
+                              (['-e', '9', '--verify-manifest', manifest, self.script, '.'], b'checksum manifest has 40 frames but 10 were output'),
+                              (['--verify-manifest', self.output_path('missing.txt'), self.script, '.'], b'Failed to read checksum manifest')]:
+            result = self.run_vspipe('--checksum-props', *args)
+            self.assertNotEqual(result.returncode, 0, args)
+            self.assertIn(message, result.stderr, args)
+
+    def test_benchmark(self):
+        result = self.run_vspipe('--benchmark', '-s', '5', '-e', '14', '--threads-sweep', '1,2', self.script, self.output_path('benchmark.json'))
+        self.assertEqual(result.returncode, 0, result.stderr)
+        with open(self.output_path('benchmark.json')) as f:
+            stats = json.load(f)
+        self.assertEqual(stats['frames'], 10)
+        self.assertGreater(stats['fps'], 0)
+        self.assertGreater(stats['time'], 0)
+        self.assertIn('framebuffer_used', stats['core'])
+        # every filter between the trim and the sources shows up with all of the frames it produced
+        names = [node['name'] for node in stats['nodes']]
+        self.assertEqual(names[:3], ['std.Trim', 'std.ModifyFrame', 'std.ShufflePlanes'])
+        self.assertEqual(names.count('std.BlankClip'), 3)
+        for node in stats['nodes']:
+            self.assertEqual(node['frames'], 10, node['name'])
+            self.assertIn(node['mode'], ['parallel', 'parreq', 'unordered', 'fstate'], node['name'])
+            self.assertLessEqual(node['latency_p50'], node['latency_p95'], node['name'])
+            self.assertLessEqual(node['latency_p95'], node['latency_p99'], node['name'])
+        self.assertEqual([run['threads'] for run in stats['threads_sweep']], [1, 2])
+        self.assertEqual(stats['threads_sweep'][0]['speedup'], 1)
+        for run in stats['threads_sweep']:
+            self.assertGreater(run['fps'], 0)
+
+        for args, message in [(['--threads-sweep', '1,x', '--benchmark', self.script, '.'], b"Couldn't convert 1,x to a list of thread counts"),
+                              (['--threads-sweep', '1,2', self.script, '.'], b'Thread sweeps can only be used together with benchmark')]:
+            result = self.run_vspipe(*args)
+            self.assertNotEqual(result.returncode, 0, args)
+            self.assertIn(message, result.stderr, args)
+
+    def test_trace(self):
+        trace = self.output_path('trace.json')
+        result = self.run_vspipe('--trace', trace, '-s', '2', '-e', '6', self.script, self.output_path())
+        self.assertEqual(result.returncode, 0, result.stderr)
+        self.assertEqual(self.read_output(), self.expected(self.clips['yuv420p8'], 2, 6))
+        with open(trace) as f:
+            data = json.load(f)
+        self.assertEqual(data['displayTimeUnit'], 'ns')
+        self.assertEqual(data['otherData'], {'droppedEvents': 0})
+        events = data['traceEvents']
+        self.assertIn({'name': 'process_name', 'ph': 'M', 'pid': 1, 'args': {'name': 'VapourSynth'}}, events)
+        for event in events:
+            self.assertIn(event['ph'], ['M', 'X', 'i'], event)
+            self.assertIsInstance(event['pid'], int, event)
+            if event['ph'] != 'M':
+                self.assertIsInstance(event['tid'], int, event)
+                self.assertGreaterEqual(event['ts'], 0, event)
+            if event['ph'] == 'X':
+                self.assertGreaterEqual(event['dur'], 0, event)
+
+        # every output frame has been requested from the trim and the frames it passes on from the filter before it
+        def frames(name, reason):
+            return sorted(set(event['args']['frame'] for event in events if event.get('cat') == 'filter' and event['name'] == name and event['args']['reason'] == reason))
+        self.assertEqual(frames('Trim', 'initial'), list(range(5)))
+        self.assertEqual(frames('Trim', 'all frames ready'), list(range(5)))
+        self.assertEqual(frames('ModifyFrame', 'initial'), list(range(2, 7)))
+        self.assertEqual(frames('ModifyFrame', 'all frames ready'), list(range(2, 7)))
+        self.assertTrue(any(event.get('cat') == 'memory' and event['name'] == 'allocate' for event in events))
+
+    def test_multiple_outputs(self):
+        # every output rendered together matches what a run with only that output writes
+        outputs = [('0', 'a.raw', []), ('1', 'b.y4m', ['-c', 'y4m']), ('3', 'c.raw', []), ('6', 'd.wav', ['-c', 'wav'])]
+        args = []
+        for index, name, container in outputs:
+            args += ['-o', index + '=' + self.output_path(name)]
+        result = self.run_vspipe(*args, self.script)
+        self.assertEqual(result.returncode, 0, result.stderr)
+        self.assertIn(b'Rendered 4 outputs', result.stderr)
+        for index, name, container in outputs:
+            result = self.run_vspipe('-o', index, *container, self.script, self.output_path('single'))
+            self.assertEqual(result.returncode, 0, result.stderr)
+            self.assertEqual(self.read_output(name), self.read_output('single'), index)
+        self.assertEqual(self.read_output('a.raw'), self.expected(self.clips['yuv420p8']))
+
+        # one of the outputs can go to stdout
+        result = self.run_vspipe('-o', '0=-', '-o', '1=' + self.output_path('b.raw'), self.script)
+        self.assertEqual(result.returncode, 0, result.stderr)
+        self.assertEqual(result.stdout, self.expected(self.clips['yuv420p8']))
+        self.assertEqual(self.read_output('b.raw'), self.expected(self.clips['yuv420p10']))
+
+        for args, message in [(['-o', '0=-', '-o', '1=-', self.script], b'Only one output can be written to stdout'),
+                              (['-o', '0=.', '-o', '1=.', '-s', '2', self.script], b'Cannot set a range when rendering multiple outputs'),
+                              (['-o', '0=.', '-o', '1=.', '-c', 'y4m', self.script], b'Containers are picked by the file extension'),
+                              (['-o', '0=.', '-o', '1=.', '-t', self.output_path('tc.txt'), self.script], b'Cannot write timecodes, JSON or checksum files'),
+                              (['-o', '0=.', '-o', '1=.', self.script, '.'], b'Multiple outputs can only be used for output and not together with an output file')]:
+            result = self.run_vspipe(*args)
+            self.assertNotEqual(result.returncode, 0, args)
+            self.assertIn(message, result.stderr, args)
+
+    # The dot output of --graph full with the node addresses replaced by the function call and name of every node
+    def graph(self, *args):
+        result = self.run_vspipe('-g', 'full', *args)
+        self.assertEqual(result.returncode, 0, result.stderr)
+        names = {}
+        label = None
+        edges = []
+        for line in result.stdout.decode().splitlines():
+            line = line.strip()
+            if line.startswith('label='):
+                label = line
+            elif line.startswith('n') and '[label=' in line:
+                names[line.split()[0]] = label + ' ' + line.split(None, 1)[1]
+            elif '->' in line:
+                edges.append(line.split(' -> '))
+        return sorted(names.values()), sorted((names[a], names[b]) for a, b in edges)
+
+    def test_graph_snapshot(self):
+        # a snapshot recreates the same filters in a new core and they produce the same frames
+        snapshot = self.output_path('graph.txt')
+        for index in ['1', '3', '5']:
+            result = self.run_vspipe('-o', index, '--save-graph', snapshot, self.script, self.output_path('script.raw'))
+            self.assertEqual(result.returncode, 0, result.stderr)
+            result = self.run_vspipe('-o', index, '--load-graph', snapshot, self.output_path('snapshot.raw'))
+            self.assertEqual(result.returncode, 0, result.stderr)
+            self.assertEqual(self.read_output('snapshot.raw'), self.read_output('script.raw'), index)
+            self.assertEqual(self.graph('-o', index, '--load-graph', snapshot), self.graph('-o', index, self.script), index)
+        self.assertEqual(self.read_output('snapshot.raw'), self.expected(self.clips['yuv422p10']))
+
+        # several outputs can share a snapshot
+        result = self.run_vspipe('-o', '1=.', '-o', '2=.', '--save-graph', snapshot, self.script)
+        self.assertEqual(result.returncode, 0, result.stderr)
+        result = self.run_vspipe('-o', '1=' + self.output_path('b.raw'), '-o', '2=' + self.output_path('c.raw'), '--load-graph', snapshot)
+        self.assertEqual(result.returncode, 0, result.stderr)
+        self.assertEqual(self.read_output('b.raw'), self.expected(self.clips['yuv420p10']))
+        result = self.run_vspipe('-o', '2', self.script, self.output_path('script.raw'))
+        self.assertEqual(result.returncode, 0, result.stderr)
+        self.assertEqual(self.read_output('c.raw'), self.read_output('script.raw'))
+
+        # filters created with a python function can't be saved
+        result = self.run_vspipe('-o', '0', '--save-graph', self.output_path('modify.txt'), self.script, '.')
+        self.assertNotEqual(result.returncode, 0)
+        self.assertIn(b"std.ModifyFrame: argument 'selector' is a function which can't be saved in a graph snapshot", result.stderr)
+
+        # a snapshot that was cut short anywhere, even between records, fails to load instead of creating only a part of the graph
+        result = self.run_vspipe('-o', '3', '--save-graph', snapshot, self.script, '.')
+        self.assertEqual(result.returncode, 0, result.stderr)
+        with open(snapshot, 'rb') as f:
+            data = f.read()
+        truncated = self.output_path('truncated.txt')
+        for size in [len(data) // 2, data.index(b'\nR\t') + 1, data.rindex(b'\nR\t') + 1, len(data) - 2]:
+            with open(truncated, 'wb') as f:
+                f.write(data[:size])
+            result = self.run_vspipe('-o', '3', '--load-graph', truncated, '.')
+            self.assertNotEqual(result.returncode, 0, size)
+            self.assertIn(b"Loading graph snapshot failed:\nGraph snapshot '" + truncated.encode() + b"' is truncated", result.stderr, size)
+
+        # damaged records, other files and missing plugins are errors too
+        bad = self.output_path('bad.txt')
+        for content, message in [(data.replace(b':clip:0\n', b':clip\n', 1), b"on line 10: invalid node reference"),
+                                 (data.replace(b'com.vapoursynth.text', b'com.example.missing', 1), b"Plugin 'com.example.missing' used by the graph snapshot isn't loaded"),
+                                 (data.replace(b'\twidth\ti\t1\t134', b'\twidth\ti\t1\t-1', 1), b'Failed to recreate std.BlankClip from the graph snapshot'),
+                                 (SCRIPT.encode(), b"isn't a graph snapshot or was written by a different version"),
+                                 (b'', b"isn't a graph snapshot or was written by a different version")]:
+            with open(bad, 'wb') as f:
+                f.write(content)
+            result = self.run_vspipe('-o', '3', '--load-graph', bad, '.')
+            self.assertNotEqual(result.returncode, 0, message)
+            self.assertIn(message, result.stderr)
+        result = self.run_vspipe('--load-graph', self.output_path('missing.txt'), '.')
+        self.assertNotEqual(result.returncode, 0)
+        self.assertIn(b"Failed to open graph snapshot '" + self.output_path('missing.txt').encode() + b"'", result.stderr)
+
+    def test_direct_output(self):
+        # With --direct video goes straight from the frame memory to the output on Linux, with writev() for files and
+        # vmsplice() for pipes, the padding at the end of the rows must not end up in the output
+        for index, clip in [('0', self.clips['yuv420p8']), ('1', self.clips['yuv420p10'])]:
+            expected = self.expected(clip)
+            result = self.run_vspipe('--direct', '-o', index, '-p', self.script, self.output_path())
+            self.assertEqual(result.returncode, 0, result.stderr)
+            self.assertEqual(self.read_output(), expected, index)
+            self.assertRegex(result.stderr, rb'Wrote \d+\.\d\d GB \(\d+\.\d\d GB/s\)')
+            result = self.run_vspipe('--direct', '-o', index, self.script, '-')
+            self.assertEqual(result.returncode, 0, result.stderr)
+            self.assertEqual(result.stdout, expected, index)
+        result = self.run_vspipe('--direct', '-c', 'y4m', self.script, '-')
+        self.assertEqual(result.returncode, 0, result.stderr)
+        clip = self.clips['yuv420p8']
+        self.assertEqual(result.stdout.split(b'\n', 1)[1], b''.join(b'FRAME\n' + self.expected(clip, n, n) for n in range(clip.num_frames)))
+
+    def test_reader_exits(self):
+        # frames handed to the pipe are only released once they're read so a reader that goes away mustn't leave vspipe hanging
+        for direct in [[], ['--direct']]:
+            with subprocess.Popen([VSPIPE] + direct + [self.script, '-'], stdout=subprocess.PIPE, stderr=subprocess.PIPE) as process:
+                self.assertEqual(len(process.stdout.read(1000)), 1000)
+                process.stdout.close()
+                self.assertNotEqual(process.wait(timeout=60), 0)
+
+    def test_segments(self):
+        # 40 frames in 3 segments are split 13, 13 and 14
+        clip = self.clips['yuv420p8']
+        pattern = self.output_path('segment_%02d.raw')
+        result = self.run_vspipe('--segments', '3', '--output-pattern', pattern, self.script)
+        self.assertEqual(result.returncode, 0, result.stderr)
+        for i, (first, last) in enumerate([(0, 12), (13, 25), (26, 39)]):
+            self.assertEqual(self.read_output('segment_{:02d}.raw'.format(i)), self.expected(clip, first, last), i)
+
+        # every segment is a complete y4m file of its own and the range is split instead of the whole clip
+        pattern = self.output_path('segment_%d.y4m')
+        result = self.run_vspipe('--segments', '2', '--output-pattern', pattern, '-c', 'y4m', '-s', '10', '-e', '19', '-o', '1', self.script)
+        self.assertEqual(result.returncode, 0, result.stderr)
+        clip = self.clips['yuv420p10']
+        for i, (first, last) in enumerate([(10, 14), (15, 19)]):
+            header, data = self.read_output('segment_{}.y4m'.format(i)).split(b'\n', 1)
+            self.assertTrue(header.startswith(b'YUV4MPEG2 C420p10 W134 H100 '), header)
+            self.assertEqual(data, b''.join(b'FRAME\n' + self.expected(clip, n, n) for n in range(first, last + 1)), i)
+
+    def test_segment_options(self):
+        pattern = self.output_path('segment_%d.raw')
+        for args, message in [(['--segments', '2', self.script, '.'], b'Segments require an output pattern'),
+                              (['--segments', '0', '--output-pattern', pattern, self.script], b'Number of segments must be at least 1'),
+                              (['--segments', 'x', '--output-pattern', pattern, self.script], b"Couldn't convert x to an integer (segments)"),
+                              (['--segments', '41', '--output-pattern', pattern, self.script], b'Cannot split 40 frames into 41 segments'),
+                              (['--segments', '2', '--output-pattern', self.output_path('segment.raw'), self.script], b'Output pattern must contain exactly one %d field'),
+                              (['--segments', '2', '--output-pattern', self.output_path('segment_%d_%d.raw'), self.script], b'Output pattern must contain exactly one %d field'),
+                              (['--segments', '2', '--output-pattern', pattern, self.script, '.'], b'Output pattern can only be used for output and not together with an output file'),
+                              (['--segments', '2', '--output-pattern', pattern, '-t', self.output_path('tc.txt'), self.script], b'Cannot write timecodes, JSON or checksum files when outputting segments')]:
+            result = self.run_vspipe(*args)
+            self.assertNotEqual(result.returncode, 0, args)
+            self.assertIn(message, result.stderr, args)
+
+    def packed(self, clip, pack, alpha=None):
+        data = bytearray()
+        for n in range(clip.num_frames):
+            frame = clip.get_frame(n)
+            planes = [bytes(frame[p]) for p in range(frame.format.num_planes)]
+            if pack in ('rgb24', 'bgra'):
+                r, g, b = planes
+                size = 3 if pack == 'rgb24' else 4
+                out = bytearray(len(r) * size)
+                out[0 if pack == 'rgb24' else 2::size] = r
+                out[1::size] = g
+                out[2 if pack == 'rgb24' else 0::size] = b
+                if pack == 'bgra':
+                    out[3::size] = bytes(alpha.get_frame(n)[0]) if alpha else b'\xff' * len(r)
+            elif pack == 'yuyv':
+                y, u, v = planes
+                out = bytearray(len(y) * 2)
+                out[0::4] = y[0::2]
+                out[1::4] = u
+                out[2::4] = y[1::2]
+                out[3::4] = v
+            elif pack == 'p010':
+                y, u, v = [array.array('H', [x << 6 for x in array.array('H', p)]) for p in planes]
+                uv = array.array('H', bytes(len(u) * 4))
+                uv[0::2] = u
+                uv[1::2] = v
+                out = y.tobytes() + uv.tobytes()
+            elif pack == 'v210':
+                out = bytearray()
+                width = frame.width
+                for row in range(frame.height):
+                    y, u, v = [memoryview(frame[p]).tolist()[row] for p in range(3)]
+                    groups = (width + 5) // 6
+                    y += [0] * (groups * 6 - len(y))
+                    u += [0] * (groups * 3 - len(u))
+                    v += [0] * (groups * 3 - len(v))
+                    samples = []
+                    for i in range(groups):
+                        samples += [u[3 * i], y[6 * i], v[3 * i], y[6 * i + 1], u[3 * i + 1], y[6 * i + 2],
+                                    v[3 * i + 1], y[6 * i + 3], u[3 * i + 2], y[6 * i + 4], v[3 * i + 2], y[6 * i + 5]]
+                    line = array.array('I', [samples[i] | (samples[i + 1] << 10) | (samples[i + 2] << 20) for i in range(0, len(samples), 3)]).tobytes()
+                    out += line + bytes((width + 47) // 48 * 128 - len(line))
+            data += out
+        return bytes(data)
+
+    def test_pack(self):
+        for pack, index, clip, alpha in [('rgb24', '2', 'rgb24', None),
+                                         ('bgra', '2', 'rgb24', None),
+                                         ('bgra', '3', 'rgb24', 'alpha'),
+                                         ('yuyv', '4', 'yuv422p8', None),
+                                         ('v210', '5', 'yuv422p10', None),
+                                         ('p010', '1', 'yuv420p10', None)]:
+            expected = self.packed(self.clips[clip], pack, self.clips[alpha] if alpha else None)
+            result = self.run_vspipe('--pack', pack, '-o', index, self.script, self.output_path())
+            self.assertEqual(result.returncode, 0, result.stderr)
+            self.assertEqual(self.read_output(), expected, (pack, index))
+            result = self.run_vspipe('--pack', pack, '-o', index, self.script, '-')
+            self.assertEqual(result.returncode, 0, result.stderr)
+            self.assertEqual(result.stdout, expected, (pack, index))
+
+        # segments are packed the same way
+        pattern = self.output_path('segment_%d.raw')
+        result = self.run_vspipe('--pack', 'v210', '-o', '5', '--segments', '2', '--output-pattern', pattern, self.script)
+        self.assertEqual(result.returncode, 0, result.stderr)
+        self.assertEqual(self.read_output('segment_0.raw') + self.read_output('segment_1.raw'), self.packed(self.clips['yuv422p10'], 'v210'))
+
+    def test_pack_options(self):
+        for args, message in [(['--pack', 'nv12', self.script, '.'], b'Unknown packed format specified: nv12'),
+                              (['--pack'], b'No packed format specified'),
+                              (['--pack', 'yuyv', self.script, '.'], b'yuyv output requires a constant size YUV422P8 clip'),
+                              (['--pack', 'v210', '-o', '4', self.script, '.'], b'v210 output requires a constant size YUV422P10 clip'),
+                              (['--pack', 'p010', '-o', '5', self.script, '.'], b'p010 output requires a constant size YUV420P10 clip'),
+                              (['--pack', 'rgb24', '-o', '0', self.script, '.'], b'rgb24 output requires a constant size RGB24 clip'),
+                              (['--pack', 'rgb24', '-o', '3', self.script, '.'], b'alpha can only be output packed together with the color planes as bgra'),
+                              (['--pack', 'p010', '-o', '1', '-c', 'y4m', self.script, '.'], b"y4m headers can't be combined with packed output"),
+                              (['--pack', 'rgb24', '-o', '6', self.script, '.'], b'packed output can only be used with video')]:
+            result = self.run_vspipe(*args)
+            self.assertNotEqual(result.returncode, 0, args)
+            self.assertIn(message, result.stderr, args)
+
+    def test_options(self):
+        for args, message in [(['-r', 'x', self.script, '.'], b"Couldn't convert x to an integer (requests)"),
+                              (['-r'], b'Number of requests not specified'),
+                              (['-s', '-1', self.script, '.'], b'Negative start position specified'),
+                              (['-s', '30', '-e', '20', self.script, '.'], b'Trim: invalid last frame specified'),
+                              (['-e', '40', self.script, '.'], b'Trim: last frame beyond clip end'),
+                              (['--container', 'mkv', self.script, '.'], b'Unknown container type specified: mkv'),
+                              (['--no-such-option', self.script, '.'], b'Unknown argument: --no-such-option'),
+                              (['-o', '9', self.script, '.'], b'Failed to retrieve output node'),
+                              ([self.script], b'No output file specified'),
+                              (['-s', '1'], b'No script file specified')]:
+            result = self.run_vspipe(*args)
+            self.assertNotEqual(result.returncode, 0, args)
+            self.assertIn(message, result.stderr, args)
+
+if __name__ == '__main__':
+    unittest.main()